@@ -89,9 +89,19 @@ mkdir -p "$RELEASE_DIR"
 # Die Diagnostics-Seite existiert nicht mehr (entfernt) — sie wurde aus der
 # Dateiliste genommen, tar wuerde sonst wegen set -e den gesamten
 # Release-Build abbrechen (Datei nicht gefunden)
-(cd firmware/data && tar -czf "../../${RELEASE_DIR}/UI-${NEW_VERSION}-AuraOS.tgz" \
+# Neben den Einzeldateien liegt je Seite ein gzip-Bundle mit eingebettetem
+# CSS/JS (ein Request pro Seite). Aeltere Firmware ignoriert die Bundles.
+BUNDLE_DIR="firmware/.pio/ui-bundle"
+rm -rf "$BUNDLE_DIR"
+python3 firmware/build-ui-bundle.py "$BUNDLE_DIR"
+# Erst ungepackt, dann mit manifest.json (Pfad, Groesse, SHA-256 je Datei) vorn
+# neu gepackt — die Lampe schreibt damit nur geaenderte Dateien
+(cd firmware/data && tar -cf "../../${BUNDLE_DIR}/ui.tar" \
     --exclude="*.tmp.*" --exclude="*.tgz" --exclude="*.tar" --exclude=".DS_Store" \
-    index.html setup.html mood.html js/ css/)
+    index.html setup.html mood.html js/ css/ \
+    -C "../../${BUNDLE_DIR}" index.html.gz setup.html.gz mood.html.gz)
+python3 firmware/build-ui-manifest.py "${BUNDLE_DIR}/ui.tar" \
+    "${RELEASE_DIR}/UI-${NEW_VERSION}-AuraOS.tgz" "${NEW_VERSION}"
 echo "   -> UI-${NEW_VERSION}-AuraOS.tgz: $(ls -lh "${RELEASE_DIR}/UI-${NEW_VERSION}-AuraOS.tgz" | awk '{print $5}')"
 
 # Firmware-BIN
@@ -109,6 +119,10 @@ if ! echo "$UI_CONTENTS" | grep -q "setup.html"; then
     echo "FEHLER: setup.html fehlt im UI-TGZ"
     exit 1
 fi
+if [ "$(echo "$UI_CONTENTS" | head -n 1)" != "manifest.json" ]; then
+    echo "FEHLER: manifest.json ist nicht der erste Eintrag im UI-TGZ"
+    exit 1
+fi
 echo "   -> UI-TGZ verifiziert"
 echo "   -> Firmware-BIN verifiziert ($(ls -lh "${RELEASE_DIR}/Firmware-${NEW_VERSION}-AuraOS.bin" | awk '{print $5}'))"
 
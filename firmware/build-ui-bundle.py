@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+"""Baut die Geraete-UI: je Seite ein gzip-Bundle mit eingebettetem CSS und JS.
+
+Der Webserver der Lampe arbeitet Anfragen nacheinander ab. index.html zieht
+style.css und script.js nach, mood.html zusaetzlich mood.css und mood.js —
+jede Datei ist ein eigener Roundtrip. Das Bundle enthaelt alles Lokale in einer
+Datei, der kalte Seitenaufruf braucht damit genau eine Anfrage.
+
+Externe Quellen (CDN, Google Fonts) bleiben Links. Die Einzeldateien bleiben
+im UI-Archiv: Firmware ohne Bundle-Unterstuetzung liest weiter sie, neuere
+Firmware liefert <seite>.html.gz aus, sobald es vorhanden ist.
+
+Verwendung: ./build-ui-bundle.py [zielverzeichnis]   (Standard: data-bundle/)
+"""
+from pathlib import Path
+import gzip
+import re
+import sys
+
+here = Path(__file__).parent
+data = here / "data"
+out = Path(sys.argv[1]) if len(sys.argv) > 1 else here / "data-bundle"
+
+PAGES = ["index.html", "setup.html", "mood.html"]
+
+STYLESHEET = re.compile(r'<link rel="stylesheet" href="(/[^"]+\.css)">')
+SCRIPT = re.compile(r'<script src="(/[^"]+\.js)"( defer)?></script>\n?')
+
+
+def local(href):
+    return (data / href.lstrip("/")).read_text(encoding="utf-8")
+
+
+def inline_css(match):
+    return f"<style>\n{local(match.group(1))}\n</style>"
+
+
+def script_tag(src):
+    # Ein "</script" im Code wuerde den Tag vorzeitig schliessen
+    js = local(src).replace("</script", "<\\/script")
+    return f"<script>\n{js}\n</script>\n"
+
+
+def bundle(html):
+    html = STYLESHEET.sub(inline_css, html)
+
+    # defer-Skripte laufen erst nach dem Parsen, in Dokumentreihenfolge. Inline
+    # kennt defer nicht — deshalb wandern sie ans Ende des <body>, hinter alle
+    # anderen Skripte. So bleibt die Ausfuehrungsreihenfolge erhalten.
+    deferred = []
+
+    def replace(match):
+        if match.group(2):
+            deferred.append(script_tag(match.group(1)))
+            return ""
+        return script_tag(match.group(1))
+
+    html = SCRIPT.sub(replace, html)
+    if deferred:
+        html = html.replace("</body>", "".join(deferred) + "</body>", 1)
+
+    leftover = re.findall(r'(?:href|src)="(/(?:css|js)/[^"]+)"', html)
+    if leftover:
+        sys.exit(f"FEHLER: nicht eingebettete lokale Referenzen: {', '.join(leftover)}")
+    return html
+
+
+out.mkdir(parents=True, exist_ok=True)
+for page in PAGES:
+    html = bundle((data / page).read_text(encoding="utf-8")).encode("utf-8")
+    # mtime=0: gleicher Inhalt ergibt byte-gleiche Archive
+    packed = gzip.compress(html, compresslevel=9, mtime=0)
+    (out / f"{page}.gz").write_bytes(packed)
+    print(f"geschrieben: {page}.gz ({len(html) / 1024:.0f} KB -> {len(packed) / 1024:.0f} KB)")
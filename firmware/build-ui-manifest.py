@@ -0,0 +1,62 @@
+#!/usr/bin/env python3
+"""Packt das UI-Archiv neu, mit manifest.json als erstem Eintrag.
+
+Das Manifest nennt je Datei Pfad, Groesse und SHA-256. Die Lampe liest es,
+bevor die Dateien selbst im Upload-Strom ankommen, und schreibt nur, was sich
+gegenueber der installierten UI geaendert hat — unveraenderte Dateien bleiben
+im Verzeichnis der Vorversion liegen und werden von dort ausgeliefert.
+
+Erzeugt wird das Manifest aus dem fertigen tar, nicht aus firmware/data: es
+beschreibt damit genau die Dateien, die im Archiv stehen.
+
+Verwendung: ./build-ui-manifest.py <ui.tar> <ui.tgz> <version>
+"""
+from pathlib import Path
+import gzip
+import hashlib
+import io
+import json
+import sys
+import tarfile
+
+MANIFEST = "manifest.json"
+
+
+def manifest_for(tar, version):
+    files = {}
+    for member in tar.getmembers():
+        if not member.isfile():
+            continue
+        name = member.name.removeprefix("./")
+        if name == MANIFEST:
+            continue
+        data = tar.extractfile(member).read()
+        files[name] = {"size": len(data), "sha256": hashlib.sha256(data).hexdigest()}
+    return {"version": version, "files": files}
+
+
+def repack(source, target, version):
+    with tarfile.open(source) as tar:
+        manifest = manifest_for(tar, version)
+        body = json.dumps(manifest, separators=(",", ":"), sort_keys=True).encode()
+
+        # mtime 0: gleicher Inhalt ergibt byte-gleiches Archiv
+        with open(target, "wb") as fh, \
+                gzip.GzipFile(fileobj=fh, mode="wb", compresslevel=9, mtime=0) as gz, \
+                tarfile.open(fileobj=gz, mode="w", format=tarfile.USTAR_FORMAT) as out:
+            info = tarfile.TarInfo(MANIFEST)
+            info.size = len(body)
+            info.mode = 0o644
+            out.addfile(info, io.BytesIO(body))
+            for member in tar.getmembers():
+                if member.name.removeprefix("./") == MANIFEST:
+                    continue
+                out.addfile(member, tar.extractfile(member) if member.isfile() else None)
+    return manifest
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 4:
+        sys.exit(__doc__.strip().splitlines()[-1])
+    manifest = repack(Path(sys.argv[1]), Path(sys.argv[2]), sys.argv[3])
+    print(f"   -> Manifest: {len(manifest['files'])} Dateien")
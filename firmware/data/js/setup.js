@@ -518,14 +518,25 @@ function testAPI() {
         },
         body: JSON.stringify(data)
     })
-    .then(response => response.json())
+    .then(response => pollApiTest(response, 0))
     .then(result => {
         spinner.innerHTML = '';
-        
+
+        // Zeitaufschluesselung der Messung (DNS, Verbindung, erstes Byte, gesamt)
+        let details = '';
+        if (result.timing) {
+            const t = result.timing;
+            details = '\n\nDNS: ' + t.dnsMs + ' ms' +
+                '\nVerbindung: ' + t.connectMs + ' ms' +
+                '\nErstes Byte: ' + t.firstByteMs + ' ms' +
+                '\nGesamt: ' + t.totalMs + ' ms' +
+                '\nAntwort: ' + result.payloadBytes + ' Bytes, geparst in ' + (t.parseUs / 1000).toFixed(1) + ' ms';
+        }
+
         if (result.success) {
-            alert('API-Test erfolgreich! Sentiment: ' + result.sentiment);
+            alert('API-Test erfolgreich! Sentiment: ' + result.sentiment + details);
         } else {
-            alert('API-Test fehlgeschlagen: ' + result.message);
+            alert('API-Test fehlgeschlagen: ' + result.message + details);
         }
     })
     .catch(error => {
@@ -535,6 +546,19 @@ function testAPI() {
     });
 }
 
+// Der API-Test laeuft auf dem Geraet im Hintergrund: 202 heisst "misst noch",
+// dann den Status-Endpunkt abfragen, bis das Ergebnis da ist
+function pollApiTest(response, attempt) {
+    if (response.status === 202 && attempt < 60) {
+        return response.json().then(job => new Promise(resolve => {
+            setTimeout(() => resolve(
+                fetch('/testapi/status?job=' + job.job).then(r => pollApiTest(r, attempt + 1))
+            ), 300);
+        }));
+    }
+    return response.json();
+}
+
 // Save Color Settings
 function saveColorSettings() {
     const colorInputs = document.querySelectorAll('.color-input');
@@ -656,8 +680,20 @@ function scanWifi() {
     const wifiList = document.getElementById('wifi-list');
     wifiList.innerHTML = 'Suche nach WLAN-Netzwerken...';
     
-    fetch('/wifiscan')
-    .then(response => response.json())
+    // Der Scan laeuft auf dem Geraet im Hintergrund: 202 heisst "laeuft noch",
+    // dann mit der Job-ID nachfragen, bis 200 mit den Netzwerken kommt
+    const pollScan = (url, attempt) => fetch(url)
+        .then(response => {
+            if (response.status === 202 && attempt < 40) {
+                return response.json().then(job => new Promise(resolve => {
+                    setTimeout(() => resolve(pollScan('/wifiscan?job=' + job.job, attempt + 1)), 500);
+                }));
+            }
+            if (!response.ok) throw new Error('Scan fehlgeschlagen (HTTP ' + response.status + ')');
+            return response.json();
+        });
+
+    pollScan('/wifiscan', 0)
     .then(data => {
         spinner.innerHTML = '';
         wifiList.innerHTML = '';
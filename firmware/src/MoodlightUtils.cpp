@@ -3,6 +3,8 @@
 #include "MoodlightUtils.h"
 #include <time.h>
 
+#define LOG_TAG LOG_TAG_CORE
+
 // ===== WATCHDOG-MANAGER IMPLEMENTIERUNG =====
 
 WatchdogManager::WatchdogManager() : 
@@ -29,13 +31,13 @@ bool WatchdogManager::begin(uint32_t timeoutSeconds, bool panicOnTimeout) {
     esp_err_t err = esp_task_wdt_init(timeoutSeconds, panicOnTimeout);
 #endif
     if (err != ESP_OK) {
-        debug(F("Fehler bei der Initialisierung des Watchdogs"));
+        LOG_E("Fehler bei der Initialisierung des Watchdogs");
         return false;
     }
 
     _isEnabled = true;
     _lastFeedTime = millis();
-    debug(String(F("Watchdog initialisiert: ")) + timeoutSeconds + "s Timeout");
+    LOG_I("Watchdog initialisiert: %us Timeout", timeoutSeconds);
     return true;
 }
 
@@ -45,18 +47,18 @@ bool WatchdogManager::registerCurrentTask() {
     // Erhalte den aktuellen Task-Handle (in der Regel der Loop-Task)
     _monitoredTask = xTaskGetCurrentTaskHandle();
     if (_monitoredTask == NULL) {
-        debug(F("Konnte Task-Handle nicht erhalten"));
+        LOG_I("Konnte Task-Handle nicht erhalten");
         return false;
     }
     
     // Registriere Task beim Watchdog
     esp_err_t err = esp_task_wdt_add(_monitoredTask);
     if (err != ESP_OK) {
-        debug(F("Fehler beim Registrieren des Tasks beim Watchdog"));
+        LOG_E("Fehler beim Registrieren des Tasks beim Watchdog");
         return false;
     }
     
-    debug(F("Task erfolgreich beim Watchdog registriert"));
+    LOG_I("Task erfolgreich beim Watchdog registriert");
     return true;
 }
 
@@ -83,15 +85,15 @@ bool WatchdogManager::autoFeed(unsigned long interval) {
 
 void WatchdogManager::analyzeStack() {
     if (_monitoredTask == NULL) {
-        debug(F("Kein überwachter Task für Stack-Analyse"));
+        LOG_I("Kein überwachter Task für Stack-Analyse");
         return;
     }
     
     UBaseType_t stackHighWaterMark = uxTaskGetStackHighWaterMark(_monitoredTask);
-    debug(String(F("Task Stack High Water Mark: ")) + stackHighWaterMark + F(" Wörter"));
+    LOG_D("Task Stack High Water Mark: %u Wörter", (unsigned)stackHighWaterMark);
     
     if (stackHighWaterMark < 200) {
-        debug(F("WARNUNG: Stack wird knapp! Stacküberlauf möglich"));
+        LOG_W("Stack wird knapp! Stacküberlauf möglich");
     }
 }
 
@@ -104,7 +106,7 @@ void WatchdogManager::disable() {
     }
     
     _isEnabled = false;
-    debug(F("Watchdog deaktiviert"));
+    LOG_I("Watchdog deaktiviert");
 }
 
 // ===== MEMORY-MONITOR IMPLEMENTIERUNG =====
@@ -112,6 +114,7 @@ void WatchdogManager::disable() {
 MemoryMonitor::MemoryMonitor() :
     _lastFreeHeap(ESP.getFreeHeap()),
     _lowestHeap(ESP.getFreeHeap()),
+    _lowestMaxBlock(ESP.getMaxAllocHeap()),
     _lastPersistedLowestHeap(ESP.getFreeHeap()),
     _lastReportTime(0),
     _reportInterval(60000),
@@ -139,7 +142,7 @@ bool MemoryMonitor::begin(unsigned long reportInterval) {
     _prefs.end();
     _lastPersistedLowestHeap = _lowestHeap;
 
-    debug(String(F("Speicher-Monitor initialisiert. Initiale Heap-Größe: ")) + formatBytes(_lastFreeHeap));
+    LOG_I("Speicher-Monitor initialisiert. Initiale Heap-Größe: %s", formatBytes(_lastFreeHeap));
     return true;
 }
 
@@ -153,6 +156,10 @@ void MemoryMonitor::update() {
     if (currentFree < _lowestHeap) {
         _lowestHeap = currentFree;
     }
+    size_t currentMaxBlock = ESP.getMaxAllocHeap();
+    if (currentMaxBlock < _lowestMaxBlock) {
+        _lowestMaxBlock = currentMaxBlock;
+    }
 
     // NVS-Write throttlen: max. alle 10 Minuten ODER wenn sich der Tiefstwert
     // um mehr als 1 KB seit dem letzten Schreiben verändert hat (A10)
@@ -174,10 +181,8 @@ void MemoryMonitor::update() {
         size_t maxBlock = ESP.getMaxAllocHeap();
         float fragmentationPercent = 100.0 - (maxBlock * 100.0 / currentFree);
         
-        debug(String(F("Speicher: Frei=")) + formatBytes(currentFree) + 
-              F(", Max Block=") + formatBytes(maxBlock) + 
-              F(", Niedrigster=") + formatBytes(_lowestHeap) + 
-              F(", Fragmentierung=") + fragmentationPercent + F("%"));
+        LOG_I("Speicher: Frei=%s, Max Block=%s, Niedrigster=%s, Fragmentierung=%.2f%%", formatBytes(currentFree),
+              formatBytes(maxBlock), formatBytes(_lowestHeap), fragmentationPercent);
         
         _lastFreeHeap = currentFree;
         _lastReportTime = currentTime;
@@ -187,9 +192,8 @@ void MemoryMonitor::update() {
 bool MemoryMonitor::checkHeapBefore(const char* operation, size_t requiredFree) {
     size_t currentFree = ESP.getFreeHeap();
     if (currentFree < requiredFree) {
-        debug(String(F("WARNUNG: Zu wenig Speicher für ")) + operation + 
-              F(" (") + formatBytes(currentFree) + F(" verfügbar, ") + 
-              formatBytes(requiredFree) + F(" benötigt)"));
+        LOG_W("Zu wenig Speicher für %s (%s verfügbar, %s benötigt)", operation, formatBytes(currentFree),
+              formatBytes(requiredFree));
         return false;
     }
     return true;
@@ -201,46 +205,50 @@ void MemoryMonitor::diagnose() {
     float fragmentationPercent = 100.0 - (maxBlock * 100.0 / currentFree);
     unsigned long uptime = (millis() - _startTime) / 1000;
     
-    debug(F("===== SPEICHER-DIAGNOSE ====="));
-    debug(String(F("Aktuell frei: ")) + formatBytes(currentFree));
-    debug(String(F("Größter Block: ")) + formatBytes(maxBlock));
-    debug(String(F("Niedrigster Heap: ")) + formatBytes(_lowestHeap));
-    debug(String(F("Fragmentierung: ")) + fragmentationPercent + F("%"));
-    debug(String(F("Programm läuft seit: ")) + MoodlightUtils::formatTime(uptime * 1000));
+    LOG_I("===== SPEICHER-DIAGNOSE =====");
+    LOG_I("Aktuell frei: %s", formatBytes(currentFree));
+    LOG_I("Größter Block: %s", formatBytes(maxBlock));
+    LOG_I("Niedrigster Heap: %s", formatBytes(_lowestHeap));
+    LOG_I("Fragmentierung: %.2f%%", fragmentationPercent);
+    LOG_I("Programm läuft seit: %s", MoodlightUtils::formatTime(uptime * 1000));
     
     // Heap-Histogramm für detailliertere Analyse
     size_t blocks[6] = {0}; // Anzahl der Blöcke in verschiedenen Größenkategorien
     size_t testSizes[6] = {64, 256, 1024, 4096, 16384, 65536};
     
-    debug(F("Heap-Blockgrößen-Test:"));
+    LOG_I("Heap-Blockgrößen-Test:");
     for (int i = 0; i < 6; i++) {
         // Versuche, Blöcke dieser Größe zu allozieren
         void* testBlock = malloc(testSizes[i]);
         if (testBlock) {
             blocks[i] = 1;
             free(testBlock);
-            debug(String(F("  ")) + formatBytes(testSizes[i]) + F(": Verfügbar"));
+            LOG_I("  %s: Verfügbar", formatBytes(testSizes[i]));
         } else {
-            debug(String(F("  ")) + formatBytes(testSizes[i]) + F(": Nicht verfügbar"));
+            LOG_I("  %s: Nicht verfügbar", formatBytes(testSizes[i]));
         }
     }
     
     // Empfehlungen basierend auf der Analyse
     if (fragmentationPercent > 70) {
-        debug(F("WARNUNG: Hohe Fragmentierung. Neustart könnte helfen."));
+        LOG_W("Hohe Fragmentierung. Neustart könnte helfen.");
     }
     
     if (currentFree < 20000) {
-        debug(F("WARNUNG: Wenig freier Speicher. Vermeide große Allokationen."));
+        LOG_W("Wenig freier Speicher. Vermeide große Allokationen.");
     }
     
-    debug(F("============================"));
+    LOG_I("============================");
 }
 
 size_t MemoryMonitor::getLowestHeap() const {
     return _lowestHeap;
 }
 
+size_t MemoryMonitor::getLowestMaxBlock() const {
+    return _lowestMaxBlock;
+}
+
 String MemoryMonitor::formatBytes(size_t bytes) {
     if (bytes < 1024) {
         return String(bytes) + F(" B");
@@ -266,14 +274,13 @@ String SafeFileOps::readFile(const char* path, int maxRetries) {
     
     while (attempts < maxRetries) {
         if (!LittleFS.exists(path)) {
-            debug(String(F("Datei nicht gefunden: ")) + path);
+            LOG_W("Datei nicht gefunden: %s", path);
             return "";
         }
         
         File file = LittleFS.open(path, "r");
         if (!file) {
-            debug(String(F("Konnte Datei nicht öffnen: ")) + path + F(" (Versuch ") + 
-                  (attempts+1) + F("/") + maxRetries + F(")"));
+            LOG_W("Konnte Datei nicht öffnen: %s (Versuch %d/%d)", path, attempts + 1, maxRetries);
             attempts++;
             delay(50); // Kurze Pause vor erneutem Versuch
             continue;
@@ -284,8 +291,7 @@ String SafeFileOps::readFile(const char* path, int maxRetries) {
         size_t freeHeap = ESP.getFreeHeap();
         
         if (fileSize > freeHeap / 2) {
-            debug(String(F("WARNUNG: Datei zu groß für sicheres Laden: ")) + fileSize + 
-                  F("B, Freier Heap: ") + freeHeap + F("B"));
+            LOG_W("Datei zu groß für sicheres Laden: %uB, Freier Heap: %uB", fileSize, freeHeap);
             
             // Lese die Datei in Blöcken statt als Ganzes
             const size_t bufferSize = 512;
@@ -320,7 +326,7 @@ bool SafeFileOps::writeFile(const char* path, const String& content) {
         
         // Kopiere aktuelle Datei als Backup
         if (!copyFile(path, backupPath)) {
-            debug(String(F("WARNUNG: Konnte kein Backup von ")) + path + F(" erstellen"));
+            LOG_W("Konnte kein Backup von %s erstellen", path);
             // Fahre trotzdem fort, aber mit Vorsicht
         }
     }
@@ -333,7 +339,7 @@ bool SafeFileOps::writeFile(const char* path, const String& content) {
     
     File tempFile = LittleFS.open(tempPath.c_str(), "w");
     if (!tempFile) {
-        debug(String(F("Fehler: Konnte temporäre Datei nicht erstellen: ")) + tempPath);
+        LOG_E("Konnte temporäre Datei nicht erstellen: %s", tempPath);
         return false;
     }
     
@@ -348,7 +354,7 @@ bool SafeFileOps::writeFile(const char* path, const String& content) {
         
         if (!tempFile.print(chunk)) {
             writeSuccess = false;
-            debug(String(F("Fehler beim Schreiben von Chunk ")) + i + F(" zu ") + endPos);
+            LOG_E("Fehler beim Schreiben von Chunk %u zu %u", i, endPos);
             break;
         }
         
@@ -362,14 +368,14 @@ bool SafeFileOps::writeFile(const char* path, const String& content) {
     
     if (!writeSuccess) {
         LittleFS.remove(tempPath.c_str());
-        debug(String(F("Schreiben in temporäre Datei fehlgeschlagen: ")) + tempPath);
+        LOG_E("Schreiben in temporäre Datei fehlgeschlagen: %s", tempPath);
         return false;
     }
     
     // Lösche Zieldatei, wenn sie existiert
     if (LittleFS.exists(path)) {
         if (!LittleFS.remove(path)) {
-            debug(String(F("Konnte die alte Datei nicht entfernen: ")) + path);
+            LOG_E("Konnte die alte Datei nicht entfernen: %s", path);
             LittleFS.remove(tempPath.c_str());
             return false;
         }
@@ -379,14 +385,14 @@ bool SafeFileOps::writeFile(const char* path, const String& content) {
     if (LittleFS.rename(tempPath.c_str(), path)) {
         return true;
     } else {
-        debug(String(F("Umbenennen der temporären Datei fehlgeschlagen: ")) + tempPath + F(" -> ") + path);
+        LOG_E("Umbenennen der temporären Datei fehlgeschlagen: %s -> %s", tempPath, path);
         
         // Versuche Backup wiederherzustellen, wenn vorhanden
         if (_backupEnabled) {
             String backupPath = String(path) + _backupSuffix;
             if (LittleFS.exists(backupPath)) {
                 if (LittleFS.rename(backupPath.c_str(), path)) {
-                    debug(F("Backup wiederhergestellt nach Schreibfehler"));
+                    LOG_I("Backup wiederhergestellt nach Schreibfehler");
                 }
             }
         }
@@ -397,19 +403,19 @@ bool SafeFileOps::writeFile(const char* path, const String& content) {
 
 bool SafeFileOps::copyFile(const String& source, const String& destination) {
     if (!LittleFS.exists(source)) {
-        debug("Quelldatei existiert nicht: " + source);
+        LOG_E("Quelldatei existiert nicht: %s", source);
         return false;
     }
     
     File sourceFile = LittleFS.open(source, "r");
     if (!sourceFile) {
-        debug("Quelldatei konnte nicht geöffnet werden: " + source);
+        LOG_E("Quelldatei konnte nicht geöffnet werden: %s", source);
         return false;
     }
     
     File destFile = LittleFS.open(destination, "w");
     if (!destFile) {
-        debug("Zieldatei konnte nicht erstellt werden: " + destination);
+        LOG_E("Zieldatei konnte nicht erstellt werden: %s", destination);
         sourceFile.close();
         return false;
     }
@@ -419,7 +425,7 @@ bool SafeFileOps::copyFile(const String& source, const String& destination) {
     
     while ((bytesRead = sourceFile.read(buffer, sizeof(buffer))) > 0) {
         if (destFile.write(buffer, bytesRead) != bytesRead) {
-            debug(F("Fehler beim Schreiben in Zieldatei"));
+            LOG_E("Fehler beim Schreiben in Zieldatei");
             sourceFile.close();
             destFile.close();
             return false;
@@ -427,7 +433,7 @@ bool SafeFileOps::copyFile(const String& source, const String& destination) {
         yield(); // Allow for WiFi processing
     }
     
-    debug("Datei kopiert von " + source + " nach " + destination);
+    LOG_D("Datei kopiert von %s nach %s", source, destination);
     destFile.close();
     sourceFile.close();
     return true;
@@ -436,8 +442,7 @@ bool SafeFileOps::copyFile(const String& source, const String& destination) {
 bool SafeFileOps::checkSpaceBefore(size_t requiredBytes) {
     size_t freeSpace = LittleFS.totalBytes() - LittleFS.usedBytes();
     if (freeSpace < requiredBytes) {
-        debug(String(F("WARNUNG: Nicht genügend freier Speicherplatz: ")) + 
-              freeSpace + F(" verfügbar, ") + requiredBytes + F(" benötigt"));
+        LOG_W("Nicht genügend freier Speicherplatz: %u verfügbar, %u benötigt", freeSpace, requiredBytes);
         return false;
     }
     return true;
@@ -448,12 +453,12 @@ void SafeFileOps::listDir(const char* dirname, uint8_t levels) {
     
     File root = LittleFS.open(dirname);
     if (!root) {
-        debug(String(F("Konnte Verzeichnis nicht öffnen: ")) + dirname);
+        LOG_E("Konnte Verzeichnis nicht öffnen: %s", dirname);
         return;
     }
     
     if (!root.isDirectory()) {
-        debug(String(F("Nicht ein Verzeichnis: ")) + dirname);
+        LOG_E("Nicht ein Verzeichnis: %s", dirname);
         root.close();
         return;
     }
@@ -468,7 +473,7 @@ void SafeFileOps::listDir(const char* dirname, uint8_t levels) {
         String filePath = String(file.path());
         
         if (file.isDirectory()) {
-            debug(indent + F("DIR: ") + filePath);
+            LOG_I("%sDIR: %s", indent, filePath);
             file.close();
             listDir(filePath.c_str(), levels + 1);
         } else {
@@ -481,7 +486,7 @@ void SafeFileOps::listDir(const char* dirname, uint8_t levels) {
                 fileSize = String(file.size() / 1024.0 / 1024.0, 1) + F(" MB");
             }
             
-            debug(indent + filePath + F(" (") + fileSize + F(")"));
+            LOG_I("%s%s (%s)", indent, filePath, fileSize);
             file.close();
         }
         
@@ -508,7 +513,7 @@ bool NetworkDiagnostics::begin(unsigned long intervalMs) {
 
 void NetworkDiagnostics::analyzeWiFiSignal() {
     if (WiFi.status() != WL_CONNECTED) {
-        debug(F("WiFi nicht verbunden, keine Signalanalyse möglich"));
+        LOG_W("WiFi nicht verbunden, keine Signalanalyse möglich");
         return;
     }
     
@@ -534,40 +539,38 @@ void NetworkDiagnostics::analyzeWiFiSignal() {
         else quality = F("Sehr schwach");
     }
     
-    debug(String(F("WiFi-Signalanalyse: RSSI=")) + rssi + 
-          F(" dBm, Qualität=") + quality + 
-          F(" (") + qualityPercent + F("%)"));
+    LOG_I("WiFi-Signalanalyse: RSSI=%d dBm, Qualität=%s (%d%%)", rssi, quality, qualityPercent);
     
     // Kanal-Informationen erfassen
     int channel = WiFi.channel();
-    debug(String(F("WiFi-Kanal: ")) + channel);
+    LOG_I("WiFi-Kanal: %d", channel);
     
     // Prüfen auf kritisch schwaches Signal
     if (qualityPercent < 30) {
-        debug(F("WARNUNG: Sehr schwache WiFi-Signalstärke erkannt!"));
+        LOG_W("Sehr schwache WiFi-Signalstärke erkannt!");
     }
 }
 
 void NetworkDiagnostics::quickCheck() {
     if (WiFi.status() != WL_CONNECTED) {
-        debug(F("WiFi ist nicht verbunden"));
+        LOG_W("WiFi ist nicht verbunden");
         return;
     }
     
     int rssi = WiFi.RSSI();
     if (abs(rssi - _lastRssi) > 5) {
-        debug(String(F("WiFi-Signalstärke geändert: ")) + _lastRssi + F(" dBm -> ") + rssi + F(" dBm"));
+        LOG_I("WiFi-Signalstärke geändert: %d dBm -> %d dBm", _lastRssi, rssi);
         _lastRssi = rssi;
     }
 }
 
 void NetworkDiagnostics::fullAnalysis() {
     if (WiFi.status() != WL_CONNECTED) {
-        debug(F("WiFi nicht verbunden, keine Netzwerkanalyse möglich"));
+        LOG_W("WiFi nicht verbunden, keine Netzwerkanalyse möglich");
         return;
     }
 
-    debug(F("Starte vollständige Netzwerkanalyse..."));
+    LOG_I("Starte vollständige Netzwerkanalyse...");
 
     // Grundlegende Netzwerkinfos
     analyzeWiFiSignal();
@@ -576,16 +579,16 @@ void NetworkDiagnostics::fullAnalysis() {
     // Sekunden). Nur RSSI/Kanal des aktuellen Netzwerks loggen — Scan bleibt on-demand
     // ueber den /wifiscan-Endpunkt verfuegbar.
     int channel = WiFi.channel();
-    debug(String(F("Aktueller Kanal: ")) + channel);
+    LOG_I("Aktueller Kanal: %d", channel);
 
     // Router-Verbindungsinformationen
     IPAddress gatewayIP = WiFi.gatewayIP();
-    debug(String(F("Gateway-IP: ")) + gatewayIP.toString());
+    LOG_I("Gateway-IP: %s", gatewayIP.toString());
 
     // DNS-Informationen
     IPAddress dns1 = WiFi.dnsIP(0);
     IPAddress dns2 = WiFi.dnsIP(1);
-    debug(String(F("DNS-Server: ")) + dns1.toString() + F(", ") + dns2.toString());
+    LOG_I("DNS-Server: %s, %s", dns1.toString(), dns2.toString());
 
     _lastFullAnalysis = millis();
 }
@@ -638,17 +641,17 @@ bool SystemHealthCheck::begin(MemoryMonitor* memMonitor, NetworkDiagnostics* net
     _prefs.end();
 
     _initialized = true;
-    debug(String(F("System-Gesundheitscheck initialisiert, Neustarts: ")) + (_restartCount + 1));
+    LOG_I("System-Gesundheitscheck initialisiert, Neustarts: %lu", _restartCount + 1);
     return true;
 }
 
 void SystemHealthCheck::performFullCheck() {
     if (!_initialized) {
-        debug(F("SystemHealthCheck nicht initialisiert"));
+        LOG_W("SystemHealthCheck nicht initialisiert");
         return;
     }
     
-    debug(F("====== VOLLSTÄNDIGE SYSTEMPRÜFUNG ======"));
+    LOG_I("====== VOLLSTÄNDIGE SYSTEMPRÜFUNG ======");
     
     // Speicher-Status prüfen
     if (_memMonitor != nullptr) {
@@ -658,18 +661,15 @@ void SystemHealthCheck::performFullCheck() {
         size_t maxBlock = ESP.getMaxAllocHeap();
         float fragmentationIndex = 1.0 - ((float)maxBlock / freeHeap);
         
-        debug(String(F("Speicher: Frei=")) + freeHeap + 
-              F(" Bytes, Max Block=") + maxBlock + 
-              F(" Bytes, Fragmentierung=") + (fragmentationIndex * 100) + F("%"));
+        LOG_I("Speicher: Frei=%u Bytes, Max Block=%u Bytes, Fragmentierung=%.2f%%", freeHeap, maxBlock,
+              fragmentationIndex * 100);
     }
     
     // Netzwerk prüfen
     if (_netDiagnostics != nullptr) {
         _netDiagnostics->fullAnalysis();
     } else if (WiFi.status() == WL_CONNECTED) {
-        debug(String(F("WiFi: SSID=")) + WiFi.SSID() + 
-              F(", IP=") + WiFi.localIP().toString() + 
-              F(", RSSI=") + WiFi.RSSI() + F(" dBm"));
+        LOG_I("WiFi: SSID=%s, IP=%s, RSSI=%d dBm", WiFi.SSID(), WiFi.localIP().toString(), WiFi.RSSI());
     }
     
     // Dateisystem prüfen
@@ -677,27 +677,27 @@ void SystemHealthCheck::performFullCheck() {
     uint64_t used = LittleFS.usedBytes();
     float percentUsed = ((float)used / total) * 100;
     
-    debug(String(F("Dateisystem: Genutzt=")) + used + 
-          F(" Bytes (") + percentUsed + F("%) von ") + total + F(" Bytes"));
+    LOG_I("Dateisystem: Genutzt=%lu Bytes (%.2f%%) von %lu Bytes", (unsigned long)used, percentUsed,
+          (unsigned long)total);
     
     if (percentUsed > 85) {
-        debug(F("WARNUNG: Dateisystem ist fast voll. Bereinigung erforderlich."));
+        LOG_W("Dateisystem ist fast voll. Bereinigung erforderlich.");
     }
     
     // CPU-Last und Temperatur
     float temperature = temperatureRead(); // ESP32-Funktion für die interne Temperatur
-    debug(String(F("CPU-Temperatur: ")) + temperature + F("°C"));
+    LOG_I("CPU-Temperatur: %.2f°C", temperature);
     
     if (temperature > 70) {
-        debug(F("WARNUNG: Hohe CPU-Temperatur erkannt."));
+        LOG_W("Hohe CPU-Temperatur erkannt.");
     }
     
     // Runtime-Statistiken
     unsigned long uptimeSeconds = millis() / 1000;
-    debug(String(F("Systemlaufzeit: ")) + MoodlightUtils::formatTime(uptimeSeconds * 1000));
-    debug(String(F("Systemneustarts: ")) + (_restartCount + 1));
+    LOG_I("Systemlaufzeit: %s", MoodlightUtils::formatTime(uptimeSeconds * 1000));
+    LOG_I("Systemneustarts: %lu", _restartCount + 1);
     
-    debug(F("========================================"));
+    LOG_I("========================================");
     
     _lastCheckTime = millis();
 }
@@ -717,11 +717,11 @@ void SystemHealthCheck::update() {
 
     if (currentBootHours > _bootUptimeHours) {
         _bootUptimeHours = currentBootHours;
-        debug(String(F("Boot-Uptime: ")) + _bootUptimeHours + F(" Stunden"));
+        LOG_I("Boot-Uptime: %lu Stunden", _bootUptimeHours);
 
         // Bei 24h-Intervallen zusätzliche Prüfungen
         if (_bootUptimeHours % 24 == 0) {
-            debug(String(F("24-Stunden-Meilenstein: ")) + _bootUptimeHours + F(" Stunden Laufzeit (dieser Boot)"));
+            LOG_I("24-Stunden-Meilenstein: %lu Stunden Laufzeit (dieser Boot)", _bootUptimeHours);
             performFullCheck();
         }
     }
@@ -793,13 +793,13 @@ bool SystemHealthCheck::isRestartRecommended() {
 
     // Extrem hohe Fragmentierung
     if (fragmentationIndex > 0.85 && _bootUptimeHours > 48) {
-        debug(F("Neustart empfohlen: Extreme Speicherfragmentierung"));
+        LOG_I("Neustart empfohlen: Extreme Speicherfragmentierung");
         return true;
     }
 
     // Sehr wenig freier Speicher
     if (freeHeap < 10000 && _bootUptimeHours > 24) {
-        debug(F("Neustart empfohlen: Kritisch wenig freier Speicher"));
+        LOG_I("Neustart empfohlen: Kritisch wenig freier Speicher");
         return true;
     }
 
@@ -809,13 +809,13 @@ bool SystemHealthCheck::isRestartRecommended() {
     float percentUsed = (total > 0) ? (((float)used / total) * 100) : 0;
 
     if (percentUsed > 95 && _bootUptimeHours > 1) {
-        debug(F("Neustart empfohlen: Dateisystem fast voll"));
+        LOG_I("Neustart empfohlen: Dateisystem fast voll");
         return true;
     }
 
     // Sehr lange Laufzeit dieses Boots
     if (_bootUptimeHours > 720) { // 30 Tage
-        debug(F("Neustart empfohlen: Sehr lange Laufzeit (>30 Tage, dieser Boot)"));
+        LOG_I("Neustart empfohlen: Sehr lange Laufzeit (>30 Tage, dieser Boot)");
         return true;
     }
 
@@ -48,6 +48,7 @@ class MemoryMonitor {
 private:
     size_t _lastFreeHeap;
     size_t _lowestHeap;
+    size_t _lowestMaxBlock;            // Kleinster groesster freier Block seit Boot (Fragmentierung)
     size_t _lastPersistedLowestHeap;   // NVS-Throttle: zuletzt tatsaechlich geschriebener Wert
     unsigned long _lastReportTime;
     unsigned long _reportInterval;
@@ -73,6 +74,10 @@ public:
     
     // Erhalte den niedrigsten gesehenen Heap-Wert
     size_t getLowestHeap() const;
+
+    // Erhalte den kleinsten gesehenen groessten freien Block seit Boot. Sinkt er
+    // ueber Tage, zerstueckelt etwas den Heap.
+    size_t getLowestMaxBlock() const;
     
     // Formatiere Bytes in lesbare Größe (KB, MB)
     static String formatBytes(size_t bytes);
@@ -93,6 +98,9 @@ public:
     
     // Sichere Schreiboperation mit temporärer Datei und Backups
     bool writeFile(const char* path, const String& content);
+
+    // Pfad der Backup-Kopie, die writeFile() vor dem Überschreiben anlegt
+    String backupPath(const char* path) const { return String(path) + _backupSuffix; }
     
     // Sicheres Kopieren von Dateien
     bool copyFile(const String& source, const String& destination);
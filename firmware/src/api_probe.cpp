@@ -0,0 +1,271 @@
+#include "api_probe.h"
+#include "config.h"
+#include "debug.h"
+#include <ArduinoJson.h>
+#include <WiFi.h>
+#include <WiFiClient.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#define LOG_TAG LOG_TAG_SENSOR
+#include <freertos/semphr.h>
+
+// Messwerte eines Durchlaufs. Der Task fuellt eine lokale Kopie und uebergibt sie
+// erst am Ende unter dem Mutex — der Webserver sieht nie einen halben Stand.
+struct ApiProbeResult {
+    bool success;
+    String message;
+    int httpCode;
+    float sentiment;
+    uint32_t dnsMs;
+    uint32_t connectMs;
+    uint32_t firstByteMs;     // Anfrage gesendet -> erstes Antwortbyte
+    uint32_t totalMs;         // Start bis Ende des Body
+    uint32_t parseUs;
+    size_t headerBytes;
+    size_t payloadBytes;
+};
+
+static SemaphoreHandle_t probeMutex = NULL;
+static uint32_t probeJob = 0;
+static bool probeRunning = false;
+static bool probeReported = false;
+static unsigned long probeStartedAt = 0;
+static String probeUrl;                 // Nur geschrieben, solange kein Task laeuft
+static ApiProbeResult probeResult;
+
+// Zerlegt http://host[:port]/pfad. HTTPS kann der Test nicht, genauso wenig wie
+// der regulaere Abruf ueber den unverschluesselten WiFiClient.
+static bool parseHttpUrl(const String &url, String &host, uint16_t &port, String &path) {
+    if (!url.startsWith("http://")) return false;
+
+    int hostStart = 7;
+    int pathStart = url.indexOf('/', hostStart);
+    String authority = pathStart < 0 ? url.substring(hostStart) : url.substring(hostStart, pathStart);
+    path = pathStart < 0 ? String("/") : url.substring(pathStart);
+
+    int colon = authority.indexOf(':');
+    if (colon >= 0) {
+        host = authority.substring(0, colon);
+        port = authority.substring(colon + 1).toInt();
+    } else {
+        host = authority;
+        port = 80;
+    }
+    return host.length() > 0 && port > 0;
+}
+
+// Liest eine Header-Zeile ohne CR/LF; false bei Timeout oder Verbindungsende
+static bool readHeaderLine(WiFiClient &client, String &line, unsigned long deadline) {
+    line = "";
+    while ((long)(deadline - millis()) > 0) {
+        int c = client.read();
+        if (c < 0) {
+            if (!client.connected()) return false;
+            vTaskDelay(pdMS_TO_TICKS(2));
+            continue;
+        }
+        if (c == '\n') return true;
+        if (c != '\r') line += (char)c;
+    }
+    return false;
+}
+
+static void runProbe(ApiProbeResult &r) {
+    unsigned long start = millis();
+    unsigned long deadline = start + API_PROBE_TIMEOUT_MS;
+
+    String host, path;
+    uint16_t port;
+    if (!parseHttpUrl(probeUrl, host, port, path)) {
+        r.message = "Nur http://-URLs werden unterstuetzt";
+        return;
+    }
+
+    // DNS
+    IPAddress ip;
+    unsigned long t = millis();
+    if (!WiFi.hostByName(host.c_str(), ip)) {
+        r.message = "DNS-Aufloesung fehlgeschlagen: " + host;
+        r.totalMs = millis() - start;
+        return;
+    }
+    r.dnsMs = millis() - t;
+
+    // Verbindungsaufbau
+    WiFiClient client;
+    t = millis();
+    if (!client.connect(ip, port, API_PROBE_TIMEOUT_MS)) {
+        r.message = "Verbindungsfehler zur API";
+        r.totalMs = millis() - start;
+        return;
+    }
+    r.connectMs = millis() - t;
+
+    // HTTP/1.0: der Server antwortet ohne Chunked-Encoding und schliesst danach
+    client.print(String("GET ") + path + " HTTP/1.0\r\nHost: " + host +
+                 "\r\nUser-Agent: MoodlightClient/1.0\r\nAccept: application/json\r\n\r\n");
+    unsigned long sent = millis();
+
+    while (!client.available()) {
+        if (!client.connected() || (long)(deadline - millis()) <= 0) {
+            r.message = "Keine Antwort innerhalb von " + String(API_PROBE_TIMEOUT_MS / 1000) + " s";
+            r.totalMs = millis() - start;
+            client.stop();
+            return;
+        }
+        vTaskDelay(pdMS_TO_TICKS(2));
+    }
+    r.firstByteMs = millis() - sent;
+
+    // Statuszeile und Header
+    String line;
+    long contentLength = -1;
+    if (readHeaderLine(client, line, deadline) && line.startsWith("HTTP/")) {
+        r.httpCode = line.substring(9, 12).toInt();
+        r.headerBytes += line.length() + 2;
+        while (readHeaderLine(client, line, deadline) && line.length() > 0) {
+            r.headerBytes += line.length() + 2;
+            if (line.substring(0, 15).equalsIgnoreCase("Content-Length:")) {
+                contentLength = line.substring(15).toInt();
+            }
+        }
+        r.headerBytes += 2;
+    }
+
+    // Body: komplett zaehlen, aber nur bis API_PROBE_MAX_BODY behalten
+    String body;
+    body.reserve(contentLength > 0 && contentLength < API_PROBE_MAX_BODY ? contentLength : 1024);
+    uint8_t buf[512];
+    while ((contentLength < 0 || (long)r.payloadBytes < contentLength) && (long)(deadline - millis()) > 0) {
+        int n = client.read(buf, sizeof(buf));
+        if (n > 0) {
+            r.payloadBytes += n;
+            if (body.length() + n <= API_PROBE_MAX_BODY) {
+                body.concat((const char*)buf, n);
+            }
+        } else if (!client.connected()) {
+            break;
+        } else {
+            vTaskDelay(pdMS_TO_TICKS(2));
+        }
+    }
+    client.stop();
+    r.totalMs = millis() - start;
+
+    if (r.httpCode != 200) {
+        r.message = r.httpCode > 0 ? "HTTP Fehler: " + String(r.httpCode) : String("Ungueltige HTTP-Antwort");
+        return;
+    }
+    if (r.payloadBytes > body.length()) {
+        r.message = "Antwort groesser als " + String(API_PROBE_MAX_BODY) + " Bytes — nicht geparst";
+        return;
+    }
+
+    JsonDocument doc;
+    unsigned long parseStart = micros();
+    DeserializationError error = deserializeJson(doc, body);
+    r.parseUs = micros() - parseStart;
+
+    if (error) {
+        r.message = "JSON Parsing Fehler: " + String(error.c_str());
+    } else if (!doc["sentiment"].is<float>()) {
+        r.message = "JSON enthält keinen gültigen 'sentiment' Wert";
+    } else {
+        r.sentiment = doc["sentiment"].as<float>();
+        r.success = true;
+    }
+}
+
+static void apiProbeTask(void *) {
+    ApiProbeResult result = {};
+    runProbe(result);
+
+    xSemaphoreTake(probeMutex, portMAX_DELAY);
+    probeResult = result;
+    probeRunning = false;
+    xSemaphoreGive(probeMutex);
+
+    vTaskDelete(NULL);
+}
+
+uint32_t startApiProbe(const String &url) {
+    if (!probeMutex) {
+        probeMutex = xSemaphoreCreateMutex();
+    }
+
+    xSemaphoreTake(probeMutex, portMAX_DELAY);
+    bool running = probeRunning;
+    xSemaphoreGive(probeMutex);
+    if (running) {
+        return probeJob;
+    }
+
+    probeUrl = url;
+    probeJob++;
+    probeRunning = true;
+    probeReported = false;
+    probeStartedAt = millis();
+
+    if (xTaskCreate(apiProbeTask, "apiProbe", API_PROBE_TASK_STACK, NULL, 1, NULL) != pdPASS) {
+        probeRunning = false;
+        LOG_E("API-Test: Task konnte nicht gestartet werden");
+        return 0;
+    }
+
+    LOG_I("Teste API URL: %s", url);
+    return probeJob;
+}
+
+int apiProbeResponse(uint32_t job, String &json) {
+    if (job == 0 || job != probeJob || !probeMutex) {
+        json = "{\"status\":\"unknown\"}";
+        return 404;
+    }
+
+    JsonDocument doc;
+    doc["job"] = probeJob;
+
+    xSemaphoreTake(probeMutex, portMAX_DELAY);
+    bool running = probeRunning;
+    ApiProbeResult r = probeResult;
+    xSemaphoreGive(probeMutex);
+
+    if (running) {
+        doc["status"] = "running";
+        doc["elapsedMs"] = millis() - probeStartedAt;
+        serializeJson(doc, json);
+        return 202;
+    }
+
+    doc["status"] = "done";
+    doc["success"] = r.success;
+    doc["url"] = probeUrl;
+    if (r.success) {
+        doc["sentiment"] = r.sentiment;
+    } else {
+        doc["message"] = r.message;
+    }
+    doc["httpCode"] = r.httpCode;
+    JsonObject timing = doc["timing"].to<JsonObject>();
+    timing["dnsMs"] = r.dnsMs;
+    timing["connectMs"] = r.connectMs;
+    timing["firstByteMs"] = r.firstByteMs;
+    timing["totalMs"] = r.totalMs;
+    timing["parseUs"] = r.parseUs;
+    doc["headerBytes"] = r.headerBytes;
+    doc["payloadBytes"] = r.payloadBytes;
+    serializeJson(doc, json);
+
+    // Einmal ins Log, aus dem Webserver-Kontext
+    if (!probeReported) {
+        probeReported = true;
+        if (r.success) {
+            LOG_I("API Test erfolgreich! Sentiment: %.2f (DNS %lu ms, Connect %lu ms, TTFB %lu ms, gesamt %lu ms)",
+                  r.sentiment, r.dnsMs, r.connectMs, r.firstByteMs, r.totalMs);
+        } else {
+            LOG_W("API Test fehlgeschlagen: %s", r.message);
+        }
+    }
+    return 200;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <Arduino.h>
+
+// === API-Probe ===
+// Misst einen Abruf der Sentiment-API in einem eigenen FreeRTOS-Task: DNS,
+// Verbindungsaufbau, erstes Byte, Gesamtzeit, Payload-Groesse und JSON-Parse-Zeit.
+// Der Webserver startet die Messung nur und fragt spaeter den Stand ab — er
+// blockiert dabei nicht, LEDs und andere Clients laufen weiter.
+
+// Startet eine Messung fuer url. Laeuft bereits eine, wird deren Job-ID
+// zurueckgegeben; 0 wenn der Task nicht angelegt werden konnte.
+uint32_t startApiProbe(const String &url);
+
+// Stand eines Jobs als JSON; Rueckgabe ist der HTTP-Status
+// (200 fertig, 202 laeuft noch, 404 unbekannter Job)
+int apiProbeResponse(uint32_t job, String &json);
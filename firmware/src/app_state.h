@@ -2,6 +2,8 @@
 #define APP_STATE_H
 
 // Zentrales AppState-Struct fuer alle geteilten globalen Variablen.
+// Langlebige Zeichenketten sind FixedString (fixed_string.h) statt String: sie
+// liegen im Struct selbst, Zuweisungen gehen nie an den Heap.
 // Hardware-Library-Instanzen (pixels, dht, preferences, server, dnsServer,
 // ArduinoHA-Objekte, WiFiClient, Utility-Instanzen, JsonBufferPool)
 // gehoeren NICHT hierher — sie bleiben als separate Globals in moodlight.cpp.
@@ -10,6 +12,7 @@
 // erfolgt in Plan 02 in moodlight.cpp.
 
 #include "config.h"
+#include "fixed_string.h"
 #include <Arduino.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
@@ -19,8 +22,8 @@ struct AppState {
     // =========================================================
     // WiFi-Gruppe
     // =========================================================
-    String wifiSSID = "";
-    String wifiPassword = "";
+    FixedString<SETTINGS_SSID_LEN> wifiSSID;
+    FixedString<SETTINGS_WIFI_PASS_LEN> wifiPassword;
     bool wifiConfigured = false;
     bool isInConfigMode = false;
     bool wifiReconnectActive = false;       // Unterdrueckt pixels.show() waehrend Reconnect
@@ -63,7 +66,7 @@ struct AppState {
     // Sentiment-Gruppe
     // =========================================================
     float sentimentScore = 0.0;                              // Umbenannt von lastSentimentScore
-    String sentimentCategory = "neutral";                    // Umbenannt von lastSentimentCategory
+    FixedString<24> sentimentCategory = "neutral";           // Umbenannt von lastSentimentCategory
     unsigned long moodUpdateInterval = DEFAULT_MOOD_UPDATE_INTERVAL;
     unsigned long lastMoodUpdate = 0;
     unsigned long nextMoodPollDelay = 0;      // Servergeführtes Poll-Delay; 0 = kein Serverwert vorhanden — Fallback auf moodUpdateInterval
@@ -71,7 +74,7 @@ struct AppState {
     unsigned long lastSuccessfulSentimentUpdate = 0;
     bool sentimentAPIAvailable = true;
     int consecutiveSentimentFailures = 0;
-    String apiUrl = DEFAULT_NEWS_API_URL;
+    FixedString<SETTINGS_URL_LEN> apiUrl = DEFAULT_NEWS_API_URL;
 
     // Perzentil-Daten vom Backend (für Dashboard-Visualisierung)
     float percentile = 0.0;
@@ -89,9 +92,9 @@ struct AppState {
     // =========================================================
     // MQTT-Gruppe
     // =========================================================
-    String mqttServer = "";
-    String mqttUser = "";
-    String mqttPassword = "";
+    FixedString<SETTINGS_MQTT_LEN> mqttServer;
+    FixedString<SETTINGS_MQTT_LEN> mqttUser;
+    FixedString<SETTINGS_MQTT_LEN> mqttPassword;
     bool mqttEnabled = false;
     unsigned long lastMqttReconnectAttempt = 0;
     unsigned long lastMqttHeartbeat = 0;
@@ -114,14 +117,25 @@ struct AppState {
     // Update-Gruppe
     // =========================================================
     bool updateCheckEnabled = true;                  // Stuendliche Suche nach neuer Firmware
+    bool updatePrefetchEnabled = false;              // Freigegebene Firmware nachts vorab laden
+    uint8_t updatePrefetchRate = UPDATE_PREFETCH_DEFAULT_RATE;  // Dabei hoechstens so viele KB/s
     unsigned long lastUpdateCheck = 0;               // millis() der letzten Abfrage
     bool updateAvailable = false;                    // Backend meldet eine neuere Version
-    String updateVersion = "";                       // Version die bereitsteht, z.B. "9.17"
-    String updateReleaseUrl = "";                    // GitHub-Release-Seite fuer die Notes
-    String updateFirmwarePath = "";                  // Pfad am Backend, nicht die volle URL
+    FixedString<16> updateVersion;                   // Version die bereitsteht, z.B. "9.17"
+    FixedString<128> updateReleaseUrl;               // GitHub-Release-Seite fuer die Notes
+    FixedString<96> updateFirmwarePath;              // Pfad am Backend, nicht die volle URL
     size_t updateFirmwareSize = 0;                   // Erwartete Groesse in Bytes
+    FixedString<96> updateFirmwareGzPath;            // gzip-Variante, leer wenn keine
+    size_t updateFirmwareGzSize = 0;                 // Groesse der .gz in Bytes
+    FixedString<65> updateFirmwareSha256;            // SHA-256 des Binarys, Hex
+    FixedString<96> updateDeltaPath;                 // Patch von der laufenden Version, leer wenn keiner
+    size_t updateDeltaSize = 0;                      // Groesse des Patches in Bytes
+    size_t updateDeltaBaseSize = 0;                  // Groesse des Binarys, gegen das er gebaut ist
+    FixedString<65> updateDeltaBaseSha256;           // SHA-256 dieses Binarys, Hex
+    FixedString<96> updateUiPath;                    // Passendes UI-Archiv am Backend, leer wenn keins
+    size_t updateUiSize = 0;                         // Groesse des UI-Archivs in Bytes
     bool updateInProgress = false;                   // Laeuft gerade ein Download+Flash
-    String updateLastError = "";                     // Letzter Fehlschlag fuer die WebUI
+    FixedString<96> updateLastError;                 // Letzter Fehlschlag fuer die WebUI
 
     // =========================================================
     // System-Gruppe
@@ -136,14 +150,11 @@ struct AppState {
     bool settingsNeedSaving = false;
     unsigned long lastSettingsSaved = 0;
 
-    // =========================================================
-    // Log-Gruppe
-    // =========================================================
-    // Fix-Groesse char-Arrays statt String-Objekte — verhindert Heap-Fragmentierung
-    // durch staendiges Allokieren/Freigeben von String-Speicher im Ringpuffer.
-    static const int LOG_ENTRY_SIZE = 192;
-    char logBuffer[LOG_BUFFER_SIZE][LOG_ENTRY_SIZE];  // Ringpuffer fuer Log-Zeilen (LOG_BUFFER_SIZE aus config.h, Wert 20)
-    int logIndex = 0;      // Aktuelle Position im Ringpuffer
+    // Dauer der Boot-Phasen in setup() (fuer /api/system/metrics)
+    static const int BOOT_PHASE_MAX = 10;
+    const char *bootPhaseNames[BOOT_PHASE_MAX] = {};
+    uint32_t bootPhaseMicros[BOOT_PHASE_MAX] = {};
+    int bootPhaseCount = 0;
 
 };
 
@@ -34,10 +34,63 @@
 #define UPDATE_DOWNLOAD_TIMEOUT 60000         // Timeout fuer den Binary-Download
 #define UPDATE_MIN_FIRMWARE_SIZE 200000       // Kleiner als 200 KB ist keine AuraOS-Firmware
 #define UPDATE_MIN_FREE_HEAP 40000            // Ohne so viel freien Heap kein Flash-Versuch
+#define UPDATE_TASK_STACK 10240               // Stack des Download-Tasks in Bytes (inkl. Delta-Puffer)
+#define UPDATE_RESUME_MAX 10                  // So oft setzt ein abgerissener Download fort
+#define UPDATE_RESUME_STALL 15000             // Ohne Daten so lange: Verbindung neu aufbauen
+#define UPDATE_RESUME_WIFI_WAIT 60000         // Auf WLAN-Reconnect warten, dann aufgeben
+#define UPDATE_RESUME_DELAY 1000              // Pause vor Fortsetzung, waechst je Versuch
+#define UPDATE_PROGRESS_MQTT_MS 2000          // Fortschritt so oft an Home Assistant melden
+#define UPDATE_VERIFY_STABLE_MS 30000         // Neue Firmware so lange im Netz: bestaetigen, UI aktivieren
+#define UPDATE_VERIFY_TIMEOUT_MS 180000       // Bis dahin nicht im Netz: zurueck zur alten Firmware
+#define UPDATE_PREFETCH_HOUR_START 1          // Vorab-Laden nur nachts ab ...
+#define UPDATE_PREFETCH_HOUR_END 5            // ... bis (Ortszeit, braucht NTP)
+#define UPDATE_PREFETCH_DEFAULT_RATE 16       // KB/s beim Vorab-Laden — LEDs und MQTT bleiben fluessig
+#define UPDATE_PREFETCH_RETRY 3600000         // Nach einem Fehlschlag so lange warten
+#define UPDATE_PEER_SERVICE "moodlight-ota"   // mDNS-Dienst: Firmware fuer andere Moodlights im LAN
+#define UPDATE_PEER_MAX_TRIES 2               // So viele Geraete im LAN versuchen, dann Backend
+#define UPDATE_PEER_RESUME_MAX 1              // Fortsetzungen je Geraet — danach lieber das Backend
+#define UPDATE_PEER_SCAN_MAX 8                // So viele mDNS-Antworten werden ausgewertet
+#define UPDATE_PEER_SLICE 8192                // Bytes je loop()-Durchlauf beim Weitergeben der Firmware
+
+// Web-Server: RAM-Cache fuer die meistgeladenen UI-Dateien
+#define FILE_CACHE_MAX_ENTRIES 8              // Hoechstens so viele Dateien im RAM
+#define FILE_CACHE_MAX_BYTES 49152            // Obergrenze des Cache (48 KB)
+#define FILE_CACHE_MAX_FILE_BYTES 32768       // Groessere Dateien werden immer gestreamt (Seiten-Bundles ~27 KB)
+#define FILE_CACHE_HEAP_RESERVE 60000         // So viel Heap bleibt neben dem Cache mindestens frei
+
+// UI-Upload: Manifest und Dateiindex je installierter UI-Version
+#define UI_MAX_FILES 24                       // Hoechstens so viele Dateien je UI-Archiv (aktuell 11)
+#define UI_MANIFEST_MAX_BYTES 4096            // manifest.json wird im RAM geparst
+
+// API-Test (/testapi): Messung laeuft in einem eigenen Task
+#define API_PROBE_TIMEOUT_MS 10000            // Wie beim regulaeren Sentiment-Abruf
+#define API_PROBE_MAX_BODY 8192               // Groessere Antworten werden gezaehlt, aber nicht geparst
+#define API_PROBE_TASK_STACK 6144             // Stack des Mess-Tasks in Bytes
+
+// Einstellungen: Binaerbloecke je Abschnitt im NVS (settings_manager.cpp)
+#define SETTINGS_BLOB_MAGIC 0x5341            // "AS"
+#define SETTINGS_SCHEMA_VERSION 1             // Bei jedem neuen Feld erhoehen (settings_schema.h)
+#define SETTINGS_BLOB_MAX_BYTES 1024          // Obergrenze beim Lesen (auch fuer neuere Schemata)
+#define SETTINGS_SSID_LEN 33                  // Maximale Laengen inkl. Nullterminator
+#define SETTINGS_WIFI_PASS_LEN 65
+#define SETTINGS_URL_LEN 161
+#define SETTINGS_MQTT_LEN 65
+#define JOURNAL_MAX_RECORDS 32                // Bedienzustand-Journal: danach wird nach cfg.run verdichtet
 
 // Netzwerk
 #define DNS_PORT 53
-#define LOG_BUFFER_SIZE 20                    // Groesse des Ringpuffers
+#define WIFI_SCAN_CACHE_MS 30000              // Scan-Ergebnis 30s wiederverwenden
+#define WIFI_SCAN_TIMEOUT_MS 15000            // Laenger laeuft kein Scan — sonst gilt er als fehlgeschlagen
+
+// Logging: binaerer Ringpuffer (debug.cpp)
+#define LOG_RING_BYTES 4096                   // Groesse des Rings in Bytes (liegt im RTC-Speicher, 8 KB)
+#define LOG_CRASH_LINES 20                    // So viele Zeilen des vorherigen Boots bleiben lesbar
+#define LOG_SERIAL_DEFAULT true               // Serielle Ausgabe nach dem Boot aktiv
+#define LOG_MAX_TEXT 180                      // Laengere debug()-Texte werden gekuerzt
+#define LOG_MAX_ARGS 6                        // Argumente je LOG_E/W/I/D/T-Aufruf
+#define LOG_MAX_STRING_ARG 64                 // Zeichen je %s-Argument
+#define LOG_SERIAL_QUEUE_BYTES 2048           // Warteschlange zum Serial-Task (Zweierpotenz)
+#define LOG_SERIAL_TASK_STACK 3072            // Stack des Serial-Tasks in Bytes
 
 // Timing: Startup & Boot
 #define STARTUP_GRACE_PERIOD 15000            // 15s Grace Period nach Boot
@@ -1,16 +1,108 @@
 // ========================================================
 // Debug-Modul
 // ========================================================
-// debug()-Funktionen mit Ringpuffer-Logging und Serial-Ausgabe.
+// debug()-Funktionen mit binaerem Ringpuffer und optionaler Serial-Ausgabe.
 // floatToString()-Hilfsfunktion fuer Float-zu-String-Konvertierung.
+//
+// Der Ring speichert Eintraege variabler Laenge hintereinander: Kopf mit
+// Zeitstempel, Level, Modul und Formatstring-Zeiger, danach die Argumente roh.
+// F()-Texte kosten so 14 Bytes statt eines 192-Byte-Slots, und solange weder /logs
+// gelesen wird noch Serial aktiv ist, wird nichts formatiert. Volle Eintraege
+// werden vorne verdraengt.
+//
+// Der Ring liegt im RTC-Speicher und uebersteht Software-Reset, Panic und
+// Watchdog (nicht aber Stromausfall). Gilt er beim Start noch — Magic, gleiche
+// Firmware (ELF-SHA, sonst zeigen die Formatstring-Zeiger ins Leere) und
+// stimmige Verkettung —, wird weiter angehaengt und die Eintraege des
+// vorherigen Boots bleiben lesbar (/api/system/crashlog).
+//
+// Serial: Der Aufrufer kopiert den Eintrag nur in eine Warteschlange; ein Task
+// mit niedriger Prioritaet formatiert und schreibt ihn. Bei 115200 Baud
+// blockiert eine volle UART sonst ~13 ms je Zeile im Aufrufer.
 
-#define DEBUG_MODE  // AKTIVIERT fuer besseres Debugging
 #include "debug.h"
-#include "app_state.h"
 #include "config.h"
+#include <atomic>
+#include <esp_app_desc.h>
+#include <esp_system.h>
 
-// Zentrale AppState-Instanz (definiert in moodlight.cpp)
-extern AppState appState;
+enum LogRecordKind : uint8_t {
+    LOG_KIND_LITERAL,           // fmt ist der fertige Text (F()-Meldung)
+    LOG_KIND_TEXT,              // Text folgt kopiert hinter dem Kopf
+    LOG_KIND_FORMAT,            // fmt + Argumente
+};
+
+struct __attribute__((packed)) LogRecordHeader {
+    uint16_t size;              // Gesamtgroesse inkl. Kopf; 0 = Rest des Rings ungenutzt
+    uint8_t kind;
+    uint8_t argc;
+    uint8_t level;
+    uint8_t tag;
+    uint32_t ms;
+    const char *fmt;
+};
+
+// Argumente hinter dem Kopf: 1 Byte Typ, dann 4 Byte Wert bzw. bei
+// LOG_ARG_STR 1 Byte Laenge und die Zeichen mit Nullterminator.
+
+static const size_t LOG_LINE_BYTES = 192;   // Eine formatierte Zeile
+static const size_t LOG_MAX_RECORD_BYTES = sizeof(LogRecordHeader) + LOG_MAX_ARGS * (2 + LOG_MAX_STRING_ARG + 1);
+
+static_assert(sizeof(LogRecordHeader) + LOG_MAX_TEXT + 1 <= LOG_MAX_RECORD_BYTES,
+              "LOG_MAX_TEXT passt nicht in einen Eintrag");
+static_assert((LOG_SERIAL_QUEUE_BYTES & (LOG_SERIAL_QUEUE_BYTES - 1)) == 0,
+              "LOG_SERIAL_QUEUE_BYTES muss eine Zweierpotenz sein");
+static_assert(LOG_SERIAL_QUEUE_BYTES >= LOG_MAX_RECORD_BYTES,
+              "LOG_SERIAL_QUEUE_BYTES kleiner als ein Eintrag");
+
+static const uint32_t LOG_RTC_MAGIC = 0x4C4F4752;     // "LOGR"
+static const size_t LOG_BUILD_ID_BYTES = 8;            // Anfang des ELF-SHA-256
+
+struct LogRtcState {
+    uint32_t magic;
+    uint8_t buildId[LOG_BUILD_ID_BYTES];
+    uint32_t head;              // Naechster freier Offset
+    uint32_t tail;              // Aeltester Eintrag
+    uint32_t count;             // Eintraege im Ring
+    uint32_t boots;             // Starts, seit der Ring gueltig ist
+    uint8_t ring[LOG_RING_BYTES];
+};
+
+RTC_NOINIT_ATTR static LogRtcState rtcLog;
+static uint8_t *const logRing = rtcLog.ring;
+static uint32_t &logHead = rtcLog.head;
+static uint32_t &logTail = rtcLog.tail;
+static uint32_t &logCount = rtcLog.count;
+
+static bool ringChecked = false;        // Liegt im normalen RAM: nach jedem Reset false
+static uint32_t previousRecords = 0;    // Davon noch im Ring liegende Eintraege des letzten Boots
+static String previousBootLog;          // Formatiertes Ende des letzten Boots (captureCrashLog)
+static uint32_t previousBootLines = 0;
+
+static bool serialOutput = LOG_SERIAL_DEFAULT;
+
+// Schuetzt Ring, Warteschlangen-Kopf und Zaehler. Kurze Spinlock-Sektion statt
+// Mutex: geloggt wird aus loop() und aus Hintergrund-Tasks, gehalten wird die
+// Sperre nur fuer ein paar memcpy.
+static portMUX_TYPE logMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Warteschlange zum Serial-Task: ein Erzeuger (unter logMux), ein Verbraucher.
+// Die beiden frei laufenden Zaehler sind die einzige Synchronisation.
+static uint8_t serialQueue[LOG_SERIAL_QUEUE_BYTES];
+static std::atomic<uint32_t> serialHead{0};  // Schreibt nur der Erzeuger
+static std::atomic<uint32_t> serialTail{0};  // Schreibt nur der Serial-Task
+static TaskHandle_t serialTask = nullptr;
+
+// Standard: alles, was einkompiliert ist
+uint8_t logRuntimeLevel = LOG_COMPILE_LEVEL;
+
+static const char *const levelNames[] = {"none", "error", "warn", "info", "debug", "trace"};
+static const char levelLetters[] = "-EWIDT";
+static const char *const tagNames[LOG_TAG_COUNT] = {
+    "", "core", "led", "sensor", "web", "mqtt", "wifi", "settings", "update"
+};
+
+LogStats logStats;
 
 // === Hilfsfunktion ===
 String floatToString(float value, int decimalPlaces)
@@ -20,54 +112,539 @@ String floatToString(float value, int decimalPlaces)
     return String(buffer);
 }
 
-#ifdef DEBUG_MODE
-// === Debug-Funktion mit Logging ===
-// Verwendet fix-groesse char-Arrays im Ringpuffer statt String-Objekte.
-// Verhindert Heap-Fragmentierung durch staendiges Allokieren/Freigeben.
-void debug(const String &message) {
-    unsigned long ms = millis();
+// Liegt an offset ein Kopf oder beginnt dort die Luecke bis zum Ringende?
+static bool isGap(const uint8_t *ring, size_t offset) {
+    if (offset + sizeof(LogRecordHeader) > LOG_RING_BYTES) {
+        return true;
+    }
+    uint16_t size;
+    memcpy(&size, ring + offset, sizeof(size));
+    return size == 0;
+}
 
-    // Direkt in den Ringpuffer-Slot schreiben (kein String-Objekt, kein Heap)
-    snprintf(appState.logBuffer[appState.logIndex], AppState::LOG_ENTRY_SIZE,
-             "[%lus] %s", ms / 1000, message.c_str());
+// Verdraengt den aeltesten Eintrag (oder ueberspringt die Luecke am Ringende)
+static void dropOldest() {
+    if (isGap(logRing, logTail)) {
+        logTail = 0;
+        return;
+    }
+    uint16_t size;
+    memcpy(&size, logRing + logTail, sizeof(size));
+    logTail += size;
+    logCount--;
+    logStats.overwritten++;
+    if (previousRecords > 0) {
+        previousRecords--;
+    }
+}
 
-    // Print to Serial
-    Serial.print(appState.logBuffer[appState.logIndex]);
-    Serial.print(F(" (Mem: "));
-    Serial.print(ESP.getFreeHeap());
-    Serial.println(F(")"));
+// Passt der Ring aus dem RTC-Speicher zu dieser Firmware und ist er intakt?
+static bool rtcRingValid(const uint8_t *buildId) {
+    if (rtcLog.magic != LOG_RTC_MAGIC || memcmp(rtcLog.buildId, buildId, LOG_BUILD_ID_BYTES) != 0) {
+        return false;
+    }
+    if (logHead > LOG_RING_BYTES || logTail > LOG_RING_BYTES ||
+        logCount > LOG_RING_BYTES / sizeof(LogRecordHeader)) {
+        return false;
+    }
 
-    appState.logIndex = (appState.logIndex + 1) % LOG_BUFFER_SIZE;
+    // Kette von tail bis head nachgehen
+    size_t offset = logTail;
+    for (uint32_t n = 0; n < logCount; ) {
+        if (isGap(logRing, offset)) {
+            if (offset == 0) {
+                return false;
+            }
+            offset = 0;
+            continue;
+        }
+        LogRecordHeader header;
+        memcpy(&header, logRing + offset, sizeof(header));
+        if (header.size < sizeof(header) || header.size > LOG_MAX_RECORD_BYTES ||
+            offset + header.size > LOG_RING_BYTES || header.kind > LOG_KIND_FORMAT ||
+            header.argc > LOG_MAX_ARGS) {
+            return false;
+        }
+        offset += header.size;
+        n++;
+    }
+    return logCount == 0 || offset == logHead;
 }
 
-void debug(const __FlashStringHelper *message) {
-    unsigned long ms = millis();
+// Unter logMux, einmal je Boot vor dem ersten Zugriff auf den Ring
+static void adoptRtcRing() {
+    ringChecked = true;
+    const uint8_t *buildId = esp_app_get_description()->app_elf_sha256;
+    if (rtcRingValid(buildId)) {
+        previousRecords = logCount;
+        rtcLog.boots++;
+        return;
+    }
+    rtcLog.magic = LOG_RTC_MAGIC;
+    memcpy(rtcLog.buildId, buildId, LOG_BUILD_ID_BYTES);
+    logHead = logTail = logCount = 0;
+    rtcLog.boots = 0;
+    previousRecords = 0;
+}
 
-    // Direkt in den Ringpuffer-Slot schreiben (kein String-Objekt, kein Heap)
-    snprintf(appState.logBuffer[appState.logIndex], AppState::LOG_ENTRY_SIZE,
-             "[%lus] %s", ms / 1000, (const char*)message);
+// Reserviert size zusammenhaengende Bytes und gibt den Zeiger darauf zurueck
+static uint8_t *reserve(size_t size) {
+    if (!ringChecked) {
+        adoptRtcRing();
+    }
+    if (logCount == 0) {
+        logHead = logTail = 0;
+    }
+    if (logHead + size > LOG_RING_BYTES) {
+        // Passt nicht mehr bis zum Ende: alles dahinter verwerfen, Luecke
+        // markieren und vorne weiterschreiben
+        while (logCount > 0 && logTail >= logHead) {
+            dropOldest();
+        }
+        if (logHead + sizeof(uint16_t) <= LOG_RING_BYTES) {
+            memset(logRing + logHead, 0, sizeof(uint16_t));
+        }
+        logHead = 0;
+    }
+    // Eintraege verdraengen, die im neuen Bereich beginnen
+    while (logCount > 0 && logTail >= logHead && logTail < logHead + size) {
+        dropOldest();
+    }
 
-    // Print to Serial
-    Serial.print(appState.logBuffer[appState.logIndex]);
-    Serial.print(F(" (Mem: "));
-    Serial.print(ESP.getFreeHeap());
-    Serial.println(F(")"));
+    uint8_t *ptr = logRing + logHead;
+    logHead += size;
+    logCount++;
+    logStats.records++;
+    logStats.bytesLogged += size;
+    return ptr;
+}
+
+// Schreibt fmt mit den Argumenten aus data nach out; gibt die Laenge zurueck
+static size_t formatArgs(const char *fmt, const uint8_t *data, uint8_t argc, char *out, size_t outSize) {
+    size_t len = 0;
+    uint8_t used = 0;
+    const char *p = fmt;
+
+    while (*p && len + 1 < outSize) {
+        if (*p != '%') {
+            out[len++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            out[len++] = '%';
+            p += 2;
+            continue;
+        }
+
+        // Spezifikation ohne Laengenangabe nachbauen: %[flags][breite][.genauigkeit]
+        char spec[16];
+        size_t specLen = 0;
+        const char *start = p++;
+        spec[specLen++] = '%';
+        while (*p && strchr("-+ #0123456789.", *p) && specLen < sizeof(spec) - 5) {
+            spec[specLen++] = *p++;
+        }
+        while (*p && strchr("hlzjt", *p)) {
+            p++;
+        }
+        char conv = *p ? *p++ : '\0';
 
-    appState.logIndex = (appState.logIndex + 1) % LOG_BUFFER_SIZE;
+        if (used >= argc || !strchr("diuxXcsfeEgG", conv)) {
+            // Kein Argument mehr oder unbekannt: Spezifikation unveraendert ausgeben
+            size_t n = min((size_t)(p - start), outSize - 1 - len);
+            memcpy(out + len, start, n);
+            len += n;
+            continue;
+        }
+
+        LogArgType type = (LogArgType)*data++;
+        used++;
+        int n = 0;
+        size_t room = outSize - len;
+        if (type == LOG_ARG_STR) {
+            uint8_t strLen = *data++;
+            const char *str = (const char*)data;
+            data += strLen + 1;
+            spec[specLen++] = 's';
+            spec[specLen] = '\0';
+            n = snprintf(out + len, room, spec, str);
+        } else {
+            uint32_t raw;
+            memcpy(&raw, data, sizeof(raw));
+            data += sizeof(raw);
+            if (conv == 's') {
+                // Zahl fuer %s: wie String(x), Gleitkomma mit zwei Stellen
+                conv = type == LOG_ARG_FLOAT ? 'f' : type == LOG_ARG_INT ? 'd' : 'u';
+                if (conv == 'f' && !memchr(spec, '.', specLen)) {
+                    spec[specLen++] = '.';
+                    spec[specLen++] = '2';
+                }
+            }
+            if (strchr("feEgG", conv)) {
+                float f;
+                if (type == LOG_ARG_FLOAT) {
+                    memcpy(&f, &raw, sizeof(f));
+                } else {
+                    f = type == LOG_ARG_INT ? (float)(int32_t)raw : (float)raw;
+                }
+                spec[specLen++] = conv;
+                spec[specLen] = '\0';
+                n = snprintf(out + len, room, spec, (double)f);
+            } else {
+                long value = type == LOG_ARG_FLOAT ? 0 : (long)(int32_t)raw;
+                if (conv != 'c') spec[specLen++] = 'l';
+                spec[specLen++] = conv;
+                spec[specLen] = '\0';
+                n = snprintf(out + len, room, spec, value);
+            }
+        }
+        if (n > 0) {
+            len += min((size_t)n, room - 1);
+        }
+    }
+    out[len] = '\0';
+    return len;
 }
-#else
 
-void debug(const String &message) {
-    if (message.startsWith("ERROR:") || message.startsWith("CRITICAL:")) {
-        Serial.println(message);
+// Formatiert einen Eintrag als "[123s] I led: Text"
+static size_t formatRecord(const uint8_t *record, char *out, size_t outSize) {
+    LogRecordHeader header;
+    memcpy(&header, record, sizeof(header));
+    const uint8_t *data = record + sizeof(header);
+
+    uint8_t level = header.level <= LOG_LEVEL_TRACE ? header.level : (uint8_t)LOG_LEVEL_NONE;
+    const char *tag = header.tag < LOG_TAG_COUNT ? tagNames[header.tag] : "?";
+    int prefix = snprintf(out, outSize, "[%lus] %c %s%s", (unsigned long)(header.ms / 1000),
+                          levelLetters[level], tag, *tag ? ": " : "");
+    size_t len = prefix > 0 ? min((size_t)prefix, outSize - 1) : 0;
+
+    switch (header.kind) {
+        case LOG_KIND_LITERAL:
+            len += strlcpy(out + len, header.fmt, outSize - len);
+            break;
+        case LOG_KIND_TEXT:
+            len += strlcpy(out + len, (const char*)data, outSize - len);
+            break;
+        default:
+            len += formatArgs(header.fmt, data, header.argc, out + len, outSize - len);
+            break;
     }
+    return min(len, outSize - 1);
+}
+
+// === Serial-Warteschlange ===
+static void queueCopyIn(uint32_t pos, const uint8_t *src, size_t len) {
+    size_t offset = pos & (LOG_SERIAL_QUEUE_BYTES - 1);
+    size_t first = min(len, LOG_SERIAL_QUEUE_BYTES - offset);
+    memcpy(serialQueue + offset, src, first);
+    memcpy(serialQueue, src + first, len - first);
+}
+
+static void queueCopyOut(uint32_t pos, uint8_t *dst, size_t len) {
+    size_t offset = pos & (LOG_SERIAL_QUEUE_BYTES - 1);
+    size_t first = min(len, LOG_SERIAL_QUEUE_BYTES - offset);
+    memcpy(dst, serialQueue + offset, first);
+    memcpy(dst + first, serialQueue, len - first);
+}
+
+// Unter logMux: Eintrag in die Warteschlange kopieren oder verwerfen.
+// true, wenn die Warteschlange vorher leer war — dann schlaeft der Serial-Task
+// womoeglich und muss nach dem Verlassen der Sperre geweckt werden.
+static bool enqueueSerial(const uint8_t *record, size_t size) {
+    if (!serialOutput) {
+        return false;
+    }
+    uint32_t head = serialHead.load(std::memory_order_relaxed);
+    uint32_t tail = serialTail.load(std::memory_order_acquire);
+    if (LOG_SERIAL_QUEUE_BYTES - (head - tail) < size) {
+        logStats.serialDropped++;
+        return false;
+    }
+    queueCopyIn(head, record, size);
+    serialHead.store(head + size, std::memory_order_release);
+    return head == tail;
+}
+
+// Ausserhalb von logMux: In einer Critical Section darf keine Task-API laufen.
+// Vor startLogWriter() gibt es niemanden zu wecken; der Task leert beim Start
+// zuerst, was bis dahin aufgelaufen ist.
+static void wakeSerialWriter() {
+    TaskHandle_t task = serialTask;
+    if (task) {
+        xTaskNotifyGive(task);
+    }
+}
+
+static void serialWriterTask(void *) {
+    uint8_t record[LOG_MAX_RECORD_BYTES];
+    char line[LOG_LINE_BYTES];
+
+    for (;;) {
+        uint32_t tail = serialTail.load(std::memory_order_relaxed);
+        if (tail == serialHead.load(std::memory_order_acquire)) {
+            // Schlafen bis zum naechsten Eintrag. Kam er zwischen Pruefung und
+            // Warten, ist die Benachrichtigung schon da und es geht sofort weiter.
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+        uint16_t size;
+        queueCopyOut(tail, (uint8_t*)&size, sizeof(size));
+        queueCopyOut(tail, record, size);
+        serialTail.store(tail + size, std::memory_order_release);
+
+        formatRecord(record, line, sizeof(line));
+        Serial.println(line);
+        logStats.serialWritten++;
+    }
+}
+
+// Laufzeit eines Log-Aufrufs in CPU-Takten; unter logMux
+static void recordLatency(uint32_t startCycles) {
+    uint32_t cycles = ESP.getCycleCount() - startCycles;
+    logStats.calls++;
+    logStats.totalCycles += cycles;
+    if (cycles > logStats.maxCycles) {
+        logStats.maxCycles = cycles;
+    }
+}
+
+static void writeText(LogRecordKind kind, const char *fmt, const char *text, size_t textLen) {
+    if (!logLevelEnabled(LOG_LEVEL_INFO)) {
+        return;
+    }
+    uint32_t start = ESP.getCycleCount();
+    bool truncated = textLen > LOG_MAX_TEXT;
+    if (truncated) {
+        textLen = LOG_MAX_TEXT;
+    }
+    size_t size = sizeof(LogRecordHeader) + (kind == LOG_KIND_TEXT ? textLen + 1 : 0);
+    LogRecordHeader header = {(uint16_t)size, kind, 0, LOG_LEVEL_INFO, LOG_TAG_NONE, (uint32_t)millis(), fmt};
+
+    portENTER_CRITICAL(&logMux);
+    uint8_t *record = reserve(size);
+    memcpy(record, &header, sizeof(header));
+    if (kind == LOG_KIND_TEXT) {
+        memcpy(record + sizeof(header), text, textLen);
+        record[sizeof(header) + textLen] = '\0';
+    }
+    bool wake = enqueueSerial(record, size);
+    logStats.perLevel[LOG_LEVEL_INFO]++;
+    if (truncated) {
+        logStats.truncatedArgs++;
+    }
+    recordLatency(start);
+    portEXIT_CRITICAL(&logMux);
+    if (wake) {
+        wakeSerialWriter();
+    }
+}
+
+// === Debug-Funktionen ===
+void debug(const String &message) {
+    writeText(LOG_KIND_TEXT, nullptr, message.c_str(), message.length());
+}
+
+void debug(const char *message) {
+    writeText(LOG_KIND_TEXT, nullptr, message, strlen(message));
 }
 
 void debug(const __FlashStringHelper *message) {
-    // Optional: Nur kritische Meldungen
-    if (strstr_P((PGM_P)message, PSTR("ERROR:")) || strstr_P((PGM_P)message, PSTR("CRITICAL:"))) {
-        Serial.println(message);
+    writeText(LOG_KIND_LITERAL, (const char*)message, nullptr, 0);
+}
+
+void logWrite(LogLevel level, LogTag tag, const char *fmt, const LogArg *args, uint8_t argc) {
+    uint32_t start = ESP.getCycleCount();
+    uint8_t truncated = 0;
+    if (argc > LOG_MAX_ARGS) {
+        argc = LOG_MAX_ARGS;
+        truncated++;
+    }
+
+    // Groesse vorab bestimmen — der Eintrag wird in einem Stueck reserviert
+    size_t size = sizeof(LogRecordHeader);
+    size_t strLens[LOG_MAX_ARGS];
+    for (uint8_t i = 0; i < argc; i++) {
+        if (args[i].type == LOG_ARG_STR) {
+            strLens[i] = strlen(args[i].s);
+            if (strLens[i] > LOG_MAX_STRING_ARG) {
+                strLens[i] = LOG_MAX_STRING_ARG;
+                truncated++;
+            }
+            size += 2 + strLens[i] + 1;
+        } else {
+            size += 1 + sizeof(uint32_t);
+        }
+    }
+
+    LogRecordHeader header = {(uint16_t)size, LOG_KIND_FORMAT, argc, level, tag, (uint32_t)millis(), fmt};
+
+    portENTER_CRITICAL(&logMux);
+    uint8_t *record = reserve(size);
+    memcpy(record, &header, sizeof(header));
+    uint8_t *data = record + sizeof(header);
+    for (uint8_t i = 0; i < argc; i++) {
+        *data++ = args[i].type;
+        if (args[i].type == LOG_ARG_STR) {
+            *data++ = (uint8_t)strLens[i];
+            memcpy(data, args[i].s, strLens[i]);
+            data[strLens[i]] = '\0';
+            data += strLens[i] + 1;
+        } else {
+            memcpy(data, &args[i].u, sizeof(uint32_t));
+            data += sizeof(uint32_t);
+        }
+    }
+    bool wake = enqueueSerial(record, size);
+    if (level <= LOG_LEVEL_TRACE) {
+        logStats.perLevel[level]++;
+    }
+    logStats.truncatedArgs += truncated;
+    recordLatency(start);
+    portEXIT_CRITICAL(&logMux);
+    if (wake) {
+        wakeSerialWriter();
+    }
+}
+
+void formatLogs(String &out) {
+    // Kopie unter der Sperre, formatiert wird ohne — das dauert Millisekunden
+    uint8_t *snapshot = (uint8_t*)malloc(LOG_RING_BYTES);
+    if (!snapshot) {
+        out += F("Log: zu wenig Speicher fuer die Ausgabe\n");
+        return;
+    }
+    portENTER_CRITICAL(&logMux);
+    if (!ringChecked) {
+        adoptRtcRing();
+    }
+    memcpy(snapshot, logRing, LOG_RING_BYTES);
+    size_t offset = logTail;
+    size_t count = logCount;
+    portEXIT_CRITICAL(&logMux);
+
+    out.reserve(out.length() + count * 64);
+    char line[LOG_LINE_BYTES];
+    for (size_t n = 0; n < count; ) {
+        if (isGap(snapshot, offset)) {
+            offset = 0;
+            continue;
+        }
+        uint16_t size;
+        memcpy(&size, snapshot + offset, sizeof(size));
+        formatRecord(snapshot + offset, line, sizeof(line));
+        out += line;
+        out += '\n';
+        offset += size;
+        n++;
+    }
+    free(snapshot);
+}
+
+void startLogWriter() {
+    if (serialTask) {
+        return;
+    }
+    if (xTaskCreate(serialWriterTask, "logSerial", LOG_SERIAL_TASK_STACK, NULL,
+                    tskIDLE_PRIORITY + 1, &serialTask) != pdPASS) {
+        serialTask = nullptr;
+        Serial.println(F("Log: Serial-Task konnte nicht gestartet werden"));
+    }
+}
+
+void setLogSerial(bool enabled) {
+    serialOutput = enabled;
+}
+
+bool logSerialEnabled() {
+    return serialOutput;
+}
+
+void setLogLevel(LogLevel level) {
+    logRuntimeLevel = level;
+}
+
+LogLevel logLevel() {
+    return (LogLevel)logRuntimeLevel;
+}
+
+const char *logLevelName(uint8_t level) {
+    return level <= LOG_LEVEL_TRACE ? levelNames[level] : "?";
+}
+
+bool parseLogLevel(const char *name, LogLevel &level) {
+    for (uint8_t i = 0; i <= LOG_LEVEL_TRACE; i++) {
+        if (strcasecmp(name, levelNames[i]) == 0 || (name[0] == '0' + i && name[1] == '\0')) {
+            level = (LogLevel)i;
+            return true;
+        }
     }
+    return false;
 }
 
-#endif
+// === Absturz-Log ===
+void captureCrashLog() {
+    uint8_t *snapshot = (uint8_t*)malloc(LOG_RING_BYTES);
+    if (!snapshot) {
+        return;
+    }
+    portENTER_CRITICAL(&logMux);
+    if (!ringChecked) {
+        adoptRtcRing();
+    }
+    memcpy(snapshot, logRing, LOG_RING_BYTES);
+    size_t offset = logTail;
+    uint32_t count = previousRecords;
+    portEXIT_CRITICAL(&logMux);
+
+    // Nur die letzten LOG_CRASH_LINES Eintraege vor dem Reset
+    uint32_t skip = count > LOG_CRASH_LINES ? count - LOG_CRASH_LINES : 0;
+    previousBootLog = "";
+    previousBootLog.reserve((count - skip) * 64);
+    previousBootLines = 0;
+    char line[LOG_LINE_BYTES];
+    for (uint32_t n = 0; n < count; ) {
+        if (isGap(snapshot, offset)) {
+            offset = 0;
+            continue;
+        }
+        uint16_t size;
+        memcpy(&size, snapshot + offset, sizeof(size));
+        if (n >= skip) {
+            formatRecord(snapshot + offset, line, sizeof(line));
+            previousBootLog += line;
+            previousBootLog += '\n';
+            previousBootLines++;
+        }
+        offset += size;
+        n++;
+    }
+    free(snapshot);
+}
+
+const String &crashLogLines() {
+    return previousBootLog;
+}
+
+uint32_t crashLogLineCount() {
+    return previousBootLines;
+}
+
+uint32_t logRingBoots() {
+    return rtcLog.boots;
+}
+
+const char *resetReasonName() {
+    switch (esp_reset_reason()) {
+        case ESP_RST_POWERON: return "poweron";
+        case ESP_RST_EXT: return "external";
+        case ESP_RST_SW: return "software";
+        case ESP_RST_PANIC: return "panic";
+        case ESP_RST_INT_WDT: return "int_wdt";
+        case ESP_RST_TASK_WDT: return "task_wdt";
+        case ESP_RST_WDT: return "wdt";
+        case ESP_RST_DEEPSLEEP: return "deepsleep";
+        case ESP_RST_BROWNOUT: return "brownout";
+        case ESP_RST_SDIO: return "sdio";
+        default: return "unknown";
+    }
+}
@@ -2,10 +2,201 @@
 #define DEBUG_H
 
 #include <Arduino.h>
+#include "fixed_string.h"
 
-// Debug-Logging mit Ringpuffer und Serial-Ausgabe
-void debug(const String &message);
-void debug(const __FlashStringHelper *message);
+// Debug-Logging in einen binaeren Ringpuffer (debug.cpp).
+// Ein Eintrag speichert Zeitstempel, Level, Modul, Zeiger auf den Formatstring und
+// die rohen Argumente. Formatiert wird erst, wenn /logs gelesen wird oder die
+// serielle Ausgabe aktiv ist.
+void debug(const String &message);              // Text wird kopiert
+void debug(const char *message);                // Text wird kopiert, kein String-Umweg
+void debug(const __FlashStringHelper *message); // Nur der Zeiger wird gespeichert
+
+// === Level und Modul-Tags ===
+// LOG_E/LOG_W/LOG_I/LOG_D/LOG_T("Sentiment %.2f, LED %d", score, index);
+// fmt muss ein Literal sein — gespeichert wird nur der Zeiger.
+// Unterstuetzt %d %i %u %x %X %c %s %f %e %g mit Flags, Breite und Genauigkeit;
+// Laengenangaben (l, h, z) sind erlaubt und werden ignoriert. %s nimmt auch
+// Zahlen und gibt sie wie String(x) aus. Zeichenketten werden beim Aufruf
+// kopiert (hoechstens LOG_MAX_STRING_ARG Zeichen).
+// Hoechstens LOG_MAX_ARGS Argumente.
+//
+// Ein Modul setzt nach seinen Includes sein Tag:
+//   #define LOG_TAG LOG_TAG_LED
+//
+// Level oberhalb von LOG_COMPILE_LEVEL (bzw. LOG_COMPILE_LEVEL_<MODUL>) werden
+// per if constexpr verworfen — Formatstring und Argumente landen nicht im
+// Binary. Alles darunter prueft zur Laufzeit gegen logLevel()
+// (/api/system/loglevel). debug() ohne Level zaehlt als LOG_LEVEL_INFO.
+
+enum LogLevel : uint8_t {
+    LOG_LEVEL_NONE,
+    LOG_LEVEL_ERROR,
+    LOG_LEVEL_WARN,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_DEBUG,
+    LOG_LEVEL_TRACE,
+};
+
+enum LogTag : uint8_t {
+    LOG_TAG_NONE,               // debug() ohne Modul
+    LOG_TAG_CORE,
+    LOG_TAG_LED,
+    LOG_TAG_SENSOR,
+    LOG_TAG_WEB,
+    LOG_TAG_MQTT,
+    LOG_TAG_WIFI,
+    LOG_TAG_SETTINGS,
+    LOG_TAG_UPDATE,
+    LOG_TAG_COUNT
+};
+
+// Obergrenze im Binary — Produktions-Build ohne Debug/Trace siehe platformio.ini
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LEVEL_TRACE
+#endif
+#ifndef LOG_COMPILE_LEVEL_CORE
+#define LOG_COMPILE_LEVEL_CORE LOG_COMPILE_LEVEL
+#endif
+#ifndef LOG_COMPILE_LEVEL_LED
+#define LOG_COMPILE_LEVEL_LED LOG_COMPILE_LEVEL
+#endif
+#ifndef LOG_COMPILE_LEVEL_SENSOR
+#define LOG_COMPILE_LEVEL_SENSOR LOG_COMPILE_LEVEL
+#endif
+#ifndef LOG_COMPILE_LEVEL_WEB
+#define LOG_COMPILE_LEVEL_WEB LOG_COMPILE_LEVEL
+#endif
+#ifndef LOG_COMPILE_LEVEL_MQTT
+#define LOG_COMPILE_LEVEL_MQTT LOG_COMPILE_LEVEL
+#endif
+#ifndef LOG_COMPILE_LEVEL_WIFI
+#define LOG_COMPILE_LEVEL_WIFI LOG_COMPILE_LEVEL
+#endif
+#ifndef LOG_COMPILE_LEVEL_SETTINGS
+#define LOG_COMPILE_LEVEL_SETTINGS LOG_COMPILE_LEVEL
+#endif
+#ifndef LOG_COMPILE_LEVEL_UPDATE
+#define LOG_COMPILE_LEVEL_UPDATE LOG_COMPILE_LEVEL
+#endif
+
+constexpr uint8_t logCompileLevel(LogTag tag) {
+    return tag == LOG_TAG_CORE ? LOG_COMPILE_LEVEL_CORE
+         : tag == LOG_TAG_LED ? LOG_COMPILE_LEVEL_LED
+         : tag == LOG_TAG_SENSOR ? LOG_COMPILE_LEVEL_SENSOR
+         : tag == LOG_TAG_WEB ? LOG_COMPILE_LEVEL_WEB
+         : tag == LOG_TAG_MQTT ? LOG_COMPILE_LEVEL_MQTT
+         : tag == LOG_TAG_WIFI ? LOG_COMPILE_LEVEL_WIFI
+         : tag == LOG_TAG_SETTINGS ? LOG_COMPILE_LEVEL_SETTINGS
+         : tag == LOG_TAG_UPDATE ? LOG_COMPILE_LEVEL_UPDATE
+         : LOG_COMPILE_LEVEL;
+}
+
+// Modul ohne eigenes Tag
+static constexpr LogTag LOG_TAG = LOG_TAG_NONE;
+
+// Laufzeit-Schwelle; ein Byte-Vergleich vor jedem Eintrag
+extern uint8_t logRuntimeLevel;
+inline bool logLevelEnabled(uint8_t level) { return level <= logRuntimeLevel; }
+
+void setLogLevel(LogLevel level);
+LogLevel logLevel();
+const char *logLevelName(uint8_t level);
+bool parseLogLevel(const char *name, LogLevel &level);   // "debug" oder "4"
+
+enum LogArgType : uint8_t {
+    LOG_ARG_INT,
+    LOG_ARG_UINT,
+    LOG_ARG_FLOAT,
+    LOG_ARG_STR,
+};
+
+struct LogArg {
+    LogArgType type;
+    union {
+        int32_t i;
+        uint32_t u;
+        float f;
+        const char *s;
+    };
+};
+
+inline LogArg logArg(int v) { LogArg a; a.type = LOG_ARG_INT; a.i = v; return a; }
+inline LogArg logArg(long v) { LogArg a; a.type = LOG_ARG_INT; a.i = v; return a; }
+inline LogArg logArg(unsigned int v) { LogArg a; a.type = LOG_ARG_UINT; a.u = v; return a; }
+inline LogArg logArg(unsigned long v) { LogArg a; a.type = LOG_ARG_UINT; a.u = v; return a; }
+inline LogArg logArg(char v) { return logArg((int)v); }
+inline LogArg logArg(unsigned char v) { return logArg((unsigned int)v); }
+inline LogArg logArg(short v) { return logArg((int)v); }
+inline LogArg logArg(unsigned short v) { return logArg((unsigned int)v); }
+inline LogArg logArg(bool v) { return logArg((int)v); }
+inline LogArg logArg(float v) { LogArg a; a.type = LOG_ARG_FLOAT; a.f = v; return a; }
+inline LogArg logArg(double v) { return logArg((float)v); }
+inline LogArg logArg(const char *v) { LogArg a; a.type = LOG_ARG_STR; a.s = v ? v : ""; return a; }
+inline LogArg logArg(const String &v) { return logArg(v.c_str()); }
+template <size_t N>
+inline LogArg logArg(const FixedString<N> &v) { return logArg(v.c_str()); }
+
+void logWrite(LogLevel level, LogTag tag, const char *fmt, const LogArg *args, uint8_t argc);
+
+template <typename... Args>
+inline void logFormat(LogLevel level, LogTag tag, const char *fmt, const Args &... args) {
+    LogArg packed[sizeof...(Args) + 1] = {logArg(args)...};
+    logWrite(level, tag, fmt, packed, sizeof...(Args));
+}
+
+#define LOG_AT(level, fmt, ...)                                         \
+    do {                                                                \
+        if constexpr ((level) <= logCompileLevel(LOG_TAG)) {            \
+            if (logLevelEnabled(level)) {                               \
+                logFormat((level), LOG_TAG, fmt, ##__VA_ARGS__);        \
+            }                                                           \
+        }                                                               \
+    } while (0)
+
+#define LOG_E(fmt, ...) LOG_AT(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#define LOG_W(fmt, ...) LOG_AT(LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#define LOG_I(fmt, ...) LOG_AT(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define LOG_D(fmt, ...) LOG_AT(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#define LOG_T(fmt, ...) LOG_AT(LOG_LEVEL_TRACE, fmt, ##__VA_ARGS__)
+
+// Alle gespeicherten Eintraege formatiert, aelteste zuerst, je Zeile ein "\n"
+void formatLogs(String &out);
+
+// Serielle Ausgabe ein/aus (Standard: LOG_SERIAL_DEFAULT aus config.h).
+// Aus bedeutet: nichts wird beim Loggen formatiert.
+void setLogSerial(bool enabled);
+bool logSerialEnabled();
+
+// Startet den Task, der die Serial-Warteschlange formatiert und ausgibt.
+// Was vorher geloggt wurde, wartet in der Warteschlange und erscheint, sobald
+// der Task laeuft. Nur was bei voller Warteschlange kommt, bleibt allein im Ring.
+void startLogWriter();
+
+// === Absturz-Log ===
+// Der Ring uebersteht Resets (RTC-Speicher, siehe debug.cpp). captureCrashLog()
+// formatiert frueh in setup() die letzten LOG_CRASH_LINES Eintraege des
+// vorherigen Boots, bevor neue sie verdraengen.
+void captureCrashLog();
+const String &crashLogLines();          // Leer nach Stromausfall/neuer Firmware
+uint32_t crashLogLineCount();
+uint32_t logRingBoots();                // Starts, seit der Ring gueltig ist
+const char *resetReasonName();          // esp_reset_reason() als Text
+
+// Kennzahlen fuer /api/system/metrics
+struct LogStats {
+    uint32_t records = 0;              // Eintraege seit Boot
+    uint32_t overwritten = 0;          // Vom Ring verdraengte Eintraege
+    uint32_t bytesLogged = 0;          // Geschriebene Bytes im Ring
+    uint32_t truncatedArgs = 0;        // Gekuerzte Texte/Argumente
+    uint32_t perLevel[LOG_LEVEL_TRACE + 1] = {};  // Eintraege je Level
+    uint32_t serialWritten = 0;        // Vom Serial-Task ausgegebene Zeilen
+    uint32_t serialDropped = 0;        // Warteschlange voll, nicht ausgegeben
+    uint32_t calls = 0;                // Gemessene Log-Aufrufe
+    uint64_t totalCycles = 0;          // CPU-Takte aller Log-Aufrufe
+    uint32_t maxCycles = 0;            // Laengster Log-Aufruf in Takten
+};
+extern LogStats logStats;
 
 // Hilfsfunktion fuer Float-zu-String-Konvertierung
 String floatToString(float value, int decimalPlaces);
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <Arduino.h>
+
+// === FixedString ===
+// Zeichenkette mit fester Kapazitaet direkt im Objekt, fuer langlebigen Zustand
+// in AppState. Zuweisen kopiert in den eigenen Puffer — kein malloc/free, also
+// auch keine Heap-Fragmentierung, egal wie oft sich der Wert aendert. Zu lange
+// Werte werden abgeschnitten (truncated() meldet das).
+//
+// N ist die Kapazitaet inklusive Nullterminator, passend zu den
+// SETTINGS_*_LEN-Laengen in config.h.
+//
+// Fuer bestehenden Code verhaelt sich FixedString weitgehend wie String:
+// Vergleiche, isEmpty()/length()/c_str() und die implizite Umwandlung nach
+// String (z.B. fuer String + FixedString oder debug()). Die Umwandlung legt
+// einen temporaeren String an — fuer ArduinoJson und Bibliotheken mit
+// const char* deshalb c_str() verwenden.
+template <size_t N>
+class FixedString {
+public:
+    static_assert(N > 1, "FixedString braucht Platz fuer mindestens ein Zeichen");
+
+    FixedString() { clear(); }
+    FixedString(const char *value) { assign(value); }
+    FixedString(const FixedString &other) = default;
+
+    FixedString &operator=(const FixedString &other) = default;
+    FixedString &operator=(const char *value) { assign(value); return *this; }
+    FixedString &operator=(const String &value) { assign(value.c_str(), value.length()); return *this; }
+    FixedString &operator=(const __FlashStringHelper *value) { assign(reinterpret_cast<const char*>(value)); return *this; }
+
+    // Kopiert hoechstens N-1 Zeichen; false wenn gekuerzt wurde
+    bool assign(const char *value) {
+        return assign(value, value ? strlen(value) : 0);
+    }
+
+    bool assign(const char *value, size_t len) {
+        _truncated = len >= N;
+        _length = _truncated ? N - 1 : len;
+        if (_length > 0) {
+            memmove(_data, value, _length);
+        }
+        _data[_length] = '\0';
+        return !_truncated;
+    }
+
+    void clear() {
+        _data[0] = '\0';
+        _length = 0;
+        _truncated = false;
+    }
+
+    const char *c_str() const { return _data; }
+    size_t length() const { return _length; }
+    bool isEmpty() const { return _length == 0; }
+    bool truncated() const { return _truncated; }
+    static constexpr size_t capacity() { return N - 1; }
+
+    operator String() const { return String(_data); }
+
+    bool operator==(const char *other) const { return strcmp(_data, other ? other : "") == 0; }
+    bool operator==(const String &other) const { return _length == other.length() && *this == other.c_str(); }
+    template <size_t M>
+    bool operator==(const FixedString<M> &other) const { return *this == other.c_str(); }
+    bool operator!=(const char *other) const { return !(*this == other); }
+    bool operator!=(const String &other) const { return !(*this == other); }
+    template <size_t M>
+    bool operator!=(const FixedString<M> &other) const { return !(*this == other); }
+
+private:
+    char _data[N];
+    uint16_t _length;
+    bool _truncated;
+};
+
+template <size_t N>
+bool operator==(const String &lhs, const FixedString<N> &rhs) { return rhs == lhs; }
+template <size_t N>
+bool operator!=(const String &lhs, const FixedString<N> &rhs) { return rhs != lhs; }
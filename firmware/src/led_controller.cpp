@@ -1,6 +1,8 @@
 #include "led_controller.h"
 #include "debug.h"
 
+#define LOG_TAG LOG_TAG_LED
+
 extern AppState appState;
 
 // Hardware-Instanz. Wird in initPixels() mit den echten Parametern erzeugt —
@@ -96,12 +98,9 @@ void updateLEDs() {
     uint8_t g = (colorToShow >> 8) & 0xFF;
     uint8_t b = colorToShow & 0xFF;
 
-    char debugBuffer[100];
-    snprintf(debugBuffer, sizeof(debugBuffer),
-             "LEDs update requested: %s B=%d RGB(%d,%d,%d)",
-             (appState.autoMode ? "Auto" : "Manual"),
-             brightnessToShow, r, g, b);
-    debug(debugBuffer);
+    LOG_D("LEDs update requested: %s B=%d RGB(%d,%d,%d)",
+          (appState.autoMode ? "Auto" : "Manual"),
+          brightnessToShow, r, g, b);
 }
 
 // === Status-LED Funktionen ===
@@ -119,21 +118,16 @@ static const char* statusLedModeName(int mode) {
 void setStatusLED(int mode) {
     int prevMode = appState.statusLedMode;
     if (mode != prevMode) {
-        char logBuffer[112];
         unsigned long activeSecs = (millis() - appState.statusLedModeSince) / 1000UL;
         if (prevMode == 0) {
-            snprintf(logBuffer, sizeof(logBuffer),
-                     "Status-LED: Blinken AN — %s", statusLedModeName(mode));
+            LOG_I("Status-LED: Blinken AN — %s", statusLedModeName(mode));
         } else if (mode == 0) {
-            snprintf(logBuffer, sizeof(logBuffer),
-                     "Status-LED: Blinken AUS (war: %s, Dauer %lus)",
-                     statusLedModeName(prevMode), activeSecs);
+            LOG_I("Status-LED: Blinken AUS (war: %s, Dauer %lus)",
+                  statusLedModeName(prevMode), activeSecs);
         } else {
-            snprintf(logBuffer, sizeof(logBuffer),
-                     "Status-LED: Wechsel %s → %s (nach %lus)",
-                     statusLedModeName(prevMode), statusLedModeName(mode), activeSecs);
+            LOG_I("Status-LED: Wechsel %s → %s (nach %lus)",
+                  statusLedModeName(prevMode), statusLedModeName(mode), activeSecs);
         }
-        debug(logBuffer);
         appState.statusLedModeSince = millis();
     }
 
@@ -301,13 +295,13 @@ void initFirstLEDUpdate() {
         xSemaphoreGive(appState.ledMutex);
     }
     appState.firstLedShowDone = true;
-    debug(F("First LED update scheduled"));
+    LOG_I("First LED update scheduled");
 
     // Direkt danach den tatsaechlichen Zustand ausgeben. Ohne diesen Aufruf
     // bleibt der Ring nach dem Loeschen dunkel, bis zufaellig ein Ereignis
     // (Web-Klick, MQTT-Befehl, Sentiment-Abruf) updateLEDs() ausloest — beim
     // 30-Minuten-Poll also potenziell eine halbe Stunde lang.
     updateLEDs();
-    debug(F("Initialer LED-Zustand ausgegeben"));
+    LOG_I("Initialer LED-Zustand ausgegeben");
 }
 
@@ -24,6 +24,7 @@
 #include "mqtt_handler.h"
 #include "web_server.h"
 #include "update_checker.h"
+#include "update_txn.h"
 
 // Zentrale AppState-Instanz
 AppState appState;
@@ -33,6 +34,8 @@ extern const String SOFTWARE_VERSION = MOODLIGHT_FULL_VERSION;
 
 #include "MoodlightUtils.h"
 
+#define LOG_TAG LOG_TAG_CORE
+
 WatchdogManager watchdog;
 MemoryMonitor memMonitor;
 SafeFileOps fileOps;
@@ -40,8 +43,22 @@ NetworkDiagnostics netDiag;
 SystemHealthCheck sysHealth;
 
 
+// Schliesst eine Boot-Phase ab: Dauer seit dem vorigen Aufruf (bzw. Boot-Beginn)
+static void bootPhase(const char *name) {
+    static unsigned long phaseStart = 0;
+    unsigned long now = micros();
+    if (appState.bootPhaseCount < AppState::BOOT_PHASE_MAX) {
+        appState.bootPhaseNames[appState.bootPhaseCount] = name;
+        appState.bootPhaseMicros[appState.bootPhaseCount] = now - phaseStart;
+        appState.bootPhaseCount++;
+    }
+    phaseStart = now;
+}
+
 // === Arduino Setup ===
 void setup() {
+    bootPhase("core");   // Core-Init und globale Konstruktoren bis setup()
+    captureCrashLog();   // Ende des vorherigen Boots sichern, bevor neue Eintraege es verdraengen
     Serial.begin(115200);
 
     // Log-Level konfigurieren
@@ -59,31 +76,43 @@ void setup() {
     Serial.println(F("==========================================="));
     Serial.println(F("AuraOS Moodlight — " MOODLIGHT_FULL_VERSION));
     Serial.println(F("==========================================="));
-    debug(F("Starte Moodlight..."));
+    startLogWriter();   // Ab hier gehen Log-Zeilen ueber den Serial-Task
+    LOG_I("Starte Moodlight... (Reset-Grund: %s, %lu Zeilen vom letzten Boot)",
+          resetReasonName(), crashLogLineCount());
+    bootPhase("serial");
 
     // Hardware-Mutex ZUERST (wird von loadSettings/updateLEDs gebraucht)
     appState.ledMutex = xSemaphoreCreateMutex();
 
     // Dateisystem und Utils
     initFS();
+    updateTxnBoot();     // Neue Firmware nach Update? Dann laeuft ab jetzt ihre Pruefung
+    bootPhase("fs");
     watchdog.begin(30, false);
     watchdog.registerCurrentTask();
     memMonitor.begin(60000);
     netDiag.begin(3600000);
     sysHealth.begin(&memMonitor, &netDiag);
     initJsonPool();
+    bootPhase("utils");
     loadSettings();
+    bootPhase("settings");
 
     // Hardware — DHT mit Pin aus Settings initialisieren
     delay(200);
     initDHT();
+    bootPhase("dht");
 
     // Webserver-Routen definieren
     setupWebServer();
+    bootPhase("web");
 
     // WiFi + NTP + mDNS + Server starten, dann MQTT
-    if (connectWiFiAndStartServices()) {
+    bool online = connectWiFiAndStartServices();
+    bootPhase("wifi");
+    if (online) {
         connectMQTTOnStartup();
+        bootPhase("mqtt");
     }
 
     // NeoPixel-LEDs ZULETZT initialisieren
@@ -92,10 +121,16 @@ void setup() {
     // Testsketch, der nachweislich funktioniert. Nachtraegliches setPin() auf
     // einem parameterlos konstruierten Objekt hat den GPIO nie konfiguriert.
     initPixels();
-    debug(String(F("NeoPixel initialisiert: Pin ")) + String(appState.ledPin) +
-          F(", LEDs ") + String(appState.numLeds) +
-          F(", Bibliothek meldet Pin ") + String(pixels.getPin()));
-    debug(F("Setup abgeschlossen."));
+    LOG_I("NeoPixel initialisiert: Pin %d, LEDs %d, Bibliothek meldet Pin %d",
+          appState.ledPin, appState.numLeds, pixels.getPin());
+    bootPhase("leds");
+
+    uint32_t totalMicros = 0;
+    for (int i = 0; i < appState.bootPhaseCount; i++) {
+        LOG_I("Boot-Phase %s: %lu ms", appState.bootPhaseNames[i], appState.bootPhaseMicros[i] / 1000);
+        totalMicros += appState.bootPhaseMicros[i];
+    }
+    LOG_I("Setup abgeschlossen nach %lu ms", totalMicros / 1000);
 
     appState.startupTime = millis();
     appState.initialStartupPhase = true;
@@ -111,6 +146,8 @@ void loop() {
     if (appState.isInConfigMode) {
         dnsServer.processNextRequest();
         server.handleClient();
+        servePeerImage();
+        updateWiFiScan();
         // AP-Timeout nicht auffrischen waehrend aktiv konfiguriert wird —
         // ein verbundener Client (Handy/Laptop im Setup-WLAN) zaehlt als aktive Nutzung
         if (WiFi.softAPgetStationNum() > 0) {
@@ -127,8 +164,11 @@ void loop() {
         // Reboot im Config-Modus — Overflow-sicherer Vergleich (millis() wrapt nach ~49 Tagen)
         if (appState.rebootNeeded && (long)(millis() - appState.rebootTime) >= 0) {
             delay(200);
+            updateTxnRestarting();
             ESP.restart();
         }
+        // Auch im Setup-Modus bestaetigen — sonst kehrt der naechste Reset zur alten Firmware zurueck
+        handleUpdateTxn();
         // AP-Status-LED sichtbar machen und Busy-Loop beenden (A-MITTEL Blockaden in loop())
         processLEDUpdates();
         updateStatusLED();
@@ -141,17 +181,23 @@ void loop() {
 
     // Webserver-Anfragen verarbeiten — Gate entfernt, delay(LOOP_DELAY_MS) am Loop-Ende drosselt bereits
     server.handleClient();
+    servePeerImage();
+    updateWiFiScan();
 
     // Neustart-Anforderung prüfen — Overflow-sicherer Vergleich (millis() wrapt nach ~49 Tagen)
     if (appState.rebootNeeded && (long)(millis() - appState.rebootTime) >= 0) {
         delay(200);
+        updateTxnRestarting();
         ESP.restart();
     }
 
+    // Frisch installierte Firmware bestaetigen und die passende UI aktivieren
+    handleUpdateTxn();
+
     // Startup-Grace-Period beenden
     if (appState.initialStartupPhase && (millis() - appState.startupTime > STARTUP_GRACE_PERIOD)) {
         appState.initialStartupPhase = false;
-        debug(F("Startup grace period ended"));
+        LOG_I("Startup grace period ended");
     }
 
     // Nicht-blockierende Pruefung der asynchronen NTP-Synchronisation
@@ -161,6 +207,7 @@ void loop() {
     static unsigned long lastMqttLoop = 0;
     if (appState.mqttEnabled && WiFi.status() == WL_CONNECTED && (millis() - lastMqttLoop >= LOOP_MQTT_INTERVAL_MS)) {
         mqtt.loop();
+        sendUpdateProgress();
         lastMqttLoop = millis();
     }
 
@@ -195,7 +242,7 @@ void loop() {
         if (appState.mqttRefreshPending) {
             appState.mqttRefreshPending = false;
             appState.lastMoodUpdate = 0;
-            debug(F("Force-Refresh: lastMoodUpdate zurueckgesetzt"));
+            LOG_I("Force-Refresh: lastMoodUpdate zurueckgesetzt");
         }
         if (appState.autoMode) {
             getSentiment();
@@ -208,6 +255,10 @@ void loop() {
         // Installiert wird nichts von selbst — nur auf Klick in der WebUI.
         handleUpdateCheck();
         watchdog.feed();
+
+        // Nachts, falls eingeschaltet: freigegebene Firmware gedrosselt vorab
+        // laden, damit "Installieren" spaeter nur noch umschaltet
+        handleUpdatePrefetch();
     }
 
     updateStatusLED();
@@ -3,9 +3,12 @@
 #include "sensor_manager.h"
 #include "debug.h"
 #include "MoodlightUtils.h"
+#include "update_checker.h"
 #include <WiFi.h>
 #include <ArduinoJson.h>
 
+#define LOG_TAG LOG_TAG_MQTT
+
 // === ArduinoHA Globals ===
 static WiFiClient wifiClientHA;
 static byte mac[6];
@@ -25,6 +28,7 @@ HASensor haSentimentPercentile("sentiment_percentile", HASensor::PrecisionP0);
 HASensor haUptime("uptime");
 HASensor haWifiSignal("wifi_signal");
 HASensor haSystemStatus("system_status");
+HASensor haUpdateProgress("update_progress", HASensor::PrecisionP0);
 
 // === Extern-Deklarationen fuer abhaengige Globals ===
 extern AppState appState;
@@ -42,14 +46,14 @@ void onStateCommand(bool state, HALight *sender)
 {
     // Ignoriere Callbacks waehrend wir Initial States senden
     if (appState.sendingInitialStates) {
-        debug(F("Ignoriere State Command waehrend Initial States"));
+        LOG_D("Ignoriere State Command waehrend Initial States");
         return;
     }
 
     if (state == appState.lightOn)
         return;
     appState.lightOn = state;
-    debug(state ? F("HA Light: ON") : F("HA Light: OFF"));
+    LOG_I("HA Light: %s", state ? "ON" : "OFF");
     // LED-Update ueber Mutex-geschuetzten Pfad (NICHT pixels.show() direkt im Callback!)
     updateLEDs();
     sender->setState(state);
@@ -63,14 +67,14 @@ void onBrightnessCommand(uint8_t brightness, HALight *sender)
 {
     // Ignoriere Callbacks waehrend wir Initial States senden
     if (appState.sendingInitialStates) {
-        debug(F("Ignoriere Brightness Command waehrend Initial States"));
+        LOG_D("Ignoriere Brightness Command waehrend Initial States");
         return;
     }
 
     if (brightness == appState.manualBrightness)
         return;
     appState.manualBrightness = brightness;
-    debug(F("HA Brightness Command"));
+    LOG_I("HA Brightness Command");
     if (!appState.autoMode && appState.lightOn)
     {
         updateLEDs();
@@ -86,7 +90,7 @@ void onRGBColorCommand(HALight::RGBColor color, HALight *sender)
 {
     // Ignoriere Callbacks waehrend wir Initial States senden
     if (appState.sendingInitialStates) {
-        debug(F("Ignoriere RGB Command waehrend Initial States"));
+        LOG_D("Ignoriere RGB Command waehrend Initial States");
         return;
     }
 
@@ -94,7 +98,7 @@ void onRGBColorCommand(HALight::RGBColor color, HALight *sender)
     if (newColor == appState.manualColor)
         return;
     appState.manualColor = newColor;
-    debug(F("HA RGB Command"));
+    LOG_I("HA RGB Command");
     if (!appState.autoMode && appState.lightOn)
     {
         updateLEDs();
@@ -109,7 +113,7 @@ void onRGBColorCommand(HALight::RGBColor color, HALight *sender)
 void onModeCommand(int8_t index, HASelect *sender) {
     // Ignore mode commands during startup phase
     if (appState.initialStartupPhase) {
-        debug(F("Ignoring mode command during startup grace period"));
+        LOG_D("Ignoring mode command during startup grace period");
         sender->setState(appState.autoMode ? 0 : 1);
         return;
     }
@@ -117,7 +121,7 @@ void onModeCommand(int8_t index, HASelect *sender) {
     bool newMode = (index == 0);
     if (newMode == appState.autoMode) return;
     appState.autoMode = newMode;
-    debug(newMode ? F("HA Mode: Auto") : F("HA Mode: Manual"));
+    LOG_I("HA Mode: %s", newMode ? "Auto" : "Manual");
     if (appState.lightOn) {
         updateLEDs();
     }
@@ -132,7 +136,7 @@ void onUpdateIntervalCommand(HANumeric value, HANumber *sender)
 {
     // Ignoriere Callbacks waehrend wir Initial States senden
     if (appState.sendingInitialStates) {
-        debug(F("Ignoriere Update Interval Command waehrend Initial States"));
+        LOG_D("Ignoriere Update Interval Command waehrend Initial States");
         return;
     }
 
@@ -143,7 +147,7 @@ void onUpdateIntervalCommand(HANumeric value, HANumber *sender)
         return;
     appState.moodUpdateInterval = newInterval;
     sender->setState(float(intervalSeconds));
-    debug(F("Mood Update Interval geaendert"));
+    LOG_I("Mood Update Interval geaendert");
 
     // Verzoegerte Speicherung statt Flash-I/O im Callback-Kontext
     appState.settingsNeedSaving = true;
@@ -156,7 +160,7 @@ void onDHTIntervalCommand(HANumeric value, HANumber *sender)
 {
     // Ignoriere Callbacks waehrend wir Initial States senden
     if (appState.sendingInitialStates) {
-        debug(F("Ignoriere DHT Interval Command waehrend Initial States"));
+        LOG_D("Ignoriere DHT Interval Command waehrend Initial States");
         return;
     }
 
@@ -167,7 +171,7 @@ void onDHTIntervalCommand(HANumeric value, HANumber *sender)
         return;
     appState.dhtUpdateInterval = newInterval;
     sender->setState(float(intervalSeconds));
-    debug(F("DHT Interval geaendert"));
+    LOG_I("DHT Interval geaendert");
 
     // Verzoegerte Speicherung statt Flash-I/O im Callback-Kontext
     appState.settingsNeedSaving = true;
@@ -179,7 +183,7 @@ void onRefreshButtonPressed(HAButton *sender)
     // HTTP-Requests dürfen NICHT im Callback-Kontext ausgeführt werden
     // (mqtt.loop() → Callback → HTTP blockiert → WDT-Timeout / Stack-Korruption).
     // Stattdessen: Flag setzen, loop() führt den Abruf sicher aus.
-    debug(F("Sentiment Refresh über Home Assistant ausgelöst — wird in loop() ausgeführt"));
+    LOG_I("Sentiment Refresh über Home Assistant ausgelöst — wird in loop() ausgeführt");
     appState.mqttRefreshPending = true;
 }
 
@@ -230,10 +234,39 @@ void sendHeartbeat()
 
     haSystemStatus.setValue(status.c_str());
 
-    debug(F("MQTT Heartbeat gesendet"));
+    LOG_D("MQTT Heartbeat gesendet");
     appState.lastMqttHeartbeat = millis();
 }
 
+// === Firmware-Update-Fortschritt ===
+// Der Update-Task darf MQTT nicht selbst anfassen (HAMqtt ist nicht
+// thread-sicher) — die loop() reicht den Stand hier weiter.
+void sendUpdateProgress()
+{
+    static unsigned long lastSent = 0;
+    static UpdatePhase lastPhase = UPDATE_PHASE_IDLE;
+
+    if (!appState.mqttEnabled || !mqtt.isConnected())
+        return;
+
+    const UpdateProgress &p = updateProgress();
+    // Das naechtliche Vorab-Laden ist keine Installation — Home Assistant
+    // sieht erst den Klick auf "Installieren"
+    if (p.prefetch)
+        return;
+    bool phaseChanged = p.phase != lastPhase;
+    if (!phaseChanged && (p.phase != UPDATE_PHASE_DOWNLOADING ||
+                          millis() - lastSent < UPDATE_PROGRESS_MQTT_MS))
+        return;
+
+    uint32_t percent = p.total > 0 ? (uint32_t)((uint64_t)p.written * 100 / p.total) : 0;
+    if (p.phase == UPDATE_PHASE_DONE)
+        percent = 100;
+    haUpdateProgress.setValue(String(percent).c_str());
+    lastPhase = p.phase;
+    lastSent = millis();
+}
+
 // ============================================================
 // HA Setup
 // ============================================================
@@ -243,7 +276,7 @@ void setupHA()
 {
     if (!appState.mqttEnabled || appState.mqttServer.isEmpty())
     {
-        debug(F("MQTT nicht konfiguriert, überspringe HA Setup"));
+        LOG_I("MQTT nicht konfiguriert, überspringe HA Setup");
         return;
     }
 
@@ -341,7 +374,11 @@ void setupHA()
     haSystemStatus.setName("Moodlight Status");
     haSystemStatus.setIcon("mdi:information-outline");
 
-    debug(F("HA Komponenten konfiguriert."));
+    haUpdateProgress.setName("Moodlight Firmware-Update");
+    haUpdateProgress.setIcon("mdi:update");
+    haUpdateProgress.setUnitOfMeasurement("%");
+
+    LOG_I("HA Komponenten konfiguriert.");
 }
 
 // ============================================================
@@ -353,11 +390,11 @@ void sendInitialStates()
 {
     if (!appState.mqttEnabled || !mqtt.isConnected())
     {
-        debug(F("MQTT not connected, skipping initial states."));
+        LOG_W("MQTT not connected, skipping initial states.");
         return;
     }
 
-    debug(F("Sende initiale Zustände an HA..."));
+    LOG_I("Sende initiale Zustände an HA...");
 
     // Setze Flag um Callback-Loops zu vermeiden
     appState.sendingInitialStates = true;
@@ -394,7 +431,7 @@ void sendInitialStates()
     // Initiale Heartbeat-Werte senden
     sendHeartbeat();
 
-    debug(F("Initiale Zustände gesendet."));
+    LOG_I("Initiale Zustände gesendet.");
 
     // Flag zurücksetzen - Callbacks sind jetzt wieder aktiv
     appState.sendingInitialStates = false;
@@ -429,7 +466,7 @@ void checkAndReconnectMQTT() {
             appState.mqttWasConnected = false;
 
             if (currentMillis - appState.lastMqttReconnectAttempt > mqttReconnectBackoff) {
-                debug(F("MQTT nicht verbunden. Versuche Reconnect..."));
+                LOG_W("MQTT nicht verbunden. Versuche Reconnect...");
 
                 // Zentrale Status-LED-Funktion nutzen (loggt AN/AUS-Wechsel selbst)
                 if (appState.statusLedMode != 4) {
@@ -451,7 +488,7 @@ void checkAndReconnectMQTT() {
                 mqttReconnectBackoff = min(mqttReconnectBackoff * 2, 300000UL);
             }
         } else if (!appState.mqttWasConnected) {
-            debug(F("MQTT wieder verbunden. Sende Zustände..."));
+            LOG_I("MQTT wieder verbunden. Sende Zustände...");
 
             // Initiale Zustände für nächsten Loop-Zyklus einplanen
             appState.mqttInitialStatesPending = true;
@@ -481,19 +518,19 @@ void checkAndReconnectMQTT() {
 void connectMQTTOnStartup() {
     if (!appState.mqttEnabled || appState.mqttServer.isEmpty()) return;
 
-    debug(F("MQTT Konfiguration gefunden, starte verzögerte Initialisierung..."));
+    LOG_I("MQTT Konfiguration gefunden, starte verzögerte Initialisierung...");
     delay(500);
 
     setupHA();
 
-    debug(F("Versuche MQTT zu initialisieren..."));
+    LOG_D("Versuche MQTT zu initialisieren...");
     unsigned long mqttStartTime = millis();
     bool mqttInitSuccess = false;
 
     try {
         mqtt.begin(appState.mqttServer.c_str(), appState.mqttUser.c_str(), appState.mqttPassword.c_str());
 
-        debug(F("Warte auf MQTT Verbindung (max 5s)..."));
+        LOG_D("Warte auf MQTT Verbindung (max 5s)...");
         while (!mqtt.isConnected() && (millis() - mqttStartTime < 5000)) {
             mqtt.loop();
             delay(100);
@@ -501,15 +538,15 @@ void connectMQTTOnStartup() {
         }
         mqttInitSuccess = mqtt.isConnected();
     } catch (...) {
-        debug(F("Exception bei MQTT-Initialisierung"));
+        LOG_E("Exception bei MQTT-Initialisierung");
         mqttInitSuccess = false;
     }
 
     if (mqttInitSuccess) {
-        debug(F("MQTT erfolgreich initialisiert und verbunden."));
+        LOG_I("MQTT erfolgreich initialisiert und verbunden.");
         appState.mqttWasConnected = true;
         sendInitialStates();
     } else {
-        debug(F("MQTT-Initialisierung/Verbindung fehlgeschlagen - Fahre ohne MQTT fort"));
+        LOG_E("MQTT-Initialisierung/Verbindung fehlgeschlagen - Fahre ohne MQTT fort");
     }
 }
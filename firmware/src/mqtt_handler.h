@@ -20,12 +20,14 @@ extern HANumber haDhtInterval;
 extern HASensor haUptime;
 extern HASensor haWifiSignal;
 extern HASensor haSystemStatus;
+extern HASensor haUpdateProgress;
 
 // === MQTT/HA-Funktionen ===
 
 void setupHA();
 void sendInitialStates();
 void sendHeartbeat();
+void sendUpdateProgress();      // Fortschritt des Firmware-Updates (aus der loop())
 void checkAndReconnectMQTT();
 
 // MQTT beim Start einmalig verbinden (mit 5s Timeout)
@@ -0,0 +1,229 @@
+// ota_delta.cpp — Delta-Patch blockweise auf die laufende Firmware anwenden
+//
+// Format (little endian, Referenz: sentiment-api/firmware_delta.py):
+//   Kopf    "AOD1" | u32 Basisgroesse | 32 Byte SHA-256 der Basis | u32 Zielgroesse
+//   COPY    0x01 | u32 Quelle | u32 Laenge               Basis unveraendert
+//   ADD     0x02 | u32 Quelle | u32 Laenge | Daten       Basis + Daten (mod 256)
+//   INSERT  0x03 | u32 Laenge | Daten                    Daten woertlich
+//
+// Kopf und Befehle koennen beliebig ueber Blockgrenzen verteilt ankommen und
+// werden deshalb in _head gesammelt, bis sie vollstaendig sind. COPY braucht
+// keine weiteren Eingabebytes und wird sofort ausgefuehrt.
+
+#include <Arduino.h>
+
+#include "ota_delta.h"
+
+static const uint8_t DELTA_MAGIC[4] = {'A', 'O', 'D', '1'};
+static constexpr uint8_t DELTA_HEADER_SIZE = 44;
+
+enum DeltaStep : uint8_t {
+    DELTA_STEP_HEADER,
+    DELTA_STEP_COMMAND,     // Befehlsbyte und Argumente
+    DELTA_STEP_DATA,        // Datenbytes von ADD bzw. INSERT
+};
+
+enum DeltaOp : uint8_t {
+    DELTA_OP_COPY = 0x01,
+    DELTA_OP_ADD = 0x02,
+    DELTA_OP_INSERT = 0x03,
+};
+
+static uint32_t readLe32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void DeltaPatcher::begin(const esp_partition_t *base, size_t baseSize, const uint8_t baseSha[32],
+                         DeltaSinkFn sink, void *ctx)
+{
+    _base = base;
+    _baseSize = baseSize;
+    memcpy(_baseSha, baseSha, sizeof(_baseSha));
+    _sink = sink;
+    _sinkCtx = ctx;
+
+    _step = DELTA_STEP_HEADER;
+    _have = 0;
+    _need = DELTA_HEADER_SIZE;
+    _target = 0;
+    _out = 0;
+    _failed = false;
+    _error = "";
+}
+
+void DeltaPatcher::nextCommand()
+{
+    _step = DELTA_STEP_COMMAND;
+    _have = 0;
+    _need = 1;
+}
+
+bool DeltaPatcher::write(const uint8_t *data, size_t len)
+{
+    if (_failed) {
+        return false;
+    }
+
+    while (len > 0) {
+        if (_step != DELTA_STEP_DATA) {
+            if (_step == DELTA_STEP_COMMAND && _have == 0 && _out >= _target) {
+                return fail("Patch geht ueber das Zielimage hinaus");
+            }
+            size_t n = _need - _have;
+            if (n > len) {
+                n = len;
+            }
+            memcpy(_head + _have, data, n);
+            _have += n;
+            data += n;
+            len -= n;
+            if (_have == _need && !command()) {
+                return false;
+            }
+            continue;
+        }
+
+        size_t n = _left;
+        if (n > len) {
+            n = len;
+        }
+        if (n > sizeof(_buf)) {
+            n = sizeof(_buf);
+        }
+
+        if (_op == DELTA_OP_ADD) {
+            if (!readBase(_src, n)) {
+                return false;
+            }
+            for (size_t i = 0; i < n; i++) {
+                _buf[i] += data[i];
+            }
+            _src += n;
+            if (!emit(_buf, n)) {
+                return false;
+            }
+        } else if (!emit(data, n)) {
+            return false;
+        }
+
+        data += n;
+        len -= n;
+        _left -= n;
+        if (_left == 0) {
+            nextCommand();
+        }
+    }
+    return true;
+}
+
+// Kopf bzw. Befehl ist vollstaendig in _head
+bool DeltaPatcher::command()
+{
+    if (_step == DELTA_STEP_HEADER) {
+        if (memcmp(_head, DELTA_MAGIC, sizeof(DELTA_MAGIC)) != 0) {
+            return fail("Kein AuraOS-Delta");
+        }
+        // Der Patch muss genau zu dem passen, was vorher in der Partition
+        // geprueft wurde — sonst entstuende aus fremden Bytes ein Image
+        if (readLe32(_head + 4) != _baseSize || memcmp(_head + 8, _baseSha, 32) != 0) {
+            return fail("Patch passt nicht zur laufenden Firmware");
+        }
+        _target = readLe32(_head + 40);
+        nextCommand();
+        return true;
+    }
+
+    if (_need == 1) {
+        // Befehlsbyte gelesen, jetzt die Argumente
+        _op = _head[0];
+        if (_op == DELTA_OP_COPY || _op == DELTA_OP_ADD) {
+            _need = 9;
+        } else if (_op == DELTA_OP_INSERT) {
+            _need = 5;
+        } else {
+            return fail("Unbekannter Befehl im Patch");
+        }
+        return true;
+    }
+
+    uint32_t len;
+    if (_op == DELTA_OP_INSERT) {
+        len = readLe32(_head + 1);
+    } else {
+        _src = readLe32(_head + 1);
+        len = readLe32(_head + 5);
+        if (_src > _baseSize || len > _baseSize - _src) {
+            return fail("Patch liest ausserhalb der Basis");
+        }
+    }
+    if (len > _target - _out) {
+        return fail("Patch geht ueber das Zielimage hinaus");
+    }
+
+    if (_op == DELTA_OP_COPY) {
+        if (!copyFromBase(len)) {
+            return false;
+        }
+        nextCommand();
+        return true;
+    }
+
+    _left = len;
+    if (_left == 0) {
+        nextCommand();
+    } else {
+        _step = DELTA_STEP_DATA;
+    }
+    return true;
+}
+
+bool DeltaPatcher::copyFromBase(uint32_t len)
+{
+    while (len > 0) {
+        size_t n = len > sizeof(_buf) ? sizeof(_buf) : len;
+        if (!readBase(_src, n) || !emit(_buf, n)) {
+            return false;
+        }
+        _src += n;
+        len -= n;
+    }
+    return true;
+}
+
+bool DeltaPatcher::readBase(uint32_t offset, size_t len)
+{
+    if (esp_partition_read(_base, offset, _buf, len) != ESP_OK) {
+        return fail("Laufende Firmware nicht lesbar");
+    }
+    return true;
+}
+
+bool DeltaPatcher::emit(const uint8_t *data, size_t len)
+{
+    if (!_sink(_sinkCtx, data, len)) {
+        _failed = true;
+        _error = "";
+        return false;
+    }
+    _out += len;
+    return true;
+}
+
+bool DeltaPatcher::end()
+{
+    if (_failed) {
+        return false;
+    }
+    if (_step != DELTA_STEP_COMMAND || _have != 0 || _out != _target) {
+        return fail("Patch unvollstaendig");
+    }
+    return true;
+}
+
+bool DeltaPatcher::fail(const char *reason)
+{
+    _failed = true;
+    _error = reason;
+    return false;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <Arduino.h>
+#include "esp_partition.h"
+
+// === Delta-Update gegen die laufende Firmware ===
+// Statt des ganzen Images laedt die Lampe einen Patch, den der Backend-Spiegel
+// beim Spiegeln aus der Vorversion gebaut hat (sentiment-api/firmware_delta.py,
+// dort auch das Format). DeltaPatcher nimmt den entpackten Patch blockweise
+// entgegen, liest die alten Bytes aus der laufenden App-Partition und gibt das
+// neue Image an eine Senke weiter — beim OTA-Download die andere Partition.
+//
+// Die laufende Partition wird nur gelesen. Geht irgendetwas schief, bleibt sie
+// unberuehrt und der Aufrufer laedt das volle Image.
+//
+// Speicher: 512 Byte Lesepuffer plus Zustand. Der Patch kommt gzip-gepackt,
+// davor sitzt also ein GzipDecoder (ota_gzip.h).
+
+// Nimmt einen Block des neuen Images entgegen; false bricht ab
+typedef bool (*DeltaSinkFn)(void *ctx, const uint8_t *data, size_t len);
+
+class DeltaPatcher {
+public:
+    // base: laufende Partition; baseSize/baseSha: was der Aufrufer dort
+    // vorher geprueft hat. Ein Patch fuer eine andere Basis wird abgelehnt.
+    void begin(const esp_partition_t *base, size_t baseSize, const uint8_t baseSha[32],
+               DeltaSinkFn sink, void *ctx);
+
+    // Naechster Block des entpackten Patches. false bei kaputtem Patch oder
+    // wenn die Senke ablehnt (dann ist error() leer).
+    bool write(const uint8_t *data, size_t len);
+
+    // Nach dem letzten write(): Patch vollstaendig abgearbeitet
+    bool end();
+
+    const char *error() const { return _error; }
+    uint32_t targetSize() const { return _target; }
+    uint32_t outputBytes() const { return _out; }
+
+private:
+    bool command();
+    bool copyFromBase(uint32_t len);
+    bool readBase(uint32_t offset, size_t len);
+    bool emit(const uint8_t *data, size_t len);
+    void nextCommand();
+    bool fail(const char *reason);
+
+    const esp_partition_t *_base = nullptr;
+    uint32_t _baseSize = 0;
+    uint8_t _baseSha[32] = {};
+    DeltaSinkFn _sink = nullptr;
+    void *_sinkCtx = nullptr;
+
+    uint8_t _step = 0;          // Kopf, Befehl oder Daten, siehe ota_delta.cpp
+    uint8_t _op = 0;
+    uint8_t _head[44] = {};     // Kopf bzw. Befehl mit Argumenten, wird gesammelt
+    uint8_t _have = 0;
+    uint8_t _need = 0;
+
+    uint32_t _src = 0;          // Naechstes Byte der Basis fuer ADD
+    uint32_t _left = 0;         // Restbytes des laufenden ADD/INSERT
+    uint32_t _target = 0;
+    uint32_t _out = 0;
+    bool _failed = false;
+    const char *_error = "";
+    uint8_t _buf[512];
+};
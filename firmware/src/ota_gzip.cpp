@@ -0,0 +1,305 @@
+// ota_gzip.cpp — gzip-Firmware blockweise entpacken und flashen
+//
+// Aufbau einer gzip-Datei (RFC 1952): 10 Byte Header, optionale Felder je
+// nach Flags, Deflate-Strom, 8 Byte Trailer (CRC32 und Laenge, little endian).
+// Den Header zerlegt consumeHeader() Byte fuer Byte, weil er beliebig ueber
+// Blockgrenzen verteilt ankommen kann. Den Deflate-Strom uebernimmt tinfl.
+//
+// Den Trailer liest finish() aus den letzten 8 empfangenen Bytes statt aus dem,
+// was tinfl uebrig laesst: tinfl liest beim Dekodieren einige Bytes voraus und
+// gibt sie am Ende nicht zurueck.
+
+#include <Arduino.h>
+#include <Update.h>
+#include "esp_rom_crc.h"
+#include "esp32/rom/miniz.h"
+
+#include "ota_gzip.h"
+
+// tinfl schreibt in einen Ringpuffer und verweist fuer Wiederholungen bis zu
+// 32 KB zurueck — kleiner darf das Fenster fuer beliebige gzip-Dateien nicht sein
+static constexpr size_t GZIP_WINDOW = TINFL_LZ_DICT_SIZE;
+
+enum GzipStep : uint8_t {
+    GZIP_STEP_FIXED,        // ID1 ID2 CM FLG MTIME(4) XFL OS
+    GZIP_STEP_EXTRA_LEN,    // FEXTRA: 2 Byte Laenge
+    GZIP_STEP_EXTRA,        // FEXTRA: Daten
+    GZIP_STEP_NAME,         // FNAME: nullterminiert
+    GZIP_STEP_COMMENT,      // FCOMMENT: nullterminiert
+    GZIP_STEP_HCRC,         // FHCRC: 2 Byte
+    GZIP_STEP_BODY,         // Deflate-Strom
+};
+
+// Flag, ohne das ein Header-Schritt uebersprungen wird (Index = GzipStep)
+static const uint8_t GZIP_STEP_FLAG[] = {0, 0x04, 0x04, 0x08, 0x10, 0x02};
+
+bool GzipDecoder::reserve()
+{
+    if (_inflator && _window) {
+        return true;
+    }
+    _inflator = (tinfl_decompressor *)malloc(sizeof(tinfl_decompressor));
+    _window = (uint8_t *)malloc(GZIP_WINDOW);
+    if (!_inflator || !_window) {
+        release();
+        _error = "Zu wenig Speicher zum Entpacken";
+        return false;
+    }
+    return true;
+}
+
+bool GzipDecoder::begin(GzipSinkFn sink, void *ctx)
+{
+    if (!reserve()) {
+        return false;
+    }
+
+    tinfl_init(_inflator);
+    _windowPos = 0;
+    _step = GZIP_STEP_FIXED;
+    _flags = 0;
+    _pos = 0;
+    _skip = 0;
+    memset(_tail, 0, sizeof(_tail));
+    _done = false;
+    _in = 0;
+    _out = 0;
+    _crc = 0;
+    _error = "";
+    _sink = sink;
+    _sinkCtx = ctx;
+    return true;
+}
+
+void GzipDecoder::nextHeaderStep()
+{
+    _pos = 0;
+    do {
+        _step++;
+    } while (_step < GZIP_STEP_BODY && !(_flags & GZIP_STEP_FLAG[_step]));
+}
+
+// Verbraucht Header-Bytes vom Anfang des Blocks; false bei ungueltigem Header
+bool GzipDecoder::consumeHeader(const uint8_t *&data, size_t &len)
+{
+    while (len > 0 && _step != GZIP_STEP_BODY) {
+        uint8_t b = *data++;
+        len--;
+
+        switch (_step) {
+            case GZIP_STEP_FIXED:
+                if ((_pos == 0 && b != 0x1f) || (_pos == 1 && b != 0x8b)) {
+                    return fail("Keine gzip-Datei");
+                }
+                if (_pos == 2 && b != 8) {
+                    return fail("gzip-Datei ist nicht mit Deflate gepackt");
+                }
+                if (_pos == 3) {
+                    if (b & 0xE0) {
+                        return fail("gzip-Header mit unbekannten Flags");
+                    }
+                    _flags = b;
+                }
+                if (++_pos == 10) {
+                    nextHeaderStep();
+                }
+                break;
+
+            case GZIP_STEP_EXTRA_LEN:
+                _skip |= (uint16_t)b << (8 * _pos);
+                if (++_pos == 2) {
+                    _step = GZIP_STEP_EXTRA;
+                    if (_skip == 0) {
+                        nextHeaderStep();
+                    }
+                }
+                break;
+
+            case GZIP_STEP_EXTRA:
+                if (--_skip == 0) {
+                    nextHeaderStep();
+                }
+                break;
+
+            case GZIP_STEP_NAME:
+            case GZIP_STEP_COMMENT:
+                if (b == 0) {
+                    nextHeaderStep();
+                }
+                break;
+
+            case GZIP_STEP_HCRC:
+                if (++_pos == 2) {
+                    nextHeaderStep();
+                }
+                break;
+        }
+    }
+    return true;
+}
+
+bool GzipDecoder::write(const uint8_t *data, size_t len)
+{
+    if (!_inflator) {
+        return false;
+    }
+
+    _in += len;
+    if (len >= sizeof(_tail)) {
+        memcpy(_tail, data + len - sizeof(_tail), sizeof(_tail));
+    } else {
+        memmove(_tail, _tail + len, sizeof(_tail) - len);
+        memcpy(_tail + sizeof(_tail) - len, data, len);
+    }
+
+    if (!consumeHeader(data, len)) {
+        return false;
+    }
+
+    // Nach dem Deflate-Strom kommt nur noch der Trailer, der steht in _tail
+    while (_step == GZIP_STEP_BODY && !_done) {
+        size_t inBytes = len;
+        size_t outBytes = GZIP_WINDOW - _windowPos;
+        tinfl_status status = tinfl_decompress(_inflator, data, &inBytes,
+                                               _window, _window + _windowPos, &outBytes,
+                                               TINFL_FLAG_HAS_MORE_INPUT);
+        data += inBytes;
+        len -= inBytes;
+
+        if (outBytes > 0) {
+            const uint8_t *block = _window + _windowPos;
+            if (!_sink(_sinkCtx, block, outBytes)) {
+                _error = "";
+                return false;
+            }
+            _crc = esp_rom_crc32_le(_crc, block, outBytes);
+            _out += outBytes;
+        }
+        _windowPos = (_windowPos + outBytes) & (GZIP_WINDOW - 1);
+
+        if (status < TINFL_STATUS_DONE) {
+            return fail("gzip-Daten beschaedigt");
+        }
+        if (status == TINFL_STATUS_DONE) {
+            _done = true;
+        } else if (status == TINFL_STATUS_NEEDS_MORE_INPUT) {
+            break;
+        }
+        // TINFL_STATUS_HAS_MORE_OUTPUT: Fenster ist voll geschrieben, weiter
+    }
+    return true;
+}
+
+bool GzipDecoder::finish()
+{
+    if (!_done) {
+        return fail("gzip-Datei unvollstaendig");
+    }
+
+    uint32_t crc = _tail[0] | (_tail[1] << 8) | (_tail[2] << 16) | ((uint32_t)_tail[3] << 24);
+    uint32_t size = _tail[4] | (_tail[5] << 8) | (_tail[6] << 16) | ((uint32_t)_tail[7] << 24);
+    if (crc != _crc) {
+        return fail("CRC32 der entpackten Daten stimmt nicht");
+    }
+    if (size != _out) {
+        return fail("Laenge der entpackten Daten stimmt nicht");
+    }
+    return true;
+}
+
+bool GzipDecoder::fail(const char *reason)
+{
+    _error = reason;
+    return false;
+}
+
+void GzipDecoder::release()
+{
+    free(_inflator);
+    free(_window);
+    _inflator = nullptr;
+    _window = nullptr;
+}
+
+// === GzipFlashWriter ===
+
+bool GzipFlashWriter::begin(size_t imageSize)
+{
+    _error = "";
+    if (!_decoder.begin(&GzipFlashWriter::flashSink, this)) {
+        _error = _decoder.error();
+        return false;
+    }
+
+    if (!Update.begin(imageSize)) {
+        _error = Update.errorString();
+        _decoder.release();
+        return false;
+    }
+    _active = true;
+    return true;
+}
+
+// Entpackten Block flashen
+bool GzipFlashWriter::flashSink(void *ctx, const uint8_t *data, size_t len)
+{
+    GzipFlashWriter *self = static_cast<GzipFlashWriter *>(ctx);
+
+    // Dieselbe Bricking-Vorsorge wie beim rohen Binary, nur nach dem Entpacken
+    if (self->_decoder.outputBytes() == 0 && data[0] != 0xE9) {
+        self->_error = "Datei ist keine ESP32-Firmware (Magic-Byte fehlt)";
+        return false;
+    }
+    // Update.write() kopiert nur in seinen Sektorpuffer
+    if (Update.write(const_cast<uint8_t *>(data), len) != len) {
+        self->_error = Update.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool GzipFlashWriter::write(const uint8_t *data, size_t len)
+{
+    if (!_active) {
+        return false;
+    }
+    if (!_decoder.write(data, len)) {
+        // Leer, wenn flashSink() abgelehnt hat — dann steht der Grund schon da
+        return fail(*_decoder.error() ? _decoder.error() : _error);
+    }
+    return true;
+}
+
+bool GzipFlashWriter::end()
+{
+    if (!_active) {
+        return false;
+    }
+    if (!_decoder.finish()) {
+        return fail(_decoder.error());
+    }
+
+    _active = false;
+    _decoder.release();
+    if (!Update.end(true)) {
+        _error = Update.errorString();
+        return false;
+    }
+    return true;
+}
+
+void GzipFlashWriter::abort()
+{
+    if (_active) {
+        Update.abort();
+        _active = false;
+    }
+    _decoder.release();
+}
+
+bool GzipFlashWriter::fail(const char *reason)
+{
+    _error = reason;
+    abort();
+    return false;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <Arduino.h>
+
+// === gzip-Firmware beim Flashen entpacken ===
+// Der Backend-Spiegel liefert die Firmware zusaetzlich als .bin.gz, und ueber
+// /update laesst sich eine Firmware-X.X-AuraOS.bin.gz hochladen. Die
+// komprimierten Bytes kommen in beliebig grossen Bloecken an — so wie sie aus
+// dem Netz oder dem Upload kommen — und werden direkt weitergereicht. Das ganze
+// Image liegt nie im RAM, nur das Deflate-Fenster.
+//
+// Entpackt wird mit tinfl aus dem ESP32-ROM (miniz), das kostet keinen Flash.
+// Speicher: 32 KB Fenster (von Deflate vorgegeben, gilt fuer jede gzip-Datei)
+// plus ~11 KB Decoder-Zustand, nur waehrend des Updates.
+//
+// GzipDecoder entpackt nur und gibt jeden Block an eine Senke weiter — beim
+// OTA-Download die Partition, bei einem Delta-Patch erst den Patcher
+// (ota_delta.h). GzipFlashWriter ist die fertige Kombination fuer den Upload:
+// entpacken und per Update.write() flashen.
+
+struct tinfl_decompressor_tag;
+
+// Nimmt einen entpackten Block entgegen; false bricht das Entpacken ab
+typedef bool (*GzipSinkFn)(void *ctx, const uint8_t *data, size_t len);
+
+class GzipDecoder {
+public:
+    ~GzipDecoder() { release(); }
+
+    // Fenster und Decoder anlegen. false bei zu wenig Heap — dann kann der
+    // Aufrufer unkomprimiert laden.
+    bool reserve();
+
+    // Neue Datei beginnen. Ruft reserve() selbst, falls noch nicht geschehen.
+    bool begin(GzipSinkFn sink, void *ctx);
+
+    // Naechster Block der .gz-Datei. false bei beschaedigten Daten oder wenn
+    // die Senke ablehnt (dann ist error() leer — den Grund kennt die Senke).
+    bool write(const uint8_t *data, size_t len);
+
+    // Nach dem letzten write(): Strom vollstaendig, CRC32 und Laenge aus dem
+    // Trailer passen zum Entpackten
+    bool finish();
+
+    // Speicher freigeben; vor dem naechsten begin() wieder noetig
+    void release();
+
+    const char *error() const { return _error; }
+    uint32_t inputBytes() const { return _in; }      // Komprimiert empfangen
+    uint32_t outputBytes() const { return _out; }    // Entpackt weitergegeben
+
+private:
+    bool consumeHeader(const uint8_t *&data, size_t &len);
+    void nextHeaderStep();
+    bool fail(const char *reason);
+
+    tinfl_decompressor_tag *_inflator = nullptr;
+    uint8_t *_window = nullptr;
+    size_t _windowPos = 0;
+
+    uint8_t _step = 0;          // Position im gzip-Header, siehe ota_gzip.cpp
+    uint8_t _flags = 0;
+    uint16_t _pos = 0;
+    uint16_t _skip = 0;         // Restlaenge des FEXTRA-Felds
+    uint8_t _tail[8] = {};      // Letzte 8 Eingabe-Bytes = CRC32 + Laenge
+    bool _done = false;         // Deflate-Strom vollstaendig
+
+    uint32_t _in = 0;
+    uint32_t _out = 0;
+    uint32_t _crc = 0;
+    const char *_error = "";
+    GzipSinkFn _sink = nullptr;
+    void *_sinkCtx = nullptr;
+};
+
+// Entpacken und flashen fuer den Upload ueber /update.
+// Vor Update.end() geprueft: gzip-Header, Magic-Byte 0xE9 im entpackten
+// Image, CRC32 und Laenge aus dem gzip-Trailer. Stimmt etwas nicht, wird
+// Update.abort() aufgerufen und die laufende Firmware bleibt aktiv.
+class GzipFlashWriter {
+public:
+    bool reserve() { return _decoder.reserve(); }
+
+    // Update.begin(); imageSize ist die entpackte Groesse oder
+    // UPDATE_SIZE_UNKNOWN. Ruft reserve() selbst, falls noch nicht geschehen.
+    bool begin(size_t imageSize);
+
+    // Naechster Block der .gz-Datei. false bei Fehler (siehe error());
+    // Update ist dann bereits abgebrochen.
+    bool write(const uint8_t *data, size_t len);
+
+    // Trailer pruefen und Update.end(true). Nach dem letzten write() aufrufen.
+    bool end();
+
+    void abort();
+
+    bool active() const { return _active; }
+    const char *error() const { return _error; }
+    uint32_t inputBytes() const { return _decoder.inputBytes(); }
+    uint32_t outputBytes() const { return _decoder.outputBytes(); }
+
+private:
+    static bool flashSink(void *ctx, const uint8_t *data, size_t len);
+    bool fail(const char *reason);
+
+    GzipDecoder _decoder;
+    bool _active = false;
+    const char *_error = "";
+};
@@ -9,6 +9,8 @@
 #include <ArduinoHA.h>
 #include <time.h>
 
+#define LOG_TAG LOG_TAG_SENSOR
+
 // Globals aus moodlight.cpp
 extern AppState appState;
 extern HAMqtt mqtt;
@@ -30,14 +32,14 @@ void initDHT() {
         dhtSensor = nullptr;
     }
     if (!appState.dhtEnabled) {
-        debug(F("DHT deaktiviert — ueberspringe Hardware-Initialisierung"));
+        LOG_I("DHT deaktiviert — ueberspringe Hardware-Initialisierung");
         return;
     }
     // Internen Pull-Up aktivieren (ersetzt externen 4.7kΩ Widerstand)
     pinMode(appState.dhtPin, INPUT_PULLUP);
     dhtSensor = new DHT(appState.dhtPin, DHT22);
     dhtSensor->begin();
-    debug(String(F("DHT22 initialisiert auf Pin ")) + String(appState.dhtPin) + F(" (mit internem Pull-Up)"));
+    LOG_I("DHT22 initialisiert auf Pin %d (mit internem Pull-Up)", appState.dhtPin);
 }
 
 // === Map Sentiment Score (-1 bis +1) zu LED Index (0-4) ===
@@ -75,7 +77,7 @@ void handleSentiment(float sentimentScore, const String &apiCategory)
         }
 
         appState.sentimentScore = sentimentScore;
-        debug("Neuer Sentiment Score: " + haValue);
+        LOG_I("Neuer Sentiment Score: %s", haValue);
     }
 
     // Kategorie aus API-Response nutzen falls vorhanden, sonst lokal bestimmen
@@ -103,7 +105,7 @@ void handleSentiment(float sentimentScore, const String &apiCategory)
         }
 
         appState.sentimentCategory = categoryText;
-        debug("Neue Sentiment Kategorie: " + categoryText);
+        LOG_I("Neue Sentiment Kategorie: %s", categoryText);
     }
 }
 
@@ -111,7 +113,7 @@ void handleSentiment(float sentimentScore, const String &apiCategory)
 bool fetchBackendStatistics(JsonDocument &doc, int hours)
 {
     if (WiFi.status() != WL_CONNECTED) {
-        debug(F("WiFi nicht verbunden - kann keine Backend-Statistiken laden"));
+        LOG_W("WiFi nicht verbunden - kann keine Backend-Statistiken laden");
         return false;
     }
 
@@ -125,7 +127,7 @@ bool fetchBackendStatistics(JsonDocument &doc, int hours)
         statsBaseUrl = DEFAULT_STATS_API_URL;
     }
     String statsUrl = statsBaseUrl + "?hours=" + String(hours);
-    debug(String(F("Lade Statistiken von Backend: ")) + statsUrl);
+    LOG_I("Lade Statistiken von Backend: %s", statsUrl);
 
     HTTPClient http;
     http.setReuse(false);
@@ -138,7 +140,7 @@ bool fetchBackendStatistics(JsonDocument &doc, int hours)
     }
 
     if (!http.begin(wifiClientHTTP, statsUrl)) {
-        debug(F("HTTP Begin fehlgeschlagen für Backend-Statistiken"));
+        LOG_E("HTTP Begin fehlgeschlagen für Backend-Statistiken");
         return false;
     }
 
@@ -146,7 +148,7 @@ bool fetchBackendStatistics(JsonDocument &doc, int hours)
 
     // A-NIEDRIG: Schein-try/catch entfernt — Arduino HTTPClient wirft hier keine C++-Exceptions
     int httpCode = http.GET();
-    debug(String(F("Backend-Statistiken HTTP Code: ")) + String(httpCode));
+    LOG_D("Backend-Statistiken HTTP Code: %d", httpCode);
 
     // WDT nach blockierendem HTTP-Call sofort füttern (kann bis zu 15s dauern)
     watchdog.feed();
@@ -157,14 +159,14 @@ bool fetchBackendStatistics(JsonDocument &doc, int hours)
         http.end();
 
         if (error) {
-            debug(String(F("JSON Parsing Fehler bei Backend-Statistiken: ")) + error.c_str());
+            LOG_E("JSON Parsing Fehler bei Backend-Statistiken: %s", error.c_str());
             return false;
         }
 
-        debug(F("Backend-Statistiken erfolgreich geladen"));
+        LOG_I("Backend-Statistiken erfolgreich geladen");
         return true;
     } else {
-        debug(String(F("HTTP Fehler beim Laden der Backend-Statistiken: ")) + httpCode);
+        LOG_E("HTTP Fehler beim Laden der Backend-Statistiken: %d", httpCode);
         http.end();
         return false;
     }
@@ -175,7 +177,7 @@ bool safeHttpGet(const String &url, JsonDocument &doc)
 {
     bool success = false;
 
-    debug(String(F("Making safe HTTP request to: ")) + url);
+    LOG_D("Making safe HTTP request to: %s", url);
 
     // Create client in local scope
     HTTPClient http;
@@ -194,7 +196,7 @@ bool safeHttpGet(const String &url, JsonDocument &doc)
 
         // A-NIEDRIG: Schein-try/catch entfernt — Arduino HTTPClient wirft hier keine C++-Exceptions
         int httpCode = http.GET();
-        debug(String(F("HTTP response code: ")) + httpCode);
+        LOG_D("HTTP response code: %d", httpCode);
 
         // WDT nach blockierendem HTTP-Call sofort füttern (kann bis zu 10s dauern)
         watchdog.feed();
@@ -205,10 +207,10 @@ bool safeHttpGet(const String &url, JsonDocument &doc)
 
             if (!error) {
                 success = true;
-                debug(F("JSON parsed successfully"));
+                LOG_T("JSON parsed successfully");
             }
             else {
-                debug(String(F("JSON parse error: ")) + error.c_str());
+                LOG_W("JSON parse error: %s", error.c_str());
             }
         }
 
@@ -216,7 +218,7 @@ bool safeHttpGet(const String &url, JsonDocument &doc)
         http.end();
     }
     else {
-        debug(F("Failed to begin HTTP connection"));
+        LOG_E("Failed to begin HTTP connection");
     }
 
     // Force close WiFi client if somehow still connected
@@ -265,15 +267,14 @@ void getSentiment()
     static unsigned long lastIntervalDebug = 0;
     if (currentMillis - lastIntervalDebug >= 300000)
     {
-        debug(String(F("Sentiment Interval Status: ")) + String(currentMillis - appState.lastMoodUpdate) + F("/") + String(effectiveDelay) + F("ms"));
+        LOG_T("Sentiment Interval Status: %lu/%lums", currentMillis - appState.lastMoodUpdate, effectiveDelay);
         lastIntervalDebug = currentMillis;
     }
 
     // Check for API timeout logic
     if (appState.sentimentAPIAvailable && appState.lastSuccessfulSentimentUpdate > 0 && currentMillis - appState.lastSuccessfulSentimentUpdate > SENTIMENT_FALLBACK_TIMEOUT)
     {
-        debug(F("API-Timeout: Kein erfolgreicher Sentiment-Abruf seit über einer Stunde."));
-        debug(F("Wechsel in Neutral-Modus."));
+        LOG_W("API-Timeout: Kein erfolgreicher Sentiment-Abruf seit über einer Stunde. Wechsel in Neutral-Modus.");
         appState.sentimentAPIAvailable = false;
         handleSentiment(0.0);
         // LED-Index auf Neutral setzen, damit der "Neutral-Modus" auch die LEDs neutral faerbt
@@ -293,7 +294,7 @@ void getSentiment()
     if (!(currentMillis - appState.lastMoodUpdate >= effectiveDelay || !appState.initialAnalysisDone))
         return;
 
-    debug(F("Starte Sentiment-Abruf..."));
+    LOG_D("Starte Sentiment-Abruf...");
     isUpdating = true;
 
     // v9.0: headlines_per_source parameter removed - not used by new /api/moodlight/* endpoints
@@ -311,7 +312,7 @@ void getSentiment()
     if (success && doc["sentiment"].is<float>())
     {
         float receivedSentiment = doc["sentiment"].as<float>();
-        debug(String(F("Sentiment empfangen: ")) + String(receivedSentiment, 2));
+        LOG_I("Sentiment empfangen: %.2f", receivedSentiment);
 
         // Phase 18: led_index aus API-Response lesen (dynamische Skalierung)
         // Fallback auf mapSentimentToLED() wenn Feld fehlt (altes Backend)
@@ -324,16 +325,15 @@ void getSentiment()
             // Fallback-Schwellwerte signalisiert vom Backend
             if (doc["thresholds"]["fallback"].is<bool>() && doc["thresholds"]["fallback"].as<bool>())
             {
-                debug(F("Hinweis: Backend nutzt Fallback-Schwellwerte (weniger als 3 historische Datenpunkte)"));
+                LOG_I("Hinweis: Backend nutzt Fallback-Schwellwerte (weniger als 3 historische Datenpunkte)");
             }
-            debug(String(F("LED-Index aus API: ")) + String(apiLedIndex) +
-                  String(F(" (Perzentil: ")) + String(doc["percentile"].as<float>(), 2) + String(F(")")));
+            LOG_D("LED-Index aus API: %d (Perzentil: %.2f)", apiLedIndex, doc["percentile"].as<float>());
         }
         else
         {
             // Altes Backend ohne led_index-Feld — lokale Berechnung als Fallback
             apiLedIndex = mapSentimentToLED(receivedSentiment);
-            debug(F("led_index nicht in Response — lokaler Fallback über mapSentimentToLED()"));
+            LOG_W("led_index nicht in Response — lokaler Fallback über mapSentimentToLED()");
         }
 
         // Kategorie aus API-Response lesen (für MQTT/HA) — Zuweisung an
@@ -370,7 +370,7 @@ void getSentiment()
         }
 
         // LED-Index aus API setzen — einzige Stelle die LEDs steuert
-        debug(String(F("LED-Index setzen: ")) + String(apiLedIndex));
+        LOG_D("LED-Index setzen: %d", apiLedIndex);
         appState.currentLedIndex = apiLedIndex;
         appState.lastLedIndex = apiLedIndex;
         if (appState.autoMode && appState.lightOn)
@@ -406,7 +406,7 @@ void getSentiment()
                     }
                     else
                     {
-                        debug(F("Konnte Analyse-Zeitstempel nicht parsen — Alter wird als 0 angenommen"));
+                        LOG_W("Konnte Analyse-Zeitstempel nicht parsen — Alter wird als 0 angenommen");
                     }
                 }
 
@@ -420,17 +420,17 @@ void getSentiment()
                 if ((unsigned long)remainingMs > appState.moodUpdateInterval) remainingMs = (long)appState.moodUpdateInterval;
 
                 appState.nextMoodPollDelay = (unsigned long)remainingMs;
-                debug(String(F("Servergeführtes Poll-Delay berechnet: ")) + String(appState.nextMoodPollDelay / 1000) +
-                      F(" Sekunden (Analyse-Alter: ") + String(ageSeconds) + F("s, Intervall: ") + String(intervalMinutes) + F("min)"));
+                LOG_D("Servergeführtes Poll-Delay berechnet: %lu Sekunden (Analyse-Alter: %lds, Intervall: %dmin)",
+                      appState.nextMoodPollDelay / 1000, ageSeconds, intervalMinutes);
             }
             else
             {
-                debug(F("next_update_minutes ausserhalb des plausiblen Bereichs — Fallback auf moodUpdateInterval"));
+                LOG_W("next_update_minutes ausserhalb des plausiblen Bereichs — Fallback auf moodUpdateInterval");
             }
         }
         else
         {
-            debug(F("next_update_minutes fehlt in API-Response — Fallback auf moodUpdateInterval"));
+            LOG_W("next_update_minutes fehlt in API-Response — Fallback auf moodUpdateInterval");
         }
 
         // Reset error tracking
@@ -447,7 +447,7 @@ void getSentiment()
     }
     else
     {
-        debug(F("Sentiment Update fehlgeschlagen"));
+        LOG_W("Sentiment Update fehlgeschlagen");
         appState.consecutiveSentimentFailures++;
 
         // Bei API-Ausfall garantiert auf konfiguriertes moodUpdateInterval zurückfallen
@@ -457,7 +457,7 @@ void getSentiment()
         if (appState.consecutiveSentimentFailures >= MAX_SENTIMENT_FAILURES && appState.sentimentAPIAvailable)
         {
             appState.sentimentAPIAvailable = false;
-            debug(F("API nicht erreichbar nach mehreren Fehlversuchen. Wechsel in Neutral-Modus."));
+            LOG_E("API nicht erreichbar nach mehreren Fehlversuchen. Wechsel in Neutral-Modus.");
 
             // Set neutral mood if no previous value exists
             if (!appState.initialAnalysisDone)
@@ -488,7 +488,7 @@ void getSentiment()
     isUpdating = false;
 
     unsigned long finalEffectiveDelay = appState.nextMoodPollDelay > 0 ? appState.nextMoodPollDelay : appState.moodUpdateInterval;
-    debug(String(F("Sentiment Update abgeschlossen. Nächstes Update in ")) + String(finalEffectiveDelay / 1000) + F(" Sekunden."));
+    LOG_I("Sentiment Update abgeschlossen. Nächstes Update in %lu Sekunden.", finalEffectiveDelay / 1000);
 }
 
 // === Lese DHT Sensor und sende an HA ===
@@ -502,7 +502,7 @@ void readAndPublishDHT()
 
     if (millis() - appState.lastDHTUpdate >= appState.dhtUpdateInterval)
     {
-        debug(F("DHT Lesezyklus gestartet..."));
+        LOG_D("DHT Lesezyklus gestartet...");
 
         float temp = NAN;
         float hum = NAN;
@@ -531,16 +531,16 @@ void readAndPublishDHT()
                 {
                     haTemperature.setValue(floatToString(temp, 1).c_str());
                 }
-                debug(String(F("DHT Temp: ")) + String(temp, 1) + F("C (geändert)"));
+                LOG_D("DHT Temp: %.1fC (geändert)", temp);
             }
             else
             {
-                debug(String(F("DHT Temp: ")) + String(temp, 1) + F("C (unverändert)"));
+                LOG_D("DHT Temp: %.1fC (unverändert)", temp);
             }
         }
         else
         {
-            debug(F("DHT Temp Lesefehler!"));
+            LOG_W("DHT Temp Lesefehler!");
         }
 
         // Process humidity if valid
@@ -554,19 +554,19 @@ void readAndPublishDHT()
                 {
                     haHumidity.setValue(floatToString(hum, 1).c_str());
                 }
-                debug(String(F("DHT Hum: ")) + String(hum, 1) + F("% (geändert)"));
+                LOG_D("DHT Hum: %.1f%% (geändert)", hum);
             }
             else
             {
-                debug(String(F("DHT Hum: ")) + String(hum, 1) + F("% (unverändert)"));
+                LOG_D("DHT Hum: %.1f%% (unverändert)", hum);
             }
         }
         else
         {
-            debug(F("DHT Hum Lesefehler!"));
+            LOG_W("DHT Hum Lesefehler!");
         }
 
         appState.lastDHTUpdate = millis();
-        debug(String(F("DHT Lesezyklus beendet. Nächstes Update in ")) + String(appState.dhtUpdateInterval / 1000) + F(" Sekunden."));
+        LOG_D("DHT Lesezyklus beendet. Nächstes Update in %lu Sekunden.", appState.dhtUpdateInterval / 1000);
     }
 }
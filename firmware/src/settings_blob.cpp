@@ -0,0 +1,60 @@
+// settings_blob.cpp — Einstellungsabschnitte kodieren und pruefen, siehe settings_blob.h
+
+#include <Arduino.h>
+#include "esp_rom_crc.h"
+
+#include "settings_blob.h"
+
+uint32_t settingsCrc(const uint8_t *data, size_t len) {
+    return esp_rom_crc32_le(0, data, len);
+}
+
+size_t encodeSettingsSection(uint8_t id, const SettingsPayload &payload, uint8_t *out) {
+    const SettingsSection &section = settingsSections[id];
+    const uint8_t *data = (const uint8_t*)&payload + section.offset;
+
+    SettingsBlobHeader header;
+    header.magic = SETTINGS_BLOB_MAGIC;
+    header.version = SETTINGS_SCHEMA_VERSION;
+    header.reserved = 0;
+    header.payloadSize = section.size;
+    header.reserved2 = 0;
+    header.crc = settingsCrc(data, section.size);
+    memcpy(out, &header, sizeof(header));
+    memcpy(out + sizeof(header), data, section.size);
+    return sizeof(header) + section.size;
+}
+
+// Kopf pruefen; bei OK zeigt data danach auf die Nutzdaten
+static SettingsBlobResult checkBlock(const uint8_t *&data, size_t len, SettingsBlobHeader &header) {
+    if (len < sizeof(header)) {
+        return SETTINGS_BLOB_FORMAT;
+    }
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != SETTINGS_BLOB_MAGIC || header.payloadSize != len - sizeof(header)) {
+        return SETTINGS_BLOB_FORMAT;
+    }
+    data += sizeof(header);
+    if (settingsCrc(data, header.payloadSize) != header.crc) {
+        return SETTINGS_BLOB_CRC;
+    }
+    return SETTINGS_BLOB_OK;
+}
+
+SettingsBlobResult decodeSettingsSection(uint8_t id, const uint8_t *data, size_t len,
+                                         SettingsPayload &payload, uint8_t &version) {
+    const SettingsSection &section = settingsSections[id];
+    SettingsBlobHeader header;
+    SettingsBlobResult result = checkBlock(data, len, header);
+    if (result != SETTINGS_BLOB_OK) {
+        return result;
+    }
+
+    memcpy((uint8_t*)&payload + section.offset, data, min((size_t)header.payloadSize, (size_t)section.size));
+    version = header.version;
+    return SETTINGS_BLOB_OK;
+}
+
+size_t nvsBlobFootprint(size_t len) {
+    return NVS_ENTRY_BYTES * (2 + (len + NVS_ENTRY_BYTES - 1) / NVS_ENTRY_BYTES);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "settings_schema.h"
+
+// === Binaerblock eines Einstellungsabschnitts ===
+// So liegt ein Abschnitt unter settingsSections[id].key im NVS: Kopf mit Magic,
+// Schema-Version, Nutzdatengroesse und CRC32, danach die gepackten Nutzdaten.
+// Kodieren und Pruefen arbeiten nur auf Puffern — NVS-Zugriffe macht
+// settings_manager.cpp, der Host-Test (test/test_settings_blob) misst hier
+// Zeit und Bytes je Speichervorgang.
+
+struct __attribute__((packed)) SettingsBlobHeader {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t reserved;
+    uint16_t payloadSize;
+    uint16_t reserved2;
+    uint32_t crc;               // CRC32 ueber payloadSize Bytes Nutzdaten
+};
+
+// Groesster Block, den encodeSettingsSection() schreibt
+static constexpr size_t SETTINGS_SECTION_BLOB_MAX = sizeof(SettingsBlobHeader) + sizeof(NetworkSettings);
+
+// Ein NVS-Eintrag; Blobs belegen Index-, Kopf- und Dateneintraege
+static constexpr size_t NVS_ENTRY_BYTES = 32;
+
+enum SettingsBlobResult : uint8_t {
+    SETTINGS_BLOB_OK,
+    SETTINGS_BLOB_FORMAT,       // Falsches Magic oder Groesse passt nicht zum Kopf
+    SETTINGS_BLOB_CRC,
+};
+
+uint32_t settingsCrc(const uint8_t *data, size_t len);
+
+// Schreibt Abschnitt id aus payload nach out (mindestens
+// SETTINGS_SECTION_BLOB_MAX Bytes). Rueckgabe: Laenge des Blocks.
+size_t encodeSettingsSection(uint8_t id, const SettingsPayload &payload, uint8_t *out);
+
+// Prueft den Block data und kopiert die Nutzdaten an den Platz von Abschnitt
+// id in payload. payload ist mit dem aktuellen Stand vorbelegt: Felder, die
+// eine aeltere Schema-Version noch nicht kannte, behalten so ihre
+// Standardwerte, laengere Bloecke neuerer Schemata werden abgeschnitten.
+// version: Schema des Blocks.
+SettingsBlobResult decodeSettingsSection(uint8_t id, const uint8_t *data, size_t len,
+                                         SettingsPayload &payload, uint8_t &version);
+
+// Belegte NVS-Bytes fuer einen Blob der Laenge len
+size_t nvsBlobFootprint(size_t len);
@@ -1,262 +1,674 @@
 #include "settings_manager.h"
+#include "settings_blob.h"
+#include "settings_web.h"
 
 #include <ArduinoJson.h>
 #include <Preferences.h>
-#include <Adafruit_NeoPixel.h>
-#include "MoodlightUtils.h"
 #include "LittleFS.h"
+#include "MoodlightUtils.h"
 
 // Externe Objekte aus anderen Modulen
 extern AppState appState;
-extern Adafruit_NeoPixel pixels;
 extern SafeFileOps fileOps;
 
 #include "debug.h"
 
+#define LOG_TAG LOG_TAG_SETTINGS
+
 // Hardware-Instanz — definiert in diesem Modul
 Preferences preferences;
 
-bool saveSettingsToFile() {
-    if (!LittleFS.exists("/data")) {
-        if (!LittleFS.mkdir("/data")) {
-            debug(F("Fehler beim Erstellen des /data Verzeichnisses"));
-            return false;
+// ===== Binaeres Einstellungsformat =====
+// Die Einstellungen liegen in drei Abschnitten im NVS (Namespace "moodlight"),
+// jeder als eigener Key mit Kopf (Magic, Schema-Version, Nutzdatengroesse, CRC32)
+// und gepackten Nutzdaten. Gespeichert wird nur, was sich seit dem letzten
+// Schreiben geaendert hat: saveSettings() vergleicht Feld fuer Feld mit dem
+// zuletzt geschriebenen Stand und schreibt nur die Abschnitte mit geaenderten
+// Feldern. Ein Helligkeits-Slider beruehrt so nur "cfg.run" (bzw. dessen Journal,
+// siehe unten) statt WLAN-, MQTT- und Pin-Konfiguration gleich mit. NVS schreibt
+// jeden Key atomar.
+//
+// Layout der Abschnitte und das Schema stehen in settings_schema.h, das Format
+// eines Blocks in settings_blob.h.
+
+// Bringt alle Zahlen in ihre Grenzen — fuer alles, was aus dem Flash oder einem
+// Altformat kommt
+static void validateSettings(SettingsPayload &p) {
+    for (const SettingSchema &s : settingsSchema) {
+        if (s.type == SETTING_TEXT) {
+            settingPtr(s, p)[s.size - 1] = '\0';
+            continue;
+        }
+        int64_t value = readSetting(s, p);
+        if (!settingInRange(s, value)) {
+            LOG_W("Einstellung '%s' ausserhalb der Grenzen: %ld", s.key, (long)value);
+            writeSetting(s, p, value);
         }
     }
+}
 
-    JsonDocument doc;
+bool settingLimits(const char *key, long &min, long &max) {
+    const SettingSchema *s = findSetting(key);
+    if (!s || s->type == SETTING_TEXT) return false;
+    min = s->min;
+    max = s->max;
+    return true;
+}
 
-    // Allgemeine Einstellungen
-    doc["moodInterval"] = appState.moodUpdateInterval;
-    doc["dhtInterval"] = appState.dhtUpdateInterval;
-    doc["autoMode"] = appState.autoMode;
-    doc["updateCheck"] = appState.updateCheckEnabled;
-    doc["lightOn"] = appState.lightOn;
-    doc["manBright"] = appState.manualBrightness;
-    doc["manColor"] = appState.manualColor;
-    // v9.0: headlinesPS removed - only for legacy API endpoints
-
-    // WiFi-Einstellungen
-    doc["wifiSSID"] = appState.wifiSSID;
-    doc["wifiPass"] = appState.wifiPassword;
-    doc["wifiConfigured"] = appState.wifiConfigured;
-
-    // Erweiterte Einstellungen
-    doc["apiUrl"] = appState.apiUrl;
-    doc["mqttServer"] = appState.mqttServer;
-    doc["mqttUser"] = appState.mqttUser;
-    doc["mqttPass"] = appState.mqttPassword;
-    doc["dhtPin"] = appState.dhtPin;
-    doc["dhtEnabled"] = appState.dhtEnabled;
-    doc["ledPin"] = appState.ledPin;
-    doc["numLeds"] = appState.numLeds;
-    doc["mqttEnabled"] = appState.mqttEnabled;
-
-    // Benutzerdefinierte Farben
-    for (int i = 0; i < 5; i++) {
-        doc["color" + String(i)] = appState.customColors[i];
-    }
-
-    String jsonContent;
-    serializeJson(doc, jsonContent);
-
-    // Verwende die sichere Dateischreibfunktion
-    return fileOps.writeFile("/data/settings.json", jsonContent);
+SettingsStats settingsStats;
+
+// Zuletzt geschriebener bzw. geladener Stand je Abschnitt — Vergleichsbasis
+static SettingsPayload persisted;
+static bool persistedValid[SECTION_COUNT] = {};
+static uint8_t persistedVersion[SECTION_COUNT] = {};   // Schema beim Laden
+
+// Schreibzaehler je Key und Aenderungszaehler je Einstellung seit Boot
+static uint32_t sectionWrites[SECTION_COUNT] = {};
+static uint32_t sectionBytes[SECTION_COUNT] = {};
+static uint32_t fieldChanges[SETTINGS_SCHEMA_COUNT] = {};
+
+template <size_t N>
+static void packText(char *dest, size_t size, const FixedString<N> &value, const char *name) {
+    strlcpy(dest, value.c_str(), size);
+    if (value.length() >= size) {
+        LOG_W("Einstellung gekuerzt: %s", name);
+    }
 }
 
-bool loadSettingsFromFile() {
-    if (!LittleFS.exists("/data/settings.json")) {
+static void packSettings(SettingsPayload &p) {
+    memset(&p, 0, sizeof(p));
+    p.run.manualColor = appState.manualColor;
+    p.run.manualBrightness = appState.manualBrightness;
+    p.run.flags = (appState.autoMode ? SETTING_AUTO_MODE : 0) |
+                  (appState.lightOn ? SETTING_LIGHT_ON : 0);
+
+    p.device.moodInterval = appState.moodUpdateInterval;
+    p.device.dhtInterval = appState.dhtUpdateInterval;
+    memcpy(p.device.customColors, appState.customColors, sizeof(p.device.customColors));
+    p.device.flags = (appState.updateCheckEnabled ? SETTING_UPDATE_CHECK : 0) |
+                     (appState.dhtEnabled ? SETTING_DHT_ENABLED : 0) |
+                     (appState.updatePrefetchEnabled ? SETTING_UPDATE_PREFETCH : 0);
+    p.device.ledPin = appState.ledPin;
+    p.device.dhtPin = appState.dhtPin;
+    p.device.numLeds = appState.numLeds;
+    p.device.prefetchRate = appState.updatePrefetchRate;
+
+    p.net.flags = (appState.wifiConfigured ? SETTING_WIFI_CONFIGURED : 0) |
+                  (appState.mqttEnabled ? SETTING_MQTT_ENABLED : 0);
+    packText(p.net.wifiSSID, sizeof(p.net.wifiSSID), appState.wifiSSID, "wifiSSID");
+    packText(p.net.wifiPassword, sizeof(p.net.wifiPassword), appState.wifiPassword, "wifiPass");
+    packText(p.net.apiUrl, sizeof(p.net.apiUrl), appState.apiUrl, "apiUrl");
+    packText(p.net.mqttServer, sizeof(p.net.mqttServer), appState.mqttServer, "mqttServer");
+    packText(p.net.mqttUser, sizeof(p.net.mqttUser), appState.mqttUser, "mqttUser");
+    packText(p.net.mqttPassword, sizeof(p.net.mqttPassword), appState.mqttPassword, "mqttPass");
+}
+
+static void applySettings(const SettingsPayload &p) {
+    appState.manualColor = p.run.manualColor;
+    appState.manualBrightness = p.run.manualBrightness;
+    appState.autoMode = p.run.flags & SETTING_AUTO_MODE;
+    appState.lightOn = p.run.flags & SETTING_LIGHT_ON;
+
+    appState.moodUpdateInterval = p.device.moodInterval;
+    appState.dhtUpdateInterval = p.device.dhtInterval;
+    memcpy(appState.customColors, p.device.customColors, sizeof(p.device.customColors));
+    appState.updateCheckEnabled = p.device.flags & SETTING_UPDATE_CHECK;
+    appState.dhtEnabled = p.device.flags & SETTING_DHT_ENABLED;
+    appState.ledPin = p.device.ledPin;
+    appState.dhtPin = p.device.dhtPin;
+    appState.numLeds = constrain(p.device.numLeds, 1, MAX_LEDS);
+    appState.statusLedIndex = appState.numLeds - 1;
+    appState.updatePrefetchEnabled = p.device.flags & SETTING_UPDATE_PREFETCH;
+    appState.updatePrefetchRate = p.device.prefetchRate;
+
+    appState.wifiConfigured = p.net.flags & SETTING_WIFI_CONFIGURED;
+    appState.mqttEnabled = p.net.flags & SETTING_MQTT_ENABLED;
+    appState.wifiSSID = p.net.wifiSSID;
+    appState.wifiPassword = p.net.wifiPassword;
+    appState.apiUrl = p.net.apiUrl;
+    appState.mqttServer = p.net.mqttServer;
+    appState.mqttUser = p.net.mqttUser;
+    appState.mqttPassword = p.net.mqttPassword;
+}
+
+// ===== Journal fuer den Bedienzustand =====
+// Helligkeit, Farbe, Modus und Ein/Aus aendern sich unter Home-Assistant-
+// Automationen staendig. Aendert sich nur cfg.run, haengt saveSettings() den
+// Stand als 8-Byte-Datensatz an ein Journal an (Namespace JOURNAL_NAMESPACE,
+// Keys j0, j1, ...) statt den Block neu zu schreiben. Ein Datensatz ist genau
+// ein NVS-Eintrag von 32 Bytes unter einem neuen Key — nichts wird ueberschrieben.
+// Der Block dagegen belegt Index-, Kopf- und Dateneintrag und markiert die alten
+// als geloescht. Ist das Journal voll, wird cfg.run einmal geschrieben und das
+// Journal geleert. loadSettings() spielt die Datensaetze beim Boot nach.
+
+#define JOURNAL_NAMESPACE "moodjournal"
+
+struct __attribute__((packed)) JournalRecord {
+    uint8_t red;
+    uint8_t green;
+    uint8_t blue;
+    uint8_t brightness;
+    uint8_t flags;              // wie RuntimeSettings.flags
+    uint8_t seq;                // Untere 8 Bit der Datensatznummer
+    uint16_t check;             // Untere 16 Bit der CRC32 ueber die ersten 6 Bytes
+};
+static_assert(sizeof(JournalRecord) == sizeof(uint64_t), "Journal-Datensatz muss in einen NVS-Eintrag passen");
+
+static uint16_t journalCount = 0;       // Datensaetze im NVS = naechster freier Index
+
+static struct {
+    uint32_t appends = 0;
+    uint32_t compactions = 0;
+    uint16_t replayed = 0;
+    uint32_t replayMicros = 0;
+    uint32_t logicalBytes = 0;          // Geaenderter Bedienzustand (6 Bytes je Aenderung)
+    uint32_t flashBytes = 0;            // Davon belegte NVS-Eintraege inkl. Verdichtung
+} journalStats;
+
+static uint16_t journalCheck(const JournalRecord &rec) {
+    return settingsCrc((const uint8_t*)&rec, offsetof(JournalRecord, check)) & 0xFFFF;
+}
+
+static String journalKey(uint16_t index) {
+    return "j" + String(index);
+}
+
+// Haengt run an. false wenn das Journal voll ist oder der Stand nicht in einen
+// Datensatz passt — dann schreibt der Aufrufer cfg.run.
+static bool journalAppend(const RuntimeSettings &run) {
+    if (journalCount >= JOURNAL_MAX_RECORDS || run.manualColor > 0xFFFFFF) {
         return false;
     }
 
-    // Lese die Datei mit der sicheren Lesefunktion
-    String jsonContent = fileOps.readFile("/data/settings.json");
-    if (jsonContent.isEmpty()) {
-        debug(F("Fehler beim Lesen der Einstellungen aus Datei"));
+    JournalRecord rec;
+    rec.red = run.manualColor >> 16;
+    rec.green = run.manualColor >> 8;
+    rec.blue = run.manualColor;
+    rec.brightness = run.manualBrightness;
+    rec.flags = run.flags;
+    rec.seq = journalCount & 0xFF;
+    rec.check = journalCheck(rec);
+
+    uint64_t raw;
+    memcpy(&raw, &rec, sizeof(raw));
+    preferences.begin(JOURNAL_NAMESPACE, false);
+    bool ok = preferences.putULong64(journalKey(journalCount).c_str(), raw) == sizeof(raw);
+    preferences.end();
+    if (!ok) {
         return false;
     }
 
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, jsonContent);
+    journalCount++;
+    journalStats.appends++;
+    journalStats.flashBytes += NVS_ENTRY_BYTES;
+    return true;
+}
+
+// Leert das Journal. Vor dem Schreiben von cfg.run aufrufen: faellt dazwischen
+// der Strom aus, geht hoechstens die letzte Aenderung verloren — umgekehrt wuerde
+// ein altes Journal den neueren Block beim Boot ueberschreiben.
+static void journalClear() {
+    if (journalCount == 0) {
+        return;
+    }
+    preferences.begin(JOURNAL_NAMESPACE, false);
+    preferences.clear();
+    preferences.end();
+    journalCount = 0;
+    journalStats.compactions++;
+}
+
+// Spielt die Datensaetze auf payload.run nach. Ein ungueltiger Datensatz (z.B.
+// Stromausfall beim Schreiben) beendet das Nachspielen; der naechste Append
+// ueberschreibt ihn.
+static void journalReplay(SettingsPayload &payload) {
+    unsigned long start = micros();
+    uint16_t count = 0;
+
+    preferences.begin(JOURNAL_NAMESPACE, true);
+    for (; count < JOURNAL_MAX_RECORDS; count++) {
+        String key = journalKey(count);
+        if (!preferences.isKey(key.c_str())) {
+            break;
+        }
+        uint64_t raw = preferences.getULong64(key.c_str(), 0);
+        JournalRecord rec;
+        memcpy(&rec, &raw, sizeof(rec));
+        if (rec.check != journalCheck(rec) || rec.seq != (count & 0xFF)) {
+            LOG_W("Journal: Datensatz %u ungueltig — Rest verworfen", count);
+            break;
+        }
+        payload.run.manualColor = ((uint32_t)rec.red << 16) | ((uint32_t)rec.green << 8) | rec.blue;
+        payload.run.manualBrightness = rec.brightness;
+        payload.run.flags = rec.flags;
+    }
+    preferences.end();
+
+    journalCount = count;
+    journalStats.replayed = count;
+    journalStats.replayMicros = micros() - start;
+}
+
+void clearSettingsJournal() {
+    preferences.begin(JOURNAL_NAMESPACE, false);
+    preferences.clear();
+    preferences.end();
+    journalCount = 0;
+}
+
+// Liest und prueft einen Abschnitt direkt in seinen Platz in payload.
+// Preferences muss geoeffnet sein.
+static bool loadSection(uint8_t id, SettingsPayload &payload) {
+    const SettingsSection &section = settingsSections[id];
+    size_t len = preferences.isKey(section.key) ? preferences.getBytesLength(section.key) : 0;
+    if (len < sizeof(SettingsBlobHeader) || len > SETTINGS_BLOB_MAX_BYTES) {
+        if (len > 0) {
+            LOG_E("Einstellungen '%s': ungueltige Groesse %u", section.key, (unsigned)len);
+        }
+        return false;
+    }
+
+    // Die Nutzdaten gehen vom Stack-Puffer ohne Umweg ueber Strings oder JSON
+    // in ihr Feld in payload
+    uint8_t buffer[SETTINGS_BLOB_MAX_BYTES];
+    if (preferences.getBytes(section.key, buffer, len) != len) {
+        return false;
+    }
+
+    uint8_t version = 0;
+    switch (decodeSettingsSection(id, buffer, len, payload, version)) {
+        case SETTINGS_BLOB_OK:
+            break;
+        case SETTINGS_BLOB_FORMAT:
+            LOG_E("Einstellungen '%s' unbekannt oder abgeschnitten — verworfen", section.key);
+            return false;
+        case SETTINGS_BLOB_CRC:
+            LOG_E("Einstellungen '%s': CRC-Fehler — verworfen", section.key);
+            return false;
+    }
+
+    if (version != SETTINGS_SCHEMA_VERSION) {
+        LOG_I("Einstellungen '%s': Schema %u -> %d", section.key, version, SETTINGS_SCHEMA_VERSION);
+    }
+    persistedVersion[id] = version;
+    return true;
+}
+
+// Liest alle Abschnitte. false wenn keiner da ist — dann greifen die Altformate
+// bzw. die Standardwerte. Ein einzelner beschaedigter Abschnitt behaelt seine
+// Standardwerte und wird beim naechsten Speichern neu geschrieben.
+static bool loadSettingsBlob() {
+    SettingsPayload payload;
+    packSettings(payload);
+
+    bool any = false;
+    preferences.begin("moodlight", true);
+    for (int i = 0; i < SECTION_COUNT; i++) {
+        persistedValid[i] = loadSection(i, payload);
+        any |= persistedValid[i];
+    }
+    preferences.end();
+
+    if (any) {
+        journalReplay(payload);
+        validateSettings(payload);
+        applySettings(payload);
+        persisted = payload;
+    }
+    return any;
+}
+
+// Schreibt einen Abschnitt aus image. Preferences muss schreibbar geoeffnet sein.
+static size_t writeSection(uint8_t id, const SettingsPayload &image) {
+    uint8_t buffer[SETTINGS_SECTION_BLOB_MAX];
+    size_t len = encodeSettingsSection(id, image, buffer);
+    return preferences.putBytes(settingsSections[id].key, buffer, len) == len ? len : 0;
+}
+
+bool settingsStored() {
+    preferences.begin("moodlight", true);
+    bool stored = false;
+    for (int i = 0; i < SECTION_COUNT && !stored; i++) {
+        stored = preferences.isKey(settingsSections[i].key);
+    }
+    preferences.end();
+    return stored;
+}
+
+// Exportformat: dieselben Schluessel wie die fruehere /data/settings.json,
+// Passwoerter maskiert. Wird nicht mehr gespeichert, nur noch ausgeliefert.
+void exportSettingsJson(JsonDocument &doc) {
+    SettingsPayload p;
+    packSettings(p);
+
+    doc["schema"] = SETTINGS_SCHEMA_VERSION;
+    for (const SettingSchema &s : settingsSchema) {
+        switch (s.type) {
+            case SETTING_TEXT: {
+                const char *text = (const char*)settingPtr(s, p);
+                doc[s.key] = (s.web & SETTING_SECRET) ? (*text ? "****" : "") : text;
+                break;
+            }
+            case SETTING_FLAG:
+                doc[s.key] = readSetting(s, p) != 0;
+                break;
+            case SETTING_U32:
+                doc[s.key] = (uint32_t)readSetting(s, p);
+                break;
+            default:
+                doc[s.key] = (int)readSetting(s, p);
+                break;
+        }
+    }
+}
+
+void settingsWebJson(JsonDocument &doc) {
+    SettingsPayload p;
+    packSettings(p);
+    settingsWebJson(p, doc);
+}
+
+void settingsFormJson(SettingForm form, JsonDocument &doc) {
+    SettingsPayload p;
+    packSettings(p);
+    settingsFormJson(form, p, doc);
+}
 
+int applySettingsForm(SettingForm form, JsonVariantConst in, String &error) {
+    SettingsPayload p;
+    packSettings(p);
+
+    int changed = settingsFromForm(form, in, p, error);
+    if (changed > 0) {
+        applySettings(p);
+    }
+    return changed;
+}
+
+// Direkt aus dem Dateihandle parsen — kein Zwischen-String mit dem Dateiinhalt
+static bool parseSettingsFile(const char *path, JsonDocument &doc) {
+    if (!LittleFS.exists(path)) {
+        return false;
+    }
+    File file = LittleFS.open(path, "r");
+    if (!file) {
+        LOG_E("Fehler beim Lesen der Einstellungen aus %s", path);
+        return false;
+    }
+    DeserializationError error = deserializeJson(doc, file);
+    file.close();
     if (error) {
-        debug(String(F("JSON-Parsing-Fehler beim Laden der Einstellungen: ")) + error.c_str());
+        LOG_E("JSON-Parsing-Fehler in %s: %s", path, error.c_str());
         return false;
     }
+    return true;
+}
 
-    // Einstellungen aus JSON extrahieren
-    appState.moodUpdateInterval = doc["moodInterval"] | DEFAULT_MOOD_UPDATE_INTERVAL;
-    appState.dhtUpdateInterval = doc["dhtInterval"] | DEFAULT_DHT_READ_INTERVAL;
-    // v9.0: headlinesPS removed
-    appState.autoMode = doc["autoMode"] | true;
-    appState.updateCheckEnabled = doc["updateCheck"] | true;
-    appState.lightOn = doc["lightOn"] | true;
-    appState.manualBrightness = doc["manBright"] | DEFAULT_LED_BRIGHTNESS;
-    appState.manualColor = doc["manColor"] | pixels.Color(255, 255, 255);
+// Altformat 1: /data/settings.json (bis Firmware 9.22 bei jedem Speichern
+// ueber SafeFileOps geschrieben). Fehlt die Datei oder ist sie kaputt — etwa
+// nach einem Stromausfall zwischen Loeschen und Umbenennen in writeFile() —,
+// gilt die Backup-Kopie daneben.
+static bool loadLegacySettingsFile() {
+    const char *path = "/data/settings.json";
+    String backup = fileOps.backupPath(path);
 
-    // WiFi-Einstellungen
-    appState.wifiSSID = doc["wifiSSID"] | "";
-    {
-        String loadedWifiPass = doc["wifiPass"] | "";
-        if (loadedWifiPass != "****") {
-            appState.wifiPassword = loadedWifiPass;
+    JsonDocument doc;
+    if (!parseSettingsFile(path, doc)) {
+        doc.clear();
+        if (!parseSettingsFile(backup.c_str(), doc)) {
+            return false;
         }
+        LOG_W("Einstellungen aus Backup %s gelesen", backup);
     }
-    appState.wifiConfigured = doc["wifiConfigured"] | false;
 
-    // Erweiterte Einstellungen
-    appState.apiUrl = doc["apiUrl"] | DEFAULT_NEWS_API_URL;
-    appState.mqttServer = doc["mqttServer"] | "";
-    appState.mqttUser = doc["mqttUser"] | "";
-    {
-        String loadedMqttPass = doc["mqttPass"] | "";
-        if (loadedMqttPass != "****") {
-            appState.mqttPassword = loadedMqttPass;
+    // Fehlende Schluessel behalten den aktuellen Stand (Standardwerte)
+    SettingsPayload p;
+    packSettings(p);
+    for (const SettingSchema &s : settingsSchema) {
+        JsonVariantConst value = doc[s.key];
+        if (value.isNull()) continue;
+        if (s.type == SETTING_TEXT) {
+            const char *text = value | "";
+            if (!((s.web & SETTING_SECRET) && strcmp(text, "****") == 0)) {
+                writeSettingText(s, p, text);
+            }
+        } else if (s.type == SETTING_FLAG) {
+            writeSetting(s, p, value.as<bool>());
+        } else if (value.is<long long>()) {
+            writeSetting(s, p, value.as<long long>());
         }
     }
-    appState.dhtPin = doc["dhtPin"] | DEFAULT_DHT_PIN;
-    appState.dhtEnabled = doc["dhtEnabled"] | true;
-    appState.ledPin = doc["ledPin"] | DEFAULT_LED_PIN;
-    appState.numLeds = constrain(doc["numLeds"] | DEFAULT_NUM_LEDS, 1, MAX_LEDS);
-    appState.statusLedIndex = appState.numLeds - 1;
-    appState.mqttEnabled = doc["mqttEnabled"] | false;
+    validateSettings(p);
+    applySettings(p);
+    return true;
+}
+
+// Altformat 2: einzelne Preferences-Keys (noch aelter als die JSON-Datei).
+// Die Keys sind die Schema-Schluessel; der NVS-Typ muss zum alten Getter passen.
+static bool loadLegacyPreferences() {
+    preferences.begin("moodlight", true); // read-only
+    if (!preferences.isKey("moodInterval")) {
+        preferences.end();
+        return false;
+    }
 
-    // Benutzerdefinierte Farben laden
-    for (int i = 0; i < 5; i++) {
-        String colorKey = "color" + String(i);
-        if (doc[colorKey].is<uint32_t>()) {
-            appState.customColors[i] = doc[colorKey].as<uint32_t>();
+    SettingsPayload p;
+    packSettings(p);
+    for (const SettingSchema &s : settingsSchema) {
+        if (!preferences.isKey(s.key)) continue;
+        switch (s.type) {
+            case SETTING_U32: writeSetting(s, p, preferences.getULong(s.key)); break;
+            case SETTING_U8: writeSetting(s, p, preferences.getUChar(s.key)); break;
+            case SETTING_FLAG: writeSetting(s, p, preferences.getBool(s.key)); break;
+            case SETTING_TEXT: preferences.getString(s.key, (char*)settingPtr(s, p), s.size); break;
+            default: writeSetting(s, p, preferences.getInt(s.key)); break;
         }
     }
+    preferences.end();
 
+    validateSettings(p);
+    applySettings(p);
     return true;
 }
 
+// Loescht die Einzel-Keys (~25 NVS-Eintraege). Erst
+// aufrufen, wenn alle Bloecke geschrieben sind — bis dahin sind die Keys die
+// einzige Kopie.
+static void clearLegacyPreferences() {
+    uint8_t removed = 0;
+    preferences.begin("moodlight", false);
+    for (const SettingSchema &s : settingsSchema) {
+        if (preferences.isKey(s.key) && preferences.remove(s.key)) {
+            removed++;
+        }
+    }
+    preferences.end();
+    if (removed > 0) {
+        LOG_I("Einstellungen: %u alte Keys geloescht", removed);
+    }
+}
+
 // === Einstellungen speichern/laden ===
 void saveSettings()
 {
+    unsigned long start = micros();
 
-    // Erst in JSON-Datei speichern (neue Methode) — JSON hat beim Laden Vorrang,
-    // daher bei Fehlschlag die (moeglicherweise veraltete) Datei entfernen statt
-    // stillschweigend mit stale Daten weiterzuarbeiten
-    if (!saveSettingsToFile()) {
-        debug(F("FEHLER: Einstellungen konnten nicht in JSON-Datei gespeichert werden — entferne evtl. veraltete Datei"));
-        if (LittleFS.exists("/data/settings.json")) {
-            LittleFS.remove("/data/settings.json");
+    SettingsPayload current;
+    packSettings(current);
+
+    // Geaenderte Felder bestimmen; ein Abschnitt ohne gueltigen NVS-Stand gilt
+    // komplett als geaendert
+    bool dirty[SECTION_COUNT];
+    String changed;
+    for (int i = 0; i < SECTION_COUNT; i++) {
+        dirty[i] = !persistedValid[i];
+    }
+    for (size_t i = 0; i < SETTINGS_SCHEMA_COUNT; i++) {
+        const SettingSchema &field = settingsSchema[i];
+        if (!persistedValid[field.section] || settingDiffers(field, current, persisted)) {
+            dirty[field.section] = true;
+            fieldChanges[i]++;
+            if (persistedValid[field.section]) {
+                changed += changed.length() ? "," : "";
+                changed += field.key;
+            }
         }
     }
-    // Dann in Preferences speichern (bestehende Methode)
-    preferences.begin("moodlight", false);
 
-    // Speichere allgemeine Einstellungen
-    preferences.putULong("moodInterval", appState.moodUpdateInterval);
-    preferences.putULong("dhtInterval", appState.dhtUpdateInterval);
-    preferences.putBool("autoMode", appState.autoMode);
-    preferences.putBool("updateCheck", appState.updateCheckEnabled);
-    preferences.putBool("lightOn", appState.lightOn);
-    preferences.putUChar("manBright", appState.manualBrightness);
-    preferences.putUInt("manColor", appState.manualColor);
-    // v9.0: headlinesPS removed
-
-    // Speichere WiFi-Einstellungen
-    preferences.putString("wifiSSID", appState.wifiSSID);
-    preferences.putString("wifiPass", appState.wifiPassword);
-    preferences.putBool("wifiConfigured", appState.wifiConfigured);
-
-    // Speichere erweiterte Einstellungen
-    preferences.putString("apiUrl", appState.apiUrl);
-    preferences.putString("mqttServer", appState.mqttServer);
-    preferences.putString("mqttUser", appState.mqttUser);
-    preferences.putString("mqttPass", appState.mqttPassword);
-    preferences.putInt("dhtPin", appState.dhtPin);
-    preferences.putBool("dhtEnabled", appState.dhtEnabled);
-    preferences.putInt("ledPin", appState.ledPin);
-    preferences.putInt("numLeds", appState.numLeds);
-    preferences.putBool("mqttEnabled", appState.mqttEnabled);
-
-    // Speichere benutzerdefinierte Farben
-    preferences.putUInt("color0", appState.customColors[0]);
-    preferences.putUInt("color1", appState.customColors[1]);
-    preferences.putUInt("color2", appState.customColors[2]);
-    preferences.putUInt("color3", appState.customColors[3]);
-    preferences.putUInt("color4", appState.customColors[4]);
+    if (!dirty[SECTION_RUN] && !dirty[SECTION_DEVICE] && !dirty[SECTION_NET]) {
+        settingsStats.skippedSaves++;
+        return;
+    }
 
+    if (dirty[SECTION_RUN] && persistedValid[SECTION_RUN]) {
+        journalStats.logicalBytes += sizeof(RuntimeSettings);
+    }
+
+    // Nur der Bedienzustand geaendert: ans Journal anhaengen
+    if (dirty[SECTION_RUN] && persistedValid[SECTION_RUN] && !dirty[SECTION_DEVICE] && !dirty[SECTION_NET] &&
+        journalAppend(current.run)) {
+        persisted.run = current.run;
+        settingsStats.saves++;
+        settingsStats.lastSaveMicros = micros() - start;
+        settingsStats.bytesWritten += sizeof(JournalRecord);
+        LOG_D("Einstellungen ins Journal (%s; %u/%d, %lu us)", changed, journalCount, JOURNAL_MAX_RECORDS,
+              (unsigned long)settingsStats.lastSaveMicros);
+        return;
+    }
+    if (dirty[SECTION_RUN]) {
+        journalClear();
+    }
+
+    size_t written = 0;
+    bool failed = false;
+    preferences.begin("moodlight", false);
+    for (int i = 0; i < SECTION_COUNT; i++) {
+        if (!dirty[i]) continue;
+        size_t len = writeSection(i, current);
+        if (len == 0) {
+            failed = true;
+            persistedValid[i] = false;
+            LOG_E("Einstellungen '%s' konnten nicht gespeichert werden", settingsSections[i].key);
+            continue;
+        }
+        memcpy((uint8_t*)&persisted + settingsSections[i].offset,
+               (const uint8_t*)&current + settingsSections[i].offset, settingsSections[i].size);
+        persistedValid[i] = true;
+        sectionWrites[i]++;
+        sectionBytes[i] += len;
+        written += len;
+        if (i == SECTION_RUN) {
+            journalStats.flashBytes += nvsBlobFootprint(len);
+        }
+    }
     preferences.end();
-    debug(F("Einstellungen in Preferences gespeichert."));
 
+    settingsStats.saves++;
+    settingsStats.lastSaveMicros = micros() - start;
+    settingsStats.bytesWritten += written;
+    if (failed) {
+        settingsStats.failedSaves++;
+        return;
+    }
+    LOG_I("Einstellungen gespeichert (%s; %u Bytes, %lu us)", changed.length() ? changed.c_str() : "alle",
+          (unsigned)written, (unsigned long)settingsStats.lastSaveMicros);
+}
+
+void settingsWriteStats(JsonObject out) {
+    JsonObject keys = out["keys"].to<JsonObject>();
+    for (int i = 0; i < SECTION_COUNT; i++) {
+        JsonObject key = keys[settingsSections[i].key].to<JsonObject>();
+        key["writes"] = sectionWrites[i];
+        key["bytes"] = sectionBytes[i];
+    }
+    JsonObject journal = out["journal"].to<JsonObject>();
+    journal["records"] = journalCount;
+    journal["capacity"] = JOURNAL_MAX_RECORDS;
+    journal["appends"] = journalStats.appends;
+    journal["compactions"] = journalStats.compactions;
+    journal["replayed"] = journalStats.replayed;
+    journal["replayUs"] = journalStats.replayMicros;
+    journal["logicalBytes"] = journalStats.logicalBytes;
+    journal["flashBytes"] = journalStats.flashBytes;
+    // Flash-Bytes je geaendertem Byte Bedienzustand; ohne Journal waeren es
+    // nvsBlobFootprint(cfg.run) / 6 = 16
+    journal["writeAmplification"] = journalStats.logicalBytes > 0
+        ? (float)journalStats.flashBytes / journalStats.logicalBytes : 0;
+
+    JsonObject fields = out["fieldChanges"].to<JsonObject>();
+    for (size_t i = 0; i < SETTINGS_SCHEMA_COUNT; i++) {
+        if (fieldChanges[i] > 0) {
+            fields[settingsSchema[i].key] = fieldChanges[i];
+        }
+    }
 }
 
 void loadSettings()
 {
-    // Zuerst versuchen wir aus der JSON-Datei zu laden
-    bool fileLoadSuccess = loadSettingsFromFile();
-
-    // Wenn das fehlschlägt, versuchen wir aus Preferences zu laden
-    if (!fileLoadSuccess)
-    {
-        debug(F("Lade Einstellungen aus Preferences als Fallback..."));
-        preferences.begin("moodlight", true); // read-only
-
-        // Lade allgemeine Einstellungen (symmetrisch zu saveSettings() — nicht auf Defaults zurückfallen,
-        // wenn bereits Werte in Preferences existieren)
-        appState.moodUpdateInterval = preferences.getULong("moodInterval", DEFAULT_MOOD_UPDATE_INTERVAL);
-        appState.dhtUpdateInterval = preferences.getULong("dhtInterval", DEFAULT_DHT_READ_INTERVAL);
-        // v9.0: headlines_per_source removed
-        appState.autoMode = preferences.getBool("autoMode", true);
-        appState.updateCheckEnabled = preferences.getBool("updateCheck", true);
-        appState.lightOn = preferences.getBool("lightOn", true);
-        appState.manualBrightness = preferences.getUChar("manBright", DEFAULT_LED_BRIGHTNESS);
-        appState.manualColor = preferences.getUInt("manColor", pixels.Color(255, 255, 255));
-
-        // Lade WiFi-Einstellungen
-        appState.wifiSSID = preferences.getString("wifiSSID", "");
-        appState.wifiPassword = preferences.getString("wifiPass", "");
-        appState.wifiConfigured = preferences.getBool("wifiConfigured", false);
-
-        // Lade erweiterte Einstellungen
-        appState.apiUrl = preferences.getString("apiUrl", DEFAULT_NEWS_API_URL);
-        appState.mqttServer = preferences.getString("mqttServer", "");
-        appState.mqttUser = preferences.getString("mqttUser", "");
-        appState.mqttPassword = preferences.getString("mqttPass", "");
-        appState.dhtPin = preferences.getInt("dhtPin", DEFAULT_DHT_PIN);
-        appState.dhtEnabled = preferences.getBool("dhtEnabled", true);
-        appState.ledPin = preferences.getInt("ledPin", DEFAULT_LED_PIN);
-        appState.numLeds = constrain(preferences.getInt("numLeds", DEFAULT_NUM_LEDS), 1, MAX_LEDS);
-        appState.statusLedIndex = appState.numLeds - 1;
-        appState.mqttEnabled = preferences.getBool("mqttEnabled", false);
-
-        // Benutzerdefinierte Farben laden
-        appState.customColors[0] = preferences.getUInt("color0", 0xFF0000);
-        appState.customColors[1] = preferences.getUInt("color1", 0xFFA500);
-        appState.customColors[2] = preferences.getUInt("color2", 0x1E90FF);
-        appState.customColors[3] = preferences.getUInt("color3", 0x545DF0);
-        appState.customColors[4] = preferences.getUInt("color4", 0x8A2BE2);
-        preferences.end();
-
-        // Nach dem Laden aus Preferences, in Datei speichern für den nächsten Ladevorgang
-        saveSettingsToFile();
-        debug(F("Einstellungen aus Preferences in JSON-Datei migriert"));
+    unsigned long start = micros();
+
+    // Reihenfolge: aktuelles Binaerformat, dann die Altformate vom neuesten zum
+    // aeltesten. Ein Altformat wird einmalig ins Binaerformat uebernommen und
+    // danach nicht mehr gelesen. Die JSON-Datei bleibt liegen: faellt das Geraet
+    // per OTA-Rollback auf eine alte Firmware zurueck, liest diese sie vor den
+    // Einzel-Keys. Die Keys werden nach der Uebernahme geloescht.
+    if (loadSettingsBlob()) {
+        settingsStats.source = "nvs";
+    } else if (loadLegacySettingsFile()) {
+        settingsStats.source = "json";
+    } else if (loadLegacyPreferences()) {
+        settingsStats.source = "prefs";
+    } else {
+        settingsStats.source = "defaults";
+    }
+    settingsStats.lastLoadMicros = micros() - start;
+
+    if (strcmp(settingsStats.source, "nvs") != 0) {
+        // Ohne geladenen Abschnitt lief kein journalReplay(): journalCount steht
+        // auf 0, alte j1..jN aus einem frueheren Stand lagen sonst weiter im NVS
+        // und wuerden beim naechsten Boot ueber die neuen Datensaetze gespielt
+        clearSettingsJournal();
+        saveSettings();
+        LOG_I("Einstellungen aus '%s' ins Binaerformat uebernommen", settingsStats.source);
+        if (persistedValid[SECTION_RUN] && persistedValid[SECTION_DEVICE] && persistedValid[SECTION_NET]) {
+            clearLegacyPreferences();
+        }
+    } else {
+        // Abschnitte aus einem aelteren Schema gleich im aktuellen neu schreiben
+        for (int i = 0; i < SECTION_COUNT; i++) {
+            if (persistedValid[i] && persistedVersion[i] != SETTINGS_SCHEMA_VERSION) {
+                persistedValid[i] = false;
+            }
+        }
+        // Fehlende oder beschaedigte Abschnitte gleich mit Standardwerten ersetzen
+        if (!persistedValid[SECTION_RUN] || !persistedValid[SECTION_DEVICE] || !persistedValid[SECTION_NET]) {
+            saveSettings();
+        }
     }
 
     // Log der geladenen Einstellungen
-    debug(F("Einstellungen geladen:"));
-    debug("  Mood Interval: " + String(appState.moodUpdateInterval / 1000) + "s");
-    debug("  DHT Interval: " + String(appState.dhtUpdateInterval / 1000) + "s");
-    debug(String(F("  DHT Enabled: ")) + (appState.dhtEnabled ? "ja" : "nein"));
+    LOG_I("Einstellungen geladen (%s, %lu us):", settingsStats.source, (unsigned long)settingsStats.lastLoadMicros);
+    if (journalStats.replayed > 0) {
+        LOG_I("  Journal: %u Datensaetze in %lu us nachgespielt", journalStats.replayed,
+              (unsigned long)journalStats.replayMicros);
+    }
+    LOG_D("  Mood Interval: %lus", appState.moodUpdateInterval / 1000);
+    LOG_D("  DHT Interval: %lus", appState.dhtUpdateInterval / 1000);
+    LOG_D("  DHT Enabled: %s", appState.dhtEnabled ? "ja" : "nein");
     // v9.0: Headlines debugging removed
-    debug(String(F("  AutoMode: ")) + (appState.autoMode ? "true" : "false"));
-    debug(String(F("  LightOn: ")) + (appState.lightOn ? "true" : "false"));
-    debug(String(F("  WiFi konfiguriert: ")) + (appState.wifiConfigured ? "ja" : "nein"));
+    LOG_D("  AutoMode: %s", appState.autoMode ? "true" : "false");
+    LOG_D("  LightOn: %s", appState.lightOn ? "true" : "false");
+    LOG_D("  WiFi konfiguriert: %s", appState.wifiConfigured ? "ja" : "nein");
 
     if (appState.wifiConfigured)
     {
-        debug(String(F("  WiFi SSID: ")) + appState.wifiSSID);
+        LOG_D("  WiFi SSID: %s", appState.wifiSSID);
     }
 
-    debug(String(F("  API URL: ")) + appState.apiUrl);
-    debug(String(F("  MQTT Enabled: ")) + (appState.mqttEnabled ? "ja" : "nein"));
+    LOG_D("  API URL: %s", appState.apiUrl);
+    LOG_D("  MQTT Enabled: %s", appState.mqttEnabled ? "ja" : "nein");
     if (appState.mqttEnabled)
     {
-        debug(String(F("  MQTT Server: ")) + appState.mqttServer);
+        LOG_D("  MQTT Server: %s", appState.mqttServer);
     }
 }
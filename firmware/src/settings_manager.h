@@ -1,6 +1,8 @@
 #pragma once
 
 #include "app_state.h"
+#include "settings_schema.h"
+#include <ArduinoJson.h>
 #include <Preferences.h>
 
 // Hardware-Instanz — definiert in settings_manager.cpp
@@ -9,7 +11,47 @@ extern Preferences preferences;
 // Settings-Manager: Laden und Speichern der Geraeteeinstellungen
 // Implementierung in settings_manager.cpp
 
-bool saveSettingsToFile();
-bool loadSettingsFromFile();
+// Kennzahlen fuer /api/system/metrics
+struct SettingsStats {
+    const char *source = "defaults";   // Woher der letzte Ladevorgang kam: nvs, json, prefs, defaults
+    uint32_t lastLoadMicros = 0;
+    uint32_t saves = 0;                // Speichervorgaenge mit mindestens einem geschriebenen Key
+    uint32_t skippedSaves = 0;         // saveSettings() ohne Aenderung — nichts geschrieben
+    uint32_t failedSaves = 0;
+    uint32_t lastSaveMicros = 0;
+    uint32_t bytesWritten = 0;         // Summe seit Boot
+};
+extern SettingsStats settingsStats;
+
 void saveSettings();
 void loadSettings();
+
+// Grenzen aus dem Einstellungsschema (settings_manager.cpp), fuer Handler
+// ausserhalb der Formulare (/api/update/prefetch). Zeiten in ms.
+bool settingLimits(const char *key, long &min, long &max);
+
+// Liegt ein Einstellungsblock im NVS?
+bool settingsStored();
+
+// Schreibzaehler je NVS-Key, Journal-Kennzahlen und Aenderungszaehler je Feld
+// (fuer /api/system/metrics)
+void settingsWriteStats(JsonObject out);
+
+// Loescht das Journal des Bedienzustands (Factory Reset)
+void clearSettingsJournal();
+
+// Einstellungen als JSON (Exportformat, Passwoerter maskiert)
+void exportSettingsJson(JsonDocument &doc);
+
+// /api/settings/all: alle Einstellungen in der Darstellung der WebUI
+// (Sekunden, "#RRGGBB", Farben als Array), ohne Passwoerter
+void settingsWebJson(JsonDocument &doc);
+
+// Felder eines Formulars unter ihren Formularnamen, Passwoerter maskiert
+// (/api/settings/mqtt)
+void settingsFormJson(SettingForm form, JsonDocument &doc);
+
+// Uebernimmt die Felder von form aus in (settingsFromForm(), settings_web.h).
+// Rueckgabe: Zahl geaenderter Felder, -1 bei ungueltiger Eingabe (Meldung in
+// error, AppState unveraendert).
+int applySettingsForm(SettingForm form, JsonVariantConst in, String &error);
@@ -0,0 +1,149 @@
+// settings_schema.cpp — Zugriff auf SettingsPayload ueber das Schema
+//
+// Alles hier arbeitet zeilenweise auf settingsSchema (settings_schema.h) und
+// baut keine Strings zur Laufzeit: Schluessel und Grenzen stehen im Flash,
+// Werte werden direkt im Block gelesen und geschrieben.
+
+#include <Arduino.h>
+
+#include "settings_schema.h"
+
+const SettingSchema *findSetting(const char *key) {
+    for (const SettingSchema &s : settingsSchema) {
+        if (strcmp(s.key, key) == 0) return &s;
+    }
+    return nullptr;
+}
+
+int64_t readSetting(const SettingSchema &s, const SettingsPayload &p) {
+    const uint8_t *ptr = settingPtr(s, p);
+    switch (s.type) {
+        case SETTING_U32: { uint32_t v; memcpy(&v, ptr, sizeof(v)); return v; }
+        case SETTING_U8: return *ptr;
+        case SETTING_FLAG: return (*ptr & s.mask) ? 1 : 0;
+        default: return (int8_t)*ptr;
+    }
+}
+
+bool settingInRange(const SettingSchema &s, int64_t value) {
+    if (value < s.min || value > s.max) return false;
+    return s.type != SETTING_PIN || value < 6 || value > 11;
+}
+
+void writeSetting(const SettingSchema &s, SettingsPayload &p, int64_t value) {
+    if (s.type == SETTING_PIN && !settingInRange(s, value)) {
+        value = s.def;
+    }
+    value = constrain(value, (int64_t)s.min, (int64_t)s.max);
+
+    uint8_t *ptr = settingPtr(s, p);
+    switch (s.type) {
+        case SETTING_U32: { uint32_t v = value; memcpy(ptr, &v, sizeof(v)); break; }
+        case SETTING_FLAG: *ptr = value ? (*ptr | s.mask) : (*ptr & ~s.mask); break;
+        default: *ptr = (uint8_t)value; break;
+    }
+}
+
+// Rest des Feldes mit Nullen: gleicher Text heisst gleiche Bytes (settingDiffers)
+void writeSettingText(const SettingSchema &s, SettingsPayload &p, const char *value) {
+    char *dest = (char*)settingPtr(s, p);
+    strncpy(dest, value, s.size - 1);
+    dest[s.size - 1] = '\0';
+}
+
+bool settingDiffers(const SettingSchema &s, const SettingsPayload &a, const SettingsPayload &b) {
+    if (s.type == SETTING_FLAG) {
+        return ((*settingPtr(s, a) ^ *settingPtr(s, b)) & s.mask) != 0;
+    }
+    return memcmp(settingPtr(s, a), settingPtr(s, b), s.size) != 0;
+}
+
+void settingWebValue(const SettingSchema &s, const SettingsPayload &p, SettingWebValue &out) {
+    out.text = nullptr;
+    out.number = 0;
+    if (s.type == SETTING_TEXT) {
+        out.kind = SettingWebValue::TEXT;
+        out.text = (const char*)settingPtr(s, p);
+        return;
+    }
+
+    int64_t value = readSetting(s, p);
+    if (s.type == SETTING_FLAG) {
+        out.kind = SettingWebValue::BOOL;
+        out.number = value;
+    } else if (s.web & SETTING_HEX_COLOR) {
+        out.kind = SettingWebValue::TEXT;
+        snprintf(out.hex, sizeof(out.hex), "#%06X", (unsigned)(value & 0xFFFFFF));
+        out.text = out.hex;
+    } else {
+        out.kind = SettingWebValue::NUMBER;
+        out.number = (s.web & SETTING_SECONDS) ? value / 1000 : value;
+    }
+}
+
+// "#RRGGBB" bzw. "RRGGBB"
+static bool parseHexColor(const char *text, int64_t &value) {
+    if (*text == '#') text++;
+    if (strlen(text) != 6) return false;
+    char *end;
+    unsigned long color = strtoul(text, &end, 16);
+    if (*end != '\0') return false;
+    value = color;
+    return true;
+}
+
+SettingInput settingFromWeb(const SettingSchema &s, SettingsPayload &p, const char *text) {
+    if (s.type != SETTING_TEXT) {
+        int64_t value;
+        if (!(s.web & SETTING_HEX_COLOR) || !parseHexColor(text, value)) {
+            return SETTING_INPUT_INVALID;
+        }
+        return settingFromWeb(s, p, value);
+    }
+
+    // Die WebUI zeigt Passwoerter nie an: Maske bzw. leeres Feld heisst "unveraendert"
+    if (((s.web & SETTING_SECRET) && strcmp(text, "****") == 0) ||
+        ((s.web & SETTING_KEEP_EMPTY) && *text == '\0')) {
+        return SETTING_INPUT_KEPT;
+    }
+    size_t len = strlen(text);
+    if (len < (size_t)s.min || len > (size_t)s.max) {
+        return SETTING_INPUT_INVALID;
+    }
+    if (strcmp((const char*)settingPtr(s, p), text) == 0) {
+        return SETTING_INPUT_KEPT;
+    }
+    writeSettingText(s, p, text);
+    return SETTING_INPUT_CHANGED;
+}
+
+SettingInput settingFromWeb(const SettingSchema &s, SettingsPayload &p, int64_t value) {
+    if (s.type == SETTING_TEXT) {
+        return SETTING_INPUT_INVALID;
+    }
+    // Ein Pin laesst sich nicht sinnvoll begrenzen — writeSetting() naehme den
+    // Standard, die WebUI soll aber erfahren, dass ihr Wert nicht gilt
+    if (s.type == SETTING_PIN && !settingInRange(s, value)) {
+        return SETTING_INPUT_INVALID;
+    }
+    if (s.type == SETTING_FLAG) {
+        value = value != 0;
+    } else if (s.web & SETTING_SECONDS) {
+        // Vor der Multiplikation begrenzen (Overflow-Schutz)
+        value = 1000 * constrain(value, (int64_t)s.min / 1000, (int64_t)s.max / 1000);
+    }
+    int64_t before = readSetting(s, p);
+    writeSetting(s, p, value);
+    return readSetting(s, p) != before ? SETTING_INPUT_CHANGED : SETTING_INPUT_KEPT;
+}
+
+void settingInputError(const SettingSchema &s, char *out, size_t size) {
+    const char *name = s.webKey ? s.webKey : s.key;
+    if (s.type != SETTING_TEXT) {
+        snprintf(out, size, "%s: ungueltiger Wert", name);
+    } else if (s.min > 0) {
+        snprintf(out, size, "%s muss %ld-%ld Zeichen lang sein", name, (long)s.min, (long)s.max);
+    } else {
+        snprintf(out, size, "%s darf maximal %ld Zeichen lang sein", name, (long)s.max);
+    }
+}
@@ -0,0 +1,243 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config.h"
+
+// === Einstellungsschema ===
+// Layout der gespeicherten Einstellungen und die Tabelle, aus der alles andere
+// entsteht: Aenderungserkennung, Validierung, NVS-Bloecke, JSON-Export, die
+// Uebernahme der Altformate und die Einstellungs-Endpunkte der WebUI
+// (settings_web.h). Kennt weder AppState noch NVS oder ArduinoJson — den Rest
+// erledigen settings_manager.cpp und settings_web.cpp — und laeuft deshalb auch
+// im Host-Test (test/test_settings_schema).
+//
+// Schema-Regel: Felder nur hinten an ihren Abschnitt anhaengen, nie umsortieren
+// oder entfernen, und dabei SETTINGS_SCHEMA_VERSION erhoehen. Aeltere Abschnitte
+// sind dann ein Praefix des aktuellen Layouts; fehlende Felder behalten ihre
+// Standardwerte.
+
+enum SettingsFlags : uint8_t {
+    SETTING_AUTO_MODE       = 1 << 0,
+    SETTING_LIGHT_ON        = 1 << 1,
+    SETTING_UPDATE_CHECK    = 1 << 2,
+    SETTING_DHT_ENABLED     = 1 << 3,
+    SETTING_WIFI_CONFIGURED = 1 << 4,
+    SETTING_MQTT_ENABLED    = 1 << 5,
+    SETTING_UPDATE_PREFETCH = 1 << 6,
+};
+
+// Bedienzustand: aendert sich oft (Slider, Home Assistant, Modus-Wechsel)
+struct __attribute__((packed)) RuntimeSettings {
+    uint32_t manualColor;
+    uint8_t manualBrightness;
+    uint8_t flags;              // SETTING_AUTO_MODE, SETTING_LIGHT_ON
+};
+
+// Geraetekonfiguration: Farben, Intervalle, Hardware
+struct __attribute__((packed)) DeviceSettings {
+    uint32_t moodInterval;
+    uint32_t dhtInterval;
+    uint32_t customColors[5];
+    uint8_t flags;              // SETTING_UPDATE_CHECK, SETTING_DHT_ENABLED, SETTING_UPDATE_PREFETCH
+    int8_t ledPin;
+    int8_t dhtPin;
+    uint8_t numLeds;
+    uint8_t prefetchRate;       // KB/s
+};
+
+// Zugangsdaten: aendern sich praktisch nur im Setup
+struct __attribute__((packed)) NetworkSettings {
+    uint8_t flags;              // SETTING_WIFI_CONFIGURED, SETTING_MQTT_ENABLED
+    char wifiSSID[SETTINGS_SSID_LEN];
+    char wifiPassword[SETTINGS_WIFI_PASS_LEN];
+    char apiUrl[SETTINGS_URL_LEN];
+    char mqttServer[SETTINGS_MQTT_LEN];
+    char mqttUser[SETTINGS_MQTT_LEN];
+    char mqttPassword[SETTINGS_MQTT_LEN];
+};
+
+struct __attribute__((packed)) SettingsPayload {
+    RuntimeSettings run;
+    DeviceSettings device;
+    NetworkSettings net;
+};
+
+enum SettingsSectionId : uint8_t { SECTION_RUN, SECTION_DEVICE, SECTION_NET, SECTION_COUNT };
+
+struct SettingsSection {
+    const char *key;
+    uint16_t offset;            // Lage in SettingsPayload
+    uint16_t size;
+};
+
+static constexpr SettingsSection settingsSections[SECTION_COUNT] = {
+    {"cfg.run", offsetof(SettingsPayload, run), sizeof(RuntimeSettings)},
+    {"cfg.dev", offsetof(SettingsPayload, device), sizeof(DeviceSettings)},
+    {"cfg.net", offsetof(SettingsPayload, net), sizeof(NetworkSettings)},
+};
+
+// ===== Schema =====
+// Eine Zeile je Einstellung: Schluessel, Typ, Lage im Block, Grenzen, Standard,
+// Darstellung in der WebUI und das Formular, das sie setzt. Der Schluessel ist
+// zugleich JSON-Name (Export, /api/settings/all) und Key der alten Preferences.
+// Neue Einstellung: Feld an den Abschnitt anhaengen, packSettings()/
+// applySettings() in settings_manager.cpp ergaenzen, hier eine Zeile eintragen.
+
+enum SettingType : uint8_t {
+    SETTING_U32,                // uint32_t
+    SETTING_U8,                 // uint8_t
+    SETTING_INT,                // int8_t/uint8_t im Block, int32 in den alten Preferences
+    SETTING_PIN,                // wie SETTING_INT, ohne die Flash-Pins 6-11
+    SETTING_FLAG,               // Bit mask im Flag-Byte des Abschnitts
+    SETTING_TEXT,               // char[size], nullterminiert; min/max = Laenge
+};
+
+enum SettingWebFlags : uint8_t {
+    SETTING_SECRET     = 1 << 0,    // Im Export maskiert, "****" bei der Eingabe ignoriert
+    SETTING_KEEP_EMPTY = 1 << 1,    // Leere Eingabe laesst den Wert stehen
+    SETTING_SECONDS    = 1 << 2,    // ms im Block, Sekunden in der WebUI
+    SETTING_HEX_COLOR  = 1 << 3,    // "#RRGGBB" in der WebUI
+    SETTING_LIST       = 1 << 4,    // In /api/settings/all ans Array webKey angehaengt
+};
+
+// Formulare der WebUI, die ihre Felder ueber das Schema uebernehmen
+enum SettingForm : uint8_t {
+    SETTING_FORM_NONE,
+    SETTING_FORM_WIFI,          // /savewifi
+    SETTING_FORM_MQTT,          // /savemqtt, /api/settings/mqtt
+    SETTING_FORM_API,           // /saveapi
+    SETTING_FORM_COLORS,        // /savecolors
+    SETTING_FORM_HARDWARE,      // /savehardware
+};
+
+struct SettingSchema {
+    const char *key;
+    SettingType type;
+    uint8_t section;
+    uint16_t offset;            // Lage in SettingsPayload
+    uint16_t size;
+    uint8_t mask;               // nur SETTING_FLAG
+    uint8_t web;                // SettingWebFlags
+    int32_t min;
+    int32_t max;
+    int32_t def;                // Ersatz fuer ungueltige Pins
+    SettingForm form;
+    const char *webKey;         // Name im Formular bzw. Array bei SETTING_LIST
+};
+
+#define SETTING_MEMBER(member) offsetof(SettingsPayload, member), sizeof(((SettingsPayload*)0)->member)
+#define SETTING_NUM(key, type, sec, member, lo, hi, def, web, form, webKey) \
+    {key, type, sec, SETTING_MEMBER(member), 0, web, lo, hi, def, form, webKey}
+#define SETTING_LIST_NUM(key, type, sec, member, lo, hi, def, web, form, list) \
+    {key, type, sec, SETTING_MEMBER(member), 0, (uint8_t)((web) | SETTING_LIST), lo, hi, def, form, list}
+#define SETTING_BIT(key, sec, member, bit, def, form, webKey) \
+    {key, SETTING_FLAG, sec, SETTING_MEMBER(member), bit, 0, 0, 1, def, form, webKey}
+#define SETTING_STR(key, sec, member, lo, hi, web, form, webKey) \
+    {key, SETTING_TEXT, sec, SETTING_MEMBER(member), 0, web, lo, hi, 0, form, webKey}
+
+static constexpr SettingSchema settingsSchema[] = {
+    SETTING_NUM("manColor", SETTING_U32, SECTION_RUN, run.manualColor, 0, 0xFFFFFF, 0xFFFFFF, SETTING_HEX_COLOR, SETTING_FORM_NONE, nullptr),
+    SETTING_NUM("manBright", SETTING_U8, SECTION_RUN, run.manualBrightness, 0, 255, DEFAULT_LED_BRIGHTNESS, 0, SETTING_FORM_NONE, nullptr),
+    SETTING_BIT("autoMode", SECTION_RUN, run.flags, SETTING_AUTO_MODE, 1, SETTING_FORM_NONE, nullptr),
+    SETTING_BIT("lightOn", SECTION_RUN, run.flags, SETTING_LIGHT_ON, 1, SETTING_FORM_NONE, nullptr),
+
+    SETTING_NUM("moodInterval", SETTING_U32, SECTION_DEVICE, device.moodInterval, 10000, 7200000, DEFAULT_MOOD_UPDATE_INTERVAL, SETTING_SECONDS, SETTING_FORM_API, "moodInterval"),
+    SETTING_NUM("dhtInterval", SETTING_U32, SECTION_DEVICE, device.dhtInterval, 10000, 3600000, DEFAULT_DHT_READ_INTERVAL, SETTING_SECONDS, SETTING_FORM_API, "dhtInterval"),
+    SETTING_LIST_NUM("color0", SETTING_U32, SECTION_DEVICE, device.customColors[0], 0, 0xFFFFFF, 0xFF0000, SETTING_HEX_COLOR, SETTING_FORM_COLORS, "colors"),
+    SETTING_LIST_NUM("color1", SETTING_U32, SECTION_DEVICE, device.customColors[1], 0, 0xFFFFFF, 0xFFA500, SETTING_HEX_COLOR, SETTING_FORM_COLORS, "colors"),
+    SETTING_LIST_NUM("color2", SETTING_U32, SECTION_DEVICE, device.customColors[2], 0, 0xFFFFFF, 0x1E90FF, SETTING_HEX_COLOR, SETTING_FORM_COLORS, "colors"),
+    SETTING_LIST_NUM("color3", SETTING_U32, SECTION_DEVICE, device.customColors[3], 0, 0xFFFFFF, 0x545DF0, SETTING_HEX_COLOR, SETTING_FORM_COLORS, "colors"),
+    SETTING_LIST_NUM("color4", SETTING_U32, SECTION_DEVICE, device.customColors[4], 0, 0xFFFFFF, 0x8A2BE2, SETTING_HEX_COLOR, SETTING_FORM_COLORS, "colors"),
+    SETTING_BIT("updateCheck", SECTION_DEVICE, device.flags, SETTING_UPDATE_CHECK, 1, SETTING_FORM_NONE, nullptr),
+    SETTING_BIT("dhtEnabled", SECTION_DEVICE, device.flags, SETTING_DHT_ENABLED, 1, SETTING_FORM_API, "dhtEnabled"),
+    SETTING_NUM("ledPin", SETTING_PIN, SECTION_DEVICE, device.ledPin, 0, 39, DEFAULT_LED_PIN, 0, SETTING_FORM_HARDWARE, "ledPin"),
+    SETTING_NUM("dhtPin", SETTING_PIN, SECTION_DEVICE, device.dhtPin, 0, 39, DEFAULT_DHT_PIN, 0, SETTING_FORM_HARDWARE, "dhtPin"),
+    SETTING_NUM("numLeds", SETTING_INT, SECTION_DEVICE, device.numLeds, 1, MAX_LEDS, DEFAULT_NUM_LEDS, 0, SETTING_FORM_HARDWARE, "numLeds"),
+    SETTING_BIT("updatePrefetch", SECTION_DEVICE, device.flags, SETTING_UPDATE_PREFETCH, 0, SETTING_FORM_NONE, nullptr),
+    SETTING_NUM("prefetchRate", SETTING_U8, SECTION_DEVICE, device.prefetchRate, 4, 255, UPDATE_PREFETCH_DEFAULT_RATE, 0, SETTING_FORM_NONE, nullptr),
+
+    SETTING_BIT("wifiConfigured", SECTION_NET, net.flags, SETTING_WIFI_CONFIGURED, 0, SETTING_FORM_NONE, nullptr),
+    SETTING_BIT("mqttEnabled", SECTION_NET, net.flags, SETTING_MQTT_ENABLED, 0, SETTING_FORM_MQTT, "enabled"),
+    SETTING_STR("wifiSSID", SECTION_NET, net.wifiSSID, 1, 32, 0, SETTING_FORM_WIFI, "ssid"),
+    SETTING_STR("wifiPass", SECTION_NET, net.wifiPassword, 0, 63, SETTING_SECRET, SETTING_FORM_WIFI, "pass"),
+    SETTING_STR("apiUrl", SECTION_NET, net.apiUrl, 0, SETTINGS_URL_LEN - 1, 0, SETTING_FORM_API, "apiUrl"),
+    SETTING_STR("mqttServer", SECTION_NET, net.mqttServer, 0, SETTINGS_MQTT_LEN - 1, 0, SETTING_FORM_MQTT, "server"),
+    SETTING_STR("mqttUser", SECTION_NET, net.mqttUser, 0, SETTINGS_MQTT_LEN - 1, 0, SETTING_FORM_MQTT, "user"),
+    SETTING_STR("mqttPass", SECTION_NET, net.mqttPassword, 0, SETTINGS_MQTT_LEN - 1, SETTING_SECRET | SETTING_KEEP_EMPTY, SETTING_FORM_MQTT, "pass"),
+};
+
+#undef SETTING_MEMBER
+#undef SETTING_NUM
+#undef SETTING_LIST_NUM
+#undef SETTING_BIT
+#undef SETTING_STR
+
+static constexpr size_t SETTINGS_SCHEMA_COUNT = sizeof(settingsSchema) / sizeof(settingsSchema[0]);
+
+// Pruefungen zur Compile-Zeit: jede Zeile liegt in ihrem Abschnitt, Zahlen
+// haben eine passende Breite, Texte passen samt Nullterminator ins Feld und
+// Formularfelder haben einen Namen
+static constexpr bool schemaRowValid(const SettingSchema &s) {
+    return s.offset >= settingsSections[s.section].offset &&
+           s.offset + s.size <= settingsSections[s.section].offset + settingsSections[s.section].size &&
+           (s.type != SETTING_U32 || s.size == 4) &&
+           (s.type == SETTING_U32 || s.type == SETTING_TEXT || s.size == 1) &&
+           s.min <= s.max && (s.type == SETTING_TEXT ? s.max < s.size : (s.def >= s.min && s.def <= s.max)) &&
+           (s.form == SETTING_FORM_NONE || s.webKey != nullptr) &&
+           (!(s.web & SETTING_LIST) || s.webKey != nullptr);
+}
+
+static constexpr bool schemaValid(size_t i = 0) {
+    return i >= SETTINGS_SCHEMA_COUNT || (schemaRowValid(settingsSchema[i]) && schemaValid(i + 1));
+}
+static_assert(schemaValid(), "settingsSchema passt nicht zu SettingsPayload");
+
+inline uint8_t *settingPtr(const SettingSchema &s, SettingsPayload &p) {
+    return (uint8_t*)&p + s.offset;
+}
+
+inline const uint8_t *settingPtr(const SettingSchema &s, const SettingsPayload &p) {
+    return (const uint8_t*)&p + s.offset;
+}
+
+const SettingSchema *findSetting(const char *key);
+
+// Zahlenwert einer Zeile (Flags als 0/1)
+int64_t readSetting(const SettingSchema &s, const SettingsPayload &p);
+
+// Liegt value in den Grenzen (bei Pins: kein Flash-Pin)?
+bool settingInRange(const SettingSchema &s, int64_t value);
+
+// Schreibt value begrenzt auf [min, max]; ungueltige Pins werden zum Standard
+void writeSetting(const SettingSchema &s, SettingsPayload &p, int64_t value);
+
+void writeSettingText(const SettingSchema &s, SettingsPayload &p, const char *value);
+
+bool settingDiffers(const SettingSchema &s, const SettingsPayload &a, const SettingsPayload &b);
+
+// Wert einer Zeile so, wie ihn die WebUI sieht (Sekunden, "#RRGGBB").
+// text zeigt auf das Feld in p bzw. auf hex.
+struct SettingWebValue {
+    enum Kind : uint8_t { BOOL, NUMBER, TEXT } kind;
+    int64_t number;
+    const char *text;
+    char hex[8];
+};
+void settingWebValue(const SettingSchema &s, const SettingsPayload &p, SettingWebValue &out);
+
+enum SettingInput : uint8_t {
+    SETTING_INPUT_KEPT,         // Gleicher Wert, Maske oder leer bei SETTING_KEEP_EMPTY
+    SETTING_INPUT_CHANGED,
+    SETTING_INPUT_INVALID,      // Text zu kurz/lang, keine Farbe bzw. Flash-Pin — p unveraendert
+};
+
+// Eingabe aus einem Formular der WebUI (Umkehrung von settingWebValue).
+// Zahlen werden begrenzt, Texte ausserhalb von min/max und ungueltige Pins
+// abgelehnt.
+SettingInput settingFromWeb(const SettingSchema &s, SettingsPayload &p, const char *text);
+SettingInput settingFromWeb(const SettingSchema &s, SettingsPayload &p, int64_t value);
+
+// Meldung fuer SETTING_INPUT_INVALID, z.B. "ssid muss 1-32 Zeichen lang sein"
+void settingInputError(const SettingSchema &s, char *out, size_t size);
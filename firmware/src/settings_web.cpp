@@ -0,0 +1,79 @@
+// settings_web.cpp — Einstellungen in der WebUI, siehe settings_web.h
+
+#include "settings_web.h"
+
+static void setWebValue(JsonVariant dest, const SettingWebValue &value) {
+    switch (value.kind) {
+        case SettingWebValue::BOOL: dest.set(value.number != 0); break;
+        case SettingWebValue::NUMBER: dest.set((long)value.number); break;
+        case SettingWebValue::TEXT: dest.set(value.text); break;
+    }
+}
+
+void settingsWebJson(const SettingsPayload &p, JsonDocument &doc) {
+    for (const SettingSchema &s : settingsSchema) {
+        if (s.web & SETTING_SECRET) continue;
+        SettingWebValue value;
+        settingWebValue(s, p, value);
+        JsonVariant dest = (s.web & SETTING_LIST) ? doc[s.webKey].add<JsonVariant>() : doc[s.key];
+        setWebValue(dest, value);
+    }
+}
+
+void settingsFormJson(SettingForm form, const SettingsPayload &p, JsonDocument &doc) {
+    for (const SettingSchema &s : settingsSchema) {
+        if (s.form != form) continue;
+        SettingWebValue value;
+        settingWebValue(s, p, value);
+        JsonVariant dest = doc[s.webKey];
+        if (s.web & SETTING_SECRET) {
+            dest.set(*value.text ? "****" : "");
+            continue;
+        }
+        setWebValue(dest, value);
+    }
+}
+
+int settingsFromForm(SettingForm form, JsonVariantConst in, SettingsPayload &p, String &error) {
+    int changed = 0;
+    const char *list = nullptr;     // Array der vorigen SETTING_LIST-Zeile
+    size_t listIndex = 0;
+    for (const SettingSchema &s : settingsSchema) {
+        if (s.form != form) continue;
+
+        JsonVariantConst value;
+        if (s.web & SETTING_LIST) {
+            listIndex = (list && strcmp(list, s.webKey) == 0) ? listIndex + 1 : 0;
+            list = s.webKey;
+            value = in[s.webKey][listIndex];
+        } else {
+            value = in[s.webKey];
+        }
+
+        SettingInput result;
+        if (value.is<const char*>()) {
+            result = settingFromWeb(s, p, value.as<const char*>());
+        } else if (s.type == SETTING_TEXT) {
+            // Fehlt ein Pflichtfeld, ist das dieselbe Meldung wie ein leeres
+            result = s.min > 0 ? SETTING_INPUT_INVALID : SETTING_INPUT_KEPT;
+        } else if (value.is<bool>()) {
+            result = settingFromWeb(s, p, (int64_t)value.as<bool>());
+        } else if (value.is<long long>()) {
+            result = settingFromWeb(s, p, value.as<long long>());
+        } else if (value.is<double>()) {
+            // Kommazahl aus der WebUI; begrenzt, damit die Wandlung definiert bleibt
+            result = settingFromWeb(s, p, (int64_t)constrain(value.as<double>(), -2147483648.0, 4294967295.0));
+        } else {
+            result = SETTING_INPUT_KEPT;
+        }
+
+        if (result == SETTING_INPUT_INVALID) {
+            char message[64];
+            settingInputError(s, message, sizeof(message));
+            error = message;
+            return -1;
+        }
+        changed += result == SETTING_INPUT_CHANGED;
+    }
+    return changed;
+}
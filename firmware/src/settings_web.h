@@ -0,0 +1,27 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include "settings_schema.h"
+
+// === Einstellungen in der WebUI ===
+// /api/settings/all, /api/settings/mqtt und die Formulare (/savewifi,
+// /savemqtt, /saveapi, /savecolors, /savehardware) ueber das Schema. Arbeitet
+// nur auf einem SettingsPayload — AppState packen und zurueckschreiben macht
+// settings_manager.cpp drumherum — und laeuft deshalb auch im Host-Test
+// (test/test_settings_schema).
+
+// Alle Einstellungen in der Darstellung der WebUI (Sekunden, "#RRGGBB",
+// Farben als Array), ohne Passwoerter
+void settingsWebJson(const SettingsPayload &p, JsonDocument &doc);
+
+// Felder eines Formulars unter ihren Formularnamen, Passwoerter maskiert
+void settingsFormJson(SettingForm form, const SettingsPayload &p, JsonDocument &doc);
+
+// Uebernimmt die Felder von form aus in nach p — nur vorhandene Schluessel,
+// Pflichtfelder (Text mit Mindestlaenge) ausgenommen. SETTING_LIST-Zeilen
+// kommen der Reihe nach aus dem Array webKey. Rueckgabe: Zahl geaenderter
+// Felder, -1 bei ungueltiger Eingabe (Meldung in error, p dann teils
+// geaendert).
+int settingsFromForm(SettingForm form, JsonVariantConst in, SettingsPayload &p, String &error);
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+// === SHA-256 als Hex-Text ===
+// Update-Antwort (firmware_sha256, delta_base_sha256), UI-Manifest und
+// Dateiindex der WebUI tragen Digests als 64 Hex-Zeichen.
+
+// "9f86d0..." nach 32 Byte; false bei falscher Laenge oder Zeichen
+inline bool parseSha256Hex(const char *hex, uint8_t out[32])
+{
+    if (!hex || strlen(hex) != 64) {
+        return false;
+    }
+    for (size_t i = 0; i < 64; i++) {
+        char c = hex[i];
+        uint8_t nibble;
+        if (c >= '0' && c <= '9') nibble = c - '0';
+        else if (c >= 'a' && c <= 'f') nibble = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') nibble = c - 'A' + 10;
+        else return false;
+        out[i / 2] = (i % 2) ? (out[i / 2] | nibble) : (nibble << 4);
+    }
+    return true;
+}
+
+// 32 Byte nach 64 Hex-Zeichen (Kleinbuchstaben) plus Nullterminator
+inline void formatSha256Hex(const uint8_t digest[32], char out[65])
+{
+    static const char digits[] = "0123456789abcdef";
+    for (size_t i = 0; i < 32; i++) {
+        out[i * 2] = digits[digest[i] >> 4];
+        out[i * 2 + 1] = digits[digest[i] & 0x0F];
+    }
+    out[64] = '\0';
+}
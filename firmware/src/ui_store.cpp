@@ -0,0 +1,957 @@
+// ui_store.cpp — Versionierte WebUI: Zeiger, Rollback und Streaming-Installer
+//
+// tar (ustar) besteht aus 512-Byte-Bloecken: je Eintrag ein Header, danach
+// die Daten, aufgefuellt auf die naechste Blockgrenze. Zwei Null-Bloecke
+// beenden das Archiv. Header kommen beliebig ueber Upload- und gzip-Bloecke
+// verteilt an und werden deshalb in _block gesammelt; Dateidaten gehen ohne
+// Umweg in die offene Zieldatei.
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include "ui_store.h"
+#include "web_server.h"
+#include "debug.h"
+#include "sha256_hex.h"
+
+#define LOG_TAG LOG_TAG_UPDATE
+
+static const char UI_ACTIVE_FILE[] = "/ui-active.txt";
+static const char UI_PREVIOUS_FILE[] = "/ui-previous.txt";
+static const char UI_PENDING_FILE[] = "/ui-pending.txt";
+static const char UI_INDEX_FILE[] = "/.files";     // je Versionsverzeichnis
+static const char UI_MANIFEST_NAME[] = "manifest.json";
+
+// Rollback-Ziel "UI im Wurzelverzeichnis" (uploadfs bzw. Uploads aus der Zeit
+// vor den Versionsverzeichnissen): steht so in /ui-previous.txt
+static const char UI_ROOT_DIR[] = "/";
+
+// Entpackt ist ein UI-tgz etwa dreimal so gross wie der Upload. Die aktive
+// Version bleibt waehrend der Installation liegen, zaehlt also nicht mit.
+static constexpr size_t UI_UNPACK_FACTOR = 3;
+
+static String activeDir;
+static String activeVersion;
+static String previousDir;
+static String previousVersion;
+static String pendingDir;
+static String pendingVersion;
+
+// Dateiindex der aktiven Version — leer bei Verzeichnissen ohne Index
+static UiFileRecord activeFiles[UI_MAX_FILES];
+static uint8_t activeFileCount = 0;
+
+// Schuetzt Zeiger, Index und das Aufraeumen der Verzeichnisse: gelesen wird im
+// Webserver (loop), geaendert auch im Update-Task (stageUi(), updateTxnAbort()).
+// Rekursiv, weil sich die oeffentlichen Funktionen gegenseitig aufrufen.
+static SemaphoreHandle_t storeMutex = nullptr;
+
+struct StoreLock {
+    StoreLock()
+    {
+        if (storeMutex) {
+            xSemaphoreTakeRecursive(storeMutex, portMAX_DELAY);
+        }
+    }
+    ~StoreLock()
+    {
+        if (storeMutex) {
+            xSemaphoreGiveRecursive(storeMutex);
+        }
+    }
+};
+
+// Liegt im Wurzelverzeichnis eine bedienbare UI?
+static bool rootUiPresent()
+{
+    const char *required[] = {"/index.html", "/setup.html"};
+    for (const char *page : required) {
+        if (!LittleFS.exists(page) && !LittleFS.exists(String(page) + ".gz")) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Version der UI im Wurzelverzeichnis — /ui-version.txt schrieb der Upload
+// vor den Versionsverzeichnissen, uploadfs legt keine an
+static String rootUiVersion()
+{
+    String version;
+    if (LittleFS.exists("/ui-version.txt")) {
+        File f = LittleFS.open("/ui-version.txt", "r");
+        if (f) {
+            version = f.readStringUntil('\n');
+            f.close();
+            version.trim();
+        }
+    }
+    return version.length() > 0 ? version : String(F("Basis"));
+}
+
+// Zeigerdatei: Verzeichnis und Version, je eine Zeile. allowRoot: "/" steht
+// fuer die UI im Wurzelverzeichnis (nur als vorherige Version)
+static bool readPointer(const char *path, String &dir, String &version, bool allowRoot = false)
+{
+    dir = "";
+    version = "";
+    if (!LittleFS.exists(path)) {
+        return false;
+    }
+    File f = LittleFS.open(path, "r");
+    if (!f) {
+        return false;
+    }
+    dir = f.readStringUntil('\n');
+    version = f.readStringUntil('\n');
+    f.close();
+    dir.trim();
+    version.trim();
+
+    // Zeigt der Zeiger ins Leere, gilt er als nicht vorhanden
+    bool valid = dir == UI_ROOT_DIR ? allowRoot && rootUiPresent()
+                                    : dir.startsWith("/ui-") && LittleFS.exists(dir);
+    if (!valid) {
+        dir = "";
+        version = "";
+        return false;
+    }
+    return true;
+}
+
+// Erst vollstaendig in eine Nachbardatei schreiben, dann per rename() ersetzen
+static bool writePointer(const char *path, const String &dir, const String &version)
+{
+    String tmp = String(path) + ".tmp";
+    File f = LittleFS.open(tmp, "w");
+    if (!f) {
+        return false;
+    }
+    bool ok = f.print(dir + "\n" + version + "\n") > 0;
+    f.close();
+    if (!ok || !LittleFS.rename(tmp, path)) {
+        LittleFS.remove(tmp);
+        return false;
+    }
+    return true;
+}
+
+// Index: je Datei eine Zeile "<sha256> <groesse> <verzeichnis> <pfad>".
+// Fehlt ein Verzeichnis, zaehlt das wie kein Index.
+static uint8_t readIndex(const String &dir, UiFileRecord *records)
+{
+    File f = LittleFS.open(dir + UI_INDEX_FILE, "r");
+    if (!f) {
+        return 0;
+    }
+    uint8_t count = 0;
+    bool ok = true;
+    while (ok && f.available() && count < UI_MAX_FILES) {
+        String line = f.readStringUntil('\n');
+        line.trim();
+        if (line.isEmpty()) {
+            continue;
+        }
+        int a = line.indexOf(' ');
+        int b = a > 0 ? line.indexOf(' ', a + 1) : -1;
+        int c = b > 0 ? line.indexOf(' ', b + 1) : -1;
+        UiFileRecord &r = records[count];
+        ok = c > 0 && parseSha256Hex(line.substring(0, a).c_str(), r.sha256);
+        if (ok) {
+            r.size = line.substring(a + 1, b).toInt();
+            r.dir = line.substring(b + 1, c);
+            r.path = line.substring(c + 1);
+            ok = r.dir.startsWith("/ui-") && r.path.startsWith("/") && LittleFS.exists(r.dir);
+            count++;
+        }
+    }
+    f.close();
+    return ok ? count : 0;
+}
+
+static bool writeIndex(const String &dir, const UiFileRecord *records, uint8_t count)
+{
+    File f = LittleFS.open(dir + UI_INDEX_FILE, "w");
+    if (!f) {
+        return false;
+    }
+    bool ok = true;
+    char hex[65];
+    for (uint8_t i = 0; i < count && ok; i++) {
+        formatSha256Hex(records[i].sha256, hex);
+        ok = f.print(String(hex) + " " + String((unsigned long)records[i].size) + " " +
+                     records[i].dir + " " + records[i].path + "\n") > 0;
+    }
+    f.close();
+    return ok;
+}
+
+static const UiFileRecord *findActive(const String &path)
+{
+    for (uint8_t i = 0; i < activeFileCount; i++) {
+        if (activeFiles[i].path == path) {
+            return &activeFiles[i];
+        }
+    }
+    return nullptr;
+}
+
+// Liest die aktive Version (noch) aus diesem Verzeichnis?
+static bool activeUses(const String &dir)
+{
+    if (dir == activeDir) {
+        return true;
+    }
+    for (uint8_t i = 0; i < activeFileCount; i++) {
+        if (activeFiles[i].dir == dir) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool listed(const String *dirs, uint8_t count, const String &dir)
+{
+    for (uint8_t i = 0; i < count; i++) {
+        if (dirs[i] == dir) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Verzeichnis einer Version samt denen, auf die ihr Index verweist, an dirs
+// anhaengen. Der Index wird zeilenweise gelesen, nicht als Ganzes.
+static uint8_t collectDirs(const String &dir, String *dirs, uint8_t count, uint8_t max)
+{
+    if (!dir.startsWith("/ui-")) {
+        return count;
+    }
+    if (count < max && !listed(dirs, count, dir)) {
+        dirs[count++] = dir;
+    }
+    File f = LittleFS.open(dir + UI_INDEX_FILE, "r");
+    if (!f) {
+        return count;
+    }
+    while (f.available() && count < max) {
+        String line = f.readStringUntil('\n');
+        int b = line.indexOf(' ', line.indexOf(' ') + 1);
+        int c = b > 0 ? line.indexOf(' ', b + 1) : -1;
+        if (c > 0) {
+            String ref = line.substring(b + 1, c);
+            if (!listed(dirs, count, ref)) {
+                dirs[count++] = ref;
+            }
+        }
+    }
+    f.close();
+    return count;
+}
+
+// Entfernt jedes /ui-*-Verzeichnis, aus dem weder die aktive noch die vorherige
+// noch die bereitgestellte Version liest
+static void pruneUiDirs()
+{
+    static constexpr uint8_t maxDirs = UI_MAX_FILES + 3;
+    String used[maxDirs];
+    uint8_t count = 0;
+    if (activeDir.length() > 0) {
+        used[count++] = activeDir;
+    }
+    for (uint8_t i = 0; i < activeFileCount && count < maxDirs; i++) {
+        if (!listed(used, count, activeFiles[i].dir)) {
+            used[count++] = activeFiles[i].dir;
+        }
+    }
+    count = collectDirs(previousDir, used, count, maxDirs);
+    count = collectDirs(pendingDir, used, count, maxDirs);
+
+    File root = LittleFS.open("/");
+    if (!root || !root.isDirectory()) {
+        return;
+    }
+    File entry = root.openNextFile();
+    while (entry) {
+        String path = String(entry.path());
+        bool stale = entry.isDirectory() && path.startsWith("/ui-") && !listed(used, count, path);
+        entry = root.openNextFile();  // Naechsten Eintrag VOR dem Loeschen holen
+        if (stale) {
+            LOG_I("Entferne alte WebUI %s", path);
+            deleteDir(path);
+        }
+    }
+}
+
+// Vorherige Version aufgeben (Zeiger; die Verzeichnisse raeumt pruneUiDirs())
+static void dropPrevious()
+{
+    LittleFS.remove(UI_PREVIOUS_FILE);
+    previousDir = "";
+    previousVersion = "";
+}
+
+void uiStoreBegin()
+{
+    if (!storeMutex) {
+        storeMutex = xSemaphoreCreateRecursiveMutex();
+    }
+    StoreLock lock;
+    readPointer(UI_ACTIVE_FILE, activeDir, activeVersion);
+    readPointer(UI_PREVIOUS_FILE, previousDir, previousVersion, true);
+    readPointer(UI_PENDING_FILE, pendingDir, pendingVersion);
+    activeFileCount = activeDir.length() > 0 ? readIndex(activeDir, activeFiles) : 0;
+    if (activeDir.length() > 0) {
+        LOG_I("WebUI %s aus %s (%u Dateien im Index)%s%s", activeVersion, activeDir, activeFileCount,
+              previousDir.length() > 0 ? ", Rollback auf " : "",
+              previousDir.length() > 0 ? previousVersion : String());
+    }
+    if (pendingDir.length() > 0) {
+        LOG_I("WebUI %s bereitgestellt in %s", pendingVersion, pendingDir);
+    }
+}
+
+File uiOpenFile(const String &path, bool preferGzip, bool &gzip)
+{
+    StoreLock lock;
+    String gzPath = path + ".gz";
+
+    // Mit Index ohne Suche im Dateisystem — die Datei kann auch im Verzeichnis
+    // einer Vorversion liegen
+    if (activeFileCount > 0) {
+        const UiFileRecord *r = preferGzip ? findActive(gzPath) : nullptr;
+        gzip = r != nullptr;
+        if (!r) {
+            r = findActive(path);
+        }
+        // Was nicht im Index steht, gehoert nicht zu dieser Version — kein
+        // Rueckgriff aufs Wurzelverzeichnis, dort liegt womoeglich noch ein
+        // veraltetes /index.html.gz aus der Zeit vor den Versionsverzeichnissen
+        return r ? LittleFS.open(r->dir + (gzip ? gzPath : path), "r") : File();
+    }
+
+    // Ohne Index: exists() nur fuer die Fassungen, die fehlen duerfen — open()
+    // auf eine fehlende Datei loggt einen VFS-Fehler
+    gzip = preferGzip && LittleFS.exists(activeDir + gzPath);
+    if (gzip) {
+        return LittleFS.open(activeDir + gzPath, "r");
+    }
+    if (activeDir.length() > 0 && LittleFS.exists(activeDir + path)) {
+        return LittleFS.open(activeDir + path, "r");
+    }
+    return LittleFS.open(path, "r");
+}
+
+// Kopien: die Strings koennen sich im Update-Task aendern, waehrend der
+// Aufrufer sie noch liest
+String uiActiveDir()
+{
+    StoreLock lock;
+    return activeDir;
+}
+
+String uiActiveVersion()
+{
+    StoreLock lock;
+    return activeVersion;
+}
+
+String uiPreviousVersion()
+{
+    StoreLock lock;
+    return previousVersion;
+}
+
+String uiPendingVersion()
+{
+    StoreLock lock;
+    return pendingVersion;
+}
+
+// Aktive Version als Zeiger: ihr Verzeichnis oder "/" fuer die UI im
+// Wurzelverzeichnis. false, wenn dort keine bedienbare UI liegt.
+static bool activePointer(String &dir, String &version)
+{
+    if (activeDir.length() > 0) {
+        dir = activeDir;
+        version = activeVersion;
+        return true;
+    }
+    dir = UI_ROOT_DIR;
+    version = rootUiVersion();
+    return rootUiPresent();
+}
+
+// Aktive Version wird zur vorherigen, dir zur aktiven — bei der ersten
+// versionierten UI die im Wurzelverzeichnis. Der Zeiger auf die aktive
+// Version wird zuletzt und atomar ersetzt.
+static bool switchActive(const String &dir, const String &version)
+{
+    String oldDir, oldVersion;
+    if (activePointer(oldDir, oldVersion) && writePointer(UI_PREVIOUS_FILE, oldDir, oldVersion)) {
+        previousDir = oldDir;
+        previousVersion = oldVersion;
+    } else {
+        // Ein aelterer Zeiger waere nicht mehr "die vorherige Version"
+        dropPrevious();
+    }
+    if (!writePointer(UI_ACTIVE_FILE, dir, version)) {
+        return false;
+    }
+    activeDir = dir;
+    activeVersion = version;
+    return true;
+}
+
+bool uiActivatePending()
+{
+    StoreLock lock;
+    if (pendingDir.isEmpty() || !LittleFS.exists(pendingDir)) {
+        uiDiscardPending();
+        return false;
+    }
+    String dir = pendingDir;
+    String version = pendingVersion;
+    if (!switchActive(dir, version)) {
+        return false;
+    }
+    LittleFS.remove(UI_PENDING_FILE);
+    pendingDir = "";
+    pendingVersion = "";
+    activeFileCount = readIndex(activeDir, activeFiles);
+    invalidateFileCache();
+    LOG_I("WebUI %s aktiviert (bereitgestellt)", activeVersion);
+
+    // Das Bereitstellen hat die bisher vorherige Version stehen lassen — erst
+    // jetzt, mit der bestaetigten Firmware, ist sie entbehrlich
+    pruneUiDirs();
+    return true;
+}
+
+void uiDiscardPending()
+{
+    StoreLock lock;
+    // Die aktive Version kann auf Dateien im bereitgestellten Verzeichnis
+    // nicht verweisen — wohl aber umgekehrt, deshalb nur das eine Verzeichnis
+    if (pendingDir.length() > 0 && !activeUses(pendingDir) && pendingDir != previousDir) {
+        LOG_I("Verwerfe bereitgestellte WebUI %s", pendingVersion);
+        deleteDir(pendingDir);
+    }
+    LittleFS.remove(UI_PENDING_FILE);
+    pendingDir = "";
+    pendingVersion = "";
+}
+
+// Aktive und vorherige Version tauschen die Rollen; geloescht wird nichts.
+// Zurueck zur UI im Wurzelverzeichnis heisst: /ui-active.txt entfernen.
+bool uiRollback()
+{
+    StoreLock lock;
+    bool toRoot = previousDir == UI_ROOT_DIR;
+    if (previousDir.isEmpty() || (!toRoot && !LittleFS.exists(previousDir))) {
+        return false;
+    }
+    String dir = previousDir;
+    String version = previousVersion;
+    String backDir, backVersion;
+    activePointer(backDir, backVersion);
+
+    // Zuerst die Rueckkehr sichern, dann atomar umschalten
+    writePointer(UI_PREVIOUS_FILE, backDir, backVersion);
+    if (!(toRoot ? LittleFS.remove(UI_ACTIVE_FILE) : writePointer(UI_ACTIVE_FILE, dir, version))) {
+        writePointer(UI_PREVIOUS_FILE, dir, version);
+        return false;
+    }
+    previousDir = backDir;
+    previousVersion = backVersion;
+    activeDir = toRoot ? String() : dir;
+    activeVersion = toRoot ? String() : version;
+    activeFileCount = toRoot ? 0 : readIndex(activeDir, activeFiles);
+    invalidateFileCache();
+    LOG_I("WebUI zurueckgesetzt auf %s", version);
+    return true;
+}
+
+// === UiInstaller ===
+
+// Oktalfeld aus dem tar-Header; Leerzeichen und Nullbytes begrenzen es
+static bool parseOctal(const uint8_t *field, size_t len, uint32_t &out)
+{
+    out = 0;
+    size_t i = 0;
+    while (i < len && field[i] == ' ') {
+        i++;
+    }
+    for (; i < len && field[i] != 0 && field[i] != ' '; i++) {
+        if (field[i] < '0' || field[i] > '7') {
+            return false;
+        }
+        out = (out << 3) | (field[i] - '0');
+    }
+    return true;
+}
+
+UiInstaller::UiInstaller()
+{
+    mbedtls_sha256_init(&_sha);
+}
+
+UiInstaller::~UiInstaller()
+{
+    mbedtls_sha256_free(&_sha);
+}
+
+bool UiInstaller::begin(const String &version, size_t contentLength)
+{
+    abort();
+    _error = "";
+    _written = 0;
+    _files = 0;
+    _skipped = 0;
+    _skippedBytes = 0;
+    _have = 0;
+    _left = 0;
+    _pad = 0;
+    _eof = false;
+    _recordCount = 0;
+    _hasManifest = false;
+    _startedMs = millis();
+
+    // Bis der Name des neuen Verzeichnisses feststeht — sonst koennte parallel
+    // aufgeraeumt oder auf dasselbe Verzeichnis umgeschaltet werden
+    StoreLock lock;
+
+    // Eine bereitgestellte Version loest diese Installation ab. Platz schaffen:
+    // weg darf, woraus keine der Versionen liest — also Reste abgebrochener
+    // Installationen. Die vorherige bleibt, bis die neue aktiv ist (end()):
+    // scheitert der Upload, ist der Rollback noch da.
+    if (pendingDir.length() > 0) {
+        LittleFS.remove(UI_PENDING_FILE);
+        pendingDir = "";
+        pendingVersion = "";
+    }
+    pruneUiDirs();
+
+    if (contentLength > 0) {
+        uint64_t total, used, free;
+        getStorageInfo(total, used, free);
+        // Reicht der Platz nur ohne die vorherige Version, wird sie geopfert —
+        // besser kein Rollback als gar kein Update
+        if (free < (uint64_t)contentLength * UI_UNPACK_FACTOR && previousDir.startsWith("/ui-")) {
+            LOG_W("UI-Upload: zu wenig Platz — gebe vorherige WebUI %s auf", previousVersion);
+            dropPrevious();
+            pruneUiDirs();
+            getStorageInfo(total, used, free);
+        }
+        if (free < (uint64_t)contentLength * UI_UNPACK_FACTOR) {
+            LOG_E("UI-Upload: %lu Bytes frei, %lu benoetigt", (unsigned long)free,
+                  (unsigned long)(contentLength * UI_UNPACK_FACTOR));
+            return fail("Nicht genuegend freier Speicherplatz");
+        }
+    }
+
+    // Der Name wird Verzeichnisname — nur harmlose Zeichen
+    _version = version;
+    for (size_t i = 0; i < _version.length(); i++) {
+        if (!isalnum(_version[i]) && _version[i] != '.') {
+            _version = "";
+            break;
+        }
+    }
+    if (_version.isEmpty()) {
+        _version = "local";
+    }
+    // Dieselbe Version noch einmal: daneben entpacken, nie in ein Verzeichnis,
+    // aus dem eine Version liest — nach pruneUiDirs() sind das alle, die es gibt
+    _dir = "/ui-" + _version;
+    for (int n = 2; LittleFS.exists(_dir); n++) {
+        _dir = "/ui-" + _version + "-" + String(n);
+    }
+
+    if (!LittleFS.mkdir(_dir)) {
+        return fail("Konnte UI-Verzeichnis nicht anlegen");
+    }
+    _active = true;
+
+    if (!_gzip.begin(&UiInstaller::tarSink, this)) {
+        return fail(_gzip.error());
+    }
+    LOG_I("UI-Upload: entpacke nach %s", _dir);
+    return true;
+}
+
+bool UiInstaller::write(const uint8_t *data, size_t len)
+{
+    if (!_active) {
+        return false;
+    }
+    if (!_gzip.write(data, len)) {
+        // Leer, wenn tar() abgelehnt hat — dann steht der Grund schon da
+        return fail(*_gzip.error() ? _gzip.error() : _error);
+    }
+    return true;
+}
+
+bool UiInstaller::tarSink(void *ctx, const uint8_t *data, size_t len)
+{
+    return static_cast<UiInstaller *>(ctx)->tar(data, len);
+}
+
+bool UiInstaller::tar(const uint8_t *data, size_t len)
+{
+    while (len > 0) {
+        if (_left > 0) {
+            size_t n = len < _left ? len : _left;
+            if (_inManifest) {
+                _manifestText.concat((const char *)data, n);
+            } else if (_entry) {
+                mbedtls_sha256_update(&_sha, data, n);
+                if (_file) {
+                    if (_file.write(data, n) != n) {
+                        _error = "Schreiben fehlgeschlagen — Speicher voll?";
+                        return false;
+                    }
+                    _written += n;
+                }
+            }
+            _left -= n;
+            data += n;
+            len -= n;
+            if (_left == 0 && !finishEntry()) {
+                return false;
+            }
+            continue;
+        }
+
+        if (_pad > 0) {
+            size_t n = len < _pad ? len : _pad;
+            _pad -= n;
+            data += n;
+            len -= n;
+            continue;
+        }
+
+        // Nach dem Ende-Block folgt nur noch Auffuellung auf die Satzgroesse
+        if (_eof) {
+            return true;
+        }
+
+        size_t n = sizeof(_block) - _have;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(_block + _have, data, n);
+        _have += n;
+        data += n;
+        len -= n;
+        if (_have == sizeof(_block)) {
+            _have = 0;
+            if (!header()) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// _block enthaelt einen vollstaendigen Header
+bool UiInstaller::header()
+{
+    uint32_t sum = 0;
+    bool zero = true;
+    for (size_t i = 0; i < sizeof(_block); i++) {
+        zero = zero && _block[i] == 0;
+        // Das Pruefsummenfeld selbst zaehlt als Leerzeichen
+        sum += (i >= 148 && i < 156) ? ' ' : _block[i];
+    }
+    if (zero) {
+        _eof = true;
+        return true;
+    }
+
+    uint32_t expected, size;
+    if (!parseOctal(_block + 148, 8, expected) || expected != sum) {
+        _error = "tar-Header beschaedigt";
+        return false;
+    }
+    if (!parseOctal(_block + 124, 12, size)) {
+        _error = "tar-Eintrag zu gross";
+        return false;
+    }
+    _left = size;
+    _pad = (sizeof(_block) - size % sizeof(_block)) % sizeof(_block);
+
+    // ustar: Pfade ueber 100 Zeichen stehen geteilt in prefix und name
+    char field[156];
+    String name;
+    if (memcmp(_block + 257, "ustar", 5) == 0 && _block[345] != 0) {
+        memcpy(field, _block + 345, 155);
+        field[155] = 0;
+        name = String(field) + "/";
+    }
+    memcpy(field, _block, 100);
+    field[100] = 0;
+    name += field;
+
+    if (!openEntry(name, (char)_block[156])) {
+        return false;
+    }
+    // Leere Datei: es kommen keine Daten, die finishEntry() ausloesen wuerden
+    return _left > 0 || finishEntry();
+}
+
+bool UiInstaller::openEntry(const String &entryName, char type)
+{
+    _entry = nullptr;
+    _inManifest = false;
+
+    String name = entryName;
+    while (name.startsWith("./")) {
+        name.remove(0, 2);
+    }
+    if (name.endsWith("/")) {
+        name.remove(name.length() - 1);
+    }
+
+    // Verzeichnisse entstehen erst mit ihrer ersten geschriebenen Datei —
+    // pax-Header, Links und Aehnliches: Daten ueberspringen
+    bool isFile = type == '0' || type == 0;
+    if (!isFile || name.isEmpty()) {
+        return true;
+    }
+    if (name.startsWith("/") || name.indexOf("..") >= 0) {
+        _error = "Unzulaessiger Pfad im Archiv";
+        return false;
+    }
+    // macOS-tar legt zu jeder Datei ._name mit Metadaten ab
+    int slash = name.lastIndexOf('/');
+    if (name.substring(slash + 1).startsWith("._")) {
+        return true;
+    }
+
+    // Das Manifest zaehlt nur vor der ersten Datei — danach waeren schon
+    // Dateien ohne Abgleich geschrieben
+    if (name == UI_MANIFEST_NAME) {
+        if (_recordCount > 0) {
+            return true;
+        }
+        if (_left > UI_MANIFEST_MAX_BYTES) {
+            _error = "manifest.json zu gross";
+            return false;
+        }
+        _inManifest = true;
+        _manifestText = "";
+        _manifestText.reserve(_left);
+        return true;
+    }
+
+    // Mit Manifest: Eintrag nachschlagen. Ohne: Eintrag anlegen, die Pruefsumme
+    // liefern die Daten selbst
+    String key = "/" + name;
+    UiFileRecord *entry = record(key);
+    bool skip = false;
+    if (_hasManifest) {
+        if (!entry || entry->size != _left || entry->dir.length() > 0) {
+            _error = "Archiv passt nicht zum Manifest";
+            return false;
+        }
+        // Gleicher Inhalt wie in der aktiven UI: nur pruefen, nicht schreiben
+        StoreLock lock;
+        const UiFileRecord *installed = findActive(key);
+        skip = installed && installed->size == entry->size &&
+               memcmp(installed->sha256, entry->sha256, sizeof(entry->sha256)) == 0 &&
+               LittleFS.exists(installed->dir + key);
+        if (skip) {
+            entry->dir = installed->dir;
+        }
+    } else if (entry) {
+        _error = "Datei doppelt im UI-Archiv";
+        return false;
+    } else if (_recordCount >= UI_MAX_FILES) {
+        _error = "Zu viele Dateien im UI-Archiv";
+        return false;
+    } else {
+        entry = &_records[_recordCount++];
+        entry->path = key;
+        entry->size = _left;
+    }
+
+    if (skip) {
+        _skipped++;
+        _skippedBytes += _left;
+    } else {
+        // Elternverzeichnisse anlegen — LittleFS.mkdir() legt nur eine Ebene an
+        String path = _dir + key;
+        for (int i = _dir.length() + 1; i < (int)path.length(); i++) {
+            if (path[i] == '/') {
+                String parent = path.substring(0, i);
+                if (!LittleFS.exists(parent)) {
+                    LittleFS.mkdir(parent);
+                }
+            }
+        }
+        _file = LittleFS.open(path, "w");
+        if (!_file) {
+            _error = "Datei im UI-Verzeichnis nicht anlegbar";
+            return false;
+        }
+        entry->dir = _dir;
+        _files++;
+    }
+    _entry = entry;
+    mbedtls_sha256_starts(&_sha, 0);
+    return true;
+}
+
+// Laufender Eintrag vollstaendig gelesen
+bool UiInstaller::finishEntry()
+{
+    if (_inManifest) {
+        _inManifest = false;
+        return parseManifest();
+    }
+    if (!_entry) {
+        return true;
+    }
+    if (_file) {
+        _file.close();
+    }
+
+    uint8_t digest[32];
+    mbedtls_sha256_finish(&_sha, digest);
+    UiFileRecord *entry = _entry;
+    _entry = nullptr;
+    if (!_hasManifest) {
+        memcpy(entry->sha256, digest, sizeof(digest));
+    } else if (memcmp(digest, entry->sha256, sizeof(digest)) != 0) {
+        LOG_E("UI-Upload: SHA-256 von %s passt nicht zum Manifest", entry->path);
+        _error = "Datei passt nicht zum Manifest";
+        return false;
+    }
+    return true;
+}
+
+bool UiInstaller::parseManifest()
+{
+    JsonDocument doc;
+    DeserializationError err = deserializeJson(doc, _manifestText);
+    _manifestText = String();  // Speicher sofort zurueck
+    if (err) {
+        _error = "manifest.json nicht lesbar";
+        return false;
+    }
+
+    for (JsonPair kv : doc["files"].as<JsonObject>()) {
+        if (_recordCount >= UI_MAX_FILES) {
+            _error = "Zu viele Dateien im UI-Archiv";
+            return false;
+        }
+        UiFileRecord &r = _records[_recordCount];
+        r.path = String("/") + kv.key().c_str();
+        r.dir = "";
+        r.size = kv.value()["size"] | 0;
+        if (r.path.indexOf("..") >= 0 || !parseSha256Hex(kv.value()["sha256"] | "", r.sha256)) {
+            _error = "manifest.json fehlerhaft";
+            return false;
+        }
+        _recordCount++;
+    }
+    _hasManifest = _recordCount > 0;
+    LOG_D("UI-Upload: Manifest mit %u Dateien", _recordCount);
+    return true;
+}
+
+UiFileRecord *UiInstaller::record(const String &path)
+{
+    for (uint8_t i = 0; i < _recordCount; i++) {
+        if (_records[i].path == path) {
+            return &_records[i];
+        }
+    }
+    return nullptr;
+}
+
+bool UiInstaller::end(bool stage)
+{
+    if (!_active) {
+        return false;
+    }
+    if (!_gzip.finish()) {
+        return fail(_gzip.error());
+    }
+    if (_left > 0 || _have > 0 || _pad > 0) {
+        return fail("tar-Archiv unvollstaendig");
+    }
+    _gzip.release();
+
+    // Jede Datei aus dem Manifest muss auch im Archiv gestanden haben
+    for (uint8_t i = 0; i < _recordCount; i++) {
+        if (_records[i].dir.isEmpty()) {
+            return fail("Archiv unvollstaendig laut Manifest");
+        }
+    }
+
+    // Ohne Startseite und Einstellungen waere die Lampe nicht mehr bedienbar
+    const char *required[] = {"/index.html", "/setup.html"};
+    for (const char *page : required) {
+        if (!record(page) && !record(String(page) + ".gz")) {
+            return fail("Archiv ohne index.html/setup.html");
+        }
+    }
+
+    if (!writeIndex(_dir, _records, _recordCount)) {
+        return fail("UI-Dateiindex nicht schreibbar");
+    }
+
+    StoreLock lock;
+
+    if (stage) {
+        if (!writePointer(UI_PENDING_FILE, _dir, _version)) {
+            return fail("UI-Zeiger nicht schreibbar");
+        }
+        pendingDir = _dir;
+        pendingVersion = _version;
+        _active = false;
+        return true;
+    }
+
+    // Bisher aktive Version wird die vorherige. Scheitert nur das, fehlt
+    // lediglich der Rollback — kein Grund, die neue UI zu verwerfen.
+    if (!switchActive(_dir, _version)) {
+        return fail("UI-Zeiger nicht schreibbar");
+    }
+    for (uint8_t i = 0; i < _recordCount; i++) {
+        activeFiles[i] = _records[i];
+    }
+    activeFileCount = _recordCount;
+    _active = false;
+
+    // Erst jetzt ist die bisher vorherige Version entbehrlich
+    pruneUiDirs();
+    return true;
+}
+
+void UiInstaller::abort()
+{
+    if (_file) {
+        _file.close();
+    }
+    _gzip.release();
+    _entry = nullptr;
+    _inManifest = false;
+    _manifestText = String();
+    if (_active) {
+        _active = false;
+        deleteDir(_dir);
+    }
+}
+
+bool UiInstaller::fail(const char *reason)
+{
+    _error = reason;
+    abort();
+    return false;
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "mbedtls/sha256.h"
+#include "config.h"
+#include "ota_gzip.h"
+
+// === Versionierte WebUI im LittleFS ===
+// Jede ueber /ui-upload installierte UI liegt in einem eigenen Verzeichnis
+// /ui-<version>/. Welches davon ausgeliefert wird, steht in /ui-active.txt.
+// Umgeschaltet wird erst, wenn die neue Version vollstaendig entpackt ist, und
+// zwar per rename() — littlefs ersetzt das Ziel atomar, ein Stromausfall
+// mittendrin laesst also entweder die alte oder die neue UI aktiv.
+//
+// Die vorherige Version bleibt liegen (/ui-previous.txt) und ist per
+// uiRollback() sofort wieder aktiv — bei der ersten versionierten UI ist das
+// die im Wurzelverzeichnis. Aeltere Verzeichnisse werden erst entfernt, wenn
+// eine neue Version aktiv geworden ist; ein gescheiterter Upload nimmt den
+// Rollback also nicht mit.
+//
+// Jede Version fuehrt einen Dateiindex (/ui-<version>/.files): Pfad, Groesse,
+// SHA-256 und das Verzeichnis, in dem die Bytes liegen. Unveraenderte Dateien
+// schreibt der Installer nicht neu, sondern verweist auf das Verzeichnis der
+// Vorversion — ein Verzeichnis bleibt deshalb so lange liegen, wie der Index der
+// aktiven Version darauf zeigt.
+//
+// Ohne /ui-active.txt — frisch per "pio run -t uploadfs" geflasht — kommen die
+// Dateien wie bisher aus dem Wurzelverzeichnis. Eine Version mit Index liefert
+// nur, was im Index steht; das Wurzelverzeichnis ist dann tabu.
+
+// Eine Datei der UI, wie sie im Manifest bzw. im Dateiindex steht
+struct UiFileRecord {
+    String path;          // "/js/mood.js"
+    String dir;           // "/ui-9.16" — wo die Bytes liegen; leer = noch nicht angekommen
+    uint8_t sha256[32];
+    uint32_t size;
+};
+
+// Zeiger lesen. Nach LittleFS.begin() aufrufen.
+void uiStoreBegin();
+
+// Datei der aktiven UI zum Lesen oeffnen: "/css/style.css" aus
+// /ui-9.16/css/style.css, ohne versionierte UI aus dem Wurzelverzeichnis.
+// preferGzip: zuerst path + ".gz" (Seiten-Bundle); gzip meldet, welche Fassung
+// offen ist. Mit Dateiindex genau ein Dateisystemzugriff (das open()).
+File uiOpenFile(const String &path, bool preferGzip, bool &gzip);
+
+// Zeiger und Index sind gegen den Update-Task gesperrt; die Abfragen liefern
+// deshalb Kopien
+String uiActiveDir();               // leer ohne versionierte UI
+String uiActiveVersion();
+String uiPreviousVersion();         // leer, wenn kein Rollback moeglich
+
+// Vorherige Version wieder aktivieren (und die aktuelle zur vorherigen machen)
+bool uiRollback();
+
+// Bereitgestellte Version (UiInstaller::end(true), /ui-pending.txt): liegt
+// vollstaendig entpackt neben der aktiven und wartet auf die passende Firmware
+// (siehe update_txn.h)
+String uiPendingVersion();          // leer, wenn nichts bereitsteht
+bool uiActivatePending();           // wie ein abgeschlossener Upload umschalten und aufraeumen
+void uiDiscardPending();            // Verzeichnis und Zeiger verwerfen
+
+// Entpackt ein UI-tgz in einem Durchgang aus dem Upload-Strom: gzip (ROM-tinfl
+// ueber GzipDecoder) und tar werden blockweise verarbeitet, jede Datei landet
+// genau einmal im Flash — direkt in ihrem Zielverzeichnis. Kein Zwischen-tgz,
+// kein Entpack- und kein Backup-Verzeichnis.
+//
+// Steht manifest.json als erster Eintrag im Archiv (build-ui-manifest.py),
+// werden Dateien, deren SHA-256 zur installierten Fassung passt, nur gehasht
+// und nicht geschrieben. Jede Datei wird gegen das Manifest geprueft; ohne
+// Manifest wird alles geschrieben und der Index aus den Daten selbst gebildet.
+class UiInstaller {
+public:
+    UiInstaller();
+    ~UiInstaller();
+
+    // Neues Verzeichnis fuer version anlegen; raeumt vorher Reste abgebrochener
+    // Installationen weg, die vorherige Version nur bei Platzmangel.
+    // contentLength fuer die Platzpruefung, 0 = unbekannt.
+    bool begin(const String &version, size_t contentLength);
+
+    // Naechster Block des tgz. false bei Fehler (siehe error()); das halbe
+    // Verzeichnis ist dann schon geloescht.
+    bool write(const uint8_t *data, size_t len);
+
+    // Archiv vollstaendig? Dann auf die neue Version umschalten — oder, mit
+    // stage, sie nur bereitstellen: vorherige Version und Rollback-Zeiger bleiben
+    // unangetastet, umgeschaltet und aufgeraeumt wird in uiActivatePending().
+    bool end(bool stage = false);
+
+    void abort();
+
+    bool active() const { return _active; }
+    const char *error() const { return _error; }
+    uint32_t bytesWritten() const { return _written; }   // Nutzdaten im Flash
+    uint16_t files() const { return _files; }             // davon geschrieben
+    uint16_t filesSkipped() const { return _skipped; }    // unveraendert, nicht geschrieben
+    uint32_t bytesSkipped() const { return _skippedBytes; }
+    bool hasManifest() const { return _hasManifest; }
+    uint32_t elapsedMs() const { return millis() - _startedMs; }
+
+private:
+    static bool tarSink(void *ctx, const uint8_t *data, size_t len);
+    bool tar(const uint8_t *data, size_t len);
+    bool header();
+    bool openEntry(const String &name, char type);
+    bool finishEntry();
+    bool parseManifest();
+    UiFileRecord *record(const String &path);
+    bool fail(const char *reason);
+
+    GzipDecoder _gzip;
+    mbedtls_sha256_context _sha;
+    String _dir;
+    String _version;
+
+    uint8_t _block[512];        // tar-Header, wird gesammelt
+    uint16_t _have = 0;
+    uint32_t _left = 0;         // Restbytes des laufenden Eintrags
+    uint16_t _pad = 0;          // Fuellbytes bis zur naechsten 512er-Grenze
+    bool _eof = false;          // Null-Block gesehen
+    File _file;                 // Offen, solange _left zu einer Datei gehoert
+
+    // Laufender Eintrag: Datei (_entry), manifest.json oder nichts
+    UiFileRecord *_entry = nullptr;
+    bool _inManifest = false;
+    String _manifestText;
+
+    UiFileRecord _records[UI_MAX_FILES];  // Manifest bzw. neuer Dateiindex
+    uint8_t _recordCount = 0;
+    bool _hasManifest = false;
+
+    bool _active = false;
+    const char *_error = "";
+    uint32_t _written = 0;
+    uint16_t _files = 0;
+    uint16_t _skipped = 0;
+    uint32_t _skippedBytes = 0;
+    uint32_t _startedMs = 0;
+};
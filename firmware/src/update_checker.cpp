@@ -8,21 +8,48 @@
 // als erstes Byte, vollstaendig empfangen. Schlaegt irgendetwas fehl, wird
 // abgebrochen — die laufende Partition bleibt unberuehrt und das Geraet startet
 // im Zweifel einfach wieder mit der alten Firmware.
+//
+// Ein abgerissener Download ist dagegen kein Fehlschlag: er wird per HTTP-Range
+// an derselben Stelle fortgesetzt (siehe runInstall()).
+//
+// Mit updatePrefetchEnabled laeuft derselbe Weg nachts gedrosselt als
+// Vorab-Laden: Image in die freie Partition, Boot-Partition bleibt die alte.
+// Der Klick auf "Installieren" prueft dann nur noch den Inhalt der Partition
+// gegen die SHA-256 und schaltet um.
+//
+// Vor dem Backend kommen Moodlights im LAN an die Reihe, die per mDNS die
+// gesuchte Version anbieten. Die Reihenfolge der Quellen steht in
+// update_source.h; was sie liefern, durchlaeuft dieselbe SHA-256-Pruefung wie
+// jeder Download.
 
 #include <Arduino.h>
 #include <WiFi.h>
 #include <HTTPClient.h>
+#include <ESPmDNS.h>
 #include <Update.h>
 #include <ArduinoJson.h>
 #include <LittleFS.h>
+#include <memory>
+#include <time.h>
+#include "mbedtls/sha256.h"
+#include "esp_ota_ops.h"
+#include "esp_image_format.h"
 
 #include "config.h"
 #include "app_state.h"
 #include "debug.h"
 #include "update_checker.h"
+#include "ota_gzip.h"
+#include "ota_delta.h"
+#include "ui_store.h"
+#include "update_txn.h"
+#include "update_source.h"
 #include "led_controller.h"
 #include "sensor_manager.h"   // wifiClientHTTP — dieselbe Client-Instanz wie der Sentiment-Abruf
 #include "MoodlightUtils.h"
+#include "sha256_hex.h"
+
+#define LOG_TAG LOG_TAG_UPDATE
 
 extern WatchdogManager watchdog;
 
@@ -52,7 +79,7 @@ bool checkForUpdate()
     }
 
     String url = updateApiBase() + "/api/firmware/latest?current=" + currentVersionForCompare();
-    debug(String(F("Update-Pruefung: ")) + url);
+    LOG_D("Update-Pruefung: %s", url);
 
     HTTPClient http;
     http.setReuse(false);
@@ -64,7 +91,7 @@ bool checkForUpdate()
     }
 
     if (!http.begin(wifiClientHTTP, url)) {
-        debug(F("Update-Pruefung: HTTP Begin fehlgeschlagen"));
+        LOG_E("Update-Pruefung: HTTP Begin fehlgeschlagen");
         return false;
     }
 
@@ -73,7 +100,7 @@ bool checkForUpdate()
     watchdog.feed();  // Blockierender Call — WDT sofort fuettern
 
     if (httpCode != HTTP_CODE_OK) {
-        debug(String(F("Update-Pruefung: HTTP ")) + String(httpCode));
+        LOG_E("Update-Pruefung: HTTP %d", httpCode);
         http.end();
         return false;
     }
@@ -84,7 +111,7 @@ bool checkForUpdate()
     http.end();
 
     if (error) {
-        debug(String(F("Update-Pruefung: JSON-Fehler ")) + error.c_str());
+        LOG_E("Update-Pruefung: JSON-Fehler %s", error.c_str());
         return false;
     }
 
@@ -92,11 +119,20 @@ bool checkForUpdate()
 
     if (!available) {
         appState.updateAvailable = false;
-        appState.updateVersion = "";
-        appState.updateReleaseUrl = "";
-        appState.updateFirmwarePath = "";
+        appState.updateVersion.clear();
+        appState.updateReleaseUrl.clear();
+        appState.updateFirmwarePath.clear();
         appState.updateFirmwareSize = 0;
-        debug(F("Update-Pruefung: aktuelle Version ist die neueste"));
+        appState.updateFirmwareGzPath.clear();
+        appState.updateFirmwareGzSize = 0;
+        appState.updateFirmwareSha256.clear();
+        appState.updateDeltaPath.clear();
+        appState.updateDeltaSize = 0;
+        appState.updateDeltaBaseSize = 0;
+        appState.updateDeltaBaseSha256.clear();
+        appState.updateUiPath.clear();
+        appState.updateUiSize = 0;
+        LOG_I("Update-Pruefung: aktuelle Version ist die neueste");
         return true;
     }
 
@@ -104,28 +140,75 @@ bool checkForUpdate()
     const char *fwPath = doc["firmware_url"] | "";
     const char *relUrl = doc["release_url"] | "";
     size_t fwSize = doc["firmware_size"] | 0;
+    const char *gzPath = doc["firmware_gz_url"] | "";
+    size_t gzSize = doc["firmware_gz_size"] | 0;
+    const char *sha256 = doc["firmware_sha256"] | "";
+    const char *deltaPath = doc["delta_url"] | "";
+    size_t deltaSize = doc["delta_size"] | 0;
+    size_t deltaBaseSize = doc["delta_base_size"] | 0;
+    const char *deltaBaseSha = doc["delta_base_sha256"] | "";
+    const char *uiPath = doc["ui_url"] | "";
+    size_t uiSize = doc["ui_size"] | 0;
 
     // Ohne Version oder Pfad ist die Antwort unbrauchbar
     if (strlen(version) == 0 || strlen(fwPath) == 0) {
-        debug(F("Update-Pruefung: Antwort ohne Version oder Pfad"));
+        LOG_E("Update-Pruefung: Antwort ohne Version oder Pfad");
         return false;
     }
 
     // Groessenplausibilitaet schon hier pruefen — spart einen sinnlosen Download
     if (fwSize > 0 && fwSize < UPDATE_MIN_FIRMWARE_SIZE) {
-        debug(String(F("Update-Pruefung: gemeldete Groesse zu klein (")) +
-              String(fwSize) + F(" Bytes) — ignoriert"));
+        LOG_W("Update-Pruefung: gemeldete Groesse zu klein (%u Bytes) — ignoriert", fwSize);
+        return false;
+    }
+
+    // Ohne Pruefsumme laesst sich nicht belegen, dass das Geflashte das
+    // Freigegebene ist — dann kein Update anbieten
+    uint8_t digest[32];
+    if (!parseSha256Hex(sha256, digest)) {
+        LOG_W("Update-Pruefung: Antwort ohne gueltige SHA-256 — ignoriert");
         return false;
     }
 
+    // Ein gekuerzter Pfad wuerde ins Leere laden — dann lieber kein Update anbieten
+    if (!appState.updateFirmwarePath.assign(fwPath)) {
+        appState.updateFirmwarePath.clear();
+        LOG_W("Update-Pruefung: Firmware-Pfad zu lang — ignoriert");
+        return false;
+    }
     appState.updateAvailable = true;
-    appState.updateVersion = String(version);
-    appState.updateReleaseUrl = String(relUrl);
-    appState.updateFirmwarePath = String(fwPath);
+    appState.updateVersion = version;
+    appState.updateReleaseUrl = relUrl;
     appState.updateFirmwareSize = fwSize;
+    appState.updateFirmwareSha256 = sha256;
+
+    // gzip-Variante ist optional (aeltere Spiegel-Eintraege haben keine).
+    // Gekuerzt waere sie unbrauchbar — dann eben unkomprimiert laden.
+    if (!appState.updateFirmwareGzPath.assign(gzPath)) {
+        appState.updateFirmwareGzPath.clear();
+    }
+    appState.updateFirmwareGzSize = appState.updateFirmwareGzPath.isEmpty() ? 0 : gzSize;
+
+    // Delta nur mit vollstaendiger Beschreibung der Basis — ob die laufende
+    // Firmware dazu passt, prueft runInstall() vor dem Download
+    uint8_t baseDigest[32];
+    if (deltaBaseSize == 0 || !parseSha256Hex(deltaBaseSha, baseDigest) ||
+        !appState.updateDeltaPath.assign(deltaPath)) {
+        appState.updateDeltaPath.clear();
+    }
+    bool hasDelta = !appState.updateDeltaPath.isEmpty();
+    appState.updateDeltaSize = hasDelta ? deltaSize : 0;
+    appState.updateDeltaBaseSize = hasDelta ? deltaBaseSize : 0;
+    appState.updateDeltaBaseSha256 = hasDelta ? deltaBaseSha : "";
+
+    // UI-Archiv ist optional; ohne wird nur die Firmware getauscht
+    if (!appState.updateUiPath.assign(uiPath)) {
+        appState.updateUiPath.clear();
+    }
+    appState.updateUiSize = appState.updateUiPath.isEmpty() ? 0 : uiSize;
 
-    debug(String(F("Update verfuegbar: ")) + appState.updateVersion +
-          F(" (") + String(fwSize) + F(" Bytes)"));
+    LOG_I("Update verfuegbar: %s (%u Bytes, gzip %u Bytes, Delta %u Bytes, UI %u Bytes)", appState.updateVersion,
+          fwSize, appState.updateFirmwareGzSize, appState.updateDeltaSize, appState.updateUiSize);
     return true;
 }
 
@@ -155,218 +238,1195 @@ void handleUpdateCheck()
     checkForUpdate();
 }
 
-bool downloadAndInstallUpdate()
+// === Installation im Hintergrund ===
+// Download und Flash laufen in einem eigenen Task. Die loop() bedient
+// waehrenddessen weiter Webserver, MQTT und LEDs; die WebUI fragt den
+// Fortschritt ueber /api/update/status ab.
+
+static UpdateProgress progress;
+static PrefetchStatus prefetch;
+
+// Gedrosselt wird nur das Vorab-Laden. Ein Klick auf "Installieren" hebt die
+// Drossel auf; der Task installiert dann gleich im Anschluss.
+static volatile bool throttleActive = false;
+static volatile bool installRequested = false;
+// Bis der Task am Ende installRequested abholt, nimmt er den Klick noch an.
+// Abholen und Annehmen laufen unter handoffMux — sonst ginge ein Klick
+// zwischen beiden verloren, obwohl die WebUI schon 202 bekommen hat.
+static portMUX_TYPE handoffMux = portMUX_INITIALIZER_UNLOCKED;
+static bool handoffOpen = false;
+static uint32_t throttleStartMs = 0;
+static uint32_t throttleBytes = 0;
+
+const UpdateProgress &updateProgress()
 {
-    if (appState.updateInProgress) {
-        appState.updateLastError = F("Es laeuft bereits ein Update");
-        return false;
+    return progress;
+}
+
+const PrefetchStatus &updatePrefetchStatus()
+{
+    return prefetch;
+}
+
+const char *prefetchStateName(PrefetchState state)
+{
+    switch (state) {
+        case PREFETCH_WAITING: return "waiting";
+        case PREFETCH_RUNNING: return "running";
+        case PREFETCH_READY: return "ready";
+        case PREFETCH_FAILED: return "failed";
+        default: return "idle";
     }
+}
 
-    if (!appState.updateAvailable || appState.updateFirmwarePath.length() == 0) {
-        appState.updateLastError = F("Kein Update vorgemerkt");
-        return false;
+// Haelt den Durchsatz beim Vorab-Laden unter updatePrefetchRate: nach jedem
+// Block so lange warten, bis die bisher geladenen Bytes "bezahlt" sind. Der
+// Empfangspuffer laeuft dabei voll und TCP bremst den Server von selbst.
+static void throttle(size_t bytes)
+{
+    if (!throttleActive) {
+        return;
+    }
+    throttleBytes += bytes;
+    uint32_t due = throttleStartMs +
+                   (uint64_t)throttleBytes * 1000 / ((uint32_t)appState.updatePrefetchRate * 1024);
+    int32_t wait = (int32_t)(due - millis());
+    if (wait > 0) {
+        delay(wait);
+    }
+}
+
+const char *updatePhaseName(UpdatePhase phase)
+{
+    switch (phase) {
+        case UPDATE_PHASE_CONNECTING: return "connecting";
+        case UPDATE_PHASE_STAGING_UI: return "staging_ui";
+        case UPDATE_PHASE_DOWNLOADING: return "downloading";
+        case UPDATE_PHASE_RESUMING: return "resuming";
+        case UPDATE_PHASE_FINISHING: return "finishing";
+        case UPDATE_PHASE_DONE: return "done";
+        case UPDATE_PHASE_FAILED: return "failed";
+        default: return "idle";
     }
+}
 
-    if (WiFi.status() != WL_CONNECTED) {
-        appState.updateLastError = F("Keine WLAN-Verbindung");
+uint32_t updateBytesPerSecond()
+{
+    uint32_t elapsed = progress.lastDataMs - progress.startedMs;
+    return elapsed > 0 ? (uint64_t)progress.written * 1000 / elapsed : 0;
+}
+
+// SHA-256 der ersten size Bytes je OTA-Partition, einmal gerechnet. Die
+// laufende Partition aendert sich bis zum Neustart nicht, die freie nur beim
+// Beschreiben — dann verwirft updatePartitionWritten() ihren Eintrag.
+// Gelesen und geschrieben vom Update-Task bzw., wenn keiner laeuft, von der
+// loop() (/api/update/peer-image) — nie von beiden zugleich.
+struct PartitionHash {
+    const esp_partition_t *part = nullptr;
+    size_t size = 0;                // 0 = nicht gerechnet
+    uint8_t digest[32];
+};
+static PartitionHash partitionHashes[2];  // Laufende und freie Partition
+
+static bool partitionSha256(const esp_partition_t *part, size_t size, uint8_t digest[32])
+{
+    if (!part || size == 0 || size > part->size) {
         return false;
     }
+    PartitionHash *slot = &partitionHashes[1];
+    for (PartitionHash &entry : partitionHashes) {
+        if (entry.part == part || entry.part == nullptr) {
+            slot = &entry;
+            break;
+        }
+    }
+    if (slot->part == part && slot->size == size) {
+        memcpy(digest, slot->digest, sizeof(slot->digest));
+        return true;
+    }
 
-    // Ohne ausreichend Heap gar nicht erst anfangen: mitten im Flash-Vorgang
-    // auszugehen ist der schlimmste Zeitpunkt.
-    uint32_t freeHeap = ESP.getFreeHeap();
-    if (freeHeap < UPDATE_MIN_FREE_HEAP) {
-        appState.updateLastError = String(F("Zu wenig freier Speicher (")) +
-                                   String(freeHeap) + F(" Bytes)");
-        debug(appState.updateLastError);
+    mbedtls_sha256_context ctx;
+    mbedtls_sha256_init(&ctx);
+    mbedtls_sha256_starts(&ctx, 0);
+
+    uint8_t buf[512];
+    bool readOk = true;
+    for (size_t offset = 0; offset < size && readOk; offset += sizeof(buf)) {
+        size_t n = size - offset < sizeof(buf) ? size - offset : sizeof(buf);
+        readOk = esp_partition_read(part, offset, buf, n) == ESP_OK;
+        if (readOk) {
+            mbedtls_sha256_update(&ctx, buf, n);
+        }
+    }
+    mbedtls_sha256_finish(&ctx, digest);
+    mbedtls_sha256_free(&ctx);
+    if (!readOk) {
         return false;
     }
+    slot->part = part;
+    slot->size = size;
+    memcpy(slot->digest, digest, sizeof(slot->digest));
+    return true;
+}
 
-    appState.updateInProgress = true;
-    appState.updateLastError = "";
-    setStatusLED(3);  // Update-Modus
+void updatePartitionWritten()
+{
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    for (PartitionHash &entry : partitionHashes) {
+        if (entry.part != running) {
+            entry.size = 0;
+        }
+    }
+}
 
-    String url = updateApiBase() + appState.updateFirmwarePath;
-    debug(String(F("Firmware-Download: ")) + url);
+// Woraus das Image in der Partition entsteht
+enum FlashSource : uint8_t {
+    FLASH_RAW,          // .bin, wird direkt geschrieben
+    FLASH_GZIP,         // .bin.gz, wird beim Schreiben entpackt
+    FLASH_DELTA,        // Delta-Patch (gzip) gegen die laufende Partition
+};
 
-    HTTPClient http;
-    http.setReuse(false);
-    http.setUserAgent("MoodlightClient/1.0");
+// Ziel der empfangenen Bytes: direkt in Update, ueber den Entpacker oder ueber
+// Entpacker und Patcher. Jeder Weg endet in flashBlock().
+// Bei false steht der Grund in updateLastError.
+//
+// Ohne activate (Vorab-Laden) schreibt FlashTarget ueber esp_ota_begin/
+// write/end statt ueber Update: Update.end() traegt die Partition in otadata
+// als Boot-Partition ein, und jedes Zuruecksetzen danach markiert die laufende
+// Firmware als neu — ein spaeterer Rollback landete im nicht installierten
+// Image. esp_ota_end() prueft das Image nur und laesst otadata in Ruhe.
+//
+// Jeder geflashte Block geht ausserdem durch SHA-256; committet wird nur, wenn
+// das Ergebnis zu firmware_sha256 vom Backend passt. Bei gzip und Delta wird
+// das Ergebnis gehasht — also genau das, was in der Partition steht. mbedtls
+// rechnet auf dem ESP32 mit dem SHA-Beschleuniger (CONFIG_MBEDTLS_HARDWARE_SHA).
+struct FlashTarget {
+    GzipDecoder inflater;
+    DeltaPatcher patcher;
+    FlashSource source = FLASH_RAW;
+    bool activate = true;           // Nach dem Schreiben Boot-Partition umstellen
+    bool active = false;
+    esp_ota_handle_t ota = 0;       // Nur ohne activate
+    mbedtls_sha256_context sha;
+    uint8_t expectedSha[32];
 
-    if (wifiClientHTTP.connected()) {
-        wifiClientHTTP.stop();
-        delay(10);
+    // Basis fuer FLASH_DELTA, vorher von baseMatches() geprueft
+    const esp_partition_t *base = nullptr;
+    size_t baseSize = 0;
+    uint8_t baseSha[32];
+
+    FlashTarget() { mbedtls_sha256_init(&sha); }
+    ~FlashTarget() { mbedtls_sha256_free(&sha); }
+
+    static bool flashSink(void *ctx, const uint8_t *data, size_t len)
+    {
+        return static_cast<FlashTarget *>(ctx)->flashBlock(data, len);
     }
 
-    if (!http.begin(wifiClientHTTP, url)) {
-        appState.updateLastError = F("Verbindung zum Backend fehlgeschlagen");
-        appState.updateInProgress = false;
-        setStatusLED(0);
-        return false;
+    static bool patchSink(void *ctx, const uint8_t *data, size_t len)
+    {
+        FlashTarget *self = static_cast<FlashTarget *>(ctx);
+        if (!self->patcher.write(data, len)) {
+            // Leer, wenn flashBlock() abgelehnt hat — dann steht der Grund schon da
+            if (strlen(self->patcher.error()) > 0) {
+                appState.updateLastError = String(F("Delta fehlgeschlagen: ")) +
+                                           String(self->patcher.error());
+            }
+            return false;
+        }
+        return true;
     }
 
-    http.setTimeout(UPDATE_DOWNLOAD_TIMEOUT);
-    int httpCode = http.GET();
-    watchdog.feed();
+    void hash(const uint8_t *data, size_t len)
+    {
+        uint32_t start = micros();
+        mbedtls_sha256_update(&sha, data, len);
+        progress.hashUs += micros() - start;
+    }
 
-    if (httpCode != HTTP_CODE_OK) {
-        appState.updateLastError = String(F("Backend antwortete mit HTTP ")) + String(httpCode);
-        debug(appState.updateLastError);
-        http.end();
-        appState.updateInProgress = false;
-        setStatusLED(0);
+    bool begin(size_t imageSize)
+    {
+        updatePartitionWritten();
+
+        // Auch ein Neubeginn nach einem Abbruch hasht wieder ab Byte 0
+        mbedtls_sha256_starts(&sha, 0);
+        progress.hashUs = 0;
+        progress.flashed = 0;
+
+        if (source != FLASH_RAW &&
+            !inflater.begin(source == FLASH_DELTA ? &FlashTarget::patchSink : &FlashTarget::flashSink, this)) {
+            appState.updateLastError = String(F("Update.begin fehlgeschlagen: ")) +
+                                       String(inflater.error());
+            return false;
+        }
+        if (source == FLASH_DELTA) {
+            patcher.begin(base, baseSize, baseSha, &FlashTarget::flashSink, this);
+        }
+
+        // Update.begin() bzw. esp_ota_begin() pruefen selbst, ob die Datei in die
+        // freie OTA-Partition passt
+        if (activate) {
+            active = Update.begin(imageSize);
+            if (!active) {
+                appState.updateLastError = String(F("Update.begin fehlgeschlagen: ")) +
+                                           String(Update.errorString());
+            }
+        } else {
+            // Sequentiell: geloescht wird Sektor fuer Sektor beim Schreiben wie
+            // bei Update, nicht der ganze Bereich vorab. Die Groesse wird dann
+            // nicht mehr geprueft — das uebernimmt der Vergleich hier.
+            const esp_partition_t *part = esp_ota_get_next_update_partition(nullptr);
+            esp_err_t err = ESP_ERR_INVALID_SIZE;
+            if (part && imageSize <= part->size) {
+                err = esp_ota_begin(part, OTA_WITH_SEQUENTIAL_WRITES, &ota);
+            }
+            active = err == ESP_OK;
+            if (!active) {
+                appState.updateLastError = String(F("esp_ota_begin fehlgeschlagen: ")) +
+                                           esp_err_to_name(err);
+            }
+        }
+        if (!active) {
+            inflater.release();
+        }
+        return active;
+    }
+
+    // Ein Block des fertigen Images
+    bool flashBlock(const uint8_t *data, size_t len)
+    {
+        // Dieselbe Bricking-Vorsorge wie beim Upload ueber die WebUI: eine
+        // ESP32-Firmware beginnt mit 0xE9. Was damit nicht anfaengt, wird nicht
+        // geflasht — egal was das Backend behauptet.
+        if (progress.flashed == 0 && data[0] != 0xE9) {
+            appState.updateLastError = F("Datei ist keine ESP32-Firmware (Magic-Byte fehlt)");
+            return false;
+        }
+        if (activate) {
+            // Update.write() kopiert nur in seinen Sektorpuffer
+            if (Update.write(const_cast<uint8_t *>(data), len) != len) {
+                appState.updateLastError = String(F("Schreibfehler: ")) +
+                                           String(Update.errorString());
+                return false;
+            }
+        } else {
+            esp_err_t err = esp_ota_write(ota, data, len);
+            if (err != ESP_OK) {
+                appState.updateLastError = String(F("Schreibfehler: ")) + esp_err_to_name(err);
+                return false;
+            }
+        }
+        hash(data, len);
+        progress.flashed += len;
+        return true;
+    }
+
+    bool digestMatches()
+    {
+        uint8_t digest[32];
+        mbedtls_sha256_finish(&sha, digest);
+        if (memcmp(digest, expectedSha, sizeof(digest)) != 0) {
+            appState.updateLastError = F("SHA-256 stimmt nicht — Firmware verworfen");
+            return false;
+        }
+        return true;
+    }
+
+    bool write(const uint8_t *buf, size_t len)
+    {
+        bool ok = source == FLASH_RAW ? flashBlock(buf, len) : inflater.write(buf, len);
+        if (!ok) {
+            // Leer, wenn eine Senke abgelehnt hat — dann steht der Grund schon da
+            if (appState.updateLastError.length() == 0) {
+                appState.updateLastError = String(F("Entpacken fehlgeschlagen: ")) +
+                                           String(inflater.error());
+            }
+            abort();
+        }
+        return ok;
+    }
+
+    bool end(size_t imageSize)
+    {
+        if (source != FLASH_RAW && !inflater.finish()) {
+            appState.updateLastError = String(F("Entpacken fehlgeschlagen: ")) +
+                                       String(inflater.error());
+            abort();
+            return false;
+        }
+        if (source == FLASH_DELTA && !patcher.end()) {
+            appState.updateLastError = String(F("Delta fehlgeschlagen: ")) +
+                                       String(patcher.error());
+            abort();
+            return false;
+        }
+        inflater.release();
+
+        // gzip-Trailer bzw. Patch-Kopf und Backend muessen sich ueber die
+        // Groesse einig sein
+        if (progress.flashed != imageSize) {
+            appState.updateLastError = String(F("Geschrieben ")) + String(progress.flashed) +
+                                       F(" statt ") + String(imageSize) + F(" Bytes");
+            abort();
+            return false;
+        }
+        if (!digestMatches()) {
+            abort();
+            return false;
+        }
+        active = false;
+        if (!activate) {
+            // Prueft das Image wie Update.end(), ohne es zu aktivieren
+            esp_err_t err = esp_ota_end(ota);
+            if (err != ESP_OK) {
+                appState.updateLastError = String(F("Abschluss fehlgeschlagen: ")) +
+                                           esp_err_to_name(err);
+                return false;
+            }
+            return true;
+        }
+        if (!Update.end(true)) {
+            appState.updateLastError = String(F("Abschluss fehlgeschlagen: ")) +
+                                       String(Update.errorString());
+            return false;
+        }
+        if (!Update.isFinished()) {
+            appState.updateLastError = F("Update wurde nicht abgeschlossen");
+            return false;
+        }
+        return true;
+    }
+
+    void abort()
+    {
+        if (active) {
+            if (activate) {
+                Update.abort();
+            } else {
+                esp_ota_abort(ota);
+            }
+        }
+        active = false;
+        inflater.release();
+    }
+};
+
+// Steht in der laufenden Partition genau das Binary, gegen das der Patch
+// gebaut wurde? Ein frueher per WebUI hochgeladenes Eigenbau-Image mit
+// gleicher Versionsnummer waere sonst eine falsche Basis. Prueft ebenso die
+// freie Partition nach dem Vorab-Laden.
+static bool baseMatches(const esp_partition_t *part, size_t size, const uint8_t expected[32])
+{
+    uint8_t digest[32];
+    return partitionSha256(part, size, digest) && memcmp(digest, expected, sizeof(digest)) == 0;
+}
+
+// Delta-Download vorbereiten; false, wenn keiner angeboten wird oder die
+// laufende Firmware nicht die Basis ist
+static bool prepareDelta(FlashTarget &target)
+{
+    if (appState.updateDeltaPath.isEmpty() || appState.updateFirmwareSize == 0 ||
+        !parseSha256Hex(appState.updateDeltaBaseSha256.c_str(), target.baseSha)) {
         return false;
     }
 
-    int contentLength = http.getSize();
+    target.base = esp_ota_get_running_partition();
+    target.baseSize = appState.updateDeltaBaseSize;
 
-    // Ohne bekannte Laenge kein Update: Update.begin() braucht die Groesse, um
-    // die Zielpartition zu pruefen, und ohne sie faellt die
-    // Vollstaendigkeitskontrolle am Ende weg.
-    if (contentLength <= 0) {
-        appState.updateLastError = F("Backend liefert keine Dateigroesse");
-        debug(appState.updateLastError);
-        http.end();
-        appState.updateInProgress = false;
-        setStatusLED(0);
+    uint32_t start = millis();
+    bool matches = baseMatches(target.base, target.baseSize, target.baseSha);
+    progress.baseCheckMs = millis() - start;
+
+    if (!matches) {
+        LOG_I("Update: laufende Firmware ist nicht die Basis des Deltas — lade volles Image");
+        return false;
+    }
+    // Patch und volles Image teilen sich den Entpacker
+    if (!target.inflater.reserve()) {
+        LOG_W("Update: zu wenig Heap fuer das Delta — lade unkomprimiert");
         return false;
     }
+    return true;
+}
 
-    if ((size_t)contentLength < UPDATE_MIN_FIRMWARE_SIZE) {
-        appState.updateLastError = String(F("Datei zu klein (")) +
-                                   String(contentLength) + F(" Bytes)");
-        debug(appState.updateLastError);
-        http.end();
-        appState.updateInProgress = false;
-        setStatusLED(0);
+// Wartet nach einem Verbindungsabbruch, bis das WLAN wieder steht.
+// false, wenn die Versuche aufgebraucht sind oder das WLAN wegbleibt.
+static bool waitBeforeResume(size_t received, size_t fileSize, uint8_t maxResumes)
+{
+    if (progress.resumes >= maxResumes) {
+        appState.updateLastError = String(F("Unvollstaendig nach ")) + String(progress.resumes) +
+                                   F(" Fortsetzungen: ") + String(received) +
+                                   F(" von ") + String(fileSize) + F(" Bytes");
         return false;
     }
+    progress.resumes++;
+    progress.phase = UPDATE_PHASE_RESUMING;
+    LOG_W("Download unterbrochen bei %u von %u Bytes — Fortsetzung %u/%u", received, fileSize, progress.resumes,
+          maxResumes);
+    // Ein Grund vom letzten Versuch steht nur im Log, nicht als Fehler in der WebUI
+    if (appState.updateLastError.length() > 0) {
+        LOG_W("%s", appState.updateLastError);
+        appState.updateLastError.clear();
+    }
+
+    unsigned long waitStart = millis();
+    while (WiFi.status() != WL_CONNECTED) {
+        if (millis() - waitStart > UPDATE_RESUME_WIFI_WAIT) {
+            appState.updateLastError = F("WLAN kam waehrend des Downloads nicht zurueck");
+            return false;
+        }
+        delay(250);
+    }
+    // Mit jedem Versuch etwas laenger warten — ein wackliger Access Point
+    // braucht nach dem Reconnect oft noch einen Moment
+    delay(UPDATE_RESUME_DELAY * progress.resumes);
+    return true;
+}
+
+// Laedt url und flasht; bei false steht der Grund in updateLastError.
+//
+// Reisst die Verbindung ab, setzt der Download mit "Range: bytes=N-" an
+// derselben Stelle fort — Update bzw. der Entpacker behalten ihren Stand im
+// RAM, geschrieben wird lueckenlos weiter. If-Range mit dem ETag der ersten
+// Antwort stellt sicher, dass die Fortsetzung aus derselben Datei stammt;
+// hat sie sich geaendert, antwortet das Backend mit der ganzen Datei und es
+// geht von vorn los. Nach maxResumes Fortsetzungen wird aufgegeben.
+static bool downloadAndFlash(HTTPClient &http, WiFiClient &client, FlashTarget &target,
+                             const String &url, uint8_t maxResumes = UPDATE_RESUME_MAX)
+{
+    LOG_I("Firmware-Download: %s", url);
+
+    const char *headerKeys[] = {"ETag"};
+    String etag;
+    size_t fileSize = 0;        // Laenge der Datei laut erster Antwort
+    size_t imageSize = 0;       // Groesse in der Partition (bei gzip/Delta das fertige Image)
+    size_t received = 0;        // Davon bereits geschrieben
+    uint8_t buffer[1024];
+
+    for (;;) {
+        // Nach einem Abbruch: retrying; mit schon geschriebenen Bytes per Range
+        bool retrying = target.active;
+        bool resuming = retrying && received > 0;
+
+        // Eigener Client statt wifiClientHTTP: der Sentiment-Abruf in der loop()
+        // laeuft parallel weiter
+        if (!http.begin(client, url)) {
+            appState.updateLastError = F("Verbindung zum Backend fehlgeschlagen");
+            if (retrying && waitBeforeResume(received, fileSize, maxResumes)) {
+                continue;
+            }
+            target.abort();
+            return false;
+        }
+
+        http.setTimeout(UPDATE_DOWNLOAD_TIMEOUT);
+        http.collectHeaders(headerKeys, 1);
+        if (resuming) {
+            http.addHeader("Range", String(F("bytes=")) + String(received) + "-");
+            if (etag.length() > 0) {
+                http.addHeader("If-Range", etag);
+            }
+        }
+        int httpCode = http.GET();
+
+        if (retrying && httpCode < 0) {
+            // Verbindung kam nicht zustande — WLAN wackelt noch
+            http.end();
+            appState.updateLastError = String(F("Backend nicht erreichbar (")) + String(httpCode) + ")";
+            if (waitBeforeResume(received, fileSize, maxResumes)) {
+                continue;
+            }
+            target.abort();
+            return false;
+        }
+
+        if (resuming && httpCode == HTTP_CODE_PARTIAL_CONTENT) {
+            // Der Rest muss genau bis zum bekannten Dateiende reichen
+            int rest = http.getSize();
+            if (rest <= 0 || received + (size_t)rest != fileSize) {
+                appState.updateLastError = F("Fortsetzung passt nicht zur begonnenen Datei");
+                target.abort();
+                return false;
+            }
+            LOG_I("Download fortgesetzt ab Byte %u", received);
+        } else if (httpCode == HTTP_CODE_OK) {
+            if (retrying) {
+                // Backend ignoriert Range oder die Datei hat sich geaendert —
+                // das bisher Geschriebene ist wertlos
+                if (received > 0) {
+                    LOG_W("Backend liefert die ganze Datei — Download beginnt von vorn");
+                }
+                progress.retransmitted += received;
+                target.abort();
+                received = 0;
+            }
+
+            int contentLength = http.getSize();
+
+            // Ohne bekannte Laenge kein Update: Update.begin() braucht die Groesse, um
+            // die Zielpartition zu pruefen, und ohne sie faellt die
+            // Vollstaendigkeitskontrolle am Ende weg.
+            if (contentLength <= 0) {
+                appState.updateLastError = F("Backend liefert keine Dateigroesse");
+                return false;
+            }
+            fileSize = contentLength;
+            etag = http.header("ETag");
+
+            // Bei gzip und Delta zaehlt die Groesse des fertigen Images, die das
+            // Backend mitliefert — Update.begin() prueft sie gegen die Partition,
+            // end() gegen das tatsaechlich Geschriebene
+            imageSize = target.source == FLASH_RAW ? fileSize : appState.updateFirmwareSize;
+            if (imageSize < UPDATE_MIN_FIRMWARE_SIZE) {
+                appState.updateLastError = String(F("Datei zu klein (")) +
+                                           String(imageSize) + F(" Bytes)");
+                return false;
+            }
+
+            if (!target.begin(imageSize)) {
+                return false;
+            }
+            LOG_I("Schreibe %u Bytes in die OTA-Partition (%u Bytes Download)", imageSize, fileSize);
+        } else {
+            appState.updateLastError = String(F("Backend antwortete mit HTTP ")) + String(httpCode);
+            target.abort();
+            return false;
+        }
+
+        progress.total = fileSize;
+        progress.phase = UPDATE_PHASE_DOWNLOADING;
+
+        WiFiClient *stream = http.getStreamPtr();
+        unsigned long lastData = millis();
+
+        while (http.connected() && received < fileSize) {
+            size_t available = stream->available();
+
+            if (available == 0) {
+                // Stillstand erkennen: haengt die Verbindung, neu ansetzen statt
+                // ewig zu warten
+                if (millis() - lastData > UPDATE_RESUME_STALL) {
+                    break;
+                }
+                delay(10);
+                continue;
+            }
+
+            size_t toRead = available > sizeof(buffer) ? sizeof(buffer) : available;
+            size_t read = stream->readBytes(buffer, toRead);
+            if (read == 0) {
+                continue;
+            }
+            // Mehr als angekuendigt waere ein Fehler des Backends
+            if (read > fileSize - received) {
+                read = fileSize - received;
+            }
+            lastData = millis();
+
+            if (!target.write(buffer, read)) {
+                return false;
+            }
+
+            received += read;
+            progress.written = received;
+            progress.lastDataMs = lastData;
+            throttle(read);
+        }
 
-    // Update.begin() prueft selbst, ob die Datei in die freie OTA-Partition passt
-    if (!Update.begin(contentLength)) {
-        appState.updateLastError = String(F("Update.begin fehlgeschlagen: ")) +
-                                   String(Update.errorString());
-        debug(appState.updateLastError);
         http.end();
-        appState.updateInProgress = false;
-        setStatusLED(0);
+        if (received == fileSize) {
+            break;
+        }
+
+        // Abgebrochene Verbindung: Update.end() wuerde eine halbe Firmware als
+        // gueltig durchwinken, das Geraet startet neu und kommt nicht wieder.
+        // Also an derselben Stelle weitermachen — oder aufgeben.
+        if (!waitBeforeResume(received, fileSize, maxResumes)) {
+            target.abort();
+            return false;
+        }
+    }
+
+    progress.phase = UPDATE_PHASE_FINISHING;
+
+    return target.end(imageSize);
+}
+
+// Laedt das UI-Archiv der neuen Version und entpackt es neben die aktive UI,
+// ohne umzuschalten. Kein Fortsetzen per Range wie bei der Firmware: das
+// Archiv ist klein, und ein Abbruch hier kostet nur einen neuen Versuch —
+// geflasht ist noch nichts.
+static bool stageUi(HTTPClient &http, WiFiClient &client)
+{
+    String url = updateApiBase() + appState.updateUiPath.c_str();
+    LOG_I("UI-Download: %s", url);
+    progress.phase = UPDATE_PHASE_STAGING_UI;
+
+    if (!http.begin(client, url)) {
+        appState.updateLastError = F("Verbindung zum Backend fehlgeschlagen");
+        return false;
+    }
+    http.setTimeout(UPDATE_DOWNLOAD_TIMEOUT);
+    int httpCode = http.GET();
+    if (httpCode != HTTP_CODE_OK) {
+        appState.updateLastError = String(F("UI-Archiv: Backend antwortete mit HTTP ")) + String(httpCode);
         return false;
     }
+    int contentLength = http.getSize();
+    progress.uiTotal = contentLength > 0 ? contentLength : 0;
 
-    debug(String(F("Schreibe ")) + String(contentLength) + F(" Bytes in die OTA-Partition"));
+    // Der Installer ist zu gross fuer den Task-Stack
+    std::unique_ptr<UiInstaller> installer(new (std::nothrow) UiInstaller());
+    if (!installer || !installer->begin(appState.updateVersion.c_str(), progress.uiTotal)) {
+        appState.updateLastError = String(F("UI-Archiv: ")) +
+                                   (installer ? installer->error() : "zu wenig Speicher");
+        return false;
+    }
 
     WiFiClient *stream = http.getStreamPtr();
     uint8_t buffer[1024];
-    size_t written = 0;
-    bool magicChecked = false;
     unsigned long lastData = millis();
-
-    while (http.connected() && written < (size_t)contentLength) {
+    while (http.connected() && (progress.uiTotal == 0 || progress.uiWritten < progress.uiTotal)) {
         size_t available = stream->available();
-
         if (available == 0) {
-            // Stillstand erkennen: haengt die Verbindung, nicht ewig warten
-            if (millis() - lastData > UPDATE_DOWNLOAD_TIMEOUT) {
-                appState.updateLastError = F("Download abgebrochen (Zeitueberschreitung)");
-                debug(appState.updateLastError);
-                Update.abort();
-                http.end();
-                appState.updateInProgress = false;
-                setStatusLED(0);
-                return false;
+            if (millis() - lastData > UPDATE_RESUME_STALL) {
+                break;
             }
-            watchdog.feed();
             delay(10);
             continue;
         }
-
-        size_t toRead = available > sizeof(buffer) ? sizeof(buffer) : available;
-        size_t read = stream->readBytes(buffer, toRead);
+        size_t read = stream->readBytes(buffer, available > sizeof(buffer) ? sizeof(buffer) : available);
         if (read == 0) {
             continue;
         }
         lastData = millis();
+        if (!installer->write(buffer, read)) {
+            appState.updateLastError = String(F("UI-Archiv: ")) + installer->error();
+            return false;
+        }
+        progress.uiWritten += read;
+        throttle(read);
+    }
+    http.end();
 
-        // Dieselbe Bricking-Vorsorge wie beim Upload ueber die WebUI: eine
-        // ESP32-Firmware beginnt mit 0xE9. Was damit nicht anfaengt, wird nicht
-        // geflasht — egal was das Backend behauptet.
-        if (!magicChecked) {
-            magicChecked = true;
-            if (buffer[0] != 0xE9) {
-                appState.updateLastError = F("Datei ist keine ESP32-Firmware (Magic-Byte fehlt)");
-                debug(appState.updateLastError);
-                Update.abort();
-                http.end();
-                appState.updateInProgress = false;
-                setStatusLED(0);
-                return false;
+    // end() prueft, ob das Archiv vollstaendig ist
+    if (!installer->end(true)) {
+        appState.updateLastError = String(F("UI-Archiv: ")) + installer->error();
+        return false;
+    }
+    progress.uiFilesSkipped = installer->filesSkipped();
+    LOG_I("UI %s bereitgestellt: %u Dateien geschrieben, %u unveraendert in %lu ms", uiPendingVersion(),
+          installer->files(), installer->filesSkipped(), (unsigned long)installer->elapsedMs());
+    return true;
+}
+
+// Liegt die freigegebene Firmware schon vollstaendig in der freien Partition?
+// Geprueft wird der Inhalt selbst: seit dem Vorab-Laden kann die Partition
+// ueberschrieben worden sein (Upload ueber /update), und nach einem Neustart
+// weiss nur noch der Flash, was vorab geladen wurde.
+static bool prefetchedImageReady()
+{
+    uint8_t expected[32];
+    if (!parseSha256Hex(appState.updateFirmwareSha256.c_str(), expected)) {
+        return false;
+    }
+    uint32_t start = millis();
+    bool ready = baseMatches(esp_ota_get_next_update_partition(nullptr),
+                             appState.updateFirmwareSize, expected);
+    if (ready) {
+        LOG_I("Update: %s liegt vorab geladen bereit (geprueft in %lu ms)", appState.updateVersion,
+              (unsigned long)(millis() - start));
+    }
+    return ready;
+}
+
+// Vorab geladenes Image zur Boot-Partition machen — esp_ota_set_boot_partition()
+// prueft das Image dabei noch einmal vollstaendig
+static bool switchToPrefetched()
+{
+    progress.phase = UPDATE_PHASE_FINISHING;
+    esp_err_t err = esp_ota_set_boot_partition(esp_ota_get_next_update_partition(nullptr));
+    if (err != ESP_OK) {
+        LOG_E("Update: vorab geladenes Image abgelehnt (%s) — lade neu", esp_err_to_name(err));
+        return false;
+    }
+    progress.fromPrefetch = true;
+    progress.flashed = appState.updateFirmwareSize;
+    return true;
+}
+
+// Ein gescheiterter Weg (Delta, Geraet im LAN) ist noch kein Fehlschlag:
+// der Grund landet im Log, der naechste Weg beginnt bei null
+static void resetAttempt()
+{
+    appState.updateLastError.clear();
+    progress.written = 0;
+    progress.total = 0;
+    progress.resumes = 0;
+    progress.phase = UPDATE_PHASE_CONNECTING;
+}
+
+// Antworten auf die mDNS-Abfrage nach UPDATE_PEER_SERVICE — ob Version und
+// Adresse passen, entscheidet planUpdateSources()
+static uint8_t findPeers(UpdatePeer *peers, uint8_t max)
+{
+    int found = MDNS.queryService(UPDATE_PEER_SERVICE, "tcp");
+    uint8_t count = 0;
+    for (int i = 0; i < found && count < max; i++) {
+        UpdatePeer &peer = peers[count++];
+        peer.ip = (uint32_t)MDNS.IP(i);
+        peer.port = MDNS.port(i);
+        strlcpy(peer.fw, MDNS.txt(i, "fw").c_str(), sizeof(peer.fw));
+        strlcpy(peer.pre, MDNS.txt(i, "pre").c_str(), sizeof(peer.pre));
+    }
+    return count;
+}
+
+struct InstallAttempt {
+    HTTPClient &http;
+    WiFiClient &client;
+    FlashTarget &target;
+    const UpdatePeer *peers;
+};
+
+// Das volle Image von einem Moodlight im LAN, das die freigegebene Version
+// laufen hat oder vorab geladen hat. Gefragt wird nach SHA-256 und Groesse
+// vom Backend; FlashTarget prueft das Ergebnis wie bei jedem Download.
+// Ungedrosselt, auch beim Vorab-Laden: die Drossel schont die Leitung nach
+// draussen, und der liefernde Webserver steht, solange er sendet.
+static UpdateAttempt flashFromPeer(InstallAttempt &run, const UpdatePeer &peer)
+{
+    IPAddress ip(peer.ip);
+    String url = String(F("http://")) + ip.toString() + ":" + String(peer.port) +
+                 F("/api/update/peer-image?sha=") + appState.updateFirmwareSha256.c_str() +
+                 F("&size=") + String(appState.updateFirmwareSize);
+    run.target.source = FLASH_RAW;
+    progress.peerIp = peer.ip;
+
+    bool throttled = throttleActive;
+    throttleActive = false;
+    bool ok = downloadAndFlash(run.http, run.client, run.target, url, UPDATE_PEER_RESUME_MAX);
+    run.http.end();
+    throttleActive = throttled && !installRequested;
+    if (throttleActive) {
+        // Was aus dem LAN kam, geht nicht aufs Konto der Drossel
+        throttleStartMs = millis();
+        throttleBytes = 0;
+    }
+    if (ok) {
+        return UPDATE_ATTEMPT_OK;
+    }
+
+    LOG_W("Update von %s gescheitert (%s) — versuche den naechsten Weg", ip.toString(), appState.updateLastError);
+    progress.retransmitted += progress.written;
+    progress.peerIp = 0;
+    progress.peerFallback = true;
+    resetAttempt();
+    return UPDATE_ATTEMPT_FAILED;
+}
+
+// Ein Versuch aus dem Plan von planUpdateSources()
+static UpdateAttempt attemptSource(const UpdateSource &source, void *ctx)
+{
+    InstallAttempt &run = *static_cast<InstallAttempt *>(ctx);
+    FlashTarget &target = run.target;
+
+    switch (source.kind) {
+        case UPDATE_SOURCE_PEER:
+            return flashFromPeer(run, run.peers[source.peer]);
+
+        case UPDATE_SOURCE_DELTA: {
+            // Scheitert der Patch, egal warum, bleibt die laufende Partition
+            // unberuehrt und es geht mit dem vollen Image weiter
+            if (!prepareDelta(target)) {
+                return UPDATE_ATTEMPT_SKIPPED;
             }
+            target.source = FLASH_DELTA;
+            progress.delta = true;
+            bool ok = downloadAndFlash(run.http, run.client, target,
+                                       updateApiBase() + appState.updateDeltaPath.c_str());
+            run.http.end();
+            if (ok) {
+                return UPDATE_ATTEMPT_OK;
+            }
+            LOG_W("Delta-Update gescheitert (%s) — lade volles Image", appState.updateLastError);
+            progress.delta = false;
+            progress.deltaFallback = true;
+            progress.deltaDiscarded = progress.written;
+            resetAttempt();
+            return UPDATE_ATTEMPT_FAILED;
         }
 
-        if (Update.write(buffer, read) != read) {
-            appState.updateLastError = String(F("Schreibfehler: ")) +
-                                       String(Update.errorString());
-            debug(appState.updateLastError);
-            Update.abort();
-            http.end();
-            appState.updateInProgress = false;
-            setStatusLED(0);
-            return false;
-        }
+        case UPDATE_SOURCE_GZIP:
+            // Entpacken braucht ~43 KB Heap am Stueck — fehlt der, wird das
+            // rohe Binary geladen
+            if (!target.inflater.reserve()) {
+                LOG_W("Update: zu wenig Heap zum Entpacken — lade unkomprimiert");
+                return UPDATE_ATTEMPT_SKIPPED;
+            }
+            target.source = FLASH_GZIP;
+            progress.compressed = true;
+            return downloadAndFlash(run.http, run.client, target,
+                                    updateApiBase() + appState.updateFirmwareGzPath.c_str())
+                       ? UPDATE_ATTEMPT_OK
+                       : UPDATE_ATTEMPT_FAILED;
 
-        written += read;
-        watchdog.feed();  // Der Download dauert; WDT bei jedem Block fuettern
+        case UPDATE_SOURCE_RAW:
+            target.source = FLASH_RAW;
+            progress.compressed = false;
+            return downloadAndFlash(run.http, run.client, target,
+                                    updateApiBase() + appState.updateFirmwarePath.c_str())
+                       ? UPDATE_ATTEMPT_OK
+                       : UPDATE_ATTEMPT_FAILED;
     }
+    return UPDATE_ATTEMPT_SKIPPED;
+}
 
-    http.end();
+void updatePeerAdvertise()
+{
+    MDNS.addServiceTxt(UPDATE_PEER_SERVICE, "tcp", "fw", MOODLIGHT_VERSION);
+    if (prefetch.state == PREFETCH_READY) {
+        MDNS.addServiceTxt(UPDATE_PEER_SERVICE, "tcp", "pre", prefetch.version.c_str());
+    }
+}
 
-    // Abgebrochene Verbindung erkennen: Update.end() wuerde eine halbe Firmware
-    // sonst als gueltig durchwinken, das Geraet startet neu und kommt nicht wieder.
-    if (written != (size_t)contentLength) {
-        appState.updateLastError = String(F("Unvollstaendig: ")) + String(written) +
-                                   F(" von ") + String(contentLength) + F(" Bytes");
-        debug(appState.updateLastError);
-        Update.abort();
-        appState.updateInProgress = false;
-        setStatusLED(0);
-        return false;
+// Laenge des App-Images in part laut seinen Segment-Koepfen — liest nur die
+// Koepfe, hasht nichts. 0, wenn dort kein Image steht.
+static size_t partitionImageSize(const esp_partition_t *part)
+{
+    if (!part) {
+        return 0;
     }
+    esp_partition_pos_t pos = {part->address, part->size};
+    esp_image_metadata_t meta;
+    return esp_image_get_metadata(&pos, &meta) == ESP_OK ? meta.image_len : 0;
+}
 
-    if (!Update.end(true)) {
-        appState.updateLastError = String(F("Abschluss fehlgeschlagen: ")) +
-                                   String(Update.errorString());
-        debug(appState.updateLastError);
-        appState.updateInProgress = false;
-        setStatusLED(0);
+const esp_partition_t *updatePeerImage(const char *sha, size_t size)
+{
+    uint8_t expected[32];
+    if (!parseSha256Hex(sha, expected) || size < UPDATE_MIN_FIRMWARE_SIZE) {
+        return nullptr;
+    }
+    // Meist laeuft beim Anbieter schon die gesuchte Version
+    const esp_partition_t *candidates[] = {esp_ota_get_running_partition(),
+                                           esp_ota_get_next_update_partition(nullptr)};
+    for (const esp_partition_t *part : candidates) {
+        // Falsche Laenge gar nicht erst hashen: partitionHashes merkt sich eine
+        // Groesse je Partition, jede solche Anfrage verdraengte sonst den
+        // gueltigen Eintrag und kostete einen vollen Durchgang durch den Flash
+        if (size != partitionImageSize(part)) {
+            continue;
+        }
+        if (baseMatches(part, size, expected)) {
+            return part;
+        }
+    }
+    return nullptr;
+}
+
+// prefetchOnly: Image schreiben, aber die laufende Firmware bleibt Boot-Partition
+static bool runInstall(HTTPClient &http, WiFiClient &client, bool prefetchOnly)
+{
+    FlashTarget target;
+    target.activate = !prefetchOnly;
+
+    // checkForUpdate() laesst nur Antworten mit gueltiger Pruefsumme durch
+    if (!parseSha256Hex(appState.updateFirmwareSha256.c_str(), target.expectedSha)) {
+        appState.updateLastError = F("Keine gueltige SHA-256 vom Backend");
         return false;
     }
 
-    if (!Update.isFinished()) {
-        appState.updateLastError = F("Update wurde nicht abgeschlossen");
-        debug(appState.updateLastError);
-        appState.updateInProgress = false;
-        setStatusLED(0);
+    // Die UI kommt zuerst, wird aber nur bereitgestellt: scheitert sie, ist
+    // noch nichts geflasht und beide Teile bleiben auf dem alten Stand.
+    // Vorab geladen liegt sie schon bereit.
+    if (!prefetchOnly) {
+        updateTxnBegin(appState.updateVersion.c_str());
+    }
+    if (!appState.updateUiPath.isEmpty() && uiPendingVersion() != appState.updateVersion.c_str()) {
+        bool staged = stageUi(http, client);
+        http.end();
+        if (!staged) {
+            return false;
+        }
+        progress.phase = UPDATE_PHASE_CONNECTING;
+    }
+
+    // Nur wenn vorab geladen worden sein kann — sonst kostet das Hashen der
+    // Partition bloss Zeit
+    if ((appState.updatePrefetchEnabled || prefetch.state == PREFETCH_READY) && prefetchedImageReady()) {
+        if (prefetchOnly) {
+            return true;
+        }
+        if (switchToPrefetched()) {
+            updateTxnFlashed();
+            return true;
+        }
+    }
+
+    // Ein Moodlight im LAN, das die Version schon hat, entlastet Backend und
+    // Internetleitung; danach der Patch gegen die laufende Firmware — meist
+    // nur ein Bruchteil der .bin.gz —, dann die .bin.gz (gut ein Drittel
+    // weniger Bytes ueber die Luft) und zuletzt das rohe Binary.
+    UpdatePeer peers[UPDATE_PEER_SCAN_MAX];
+    uint8_t peerCount = appState.updateFirmwareSize > 0 ? findPeers(peers, UPDATE_PEER_SCAN_MAX) : 0;
+
+    UpdateOffer offer;
+    offer.version = appState.updateVersion.c_str();
+    offer.firmwareSize = appState.updateFirmwareSize;
+    offer.selfIp = (uint32_t)WiFi.localIP();
+    offer.delta = !appState.updateDeltaPath.isEmpty();
+    offer.gzip = !appState.updateFirmwareGzPath.isEmpty();
+
+    UpdateSource plan[UPDATE_SOURCES_MAX];
+    uint8_t planCount = planUpdateSources(offer, peers, peerCount, plan, UPDATE_SOURCES_MAX);
+    InstallAttempt run = {http, client, target, peers};
+    bool ok = runUpdateSources(plan, planCount, attemptSource, &run) >= 0;
+    if (!ok) {
         return false;
     }
+    if (prefetchOnly) {
+        // otadata unberuehrt — umgeschaltet wird erst auf Klick (switchToPrefetched)
+        return true;
+    }
+    updateTxnFlashed();
 
     // Version festhalten, damit /api/firmware-version nach dem Neustart stimmt —
     // dieselbe Datei nutzt der Upload-Weg ueber die WebUI.
     File versionFile = LittleFS.open("/firmware-version.txt", "w");
     if (versionFile) {
-        versionFile.print(appState.updateVersion);
+        versionFile.print(appState.updateVersion.c_str());
         versionFile.close();
     }
+    return true;
+}
+
+// Ergebnis der Installation melden und den Neustart planen
+static void finishInstall(bool ok)
+{
+    if (ok && progress.fromPrefetch) {
+        LOG_I("Update auf %s aus der vorab geladenen Partition in %lu s — Neustart", appState.updateVersion,
+              (unsigned long)((millis() - progress.startedMs) / 1000));
+    } else if (ok) {
+        LOG_I("Update auf %s geschrieben: %u KB uebertragen%s%s%s", appState.updateVersion, progress.written / 1024,
+              progress.peerIp != 0 ? " von " : "",
+              progress.peerIp != 0 ? IPAddress(progress.peerIp).toString() : String(),
+              progress.delta ? " als Delta" : "");
+        LOG_I("  %u KB geflasht in %u s (%u KB/s, %ux fortgesetzt, %u KB doppelt, SHA-256 %u ms) — Neustart",
+              progress.flashed / 1024, (progress.lastDataMs - progress.startedMs) / 1000,
+              updateBytesPerSecond() / 1024, progress.resumes,
+              (progress.retransmitted + progress.deltaDiscarded) / 1024, progress.hashUs / 1000);
+    }
 
-    debug(String(F("Update auf ")) + appState.updateVersion +
-          F(" geschrieben — Neustart"));
+    if (ok) {
+        appState.updateAvailable = false;
+        progress.phase = UPDATE_PHASE_DONE;
+
+        // Neustart der loop() ueberlassen: so holt sich die WebUI den
+        // Abschluss noch ab, bevor das Geraet weg ist.
+        appState.rebootNeeded = true;
+        appState.rebootTime = millis() + 1500;
+    } else {
+        LOG_E("%s", appState.updateLastError);
+        updateTxnAbort();
+        progress.phase = UPDATE_PHASE_FAILED;
+        setStatusLED(0);
+    }
 
-    appState.updateAvailable = false;
     appState.updateInProgress = false;
+}
+
+static void updateTask(void *)
+{
+    HTTPClient http;
+    http.setReuse(false);
+    http.setUserAgent("MoodlightClient/1.0");
+    WiFiClient client;
+
+    bool ok = runInstall(http, client, false);
+    http.end();
+
+    finishInstall(ok);
+    vTaskDelete(NULL);
+}
+
+static void prefetchTask(void *)
+{
+    HTTPClient http;
+    http.setReuse(false);
+    http.setUserAgent("MoodlightClient/1.0");
+    WiFiClient client;
+
+    bool ok = runInstall(http, client, true);
+    http.end();
+    throttleActive = false;
+
+    prefetch.bytes = progress.written + progress.uiWritten + progress.retransmitted + progress.deltaDiscarded;
+    prefetch.durationMs = millis() - progress.startedMs;
+    prefetch.finishedMs = millis();
+    if (ok) {
+        prefetch.state = PREFETCH_READY;
+        updatePeerAdvertise();
+        LOG_I("Update %s vorab geladen: %u KB in %u s%s", prefetch.version, prefetch.bytes / 1024,
+              prefetch.durationMs / 1000, progress.uiTotal > 0 ? ", UI bereitgestellt" : "");
+    } else {
+        prefetch.state = PREFETCH_FAILED;
+        prefetch.lastError = appState.updateLastError;
+        LOG_E("Vorab-Laden gescheitert: %s", appState.updateLastError);
+    }
+
+    portENTER_CRITICAL(&handoffMux);
+    bool install = installRequested;
+    installRequested = false;
+    handoffOpen = false;
+    portEXIT_CRITICAL(&handoffMux);
+
+    if (install) {
+        // Waehrenddessen auf "Installieren" geklickt: jetzt nur noch umschalten
+        if (ok) {
+            progress.phase = UPDATE_PHASE_FINISHING;
+            ok = runInstall(http, client, false);
+            http.end();
+        }
+        finishInstall(ok);
+    } else {
+        // Der Fehler gehoert zum Vorab-Laden, nicht zu einer Installation
+        appState.updateLastError.clear();
+        progress.phase = UPDATE_PHASE_IDLE;
+        appState.updateInProgress = false;
+    }
+    vTaskDelete(NULL);
+}
+
+bool startUpdateInstall()
+{
+    if (appState.updateInProgress) {
+        // Laeuft gerade das Vorab-Laden: ohne Drossel fertig laden, dann umschalten
+        portENTER_CRITICAL(&handoffMux);
+        bool handedOver = handoffOpen && !installRequested;
+        if (handedOver) {
+            installRequested = true;
+        }
+        portEXIT_CRITICAL(&handoffMux);
+        if (handedOver) {
+            throttleActive = false;
+            progress.prefetch = false;
+            setStatusLED(3);
+            LOG_I("Installation angefordert — Vorab-Laden laeuft ungedrosselt zu Ende");
+            return true;
+        }
+        appState.updateLastError = F("Es laeuft bereits ein Update");
+        return false;
+    }
+
+    if (!appState.updateAvailable || appState.updateFirmwarePath.length() == 0) {
+        appState.updateLastError = F("Kein Update vorgemerkt");
+        return false;
+    }
+
+    if (WiFi.status() != WL_CONNECTED) {
+        appState.updateLastError = F("Keine WLAN-Verbindung");
+        return false;
+    }
+
+    // Ohne ausreichend Heap gar nicht erst anfangen: mitten im Flash-Vorgang
+    // auszugehen ist der schlimmste Zeitpunkt.
+    uint32_t freeHeap = ESP.getFreeHeap();
+    if (freeHeap < UPDATE_MIN_FREE_HEAP) {
+        appState.updateLastError = String(F("Zu wenig freier Speicher (")) +
+                                   String(freeHeap) + F(" Bytes)");
+        LOG_E("%s", appState.updateLastError);
+        return false;
+    }
 
-    // Neustart der loop() ueberlassen: so geht die HTTP-Antwort an die WebUI
-    // noch raus, bevor das Geraet weg ist.
-    appState.rebootNeeded = true;
-    appState.rebootTime = millis() + 1500;
+    appState.updateInProgress = true;
+    appState.updateLastError = "";
+    progress = UpdateProgress();
+    progress.phase = UPDATE_PHASE_CONNECTING;
+    progress.startedMs = progress.lastDataMs = millis();
+    setStatusLED(3);  // Update-Modus
 
+    if (xTaskCreate(updateTask, "otaUpdate", UPDATE_TASK_STACK, NULL, 1, NULL) != pdPASS) {
+        appState.updateLastError = F("Update-Task konnte nicht gestartet werden");
+        LOG_E("%s", appState.updateLastError);
+        progress.phase = UPDATE_PHASE_FAILED;
+        appState.updateInProgress = false;
+        setStatusLED(0);
+        return false;
+    }
     return true;
 }
+
+static bool inPrefetchHours()
+{
+    if (!appState.timeInitialized) {
+        return false;
+    }
+    time_t now;
+    time(&now);
+    struct tm timeinfo;
+    localtime_r(&now, &timeinfo);
+    return timeinfo.tm_hour >= UPDATE_PREFETCH_HOUR_START && timeinfo.tm_hour < UPDATE_PREFETCH_HOUR_END;
+}
+
+void handleUpdatePrefetch()
+{
+    if (appState.updateInProgress) {
+        return;
+    }
+    if (!appState.updatePrefetchEnabled || !appState.updateAvailable) {
+        if (prefetch.state != PREFETCH_READY || !appState.updateAvailable) {
+            prefetch.state = PREFETCH_IDLE;
+        }
+        return;
+    }
+
+    bool sameVersion = prefetch.version == appState.updateVersion;
+    if (sameVersion && prefetch.state == PREFETCH_READY) {
+        return;
+    }
+    if (sameVersion && prefetch.state == PREFETCH_FAILED &&
+        millis() - prefetch.finishedMs < UPDATE_PREFETCH_RETRY) {
+        return;
+    }
+
+    prefetch.state = PREFETCH_WAITING;
+    prefetch.version = appState.updateVersion;
+    if (!inPrefetchHours()) {
+        return;
+    }
+    // Die freie Partition ist der Rueckweg einer Firmware, die noch geprueft
+    // wird — und eine offene Transaktion hat ihre UI schon bereitgestellt
+    UpdateTxnState txn = updateTxnReport().state;
+    if (txn == TXN_VERIFYING || updateTxnOpen()) {
+        return;
+    }
+    if (ESP.getFreeHeap() < UPDATE_MIN_FREE_HEAP) {
+        return;
+    }
+
+    appState.updateInProgress = true;
+    appState.updateLastError.clear();
+    progress = UpdateProgress();
+    progress.prefetch = true;
+    progress.phase = UPDATE_PHASE_CONNECTING;
+    progress.startedMs = progress.lastDataMs = millis();
+    prefetch.state = PREFETCH_RUNNING;
+    prefetch.lastError.clear();
+    installRequested = false;
+    handoffOpen = true;
+    throttleStartMs = millis();
+    throttleBytes = 0;
+    throttleActive = true;
+
+    LOG_I("Lade Update %s vorab (max. %u KB/s)", prefetch.version, appState.updatePrefetchRate);
+    if (xTaskCreate(prefetchTask, "otaPrefetch", UPDATE_TASK_STACK, NULL, 1, NULL) != pdPASS) {
+        LOG_E("Vorab-Laden: Task konnte nicht gestartet werden");
+        throttleActive = false;
+        handoffOpen = false;
+        progress.phase = UPDATE_PHASE_IDLE;
+        prefetch.state = PREFETCH_FAILED;
+        prefetch.finishedMs = millis();
+        appState.updateInProgress = false;
+    }
+}
@@ -7,11 +7,23 @@
 // Installiert wird ausschliesslich auf Anforderung aus der WebUI. Ein Update,
 // das sich von selbst einspielt, koennte das Licht mitten am Abend neu starten
 // und im Fehlerfall ein Geraet zuruecklassen, an das niemand mehr herankommt.
+//
+// Auf Wunsch laedt das Geraet eine freigegebene Version nachts gedrosselt
+// vorab. Das ist keine Installation: gebootet wird weiter die laufende
+// Firmware, bis jemand auf "Installieren" klickt.
+//
+// Moodlights im selben LAN helfen sich gegenseitig: wer die freigegebene
+// Firmware schon hat (laufend oder vorab geladen), bietet sie per mDNS an und
+// liefert sie unter /api/update/peer-image aus. Die Installation fragt zuerst
+// dort und erst dann das Backend. Geprueft wird wie immer gegen die SHA-256
+// vom Backend — ein Geraet im LAN kann nichts unterschieben.
 
 #ifndef UPDATE_CHECKER_H
 #define UPDATE_CHECKER_H
 
 #include <Arduino.h>
+#include "esp_partition.h"
+#include "fixed_string.h"
 
 // Fragt das Backend nach einer neueren Version.
 // Ergebnis landet in appState.updateAvailable / updateVersion / updateReleaseUrl.
@@ -21,9 +33,94 @@ bool checkForUpdate();
 // Ruft checkForUpdate() im Stundentakt auf. Gehoert in die loop().
 void handleUpdateCheck();
 
-// Laedt die bereitstehende Firmware und flasht sie. Bei Erfolg startet das
-// Geraet neu und kehrt nie zurueck. Bei Misserfolg bleibt die laufende
-// Firmware unangetastet und updateLastError beschreibt den Grund.
-bool downloadAndInstallUpdate();
+// Startet Download und Flash der bereitstehenden Firmware in einem eigenen
+// Task und kehrt sofort zurueck. false, wenn nicht gestartet werden konnte
+// (Grund in updateLastError). Bei Erfolg plant der Task den Neustart; bei
+// Misserfolg bleibt die laufende Firmware unangetastet.
+//
+// Bietet das Backend die passende UI an, wird sie vorher geladen und nur
+// bereitgestellt — aktiv wird sie erst mit der bestaetigten Firmware
+// (update_txn.h).
+bool startUpdateInstall();
+
+// Laedt eine freigegebene Firmware (samt UI) nachts gedrosselt in die freie
+// OTA-Partition, ohne sie zu aktivieren — nur mit updatePrefetchEnabled.
+// startUpdateInstall() schaltet danach nur noch die Boot-Partition um und
+// startet neu. Gehoert in die loop().
+void handleUpdatePrefetch();
+
+// TXT-Eintraege des mDNS-Dienstes UPDATE_PEER_SERVICE setzen: "fw" = laufende
+// Version, "pre" = vorab geladene. Nach MDNS.addService() aufrufen.
+void updatePeerAdvertise();
+
+// Partition, deren Image genau size Bytes lang ist und den SHA-256 sha (Hex)
+// hat — die laufende oder die freie. nullptr, wenn keine passt. Die Laenge
+// kommt aus den Segment-Koepfen; gehasht wird nur bei passender Laenge und je
+// Partition nur einmal, danach ist die Antwort ein Vergleich im RAM.
+const esp_partition_t *updatePeerImage(const char *sha, size_t size);
+
+// Die freie OTA-Partition wird gleich beschrieben: ihre gemerkte Pruefsumme
+// verwerfen. Ruft FlashTarget selbst auf, der Upload ueber /update von Hand.
+void updatePartitionWritten();
+
+enum UpdatePhase : uint8_t {
+    UPDATE_PHASE_IDLE,
+    UPDATE_PHASE_CONNECTING,
+    UPDATE_PHASE_STAGING_UI,    // Passende UI wird geladen und bereitgestellt
+    UPDATE_PHASE_DOWNLOADING,
+    UPDATE_PHASE_RESUMING,      // Verbindung abgerissen, wartet auf Fortsetzung
+    UPDATE_PHASE_FINISHING,
+    UPDATE_PHASE_DONE,          // Geschrieben, Neustart steht an
+    UPDATE_PHASE_FAILED,
+};
+
+// Fortschritt der laufenden bzw. letzten Installation. Schreibt nur der
+// Update-Task; die Felder sind einzeln lesbar (32 Bit).
+struct UpdateProgress {
+    UpdatePhase phase = UPDATE_PHASE_IDLE;
+    uint32_t written = 0;           // Empfangene Bytes
+    uint32_t total = 0;             // Content-Length, 0 solange unbekannt
+    uint32_t flashed = 0;           // In die Partition geschriebene Bytes
+    bool compressed = false;        // .bin.gz, wird beim Flashen entpackt
+    uint8_t resumes = 0;            // Per Range fortgesetzte Verbindungen
+    uint32_t retransmitted = 0;     // Doppelt geladene Bytes (Neustart von vorn)
+    uint32_t hashUs = 0;            // Zeit in SHA-256 ueber alle Bloecke
+    bool delta = false;             // Patch gegen die laufende Firmware
+    bool deltaFallback = false;     // Patch gescheitert, volles Image geladen
+    uint32_t deltaDiscarded = 0;    // Bytes des gescheiterten Patches
+    uint32_t baseCheckMs = 0;       // Laufende Partition gegen die Patch-Basis hashen
+    bool prefetch = false;          // Gedrosseltes Vorab-Laden, keine Installation
+    bool fromPrefetch = false;      // Installiert aus der vorab geladenen Partition
+    uint32_t peerIp = 0;            // Laedt von diesem Moodlight im LAN, 0 = vom Backend
+    bool peerFallback = false;      // Kein Geraet im LAN lieferte — Backend
+    uint32_t uiWritten = 0;         // Empfangene Bytes des UI-Archivs
+    uint32_t uiTotal = 0;           // Dessen Content-Length
+    uint16_t uiFilesSkipped = 0;    // Unveraenderte UI-Dateien, nicht geschrieben
+    uint32_t startedMs = 0;
+    uint32_t lastDataMs = 0;        // Letzter empfangener Block
+};
+
+enum PrefetchState : uint8_t {
+    PREFETCH_IDLE,          // Nichts zu laden (oder abgeschaltet)
+    PREFETCH_WAITING,       // Update bereit, wartet auf die Nachtstunden
+    PREFETCH_RUNNING,
+    PREFETCH_READY,         // Image liegt geprueft in der freien Partition
+    PREFETCH_FAILED,        // Naechster Versuch nach UPDATE_PREFETCH_RETRY
+};
+
+struct PrefetchStatus {
+    PrefetchState state = PREFETCH_IDLE;
+    FixedString<16> version;        // Vorab geladene bzw. ladende Version
+    FixedString<96> lastError;
+    uint32_t bytes = 0;             // Uebertragen (Firmware + UI)
+    uint32_t durationMs = 0;
+    uint32_t finishedMs = 0;        // millis() des letzten Versuchs
+};
+
+const UpdateProgress &updateProgress();
+const PrefetchStatus &updatePrefetchStatus();
+const char *prefetchStateName(PrefetchState state);
+const char *updatePhaseName(UpdatePhase phase);
+uint32_t updateBytesPerSecond();
 
 #endif // UPDATE_CHECKER_H
@@ -0,0 +1,53 @@
+// update_source.cpp — Reihenfolge der Update-Quellen, siehe update_source.h
+
+#include <string.h>
+
+#include "update_source.h"
+
+static bool peerHasVersion(const UpdatePeer &peer, const char *version)
+{
+    return strcmp(peer.fw, version) == 0 || strcmp(peer.pre, version) == 0;
+}
+
+uint8_t planUpdateSources(const UpdateOffer &offer, const UpdatePeer *peers, uint8_t peerCount,
+                          UpdateSource *plan, uint8_t max)
+{
+    uint8_t count = 0;
+
+    // peer-image prueft gegen SHA und Groesse — ohne Groesse keine Anfrage
+    if (offer.firmwareSize > 0) {
+        uint8_t tries = 0;
+        for (uint8_t i = 0; i < peerCount && tries < UPDATE_PEER_MAX_TRIES && count < max; i++) {
+            if (peers[i].ip == offer.selfIp || !peerHasVersion(peers[i], offer.version)) {
+                continue;
+            }
+            plan[count++] = {UPDATE_SOURCE_PEER, i};
+            tries++;
+        }
+    }
+    if (offer.delta && offer.firmwareSize > 0 && count < max) {
+        plan[count++] = {UPDATE_SOURCE_DELTA, 0};
+    }
+    if (offer.gzip && offer.firmwareSize > 0 && count < max) {
+        plan[count++] = {UPDATE_SOURCE_GZIP, 0};
+    }
+    if (count < max) {
+        plan[count++] = {UPDATE_SOURCE_RAW, 0};
+    }
+    return count;
+}
+
+int runUpdateSources(const UpdateSource *plan, uint8_t count, UpdateSourceFn attempt, void *ctx)
+{
+    for (uint8_t i = 0; i < count; i++) {
+        UpdateAttempt result = attempt(plan[i], ctx);
+        if (result == UPDATE_ATTEMPT_OK) {
+            return i;
+        }
+        if (result == UPDATE_ATTEMPT_FAILED &&
+            (plan[i].kind == UPDATE_SOURCE_GZIP || plan[i].kind == UPDATE_SOURCE_RAW)) {
+            return -1;
+        }
+    }
+    return -1;
+}
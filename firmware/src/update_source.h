@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "config.h"
+
+// === Reihenfolge der Update-Quellen ===
+// Woher runInstall() (update_checker.cpp) die Firmware holt: erst Moodlights
+// im LAN, die die Version schon haben, dann der Patch gegen die laufende
+// Firmware, dann die .bin.gz und zuletzt das rohe Binary. Plan und Ablauf
+// kommen hier ohne Arduino aus, damit test/test_update_source sie auf dem
+// Host gegen ein Stub-Backend pruefen kann; Download und Flash liefert der
+// Aufrufer als Callback.
+
+enum UpdateSourceKind : uint8_t {
+    UPDATE_SOURCE_PEER,     // Moodlight im LAN, /api/update/peer-image
+    UPDATE_SOURCE_DELTA,    // Patch gegen die laufende Firmware
+    UPDATE_SOURCE_GZIP,     // Volles Image als .bin.gz
+    UPDATE_SOURCE_RAW,      // Volles Image unkomprimiert
+};
+
+// Hoechstens so viele Eintraege hat ein Plan
+#define UPDATE_SOURCES_MAX (UPDATE_PEER_MAX_TRIES + 3)
+
+// Antwort auf die mDNS-Abfrage nach UPDATE_PEER_SERVICE
+struct UpdatePeer {
+    uint32_t ip = 0;
+    uint16_t port = 0;
+    char fw[24] = {};       // TXT "fw": laufende Version
+    char pre[24] = {};      // TXT "pre": vorab geladene Version
+};
+
+// Was das Backend zur freigegebenen Version angeboten hat
+struct UpdateOffer {
+    const char *version = "";
+    uint32_t firmwareSize = 0;  // 0: unbekannt — ohne Groesse liefert kein Peer
+    uint32_t selfIp = 0;        // Eigene Antwort im mDNS ueberspringen
+    bool delta = false;         // Patch angeboten (ob er passt, prueft erst der Versuch)
+    bool gzip = false;          // .bin.gz angeboten
+};
+
+struct UpdateSource {
+    UpdateSourceKind kind;
+    uint8_t peer;           // Index in peers, nur bei UPDATE_SOURCE_PEER
+};
+
+enum UpdateAttempt : uint8_t {
+    UPDATE_ATTEMPT_OK,
+    UPDATE_ATTEMPT_SKIPPED,     // Nicht versucht (Basis passt nicht, zu wenig Heap)
+    UPDATE_ATTEMPT_FAILED,      // Versucht und gescheitert
+};
+
+typedef UpdateAttempt (*UpdateSourceFn)(const UpdateSource &source, void *ctx);
+
+// Quellen in der Reihenfolge, in der sie versucht werden. Peers nur mit
+// passender Version ("fw" oder "pre"), nicht das eigene Geraet und hoechstens
+// UPDATE_PEER_MAX_TRIES. Rueckgabe: Anzahl Eintraege in plan (<= max).
+uint8_t planUpdateSources(const UpdateOffer &offer, const UpdatePeer *peers, uint8_t peerCount,
+                          UpdateSource *plan, uint8_t max);
+
+// Versucht plan der Reihe nach, bis eine Quelle liefert. Peer und Patch
+// duerfen scheitern; ein gescheitertes volles Image beendet den Lauf — das
+// rohe Binary kaeme vom selben Backend. Uebersprungen wird die .bin.gz nur,
+// wenn der Heap zum Entpacken fehlt, dann folgt das rohe Binary.
+// Rueckgabe: Index der Quelle, die geliefert hat, -1 wenn keine.
+int runUpdateSources(const UpdateSource *plan, uint8_t count, UpdateSourceFn attempt, void *ctx);
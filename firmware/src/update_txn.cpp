@@ -0,0 +1,274 @@
+// update_txn.cpp — Firmware und WebUI als ein Update
+//
+// /update-txn.txt haelt ueber den Neustart hinweg fest, was gerade passiert:
+// Zustand, Version, die Partition, von der aus das Update begann, und den
+// Zeitpunkt des Neustarts. Startet danach wieder dieselbe Partition, wurde die
+// neue Firmware nie gebootet oder der Bootloader ist zurueckgekehrt.
+//
+// Der Neustart-Zeitpunkt kommt aus gettimeofday(): die Systemzeit laeuft im
+// RTC weiter und uebersteht einen Software-Reset (nicht aber Stromausfall).
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <WiFi.h>
+#include <sys/time.h>
+#include "esp_ota_ops.h"
+
+#include "update_txn.h"
+#include "ui_store.h"
+#include "app_state.h"
+#include "config.h"
+#include "debug.h"
+
+#define LOG_TAG LOG_TAG_UPDATE
+
+static const char TXN_FILE[] = "/update-txn.txt";
+
+static UpdateTxnReport report;
+static FixedString<17> fromLabel;     // Partition beim Start der Transaktion
+static int64_t restartAtUs = 0;       // 0 = unbekannt
+static bool pendingVerify = false;    // Bootloader wartet auf Bestaetigung
+
+// Ohne diese Definition bestaetigt der Arduino-Core jede neue Firmware schon
+// vor setup() — dann gaebe es nichts mehr, wozu der Bootloader zurueckkehren
+// koennte. So bleibt sie "pending verify", bis handleUpdateTxn() entscheidet.
+bool verifyRollbackLater()
+{
+    return true;
+}
+
+// Die bereitgestellte UI gehoert zu dieser Transaktion — eine nachts vorab
+// geladene (update_checker.h) kann auch zu einer anderen Version gehoeren
+static bool pendingUiMatches()
+{
+    return uiPendingVersion().length() > 0 && uiPendingVersion() == report.version.c_str();
+}
+
+static int64_t nowUs()
+{
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+// Millisekunden seit dem Neustart ins Update; 0, wenn sich das nicht sagen
+// laesst. Springt die Uhr dazwischen (NTP nach Stromausfall), kaeme Unsinn
+// heraus — mehr als das Bestaetigungsfenster plus Bootzeit kann es nicht sein.
+static uint32_t msSinceRestart()
+{
+    if (restartAtUs <= 0) {
+        return 0;
+    }
+    int64_t ms = (nowUs() - restartAtUs) / 1000;
+    if (ms <= 0 || ms > UPDATE_VERIFY_TIMEOUT_MS + 60000) {
+        return 0;
+    }
+    return (uint32_t)ms;
+}
+
+static bool writeTxn()
+{
+    String tmp = String(TXN_FILE) + ".tmp";
+    File f = LittleFS.open(tmp, "w");
+    if (!f) {
+        return false;
+    }
+    bool ok = f.print(String((int)report.state) + "\n" + report.version.c_str() + "\n" +
+                      fromLabel.c_str() + "\n" + String((long long)restartAtUs) + "\n") > 0;
+    f.close();
+    if (!ok || !LittleFS.rename(tmp, TXN_FILE)) {
+        LittleFS.remove(tmp);
+        LOG_E("Update: Transaktionsdatei nicht geschrieben");
+        return false;
+    }
+    return true;
+}
+
+static bool readTxn(UpdateTxnState &state)
+{
+    if (!LittleFS.exists(TXN_FILE)) {
+        return false;
+    }
+    File f = LittleFS.open(TXN_FILE, "r");
+    if (!f) {
+        return false;
+    }
+    String lines[4];
+    for (String &line : lines) {
+        line = f.readStringUntil('\n');
+        line.trim();
+    }
+    f.close();
+
+    state = (UpdateTxnState)lines[0].toInt();
+    report.version = lines[1];
+    fromLabel = lines[2];
+    restartAtUs = strtoll(lines[3].c_str(), nullptr, 10);
+    return state == TXN_STAGED || state == TXN_FLASHED;
+}
+
+void updateTxnBegin(const char *version)
+{
+    const esp_partition_t *running = esp_ota_get_running_partition();
+
+    report = UpdateTxnReport();
+    report.state = TXN_STAGED;
+    report.version = version;
+    fromLabel = running ? running->label : "";
+    restartAtUs = 0;
+    writeTxn();
+}
+
+void updateTxnFlashed()
+{
+    if (!updateTxnOpen()) {
+        return;
+    }
+    report.state = TXN_FLASHED;
+    report.withUi = pendingUiMatches();
+    writeTxn();
+}
+
+void updateTxnRestarting()
+{
+    if (report.state != TXN_FLASHED) {
+        return;
+    }
+    restartAtUs = nowUs();
+    writeTxn();
+}
+
+void updateTxnAbort()
+{
+    if (!updateTxnOpen()) {
+        return;
+    }
+    if (pendingUiMatches()) {
+        LOG_W("Update %s abgebrochen — bereitgestellte UI verworfen", report.version);
+        uiDiscardPending();
+    }
+    LittleFS.remove(TXN_FILE);
+    report.state = TXN_ABORTED;
+}
+
+void updateTxnBoot()
+{
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    esp_ota_img_states_t imgState;
+    pendingVerify = running && esp_ota_get_state_partition(running, &imgState) == ESP_OK &&
+                    imgState == ESP_OTA_IMG_PENDING_VERIFY;
+    report.rollbackSupported = pendingVerify;
+
+    UpdateTxnState saved;
+    if (!readTxn(saved)) {
+        LittleFS.remove(TXN_FILE);
+        // Neue Firmware ohne Transaktion (z.B. aelterer Stand hat geflasht):
+        // trotzdem bestaetigen, sonst kehrt der naechste Reset zurueck.
+        // Eine bereitgestellte UI bleibt liegen — sie kann vorab geladen sein
+        // und wird nur mit der passenden Firmware aktiv.
+        if (pendingVerify) {
+            report.state = TXN_VERIFYING;
+            report.version = MOODLIGHT_VERSION;
+        }
+        return;
+    }
+
+    report.withUi = pendingUiMatches();
+    if (saved != TXN_FLASHED || !running || strcmp(running->label, fromLabel.c_str()) == 0) {
+        report.state = saved == TXN_FLASHED ? TXN_ROLLED_BACK : TXN_ABORTED;
+        LOG_W("Update %s %s%s", report.version,
+              report.state == TXN_ROLLED_BACK ? "nicht bestaetigt — alte Firmware laeuft wieder"
+                                              : "vor dem Neustart abgebrochen",
+              report.withUi ? ", bereitgestellte UI verworfen" : "");
+        if (report.withUi) {
+            uiDiscardPending();
+        }
+        LittleFS.remove(TXN_FILE);
+        return;
+    }
+
+    report.state = TXN_VERIFYING;
+    LOG_I("Update %s gestartet, pruefe%s%s%s%s", report.version,
+          pendingVerify ? "" : " (Bootloader ohne Rollback)",
+          report.withUi ? " — UI " : "", report.withUi ? uiPendingVersion() : String(),
+          report.withUi ? " steht bereit" : "");
+}
+
+// Firmware bestaetigen und die bereitgestellte UI aktivieren
+static void commitTxn()
+{
+    if (pendingVerify) {
+        esp_ota_mark_app_valid_cancel_rollback();
+        pendingVerify = false;
+    }
+    if (pendingUiMatches()) {
+        report.uiActivated = uiActivatePending();
+        if (!report.uiActivated) {
+            LOG_E("Update: bereitgestellte UI liess sich nicht aktivieren — alte UI bleibt");
+        }
+    }
+    report.commitMs = msSinceRestart();
+    report.state = TXN_COMMITTED;
+    LittleFS.remove(TXN_FILE);
+
+    LOG_I("Update %s bestaetigt%s%s%s — offline %lu ms, bis zur Bestaetigung %lu ms", report.version,
+          report.uiActivated ? ", UI " : "", report.uiActivated ? uiActiveVersion() : String(),
+          report.uiActivated ? " aktiv" : "", (unsigned long)report.offlineMs, (unsigned long)report.commitMs);
+}
+
+void handleUpdateTxn()
+{
+    if (report.state != TXN_VERIFYING) {
+        return;
+    }
+
+    bool online = WiFi.status() == WL_CONNECTED;
+    if (report.offlineMs == 0 && (online || appState.isInConfigMode)) {
+        report.offlineMs = msSinceRestart();
+    }
+
+    // Gesund: so lange ohne Absturz gelaufen und erreichbar
+    if ((online || appState.isInConfigMode) && millis() >= UPDATE_VERIFY_STABLE_MS) {
+        commitTxn();
+        return;
+    }
+    if (millis() < UPDATE_VERIFY_TIMEOUT_MS) {
+        return;
+    }
+
+    if (!pendingVerify) {
+        // Ohne Rollback im Bootloader gibt es nichts, wohin es zurueckginge
+        LOG_W("Update: nach Frist nicht im Netz, Bootloader ohne Rollback — behalte Firmware");
+        commitTxn();
+        return;
+    }
+    LOG_E("Update %s nach %d s nicht im Netz — zurueck zur alten Firmware", report.version,
+          UPDATE_VERIFY_TIMEOUT_MS / 1000);
+    uiDiscardPending();
+    // Die Transaktionsdatei bleibt: die alte Firmware meldet den Rollback
+    delay(200);
+    esp_ota_mark_app_invalid_rollback_and_reboot();
+}
+
+bool updateTxnOpen()
+{
+    return report.state == TXN_STAGED || report.state == TXN_FLASHED;
+}
+
+const UpdateTxnReport &updateTxnReport()
+{
+    return report;
+}
+
+const char *updateTxnStateName(UpdateTxnState state)
+{
+    switch (state) {
+        case TXN_STAGED: return "staged";
+        case TXN_FLASHED: return "flashed";
+        case TXN_VERIFYING: return "verifying";
+        case TXN_COMMITTED: return "committed";
+        case TXN_ROLLED_BACK: return "rolled_back";
+        case TXN_ABORTED: return "aborted";
+        default: return "none";
+    }
+}
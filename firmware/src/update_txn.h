@@ -0,0 +1,60 @@
+// update_txn.h — Firmware und WebUI als ein Update
+//
+// Ein Update besteht aus Firmware und passender UI. Frueher kam zuerst die UI
+// (sofort aktiv), dann die Firmware — scheiterte der Flash oder startete die
+// neue Firmware nicht sauber, lief die alte Firmware mit der neuen UI weiter.
+//
+// Jetzt laeuft es als Transaktion:
+//   1. UI vollstaendig entpacken, aber nur bereitstellen (/ui-pending.txt)
+//   2. Firmware in die freie OTA-Partition schreiben
+//   3. Neustart; der Zeitpunkt steht in /update-txn.txt
+//   4. Die neue Firmware laeuft im Zustand "pending verify" des Bootloaders.
+//      Ist sie UPDATE_VERIFY_STABLE_MS lang am Netz (bzw. im Setup-Modus),
+//      wird sie bestaetigt und erst dann die bereitgestellte UI aktiviert.
+//   5. Kommt sie nicht so weit oder stuerzt vorher ab, kehrt der Bootloader zur
+//      alten Firmware zurueck — die verwirft die bereitgestellte UI.
+//
+// Die Ausfallzeit (Neustart bis wieder im WLAN) und die Zeit bis zur
+// Bestaetigung werden gemessen und unter /api/update/status gemeldet.
+
+#pragma once
+
+#include <Arduino.h>
+#include "fixed_string.h"
+
+enum UpdateTxnState : uint8_t {
+    TXN_NONE,
+    TXN_STAGED,         // UI bereitgestellt, Firmware wird geschrieben
+    TXN_FLASHED,        // Firmware geschrieben, Neustart steht an
+    TXN_VERIFYING,      // Neue Firmware laeuft, Bestaetigung offen
+    TXN_COMMITTED,      // Firmware bestaetigt, UI aktiv
+    TXN_ROLLED_BACK,    // Neue Firmware kam nicht hoch — alte laeuft wieder
+    TXN_ABORTED,        // Vor dem Neustart abgebrochen
+};
+
+// Stand der laufenden bzw. letzten Transaktion
+struct UpdateTxnReport {
+    UpdateTxnState state = TXN_NONE;
+    FixedString<16> version;
+    bool withUi = false;            // Gehoert eine bereitgestellte UI dazu
+    bool uiActivated = false;
+    bool rollbackSupported = false; // Bootloader kann zur alten Firmware zurueck
+    uint32_t offlineMs = 0;         // Neustart bis wieder im WLAN, 0 = unbekannt
+    uint32_t commitMs = 0;          // Neustart bis Firmware bestaetigt und UI aktiv
+};
+
+void updateTxnBegin(const char *version);   // Vor dem Bereitstellen der UI bzw. dem Flash
+void updateTxnFlashed();                    // Firmware vollstaendig geschrieben
+void updateTxnRestarting();                 // Unmittelbar vor ESP.restart()
+void updateTxnAbort();                      // Gescheitert: bereitgestellte UI verwerfen
+
+// Beim Start nach initFS(): Transaktion vom letzten Boot auswerten
+void updateTxnBoot();
+
+// Gehoert in die loop() (auch im Setup-Modus): bestaetigt die neue Firmware
+// oder kehrt zur alten zurueck
+void handleUpdateTxn();
+
+bool updateTxnOpen();   // Bereitgestellt oder geflasht, Neustart steht noch aus
+const UpdateTxnReport &updateTxnReport();
+const char *updateTxnStateName(UpdateTxnState state);
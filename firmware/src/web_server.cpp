@@ -18,13 +18,18 @@
 #include <time.h>
 #include "esp_idf_version.h"
 #include "esp_task_wdt.h"
-#define DEST_FS_USES_LITTLEFS
-#include <ESP32-targz.h>
+#include "esp_core_dump.h"
+#include "esp_ota_ops.h"
 
 #include "led_controller.h"
 #include "mqtt_handler.h"
 #include "sensor_manager.h"
 #include "update_checker.h"
+#include "ota_gzip.h"
+#include "ui_store.h"
+#include "update_txn.h"
+#include "api_probe.h"
+#include "settings_manager.h"
 
 // === Externe Globals aus moodlight.cpp ===
 extern AppState appState;
@@ -34,8 +39,45 @@ extern const String SOFTWARE_VERSION;
 
 #include "debug.h"
 
+#define LOG_TAG LOG_TAG_WEB
+
 // Hardware-Instanz — definiert in diesem Modul
-WebServer server(80);
+MeteredWebServer server(80);
+
+// Jede Antwort beginnt mit einem Schreibvorgang, der den kompletten Header
+// enthaelt ("HTTP/1.1 200 OK\r\n..."). Daraus kommen Statuscode und Content-Length.
+// Den Body von streamFile() schreibt der WebServer am Wrapper vorbei direkt auf
+// den Client — deshalb zaehlt die angekuendigte Laenge, nicht die geschriebene.
+void MeteredWebServer::meter(const char *b, size_t l) {
+    if (l > 12 && strncmp(b, "HTTP/1.", 7) == 0) {
+        _meterStatus = atoi(b + 9);
+        _meterBytes += l;
+        static const char CL[] = "\r\nContent-Length: ";
+        const size_t clLen = sizeof(CL) - 1;
+        for (size_t i = 0; i + clLen < l; i++) {
+            if (b[i] == '\r' && strncmp(b + i, CL, clLen) == 0) {
+                _meterBytes += strtoul(b + i + clLen, nullptr, 10);
+                _meterBodyKnown = true;
+                break;
+            }
+        }
+        return;
+    }
+    // Chunked (CONTENT_LENGTH_UNKNOWN): Body-Bytes einzeln zaehlen
+    if (!_meterBodyKnown) {
+        _meterBytes += l;
+    }
+}
+
+size_t MeteredWebServer::_currentClientWrite(const char *b, size_t l) {
+    meter(b, l);
+    return WebServer::_currentClientWrite(b, l);
+}
+
+size_t MeteredWebServer::_currentClientWrite_P(PGM_P b, size_t l) {
+    meter(b, l);
+    return WebServer::_currentClientWrite_P(b, l);
+}
 
 // === Externe Funktionen aus anderen Modulen ===
 extern void saveSettings();
@@ -46,7 +88,8 @@ extern void handleSentiment(float score, const String &apiCategory);
 extern void getSentiment();
 extern bool fetchBackendStatistics(JsonDocument &doc, int hours);
 extern int mapSentimentToLED(float score);
-extern String scanWiFiNetworks();
+extern uint32_t startWiFiScan(bool force);
+extern int wifiScanResponse(uint32_t job, String &json);
 
 // === Externe Utility-Instanzen aus moodlight.cpp ===
 extern MemoryMonitor memMonitor;
@@ -71,7 +114,7 @@ struct JsonBufferPool {
         for (int i = 0; i < JSON_BUFFER_COUNT; i++) {
             inUse[i] = false;
         }
-        debug(F("JSON-Puffer-Pool initialisiert"));
+        LOG_I("JSON-Puffer-Pool initialisiert");
     }
 
     // Reserviert einen Puffer
@@ -87,7 +130,7 @@ struct JsonBufferPool {
             xSemaphoreGive(mutex);
         }
         // Fallback wenn kein Puffer verfügbar ist
-        debug(F("WARNUNG: Kein JSON-Puffer verfügbar, verwende Heap!"));
+        LOG_W("Kein JSON-Puffer verfügbar, verwende Heap!");
         return new char[JSON_BUFFER_SIZE];
     }
 
@@ -118,92 +161,150 @@ void initJsonPool() {
 
 // A-NIEDRIG: JsonBufferGuard entfernt — ungenutzt, kein Aufrufer im Code
 
-// ===== Datei-Hilfsfunktionen =====
+// ===== Hot-File-Cache =====
+// Jeder Seitenaufruf zieht dieselben CSS/JS-Dateien. Ohne Cache heisst das jedes
+// Mal LittleFS.open() mit Metadaten-Suche und viele kleine Flash-Lesezugriffe.
+// Der Cache haelt die zuletzt genutzten Dateien im RAM (LRU). Das Budget wird bei
+// jedem Einfuegen gegen den freien Heap geprueft — der Cache weicht zurueck,
+// bevor er dem Rest der Firmware den Speicher streitig macht.
+// Fuer gebuendelte Seiten (siehe build-ui-bundle.py) liegt die gzip-Fassung im
+// Cache und geht mit Content-Encoding: gzip raus.
+
+struct FileCacheEntry {
+    String path;
+    uint8_t *data;          // Dateiinhalt auf dem Heap, nullptr = Slot frei
+    size_t size;
+    bool gzip;              // Inhalt ist <path>.gz
+    uint32_t lastUsed;      // LRU-Zaehlerstand des letzten Zugriffs
+    uint32_t loadMicros;    // Gemessene Flash-Lesezeit beim Laden
+};
 
-// Helper function to copy a file
-// A-NIEDRIG: char[64]-Zwischenpuffer entfernt — String::c_str() direkt verwendet
-// (Puffer haette laengere Pfade stillschweigend abgeschnitten)
-bool copyFile(const String& source, const String& destination) {
-    if (!LittleFS.exists(source)) {
-        debug("Quelldatei existiert nicht: " + source);
-        return false;
+struct StaticFileCache {
+    FileCacheEntry entries[FILE_CACHE_MAX_ENTRIES];
+    size_t usedBytes;
+    uint32_t useCounter;
+
+    // Metriken fuer /api/system/metrics
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+    uint64_t bytesFromCache;
+    uint64_t flashMicrosSaved;
+
+    FileCacheEntry* find(const String &path) {
+        for (int i = 0; i < FILE_CACHE_MAX_ENTRIES; i++) {
+            if (entries[i].data && entries[i].path == path) {
+                entries[i].lastUsed = ++useCounter;
+                return &entries[i];
+            }
+        }
+        return nullptr;
     }
 
-    File sourceFile = LittleFS.open(source, "r");
-    if (!sourceFile) {
-        debug("Quelldatei konnte nicht geöffnet werden: " + source);
-        return false;
+    void release(FileCacheEntry &entry) {
+        if (!entry.data) return;
+        free(entry.data);
+        usedBytes -= entry.size;
+        entry.data = nullptr;
+        entry.size = 0;
+        entry.path = "";
     }
 
-    File destFile = LittleFS.open(destination, "w");
-    if (!destFile) {
-        debug("Zieldatei konnte nicht erstellt werden: " + destination);
-        sourceFile.close();
-        return false;
+    // Aeltesten Eintrag verwerfen; false wenn der Cache schon leer ist
+    bool evictOldest() {
+        FileCacheEntry *oldest = nullptr;
+        for (int i = 0; i < FILE_CACHE_MAX_ENTRIES; i++) {
+            if (entries[i].data && (!oldest || entries[i].lastUsed < oldest->lastUsed)) {
+                oldest = &entries[i];
+            }
+        }
+        if (!oldest) return false;
+        release(*oldest);
+        evictions++;
+        return true;
     }
 
-    static uint8_t buffer[512];
-    size_t bytesRead = 0;
-
-    while ((bytesRead = sourceFile.read(buffer, sizeof(buffer))) > 0) {
-        if (destFile.write(buffer, bytesRead) != bytesRead) {
-            debug(F("Fehler beim Schreiben in Zieldatei"));
-            sourceFile.close();
-            destFile.close();
-            return false;
-        }
-        yield(); // Allow for WiFi processing
+    // Aktuelles Budget: feste Obergrenze, aber nie mehr als der Heap hergibt
+    size_t budget() const {
+        uint32_t freeHeap = ESP.getFreeHeap();
+        size_t heapBudget = freeHeap > FILE_CACHE_HEAP_RESERVE
+                                ? usedBytes + (freeHeap - FILE_CACHE_HEAP_RESERVE)
+                                : 0;
+        return min((size_t)FILE_CACHE_MAX_BYTES, heapBudget);
     }
 
-    debug("Datei kopiert von " + source + " nach " + destination);
-    destFile.close();
-    sourceFile.close();
-    return true;
-}
+    // Liest die Datei in einen neuen Eintrag. nullptr wenn sie nicht passt —
+    // der Aufrufer streamt dann wie bisher direkt aus dem Dateisystem.
+    FileCacheEntry* load(const String &path, File &file, bool gzip) {
+        size_t size = file.size();
+        if (size == 0 || size > FILE_CACHE_MAX_FILE_BYTES) return nullptr;
 
-// Helper function to move a file
-bool moveFile(const String& source, const String& destination) {
-    if (!LittleFS.exists(source)) {
-        return false;
-    }
+        while (usedBytes + size > budget()) {
+            if (!evictOldest()) return nullptr;
+        }
 
-    if (!copyFile(source, destination)) {
-        return false;
-    }
+        FileCacheEntry *slot = nullptr;
+        for (int i = 0; i < FILE_CACHE_MAX_ENTRIES && !slot; i++) {
+            if (!entries[i].data) slot = &entries[i];
+        }
+        if (!slot) {
+            evictOldest();
+            for (int i = 0; i < FILE_CACHE_MAX_ENTRIES && !slot; i++) {
+                if (!entries[i].data) slot = &entries[i];
+            }
+        }
+        // Nur zusammenhaengende Bloecke taugen — bei zerstueckeltem Heap verzichten
+        if (!slot || ESP.getMaxAllocHeap() < size + 4096) return nullptr;
 
-    return LittleFS.remove(source);
-}
+        uint8_t *buffer = (uint8_t*)malloc(size);
+        if (!buffer) return nullptr;
 
-// Helper function to copy a directory
-bool copyDir(const String& sourceDir, const String& destDir) {
-    File root = LittleFS.open(sourceDir);
-    if (!root) {
-        return false;
-    }
+        unsigned long start = micros();
+        size_t read = file.read(buffer, size);
+        unsigned long elapsed = micros() - start;
+        if (read != size) {
+            free(buffer);
+            return nullptr;
+        }
 
-    if (!root.isDirectory()) {
-        return false;
+        slot->path = path;
+        slot->data = buffer;
+        slot->size = size;
+        slot->gzip = gzip;
+        slot->loadMicros = elapsed;
+        slot->lastUsed = ++useCounter;
+        usedBytes += size;
+        return slot;
     }
 
-    File file = root.openNextFile();
+    // Nach einem UI-Update sind alle Eintraege veraltet
+    void clear() {
+        for (int i = 0; i < FILE_CACHE_MAX_ENTRIES; i++) {
+            release(entries[i]);
+        }
+    }
 
-    while (file) {
-        if (file.isDirectory()) {
-            String dirName = String(file.name()).substring(String(file.name()).lastIndexOf('/') + 1);
-            String newSourceDir = sourceDir + "/" + dirName;
-            String newDestDir = destDir + "/" + dirName;
-            LittleFS.mkdir(newDestDir);
-            copyDir(newSourceDir, newDestDir);
-        } else {
-            String fileName = String(file.name()).substring(String(file.name()).lastIndexOf('/') + 1);
-            copyFile(String(file.path()), destDir + "/" + fileName);
+    int count() const {
+        int n = 0;
+        for (int i = 0; i < FILE_CACHE_MAX_ENTRIES; i++) {
+            if (entries[i].data) n++;
         }
-        file = root.openNextFile();
+        return n;
     }
+};
 
-    return true;
+// Globale Instanz: statischer Speicher ist genullt, ein init() ist nicht noetig
+StaticFileCache fileCache;
+
+void invalidateFileCache() {
+    if (fileCache.count() > 0) {
+        LOG_D("Datei-Cache geleert (%lu Bytes)", (unsigned long)fileCache.usedBytes);
+    }
+    fileCache.clear();
 }
 
+// ===== Datei-Hilfsfunktionen =====
+
 // Helper function to delete a directory recursively
 bool deleteDir(const String& dirPath) {
     File root = LittleFS.open(dirPath);
@@ -236,24 +337,24 @@ bool deleteDir(const String& dirPath) {
 
 void initFS() {
     if (!LittleFS.begin()) {
-        debug(F("LittleFS Mount Failed, attempting format..."));
+        LOG_I("LittleFS Mount Failed, attempting format...");
         if (!LittleFS.format()) {
-            debug(F("LittleFS Format Failed!"));
+            LOG_I("LittleFS Format Failed!");
             return;
         }
         if (!LittleFS.begin()) {
-            debug(F("LittleFS Still Not Working After Format!"));
+            LOG_I("LittleFS Still Not Working After Format!");
             return;
         }
     }
 
     // Create required directories if they don't exist
-    const char* directories[] = {"/data", "/temp", "/extract", "/extract/css", "/extract/js", "/backup", "/css", "/js"};
+    const char* directories[] = {"/data", "/temp", "/css", "/js"};
     for (const char* dir : directories) {
         if (!LittleFS.exists(dir)) {
-            debug(String(F("Creating directory: ")) + dir);
+            LOG_I("Creating directory: %s", dir);
             if (!LittleFS.mkdir(dir)) {
-                debug(String(F("Failed to create directory: ")) + dir);
+                LOG_E("Failed to create directory: %s", dir);
                 // Continue anyway, the operation might work later
             }
         }
@@ -263,7 +364,7 @@ void initFS() {
     // REMOVED v9.0: Stats now managed in backend, no local CSV needed
 
     if (!LittleFS.exists("/ui-version.txt")) {
-        debug(F("Creating ui-version.txt..."));
+        LOG_I("Creating ui-version.txt...");
         File versionFile = LittleFS.open("/ui-version.txt", "w");
         if (versionFile) {
             versionFile.print(SOFTWARE_VERSION);
@@ -274,11 +375,24 @@ void initFS() {
     // /firmware-version.txt wird nicht mehr angelegt: die Firmware-Version kommt
     // ausschliesslich aus SOFTWARE_VERSION. Eine Datei im Flash ueberlebt einen
     // USB-Flash und meldet danach eine veraltete Version.
+
+    // Entpack- und Sicherungsverzeichnis des frueheren UI-Installers — die
+    // Versionen liegen jetzt unter /ui-<version>/
+    for (const char* legacy : {"/extract", "/backup"}) {
+        if (LittleFS.exists(legacy)) {
+            deleteDir(legacy);
+        }
+    }
+
+    uiStoreBegin();
 }
 
 // ===== Versions-Abfragen =====
 
 String getCurrentUiVersion() {
+    if (uiActiveVersion().length() > 0) {
+        return uiActiveVersion();
+    }
     if (LittleFS.exists("/ui-version.txt")) {
         File versionFile = LittleFS.open("/ui-version.txt", "r");
         if (versionFile) {
@@ -314,6 +428,27 @@ void getStorageInfo(uint64_t &totalBytes, uint64_t &usedBytes, uint64_t &freeByt
 
 // ===== Statische Dateien =====
 
+// vary: Bundle oder unkomprimierte Seite hing von Accept-Encoding ab — sonst
+// liefert ein Proxy oder der Browser-Cache die falsche Fassung aus
+static void sendCacheHeader(bool isCacheable, bool vary) {
+    if (isCacheable) {
+        server.sendHeader("Cache-Control", "public, max-age=86400");
+    } else {
+        server.sendHeader("Cache-Control", "no-cache");
+    }
+    if (vary) {
+        server.sendHeader("Vary", "Accept-Encoding");
+    }
+}
+
+static void sendCachedFile(const FileCacheEntry &entry, const String &contentType, bool isCacheable, bool vary) {
+    sendCacheHeader(isCacheable, vary);
+    if (entry.gzip) {
+        server.sendHeader("Content-Encoding", "gzip");
+    }
+    server.send_P(200, contentType.c_str(), (PGM_P)entry.data, entry.size);
+}
+
 void handleStaticFile(String path) {
     if (path.endsWith("/")) path += "index.html";
 
@@ -330,19 +465,51 @@ void handleStaticFile(String path) {
         path = "/" + path;
     }
 
-    // Direkt oeffnen statt exists()+open() — vermeidet doppelten Dateisystem-Zugriff (A-NIEDRIG)
-    File file = LittleFS.open(path, "r");
-    if (file) {
-        if (isCacheable) {
-            server.sendHeader("Cache-Control", "public, max-age=86400");
-        } else {
-            server.sendHeader("Cache-Control", "no-cache");
-        }
-        server.streamFile(file, contentType);
-        file.close();
-    } else {
+    // Seiten-Bundles nur an Clients, die gzip verstehen (Browser tun das
+    // immer, curl & Co. nur auf Wunsch) — sonst die unkomprimierte Seite
+    bool bundle = path.endsWith(".html");
+    bool acceptsGzip = server.header("Accept-Encoding").indexOf("gzip") >= 0;
+
+    // Treffer im RAM: kein Dateisystem-Zugriff
+    FileCacheEntry *cached = fileCache.find(path);
+    if (cached && (!cached->gzip || acceptsGzip)) {
+        fileCache.hits++;
+        fileCache.bytesFromCache += cached->size;
+        fileCache.flashMicrosSaved += cached->loadMicros;
+        sendCachedFile(*cached, contentType, isCacheable, bundle);
+        return;
+    }
+    fileCache.misses++;
+
+    // Seiten-Bundle bevorzugen: HTML mit eingebettetem CSS/JS, ein Request statt
+    // bis zu fuenf. uiOpenFile() loest beide Fassungen in einem Schritt auf —
+    // ueber den Dateiindex ohne Suche im Dateisystem. Der Cache-Schluessel
+    // bleibt der URL-Pfad (beim Umschalten wird der Cache ohnehin verworfen).
+    bool gzip = false;
+    File file = uiOpenFile(path, bundle && acceptsGzip, gzip);
+    if (!file && bundle && !acceptsGzip) {
+        // Archiv nur mit Bundle: besser komprimiert als gar nicht
+        file = uiOpenFile(path, true, gzip);
+    }
+    if (!file) {
         server.send(404, "text/plain", "Datei nicht gefunden: " + path);
+        return;
+    }
+
+    // Die unkomprimierte Seite fuer einen einzelnen Client soll das Bundle
+    // nicht aus dem Cache verdraengen
+    cached = acceptsGzip || !bundle ? fileCache.load(path, file, gzip) : nullptr;
+    if (cached) {
+        file.close();
+        sendCachedFile(*cached, contentType, isCacheable, bundle);
+        return;
     }
+
+    // Passt nicht in den Cache — wie bisher streamen. Bei .gz setzt streamFile()
+    // den Content-Encoding-Header selbst.
+    sendCacheHeader(isCacheable, bundle);
+    server.streamFile(file, contentType);
+    file.close();
 }
 
 // ===== UI-Upload Handler =====
@@ -350,269 +517,101 @@ void handleStaticFile(String path) {
 // Statisches Erfolgs-/Fehlerflag ueber Extraktion, Kopieren und Platzpruefung hinweg (A-HOCH-4)
 static bool uiUploadSuccess = false;
 static String uiUploadError = "";
-static File uiUploadFile;
-
+static bool uiUploadStage = false;   // ?stage=1: nur bereitstellen, Transaktion offen
+// /update: abgewiesen, weil schon ein Update laeuft — Update gehoert dann dem Task
+static bool firmwareUploadRejected = false;
+
+// Der Upload wird im Takt der ankommenden Bloecke entpackt (UiInstaller) —
+// direkt in /ui-<version>/, jede Datei genau einmal geschrieben. Erst wenn das
+// Archiv vollstaendig und plausibel ist, wird auf die neue Version umgeschaltet.
+//
+// Mit ?stage=1 wird nicht umgeschaltet: die UI gehoert zu einer Firmware, die
+// gleich danach ueber /update kommt, und wird erst mit deren Bestaetigung
+// aktiv (update_txn.h).
 void handleUiUpload() {
     HTTPUpload& upload = server.upload();
-    static String uploadPath;
-    static bool isTgzFile = false;
-    static String extractedVersion;
+    static UiInstaller installer;
 
     if (upload.status == UPLOAD_FILE_START) {
         uiUploadSuccess = false;
         uiUploadError = "";
-        extractedVersion = "";
-        uploadPath = "";
+        uiUploadStage = false;
+
+        if (appState.updateInProgress) {
+            uiUploadError = "Es laeuft bereits ein Update";
+            return;
+        }
 
         String filename = upload.filename;
         Serial.printf("UI Upload: %s\n", filename.c_str());
-        debug(String(F("UI Upload gestartet: ")) + filename);
+        LOG_I("UI Upload gestartet: %s", filename);
 
-        // Check if it's a TGZ file
-        isTgzFile = filename.endsWith(".tgz") || filename.endsWith(".tar.gz");
-        if (!isTgzFile) {
-            debug(F("Fehler: Keine TGZ-Datei"));
+        if (!filename.endsWith(".tgz") && !filename.endsWith(".tar.gz")) {
+            LOG_E("Keine TGZ-Datei");
             uiUploadError = "Keine TGZ-Datei";
             return;
         }
 
-        // Platzpruefung vor Upload-Start — freie Bytes muessen mind. 3x Content-Length sein
-        // (Original-TGZ + entpackte Dateien + Backup)
-        int contentLength = server.clientContentLength();
-        if (contentLength > 0) {
-            uint64_t total, used, free;
-            getStorageInfo(total, used, free);
-            if (free < (uint64_t)contentLength * 3) {
-                debug(String(F("Fehler: Nicht genuegend freier Speicherplatz fuer Upload (")) +
-                      String((unsigned long)free) + F(" frei, ") + String((unsigned long)contentLength * 3) + F(" benoetigt)"));
-                uiUploadError = "Nicht genuegend freier Speicherplatz";
-                isTgzFile = false;
-                return;
-            }
-        }
-
-        // Extract version — nur bei UI-Praefix (Firmware-Dateien haben anderes Namensschema)
+        // Version aus UI-9.16-AuraOS.tgz — andere Namen landen unter /ui-local
+        String version;
         if (filename.startsWith("UI-") && filename.length() > 3) {
             String versionStr = filename.substring(3);
             int dashPos = versionStr.indexOf("-");
             if (dashPos > 0) {
-                extractedVersion = versionStr.substring(0, dashPos);
-                debug(String(F("UI-Version aus Dateiname: ")) + extractedVersion);
+                version = versionStr.substring(0, dashPos);
+                LOG_D("UI-Version aus Dateiname: %s", version);
             }
         }
 
-        // Create all required directories first
-        if (!LittleFS.exists("/temp")) {
-            debug(F("Erstelle Verzeichnis /temp"));
-            if (!LittleFS.mkdir("/temp")) {
-                debug(F("Fehler beim Erstellen des /temp Verzeichnisses"));
-                uiUploadError = "Konnte /temp nicht erstellen";
-                return;
-            }
-        }
+        // Der Entpacker braucht ~43 KB Heap am Stueck; der Cache waere danach ohnehin veraltet
+        invalidateFileCache();
 
-        if (!LittleFS.exists("/extract")) {
-            debug(F("Erstelle Verzeichnis /extract"));
-            if (!LittleFS.mkdir("/extract")) {
-                debug(F("Fehler beim Erstellen des /extract Verzeichnisses"));
-                uiUploadError = "Konnte /extract nicht erstellen";
-                return;
-            }
+        if (server.arg("stage") == "1") {
+            uiUploadStage = true;
+            updateTxnBegin(version.c_str());
         }
-
-        // Create required subdirectories
-        if (!LittleFS.exists("/extract/css")) {
-            LittleFS.mkdir("/extract/css");
-        }
-
-        if (!LittleFS.exists("/extract/js")) {
-            LittleFS.mkdir("/extract/js");
-        }
-
-        // Clean temp directory
-        debug(F("Lösche alten Inhalt in /temp"));
-        File tempRoot = LittleFS.open("/temp");
-        if (tempRoot && tempRoot.isDirectory()) {
-            File tempFile = tempRoot.openNextFile();
-            while (tempFile) {
-                String path = String(tempFile.path());
-                tempFile = tempRoot.openNextFile();
-                LittleFS.remove(path);
-            }
-        }
-
-        // Clean extract directory
-        debug(F("Lösche alten Inhalt in /extract"));
-        File extractRoot = LittleFS.open("/extract");
-        if (extractRoot && extractRoot.isDirectory()) {
-            File extractFile = extractRoot.openNextFile();
-            while (extractFile) {
-                String path = String(extractFile.path());
-                extractFile = extractRoot.openNextFile();
-                LittleFS.remove(path);
-            }
-        }
-
-        uploadPath = "/temp/" + filename;
-        debug(String(F("Upload-Pfad: ")) + uploadPath);
-
-        // Datei-Handle EINMAL pro Upload oeffnen (nicht bei jedem WRITE neu) — A-MITTEL Upload-Robustheit
-        uiUploadFile = LittleFS.open(uploadPath, "w");
-        if (!uiUploadFile) {
-            debug(F("Fehler beim Erstellen der TGZ-Datei"));
-            uiUploadError = "Konnte TGZ-Datei nicht erstellen";
-            return;
+        int contentLength = server.clientContentLength();
+        if (!installer.begin(version, contentLength > 0 ? contentLength : 0)) {
+            uiUploadError = installer.error();
+            LOG_E("%s", uiUploadError);
         }
     }
-    else if (upload.status == UPLOAD_FILE_WRITE && isTgzFile) {
-        if (uiUploadFile) {
-            size_t bytesWritten = uiUploadFile.write(upload.buf, upload.currentSize);
-            if (bytesWritten != upload.currentSize) {
-                debug(String(F("Fehler beim Schreiben: Nur ")) + bytesWritten + F(" von ") + upload.currentSize + F(" Bytes geschrieben"));
-                uiUploadError = "Fehler beim Schreiben der Upload-Datei";
-            }
-        } else {
-            debug(F("Fehler: TGZ-Datei-Handle nicht offen zum Schreiben"));
-            uiUploadError = "Upload-Datei nicht offen";
+    else if (upload.status == UPLOAD_FILE_WRITE) {
+        if (installer.active() && !installer.write(upload.buf, upload.currentSize)) {
+            uiUploadError = installer.error();
+            LOG_E("Fehler beim Entpacken: %s", uiUploadError);
         }
     }
     else if (upload.status == UPLOAD_FILE_ABORTED) {
-        debug(F("UI Upload abgebrochen"));
-        if (uiUploadFile) {
-            uiUploadFile.close();
-        }
-        if (uploadPath.length() > 0 && LittleFS.exists(uploadPath)) {
-            LittleFS.remove(uploadPath);
-        }
-        isTgzFile = false;
-        uploadPath = "";
+        LOG_W("UI Upload abgebrochen");
+        installer.abort();
         uiUploadError = "Upload abgebrochen";
     }
-    else if (upload.status == UPLOAD_FILE_END && isTgzFile) {
-        if (uiUploadFile) {
-            uiUploadFile.close();
-        }
-
-        debug(String(F("UI Upload abgeschlossen: ")) + upload.totalSize + F(" Bytes"));
-        debug(F("Starte TAR-Extraktion..."));
-
-        // Ensure memory heap is sufficient
-        debug(String(F("Verfügbarer Heap vor Extraktion: ")) + ESP.getFreeHeap());
-
-        // Initialize TarGzUnpacker with proper memory management
-        TarGzUnpacker *TARGZUnpacker = new TarGzUnpacker();
-
-        // Configure unpacker with more verbose logging
-        TARGZUnpacker->setTarVerify(false);  // Skip verification to save memory
-        TARGZUnpacker->setupFSCallbacks(targzTotalBytesFn, targzFreeBytesFn);
-        TARGZUnpacker->setGzProgressCallback(BaseUnpacker::defaultProgressCallback);
-        TARGZUnpacker->setLoggerCallback(BaseUnpacker::targzPrintLoggerCallback);
-        TARGZUnpacker->setTarProgressCallback(BaseUnpacker::defaultProgressCallback);
-        TARGZUnpacker->setTarStatusProgressCallback(BaseUnpacker::defaultTarStatusProgressCallback);
-        TARGZUnpacker->setTarMessageCallback(BaseUnpacker::targzPrintLoggerCallback);
-
-        // Try the extraction with proper error reporting
-        debug(String(F("Entpacke ")) + uploadPath + F(" nach /extract"));
-        bool success = false;
-
-        try {
-            // Direct extraction to avoid temporary files
-            success = TARGZUnpacker->tarGzExpanderNoTempFile(tarGzFS, uploadPath.c_str(), tarGzFS, "/extract");
-        } catch (const std::exception& e) {
-            debug(String(F("Ausnahme bei Extraktion: ")) + e.what());
-        } catch (...) {
-            debug(F("Unbekannte Ausnahme bei Extraktion"));
+    else if (upload.status == UPLOAD_FILE_END && installer.active()) {
+        if (!installer.end(uiUploadStage)) {
+            uiUploadError = installer.error();
+            LOG_E("%s", uiUploadError);
+            return;
         }
 
-        debug(String(F("Verfügbarer Heap nach Extraktion: ")) + ESP.getFreeHeap());
-
-        if (success) {
-            debug(F("TAR-Extraktion erfolgreich. Überprüfe Dateien..."));
-
-            // Manual file installation instead of checking for files
-            // Create backup directory if needed
-            if (!LittleFS.exists("/backup")) {
-                debug(F("Erstelle Backup-Verzeichnis"));
-                LittleFS.mkdir("/backup");
-            }
-
-            // Backup existing files
-            debug(F("Erstelle Backup der aktuellen Dateien"));
-            if (LittleFS.exists("/index.html"))
-                copyFile("/index.html", "/backup/index.html");
-            if (LittleFS.exists("/setup.html"))
-                copyFile("/setup.html", "/backup/setup.html");
-            if (LittleFS.exists("/mood.html"))
-                copyFile("/mood.html", "/backup/mood.html");
-
-            // Ensure CSS and JS directories exist
-            if (!LittleFS.exists("/css"))
-                LittleFS.mkdir("/css");
-            if (!LittleFS.exists("/js"))
-                LittleFS.mkdir("/js");
-
-            // Copy main HTML files
-            debug(F("Kopiere Hauptdateien"));
-            copyFile("/extract/index.html", "/index.html");
-            copyFile("/extract/setup.html", "/setup.html");
-            copyFile("/extract/mood.html", "/mood.html");
-
-            // Copy CSS files
-            debug(F("Kopiere CSS-Dateien"));
-            if (LittleFS.exists("/extract/css/style.css"))
-                copyFile("/extract/css/style.css", "/css/style.css");
-            if (LittleFS.exists("/extract/css/mood.css"))
-                copyFile("/extract/css/mood.css", "/css/mood.css");
-
-            // Copy JS files
-            debug(F("Kopiere JS-Dateien"));
-            if (LittleFS.exists("/extract/js/script.js"))
-                copyFile("/extract/js/script.js", "/js/script.js");
-            if (LittleFS.exists("/extract/js/mood.js"))
-                copyFile("/extract/js/mood.js", "/js/mood.js");
-            if (LittleFS.exists("/extract/js/setup.js"))
-                copyFile("/extract/js/setup.js", "/js/setup.js");
-
-            // Save version
-            if (extractedVersion.length() > 0) {
-                debug(String(F("Speichere UI-Version: ")) + extractedVersion);
-                File versionFile = LittleFS.open("/ui-version.txt", "w");
-                if (versionFile) {
-                    versionFile.print(extractedVersion);
-                    versionFile.close();
-                }
-            }
-
-            // /extract nach erfolgreicher Installation rekursiv leeren
-            debug(F("Leere /extract nach erfolgreicher Installation"));
-            deleteDir("/extract");
-            LittleFS.mkdir("/extract");
-            LittleFS.mkdir("/extract/css");
-            LittleFS.mkdir("/extract/js");
-
-            debug(F("UI-Update erfolgreich!"));
+        if (uiUploadStage) {
+            LOG_I("UI %s bereitgestellt: %u Dateien geschrieben, %u unveraendert in %lu ms — wird mit der Firmware aktiv",
+                  uiPendingVersion(), installer.files(), installer.filesSkipped(),
+                  (unsigned long)installer.elapsedMs());
             uiUploadSuccess = true;
-        } else {
-            int errorCode = TARGZUnpacker->tarGzGetError();
-            debug(String(F("Extraktion fehlgeschlagen mit Fehler: ")) + errorCode);
-
-            switch (errorCode) {
-                case -1: uiUploadError = "Allgemeiner TAR-Lesefehler"; break;
-                case -2: uiUploadError = "Nicht genuegend Speicher fuer TAR-Extraktion"; break;
-                case -3: uiUploadError = "TAR-Header fehlerhaft"; break;
-                case -4: uiUploadError = "TAR-Datei fehlerhaft"; break;
-                case -5: uiUploadError = "Fehler beim Schreiben der extrahierten Dateien"; break;
-                default: uiUploadError = "Unbekannter Fehlercode " + String(errorCode); break;
-            }
-            debug(String(F("Fehler: ")) + uiUploadError);
+            return;
         }
 
-        // Clean up
-        debug(F("Aufräumen nach UI-Update"));
-        LittleFS.remove(uploadPath);
-        uploadPath = "";
+        // Zwischen Start und Ende geladene Dateien stammen noch von der alten UI
+        invalidateFileCache();
 
-        delete TARGZUnpacker;
+        LOG_I("UI-Update %s aktiv: %u Dateien, %lu KB geschrieben, %u unveraendert (%lu KB)", uiActiveVersion(),
+              installer.files(), (unsigned long)(installer.bytesWritten() / 1024), installer.filesSkipped(),
+              (unsigned long)(installer.bytesSkipped() / 1024));
+        LOG_I("  aus %lu KB Upload in %lu ms (Rollback: %s)", (unsigned long)(upload.totalSize / 1024),
+              (unsigned long)installer.elapsedMs(),
+              uiPreviousVersion().length() > 0 ? uiPreviousVersion() : String(F("keiner")));
+        uiUploadSuccess = true;
     }
 }
 
@@ -753,9 +752,9 @@ void handleApiStats() {
         String response;
         serializeJson(doc, response);
         server.send(200, "application/json", response);
-        debug(String(F("Stats from backend sent: ")) + response.length() + F(" bytes"));
+        LOG_D("Stats from backend sent: %u bytes", response.length());
     } else {
-        debug(F("Backend statistics fetch failed, sending 503"));
+        LOG_E("Backend statistics fetch failed, sending 503");
         server.send(503, "application/json", "{\"error\":\"Backend statistics unavailable\"}");
     }
 }
@@ -766,62 +765,161 @@ void logSystemStatus() {
     unsigned long currentMillis = millis();
 
     if (currentMillis - appState.lastStatusLog >= STATUS_LOG_INTERVAL) {
-        debug(F("=== SYSTEM STATUS ==="));
-        debug(String(F("Uptime: ")) + String(currentMillis / 1000 / 60) + F(" minutes"));
-        debug(String(F("Free Heap: ")) + String(ESP.getFreeHeap()) + F(" bytes"));
-        debug(String(F("WiFi Status: ")) + (WiFi.status() == WL_CONNECTED ? "Connected" : "Disconnected"));
-        debug(String(F("WiFi RSSI: ")) + String(WiFi.RSSI()) + F(" dBm"));
-        debug(String(F("MQTT Enabled: ")) + (appState.mqttEnabled ? "Yes" : "No"));
+        LOG_I("=== SYSTEM STATUS ===");
+        LOG_I("Uptime: %lu minutes", currentMillis / 1000 / 60);
+        LOG_I("Free Heap: %lu bytes", (unsigned long)ESP.getFreeHeap());
+        LOG_I("WiFi Status: %s", WiFi.status() == WL_CONNECTED ? "Connected" : "Disconnected");
+        LOG_I("WiFi RSSI: %d dBm", WiFi.RSSI());
+        LOG_I("MQTT Enabled: %s", appState.mqttEnabled ? "Yes" : "No");
         if (appState.mqttEnabled) {
-            debug(String(F("MQTT Status: ")) + (mqtt.isConnected() ? "Connected" : "Disconnected"));
+            LOG_I("MQTT Status: %s", mqtt.isConnected() ? "Connected" : "Disconnected");
         }
-        debug(String(F("LED Status: ")) + (appState.lightOn ? "ON" : "OFF") + ", Mode: " + (appState.autoMode ? "Auto" : "Manual"));
-        debug(String(F("Current Sentiment: ")) + String(appState.sentimentScore, 2) + F(" (") + appState.sentimentCategory + F(")"));
-        debug(String(F("DHT Values: T=")) + String(appState.currentTemp, 1) + F("C, H=") + String(appState.currentHum, 1) + F("%"));
-        debug(String(F("Intervals: Mood=")) + String(appState.moodUpdateInterval / 1000) + F("s, DHT=") + String(appState.dhtUpdateInterval / 1000) + F("s"));
-        debug(F("===================="));
+        LOG_I("LED Status: %s, Mode: %s", appState.lightOn ? "ON" : "OFF", appState.autoMode ? "Auto" : "Manual");
+        LOG_I("Current Sentiment: %.2f (%s)", appState.sentimentScore, appState.sentimentCategory);
+        LOG_I("DHT Values: T=%.1fC, H=%.1f%%", appState.currentTemp, appState.currentHum);
+        LOG_I("Intervals: Mood=%lus, DHT=%lus", appState.moodUpdateInterval / 1000, appState.dhtUpdateInterval / 1000);
+        LOG_I("====================");
 
         appState.lastStatusLog = currentMillis;
     }
 }
 
-// ===== Web-Server Setup =====
+// ===== Firmware fuer Moodlights im LAN =====
+// /api/update/peer-image schickt nur den Kopf. Das Image (~1,5 MB) geht danach
+// in Scheiben von UPDATE_PEER_SLICE je loop()-Durchlauf hinterher, damit LEDs,
+// MQTT und andere Anfragen bedient bleiben. Der Client gehoert ab dem Kopf
+// der Weitergabe; der WebServer schreibt nichts mehr darauf. Body-Bytes am
+// Wrapper vorbei zaehlt MeteredWebServer ohnehin ueber die Content-Length.
+struct PeerImageTransfer {
+    WiFiClient client;
+    const esp_partition_t *part = nullptr;     // nullptr = keine Weitergabe
+    size_t size = 0;
+    size_t offset = 0;
+    uint32_t startedMs = 0;
+};
+static PeerImageTransfer peerTransfer;
 
-void setupWebServer() {
+static void endPeerTransfer()
+{
+    peerTransfer.client.stop();
+    peerTransfer.client = WiFiClient();
+    peerTransfer.part = nullptr;
+}
+
+void servePeerImage()
+{
+    if (!peerTransfer.part) {
+        return;
+    }
+    // Die freie Partition wird womoeglich gerade beschrieben — die laufende nie
+    if (appState.updateInProgress && peerTransfer.part != esp_ota_get_running_partition()) {
+        LOG_W("Weitergabe der Firmware abgebrochen: Update laeuft");
+        endPeerTransfer();
+        return;
+    }
+
+    uint8_t buf[1024];
+    size_t sliceEnd = min(peerTransfer.offset + UPDATE_PEER_SLICE, peerTransfer.size);
+    while (peerTransfer.offset < sliceEnd) {
+        size_t n = min(sliceEnd - peerTransfer.offset, sizeof(buf));
+        if (!peerTransfer.client.connected() ||
+            esp_partition_read(peerTransfer.part, peerTransfer.offset, buf, n) != ESP_OK ||
+            peerTransfer.client.write(buf, n) != n) {
+            LOG_W("Weitergabe der Firmware abgebrochen nach %u von %u Bytes", peerTransfer.offset,
+                  peerTransfer.size);
+            endPeerTransfer();
+            return;
+        }
+        peerTransfer.offset += n;
+    }
+
+    if (peerTransfer.offset >= peerTransfer.size) {
+        LOG_I("Firmware weitergegeben: %u Bytes in %lu ms", peerTransfer.size,
+              (unsigned long)(millis() - peerTransfer.startedMs));
+        endPeerTransfer();
+    }
+}
+
+// ===== Routen-Tabelle =====
+// Jede Route steht hier genau einmal: Pfad, Methode, Antwortart, Handler und bei
+// Uploads der Upload-Handler. setupWebServer() registriert die Tabelle ueber einen
+// gemeinsamen Wrapper, der je Route Aufrufe, Handler-Zeit, gesendete Bytes und
+// Statusklassen mitschreibt — abrufbar unter GET /api/system/routes. So lassen
+// sich langsame Handler im Betrieb finden, ohne Debugger am Geraet.
+
+enum RouteKind : uint8_t {
+    ROUTE_STATIC,   // Dateien aus LittleFS
+    ROUTE_JSON,     // Liefert Daten
+    ROUTE_ACTION,   // Aendert Zustand oder stoesst etwas an
+    ROUTE_UPLOAD    // Datei-Upload mit eigenem Upload-Handler
+};
+
+struct WebRoute {
+    const char *path;
+    HTTPMethod method;
+    RouteKind kind;
+    void (*handler)();
+    void (*upload)();       // nullptr ausser bei ROUTE_UPLOAD
+};
+
+struct RouteStats {
+    uint32_t count;
+    uint32_t maxMicros;
+    uint64_t totalMicros;
+    uint64_t uploadMicros;  // Summe aller Upload-Chunks, getrennt von der Antwort
+    uint64_t bytes;
+    uint32_t status[4];     // 2xx, 3xx, 4xx, 5xx
+    uint32_t noResponse;    // Handler hat nichts gesendet
+
+    void record(uint32_t micros, size_t sent, int code) {
+        count++;
+        totalMicros += micros;
+        if (micros > maxMicros) maxMicros = micros;
+        bytes += sent;
+        if (code >= 200 && code < 600) {
+            status[code / 100 - 2]++;
+        } else {
+            noResponse++;
+        }
+    }
+};
+
+static void handleApiRoutes();
+static void handleApiCrashLog();
+
+static const WebRoute webRoutes[] = {
     // Statische Dateien aus LittleFS
-    server.on("/", HTTP_GET, []()
-              { handleStaticFile("/index.html"); });
+    {"/", HTTP_GET, ROUTE_STATIC, []() { handleStaticFile("/index.html"); }},
 
-    server.on("/setup", HTTP_GET, []()
-              { handleStaticFile("/setup.html"); });
+    {"/setup", HTTP_GET, ROUTE_STATIC, []() { handleStaticFile("/setup.html"); }},
 
-    server.on("/api/restart-counter", HTTP_GET, []() {
+    {"/api/restart-counter", HTTP_GET, ROUTE_JSON, []() {
         Preferences prefs;
         prefs.begin("syshealth", true);
         unsigned long restarts = prefs.getULong("restarts", 0);
         prefs.end();
         server.send(200, "application/json", "{\"restarts\":" + String(restarts) + "}");
-    });
+    }},
 
-    server.on("/api/reset-restart-counter", HTTP_GET, []() {
+    {"/api/reset-restart-counter", HTTP_GET, ROUTE_ACTION, []() {
         Preferences prefs;
         prefs.begin("syshealth", false);
         prefs.putULong("restarts", 0);
         prefs.end();
         server.send(200, "application/json", "{\"status\":\"ok\",\"restarts\":0}");
-        debug(F("Reboot-Counter zurückgesetzt"));
-    });
+        LOG_I("Reboot-Counter zurückgesetzt");
+    }},
 
-    server.on("/mood", HTTP_GET, []()
-              { handleStaticFile("/mood.html"); });
+    {"/mood", HTTP_GET, ROUTE_STATIC, []() { handleStaticFile("/mood.html"); }},
 
     // System diagnostics API endpoints (diagnostics page removed, APIs kept for debugging)
-    server.on("/api/system/metrics", HTTP_GET, []() {
+    {"/api/system/metrics", HTTP_GET, ROUTE_JSON, []() {
         JsonDocument doc;
 
         doc["heap"] = ESP.getFreeHeap();
         doc["maxBlock"] = ESP.getMaxAllocHeap();
         doc["minHeap"] = memMonitor.getLowestHeap();
+        doc["minMaxBlock"] = memMonitor.getLowestMaxBlock();
 
         uint64_t total, used, free;
         getStorageInfo(total, used, free);
@@ -844,7 +942,57 @@ void setupWebServer() {
         doc["mqttConnected"] = appState.mqttEnabled && mqtt.isConnected();
         doc["temperature"] = temperatureRead();
         doc["sentiment"] = appState.sentimentScore;
-        doc["sentimentCategory"] = appState.sentimentCategory;
+        doc["sentimentCategory"] = appState.sentimentCategory.c_str();
+
+        JsonObject boot = doc["boot"].to<JsonObject>();
+        JsonObject phases = boot["phasesMs"].to<JsonObject>();
+        uint32_t bootMicros = 0;
+        for (int i = 0; i < appState.bootPhaseCount; i++) {
+            phases[appState.bootPhaseNames[i]] = appState.bootPhaseMicros[i] / 1000.0f;
+            bootMicros += appState.bootPhaseMicros[i];
+        }
+        boot["totalMs"] = bootMicros / 1000;
+
+        JsonObject settings = doc["settings"].to<JsonObject>();
+        settings["source"] = settingsStats.source;
+        settings["loadUs"] = settingsStats.lastLoadMicros;
+        settings["saves"] = settingsStats.saves;
+        settings["skippedSaves"] = settingsStats.skippedSaves;
+        settings["failedSaves"] = settingsStats.failedSaves;
+        settings["lastSaveUs"] = settingsStats.lastSaveMicros;
+        settings["bytesWritten"] = settingsStats.bytesWritten;
+        settingsWriteStats(settings);
+
+        JsonObject log = doc["log"].to<JsonObject>();
+        log["records"] = logStats.records;
+        log["overwritten"] = logStats.overwritten;
+        log["bytes"] = logStats.bytesLogged;
+        log["truncated"] = logStats.truncatedArgs;
+        log["ringBytes"] = LOG_RING_BYTES;
+        log["serial"] = logSerialEnabled();
+        log["serialWritten"] = logStats.serialWritten;
+        log["serialDropped"] = logStats.serialDropped;
+        float cyclesPerUs = ESP.getCpuFreqMHz();
+        log["avgUs"] = logStats.calls > 0 ? logStats.totalCycles / logStats.calls / cyclesPerUs : 0;
+        log["maxUs"] = logStats.maxCycles / cyclesPerUs;
+        log["level"] = logLevelName(logLevel());
+        log["compileLevel"] = logLevelName(LOG_COMPILE_LEVEL);
+        JsonObject perLevel = log["perLevel"].to<JsonObject>();
+        for (uint8_t level = LOG_LEVEL_ERROR; level <= LOG_LEVEL_TRACE; level++) {
+            perLevel[logLevelName(level)] = logStats.perLevel[level];
+        }
+
+        JsonObject cache = doc["fileCache"].to<JsonObject>();
+        uint32_t lookups = fileCache.hits + fileCache.misses;
+        cache["entries"] = fileCache.count();
+        cache["bytes"] = (unsigned long)fileCache.usedBytes;
+        cache["budget"] = (unsigned long)fileCache.budget();
+        cache["hits"] = fileCache.hits;
+        cache["misses"] = fileCache.misses;
+        cache["hitRatio"] = lookups > 0 ? (float)fileCache.hits / lookups : 0;
+        cache["evictions"] = fileCache.evictions;
+        cache["bytesServed"] = (unsigned long)fileCache.bytesFromCache;
+        cache["flashMsSaved"] = (unsigned long)(fileCache.flashMicrosSaved / 1000);
 
         bool memoryOk = ESP.getFreeHeap() > 30000;
         bool fragmentationOk = (float)ESP.getMaxAllocHeap() / ESP.getFreeHeap() > 0.7;
@@ -863,10 +1011,60 @@ void setupWebServer() {
         size_t len = serializeJson(doc, jsonBuffer, JSON_BUFFER_SIZE);
         server.send(200, "application/json", jsonBuffer);
         jsonPool.release(jsonBuffer);
-    });
+    }},
+
+    // Log-Level zur Laufzeit: ?level=error|warn|info|debug|trace (oder 1-5),
+    // ?serial=0|1. Ohne Parameter nur der aktuelle Stand. Level oberhalb von
+    // compileLevel sind nicht im Binary und lassen sich nicht einschalten.
+    {"/api/system/loglevel", HTTP_GET, ROUTE_ACTION, []() {
+        if (server.hasArg("level")) {
+            LogLevel level;
+            if (!parseLogLevel(server.arg("level").c_str(), level)) {
+                server.send(400, "application/json",
+                            "{\"status\":\"error\",\"message\":\"Unbekanntes Level\"}");
+                return;
+            }
+            setLogLevel(level);
+            LOG_I("Log-Level: %s", logLevelName(level));
+        }
+        if (server.hasArg("serial")) {
+            setLogSerial(server.arg("serial") != "0");
+        }
 
-    server.on("/api/system/diagnose", HTTP_GET, []() {
-        debug(F("Vollständige Systemdiagnose angefordert"));
+        JsonDocument doc;
+        doc["status"] = "success";
+        doc["level"] = logLevelName(logLevel());
+        doc["compileLevel"] = logLevelName(LOG_COMPILE_LEVEL);
+        doc["serial"] = logSerialEnabled();
+        char* jsonBuffer = jsonPool.acquire();
+        serializeJson(doc, jsonBuffer, JSON_BUFFER_SIZE);
+        server.send(200, "application/json", jsonBuffer);
+        jsonPool.release(jsonBuffer);
+    }},
+
+    // Nachlese nach Panic/Watchdog ohne Serial-Kabel
+    {"/api/system/crashlog", HTTP_GET, ROUTE_JSON, handleApiCrashLog},
+
+    {"/api/system/crashlog/clear", HTTP_GET, ROUTE_ACTION, []() {
+#if CONFIG_ESP_COREDUMP_ENABLE_TO_FLASH
+        esp_err_t err = esp_core_dump_image_erase();
+        server.send(err == ESP_OK ? 200 : 500, "application/json",
+                    err == ESP_OK ? "{\"status\":\"success\"}"
+                                  : "{\"status\":\"error\",\"message\":\"Core-Dump nicht geloescht\"}");
+        if (err == ESP_OK) {
+            LOG_I("Core-Dump geloescht");
+        }
+#else
+        server.send(404, "application/json",
+                    "{\"status\":\"error\",\"message\":\"Core-Dump nicht aktiviert\"}");
+#endif
+    }},
+
+    // Aufrufe, Laufzeit und Bytes je Route (siehe Routen-Tabelle)
+    {"/api/system/routes", HTTP_GET, ROUTE_JSON, handleApiRoutes},
+
+    {"/api/system/diagnose", HTTP_GET, ROUTE_ACTION, []() {
+        LOG_I("Vollständige Systemdiagnose angefordert");
         memMonitor.diagnose();
         netDiag.fullAnalysis();
         sysHealth.performFullCheck();
@@ -880,10 +1078,10 @@ void setupWebServer() {
         size_t len = serializeJson(doc, jsonBuffer, JSON_BUFFER_SIZE);
         server.send(200, "application/json", jsonBuffer);
         jsonPool.release(jsonBuffer);
-    });
+    }},
 
-    server.on("/api/system/cleanup", HTTP_GET, []() {
-        debug(F("Dateisystem-Bereinigung angefordert"));
+    {"/api/system/cleanup", HTTP_GET, ROUTE_ACTION, []() {
+        LOG_I("Dateisystem-Bereinigung angefordert");
         int cleanedFiles = 0;
 
         // A-MITTEL: advance-then-delete-Muster (wie handleUiUpload Z. 429-434) —
@@ -899,7 +1097,7 @@ void setupWebServer() {
                     file = root.openNextFile(); // Naechste Datei VOR dem Loeschen holen
                     if (LittleFS.remove(filePath)) {
                         cleanedFiles++;
-                        debug(String(F("Gelöscht: ")) + filePath);
+                        LOG_I("Gelöscht: %s", filePath);
                     }
                 }
             }
@@ -919,7 +1117,7 @@ void setupWebServer() {
                     if (filePath.endsWith(".tmp")) {
                         if (LittleFS.remove(filePath)) {
                             cleanedFiles++;
-                            debug(String(F("Gelöscht: ")) + filePath);
+                            LOG_I("Gelöscht: %s", filePath);
                         }
                     }
                 }
@@ -940,21 +1138,21 @@ void setupWebServer() {
         size_t len = serializeJson(doc, jsonBuffer, JSON_BUFFER_SIZE);
         server.send(200, "application/json", jsonBuffer);
         jsonPool.release(jsonBuffer);
-    });
+    }},
 
     // API-Endpunkte für dynamische Daten
-    server.on("/api/status", HTTP_GET, handleApiStatus);
-    server.on("/api/stats", HTTP_GET, handleApiStats);
+    {"/api/status", HTTP_GET, ROUTE_JSON, handleApiStatus},
+    {"/api/stats", HTTP_GET, ROUTE_JSON, handleApiStats},
     // REMOVED v9.0: RSS feeds now managed in backend
-    // server.on("/api/feeds", HTTP_GET, handleApiGetFeeds);
-    // server.on("/api/feeds", HTTP_POST, handleApiSaveFeeds);
+    // {"/api/feeds", HTTP_GET, ROUTE_JSON, handleApiGetFeeds},
+    // {"/api/feeds", HTTP_POST, ROUTE_ACTION, handleApiSaveFeeds},
 
-    server.on("/api/storage", HTTP_GET, handleApiStorageInfo);
+    {"/api/storage", HTTP_GET, ROUTE_JSON, handleApiStorageInfo},
     // v9.0: Archive endpoints disabled - data managed in backend
     // setupArchiveEndpoints();
 
     // Additional common files
-    server.on("/favicon.ico", HTTP_GET, []() {
+    {"/favicon.ico", HTTP_GET, ROUTE_STATIC, []() {
         if (LittleFS.exists("/favicon.ico")) {
             File file = LittleFS.open("/favicon.ico", "r");
             server.sendHeader("Cache-Control", "public, max-age=86400");
@@ -964,30 +1162,59 @@ void setupWebServer() {
             server.sendHeader("Cache-Control", "public, max-age=86400");
             server.send(204); // No content
         }
-    });
+    }},
 
     // For CSS and JS files that might be missing
-    server.on("/css/style.css", HTTP_GET, []() { handleStaticFile("/css/style.css"); });
-    server.on("/css/mood.css", HTTP_GET, []() { handleStaticFile("/css/mood.css"); });
-    server.on("/js/script.js", HTTP_GET, []() { handleStaticFile("/js/script.js"); });
-    server.on("/js/mood.js", HTTP_GET, []() { handleStaticFile("/js/mood.js"); });
-    server.on("/js/setup.js", HTTP_GET, []() { handleStaticFile("/js/setup.js"); });
+    {"/css/style.css", HTTP_GET, ROUTE_STATIC, []() { handleStaticFile("/css/style.css"); }},
+    {"/css/mood.css", HTTP_GET, ROUTE_STATIC, []() { handleStaticFile("/css/mood.css"); }},
+    {"/js/script.js", HTTP_GET, ROUTE_STATIC, []() { handleStaticFile("/js/script.js"); }},
+    {"/js/mood.js", HTTP_GET, ROUTE_STATIC, []() { handleStaticFile("/js/mood.js"); }},
+    {"/js/setup.js", HTTP_GET, ROUTE_STATIC, []() { handleStaticFile("/js/setup.js"); }},
 
-    server.on("/ui-upload", HTTP_POST,
+    {"/ui-upload", HTTP_POST, ROUTE_UPLOAD,
         []() {
             // A-HOCH-4: Completion-Handler wertet das statische Erfolgs-/Fehlerflag aus
             // statt bedingungslos 200 zu senden
             if (uiUploadSuccess) {
                 server.send(200, "text/html", "<html><body><h1>UI Update Complete</h1><a href='/setup'>Return to Setup</a></body></html>");
             } else {
+                // Ohne UI wird auch die Firmware nicht mehr geschickt
+                if (uiUploadStage) {
+                    updateTxnAbort();
+                }
                 String errMsg = uiUploadError.length() > 0 ? uiUploadError : "Unbekannter Fehler";
                 server.send(500, "text/plain; charset=utf-8", "UI-Update fehlgeschlagen: " + errMsg);
             }
         },
         handleUiUpload
-    );
+    },
+
+    // Vorherige UI-Version wieder aktivieren — sie bleibt nach jedem Upload liegen
+    {"/api/ui/rollback", HTTP_POST, ROUTE_ACTION, []() {
+        // Eine laufende Installation verweist womoeglich gerade auf Dateien der
+        // aktiven Version — nicht unter ihr umschalten
+        if (appState.updateInProgress) {
+            server.send(409, "application/json",
+                        "{\"status\":\"error\",\"message\":\"Es laeuft gerade ein Update\"}");
+            return;
+        }
+        if (!uiRollback()) {
+            server.send(409, "application/json",
+                        "{\"status\":\"error\",\"message\":\"Keine vorherige UI-Version vorhanden\"}");
+            return;
+        }
+        JsonDocument doc;
+        doc["status"] = "success";
+        doc["version"] = uiActiveVersion();
+        doc["previous"] = uiPreviousVersion();
+
+        char* jsonBuffer = jsonPool.acquire();
+        serializeJson(doc, jsonBuffer, JSON_BUFFER_SIZE);
+        server.send(200, "application/json", jsonBuffer);
+        jsonPool.release(jsonBuffer);
+    }},
 
-    server.on("/api/settings/hardware", HTTP_GET, []() {
+    {"/api/settings/hardware", HTTP_GET, ROUTE_JSON, []() {
         JsonDocument doc;
 
         doc["ledPin"] = appState.ledPin;
@@ -998,16 +1225,16 @@ void setupWebServer() {
         size_t len = serializeJson(doc, jsonBuffer, JSON_BUFFER_SIZE);
         server.send(200, "application/json", jsonBuffer);
         jsonPool.release(jsonBuffer);
-    });
+    }},
 
     // v9.0: CSV export removed - stats managed in backend
     // A-NIEDRIG: /api/export/settings entfernt — verwaist, keine UI-Referenz
 
     // Neue API-Endpunkte für Einstellungen
-    server.on("/api/settings/api", HTTP_GET, []() {
+    {"/api/settings/api", HTTP_GET, ROUTE_JSON, []() {
         JsonDocument doc;
 
-        doc["apiUrl"] = appState.apiUrl;
+        doc["apiUrl"] = appState.apiUrl.c_str();
         doc["moodInterval"] = appState.moodUpdateInterval / 1000;
         doc["dhtInterval"] = appState.dhtUpdateInterval / 1000;
         // v9.0: headlinesPerSource removed
@@ -1017,23 +1244,20 @@ void setupWebServer() {
         size_t len = serializeJson(doc, jsonBuffer, JSON_BUFFER_SIZE);
         server.send(200, "application/json", jsonBuffer);
         jsonPool.release(jsonBuffer);
-    });
+    }},
 
-    server.on("/api/settings/mqtt", HTTP_GET, []() {
+    {"/api/settings/mqtt", HTTP_GET, ROUTE_JSON, []() {
         JsonDocument doc;
 
-        doc["enabled"] = appState.mqttEnabled;
-        doc["server"] = appState.mqttServer;
-        doc["user"] = appState.mqttUser;
-        doc["pass"] = "****";
+        settingsFormJson(SETTING_FORM_MQTT, doc);
 
         char* jsonBuffer = jsonPool.acquire();
         size_t len = serializeJson(doc, jsonBuffer, JSON_BUFFER_SIZE);
         server.send(200, "application/json", jsonBuffer);
         jsonPool.release(jsonBuffer);
-    });
+    }},
 
-    server.on("/api/settings/colors", HTTP_GET, []() {
+    {"/api/settings/colors", HTTP_GET, ROUTE_JSON, []() {
         JsonDocument doc;
 
         JsonArray colors = doc["colors"].to<JsonArray>();
@@ -1057,12 +1281,15 @@ void setupWebServer() {
         size_t len = serializeJson(doc, jsonBuffer, JSON_BUFFER_SIZE);
         server.send(200, "application/json", jsonBuffer);
         jsonPool.release(jsonBuffer);
-    });
+    }},
 
-    server.on("/api/system/info", HTTP_GET, []() {
+    {"/api/system/info", HTTP_GET, ROUTE_JSON, []() {
         JsonDocument doc;
 
         doc["version"] = getCurrentUiVersion();
+        if (uiPreviousVersion().length() > 0) {
+            doc["uiPrevious"] = uiPreviousVersion();
+        }
         doc["firmwareVersion"] = getCurrentFirmwareVersion();
         doc["chip"] = ESP.getChipModel();
 
@@ -1077,43 +1304,37 @@ void setupWebServer() {
         size_t len = serializeJson(doc, jsonBuffer, JSON_BUFFER_SIZE);
         server.send(200, "application/json", jsonBuffer);
         jsonPool.release(jsonBuffer);
-    });
-
-    // WiFi Scan Endpunkt
-    server.on("/wifiscan", HTTP_GET, []() {
-        String jsonResult = scanWiFiNetworks();
-        server.send(200, "application/json", jsonResult);
-    });
+    }},
+
+    // WiFi Scan Endpunkt — startet den Scan (202 + Job-ID) oder liefert ein
+    // frisches Ergebnis. Nachfragen mit ?job=<id>, ?refresh=1 erzwingt einen Neuscan.
+    {"/wifiscan", HTTP_GET, ROUTE_JSON, []() {
+        uint32_t job = server.hasArg("job") ? (uint32_t)server.arg("job").toInt()
+                                            : startWiFiScan(server.hasArg("refresh"));
+        String json;
+        int code = wifiScanResponse(job, json);
+        server.send(code, "application/json", json);
+    }},
 
     // WiFi Einstellungen speichern
-    server.on("/savewifi", HTTP_POST, []() {
+    {"/savewifi", HTTP_POST, ROUTE_ACTION, []() {
         String jsonStr = server.arg("plain");
         JsonDocument doc;
         DeserializationError error = deserializeJson(doc, jsonStr);
 
         if (error) {
-            debug(String(F("JSON Parsing Fehler: ")) + error.c_str());
+            LOG_E("JSON Parsing Fehler: %s", error.c_str());
             server.send(400, "text/plain", "JSON Parsing Fehler");
             return;
         }
 
-        // Werte aus JSON extrahieren und validieren
-        String newSsid = doc["ssid"].as<String>();
-        String newPass = doc["pass"].as<String>();
-
-        if (newSsid.length() < 1 || newSsid.length() > 32) {
-            debug(F("Ungueltige SSID-Laenge"));
-            server.send(400, "text/plain", "SSID muss 1-32 Zeichen lang sein");
+        // ssid (1-32 Zeichen) und pass (bis 63) laut Einstellungsschema
+        String inputError;
+        if (applySettingsForm(SETTING_FORM_WIFI, doc.as<JsonVariantConst>(), inputError) < 0) {
+            LOG_W("WiFi-Einstellungen abgelehnt: %s", inputError);
+            server.send(400, "text/plain", inputError);
             return;
         }
-        if (newPass.length() > 63) {
-            debug(F("Ungueltige WiFi-Passwort-Laenge"));
-            server.send(400, "text/plain", "Passwort darf maximal 63 Zeichen lang sein");
-            return;
-        }
-
-        appState.wifiSSID = newSsid;
-        appState.wifiPassword = newPass;
         appState.wifiConfigured = true;
 
         // Einstellungen speichern
@@ -1125,11 +1346,11 @@ void setupWebServer() {
         appState.rebootTime = millis() + REBOOT_DELAY;
 
         server.send(200, "text/plain", "OK");
-        debug(F("Neue WiFi-Einstellungen gespeichert, Reboot geplant"));
-    });
+        LOG_I("Neue WiFi-Einstellungen gespeichert, Reboot geplant");
+    }},
 
     // WiFi zurücksetzen
-    server.on("/resetwifi", HTTP_POST, []() {
+    {"/resetwifi", HTTP_POST, ROUTE_ACTION, []() {
         appState.wifiSSID = "";
         appState.wifiPassword = "";
         appState.wifiConfigured = false;
@@ -1143,54 +1364,31 @@ void setupWebServer() {
         appState.rebootTime = millis() + REBOOT_DELAY;
 
         server.send(200, "text/plain", "OK");
-        debug(F("WiFi-Einstellungen zurückgesetzt, Reboot geplant"));
-    });
+        LOG_I("WiFi-Einstellungen zurückgesetzt, Reboot geplant");
+    }},
 
     // MQTT Einstellungen speichern
-    server.on("/savemqtt", HTTP_POST, []() {
+    {"/savemqtt", HTTP_POST, ROUTE_ACTION, []() {
         String jsonStr = server.arg("plain");
         JsonDocument doc;
         DeserializationError error = deserializeJson(doc, jsonStr);
 
         if (error) {
-            debug(String(F("JSON Parsing Fehler: ")) + error.c_str());
+            LOG_E("JSON Parsing Fehler: %s", error.c_str());
             server.send(400, "text/plain", "JSON Parsing Fehler");
             return;
         }
 
-        bool changed = false;
-
-        // Werte aus JSON extrahieren — nur vorhandene Keys uebernehmen
-        if (doc["enabled"].is<bool>()) {
-            bool newEnabled = doc["enabled"].as<bool>();
-            if (newEnabled != appState.mqttEnabled) {
-                appState.mqttEnabled = newEnabled;
-                changed = true;
-            }
-        }
-        if (doc["server"].is<const char*>()) {
-            String newServer = doc["server"].as<String>();
-            if (newServer != appState.mqttServer) {
-                appState.mqttServer = newServer;
-                changed = true;
-            }
-        }
-        if (doc["user"].is<const char*>()) {
-            String newUser = doc["user"].as<String>();
-            if (newUser != appState.mqttUser) {
-                appState.mqttUser = newUser;
-                changed = true;
-            }
-        }
-        // Passwort nur uebernehmen wenn nicht leer/maskiert — sonst wuerde die
-        // Maske "****" das echte Passwort ueberschreiben (A-HOCH-2)
-        if (doc["pass"].is<const char*>()) {
-            String newPass = doc["pass"].as<String>();
-            if (newPass != "****" && newPass.length() > 0 && newPass != appState.mqttPassword) {
-                appState.mqttPassword = newPass;
-                changed = true;
-            }
+        // Nur vorhandene Keys — ein leeres bzw. maskiertes Passwort laesst das
+        // gespeicherte stehen (A-HOCH-2, SETTING_KEEP_EMPTY im Schema)
+        String inputError;
+        int changedFields = applySettingsForm(SETTING_FORM_MQTT, doc.as<JsonVariantConst>(), inputError);
+        if (changedFields < 0) {
+            LOG_W("MQTT-Einstellungen abgelehnt: %s", inputError);
+            server.send(400, "text/plain", inputError);
+            return;
         }
+        bool changed = changedFields > 0;
 
         if (changed) {
             // Einstellungen speichern
@@ -1202,77 +1400,50 @@ void setupWebServer() {
             appState.rebootTime = millis() + REBOOT_DELAY;
 
             server.send(200, "text/plain", "OK");
-            debug(F("MQTT-Einstellungen gespeichert, Reboot geplant"));
+            LOG_I("MQTT-Einstellungen gespeichert, Reboot geplant");
         } else {
-            debug(F("MQTT-Einstellungen: Keine Aenderungen erkannt."));
+            LOG_I("MQTT-Einstellungen: Keine Aenderungen erkannt.");
             server.send(200, "text/plain; charset=utf-8", "Keine Änderungen");
         }
-    });
+    }},
 
     // API und Intervall Einstellungen speichern (ohne Neustart)
-    server.on("/saveapi", HTTP_POST, []() {
+    {"/saveapi", HTTP_POST, ROUTE_ACTION, []() {
         String jsonStr = server.arg("plain");
         JsonDocument doc;
         DeserializationError error = deserializeJson(doc, jsonStr);
 
         if (error) {
-            debug(String(F("JSON Parsing Fehler: ")) + error.c_str());
+            LOG_E("JSON Parsing Fehler: %s", error.c_str());
             server.send(400, "text/plain", "JSON Parsing Fehler");
             return;
         }
 
-        bool changed = false;
-
-        // Werte aus JSON extrahieren und globale Variablen aktualisieren
-        if (doc["apiUrl"].is<const char*>()) {
-            String newApiUrl = doc["apiUrl"].as<String>();
-            if (newApiUrl.length() == 0 || !newApiUrl.startsWith("http")) {
-                debug(F("Ungueltige API-URL abgelehnt"));
-                server.send(400, "text/plain", "API-URL muss mit http/https beginnen");
-                return;
-            }
-            if (newApiUrl != appState.apiUrl) {
-                appState.apiUrl = newApiUrl;
-                appState.lastMoodUpdate = 0;  // Erzwinge Sentiment-Update bei nächster Gelegenheit
-                changed = true;
-                debug(String(F("API URL geändert zu: ")) + appState.apiUrl);
-            }
-        }
-        if (doc["moodInterval"].is<float>()) {
-            unsigned long moodSeconds = constrain(doc["moodInterval"].as<unsigned long>(), 10UL, 7200UL);  // Mind. 10s, Max 2h — vor der Multiplikation clampen (32-Bit-Overflow-Schutz)
-            unsigned long newMoodInterval = 1000UL * moodSeconds;
-            if (newMoodInterval != appState.moodUpdateInterval) {
-                appState.moodUpdateInterval = newMoodInterval;
-                changed = true;
-                debug(String(F("Mood Interval geändert zu: ")) + String(appState.moodUpdateInterval / 1000) + F("s"));
-            }
-        }
-        if (doc["dhtEnabled"].is<bool>() || doc["dhtEnabled"].is<int>() || doc["dhtEnabled"].is<float>()) {
-            bool newDhtEnabled = doc["dhtEnabled"].is<bool>()
-                ? doc["dhtEnabled"].as<bool>()
-                : (doc["dhtEnabled"].as<float>() != 0);
-            if (newDhtEnabled != appState.dhtEnabled) {
-                appState.dhtEnabled = newDhtEnabled;
-                changed = true;
-                debug(String(F("DHT Enabled geändert zu: ")) + (appState.dhtEnabled ? "ja" : "nein"));
-            }
+        // Eine URL ohne http(s) waere kein Backend — das kann das Schema nicht pruefen
+        if (doc["apiUrl"].is<const char*>() && strncmp(doc["apiUrl"].as<const char*>(), "http", 4) != 0) {
+            LOG_I("Ungueltige API-URL abgelehnt");
+            server.send(400, "text/plain", "API-URL muss mit http/https beginnen");
+            return;
         }
-        // v9.0: headlinesPerSource removed - only for legacy API endpoints
 
-        // NEU: DHT Intervall hier verarbeiten
-        if (doc["dhtInterval"].is<float>()) {
-            unsigned long dhtSeconds = constrain(doc["dhtInterval"].as<unsigned long>(), 10UL, 3600UL);  // Mind. 10s, Max 1h — vor der Multiplikation clampen (32-Bit-Overflow-Schutz)
-            unsigned long newDhtInterval = 1000UL * dhtSeconds;
-            if (newDhtInterval != appState.dhtUpdateInterval) {
-                appState.dhtUpdateInterval = newDhtInterval;
-                changed = true;
-                debug(String(F("DHT Interval geändert zu: ")) + String(appState.dhtUpdateInterval / 1000) + F("s"));
-            }
+        // Laenge der URL, Intervalle (Sekunden, begrenzt) und dhtEnabled laut
+        // Einstellungsschema; eine zu lange URL wird abgelehnt, nicht gekuerzt
+        decltype(appState.apiUrl) previousApiUrl = appState.apiUrl;
+        String inputError;
+        int changedFields = applySettingsForm(SETTING_FORM_API, doc.as<JsonVariantConst>(), inputError);
+        if (changedFields < 0) {
+            LOG_W("API-Einstellungen abgelehnt: %s", inputError);
+            server.send(400, "text/plain", inputError);
+            return;
+        }
+        if (appState.apiUrl != previousApiUrl) {
+            appState.lastMoodUpdate = 0;  // Erzwinge Sentiment-Update bei nächster Gelegenheit
+            LOG_I("API URL geändert zu: %s", appState.apiUrl);
         }
 
         // Nur speichern und HA updaten, wenn sich tatsächlich etwas geändert hat
-        if (changed) {
-            debug(F("API/Intervall-Einstellungen geändert. Speichere und aktualisiere HA..."));
+        if (changedFields > 0) {
+            LOG_I("API/Intervall-Einstellungen geändert. Speichere und aktualisiere HA...");
             // Einstellungen speichern
             appState.settingsNeedSaving = true;
             appState.lastSettingsSaved = millis();
@@ -1281,90 +1452,70 @@ void setupWebServer() {
             if (appState.mqttEnabled && mqtt.isConnected()) {
                 // API Update Interval
                 haUpdateInterval.setState(float(appState.moodUpdateInterval / 1000.0));
-                debug(String(F("  HA: haUpdateInterval auf ")) + String(appState.moodUpdateInterval / 1000.0) + F("s gesetzt."));
+                LOG_D("  HA: haUpdateInterval auf %.2fs gesetzt.", appState.moodUpdateInterval / 1000.0);
 
                 // v9.0: haHeadlinesPerSource removed
 
                 // DHT Update Interval
                 haDhtInterval.setState(float(appState.dhtUpdateInterval / 1000.0));
-                debug(String(F("  HA: haDhtInterval auf ")) + String(appState.dhtUpdateInterval / 1000.0) + F("s gesetzt."));
+                LOG_D("  HA: haDhtInterval auf %.2fs gesetzt.", appState.dhtUpdateInterval / 1000.0);
             } else {
-                debug(F("  HA: MQTT nicht verbunden, Zustände nicht gesendet."));
+                LOG_D("  HA: MQTT nicht verbunden, Zustände nicht gesendet.");
             }
             server.send(200, "text/plain", "OK");
-            debug(F("API/Intervall-Einstellungen erfolgreich gespeichert und HA aktualisiert (falls verbunden)."));
+            LOG_I("API/Intervall-Einstellungen erfolgreich gespeichert und HA aktualisiert (falls verbunden).");
         } else {
-            debug(F("API/Intervall-Einstellungen: Keine Änderungen erkannt."));
+            LOG_I("API/Intervall-Einstellungen: Keine Änderungen erkannt.");
             server.send(200, "text/plain; charset=utf-8", "Keine Änderungen");
         }
-    });
+    }},
 
     // Farben speichern
-    server.on("/savecolors", HTTP_POST, []() {
+    {"/savecolors", HTTP_POST, ROUTE_ACTION, []() {
         String jsonStr = server.arg("plain");
         JsonDocument doc;
         DeserializationError error = deserializeJson(doc, jsonStr);
 
         if (error) {
-            debug(String(F("JSON Parsing Fehler: ")) + error.c_str());
+            LOG_E("JSON Parsing Fehler: %s", error.c_str());
             server.send(400, "text/plain", "JSON Parsing Fehler");
             return;
         }
 
-        // Farben aus JSON extrahieren — in temporaeres Array parsen, nur bei
-        // vollstaendigem Erfolg komplett uebernehmen (kein Teilzustand bei Parse-Fehler)
-        if (doc["colors"].is<JsonArray>()) {
-            JsonArray colorArray = doc["colors"].as<JsonArray>();
-            uint32_t tempColors[5];
-            int index = 0;
-
-            bool parseError = false;
-            for (JsonVariant colorValue : colorArray) {
-                if (index < 5 && colorValue.is<String>()) {
-                    String hexColor = colorValue.as<String>();
-                    const char* hexStr = hexColor.c_str();
-                    if (hexStr[0] == '#') hexStr++; // führendes '#' überspringen
-                    uint32_t rgb = 0;
-                    if (sscanf(hexStr, "%x", &rgb) != 1) {
-                        debug(String(F("Ungültiger Farbwert ignoriert: ")) + hexColor);
-                        parseError = true;
-                        index++;
-                        continue;
-                    }
-                    tempColors[index] = rgb & 0xFFFFFF;
-                    index++;
-                }
-            }
-
-            if (parseError || index != 5) {
-                server.send(400, "text/plain; charset=utf-8", "Ungültiger Farbwert");
-                return;
-            }
-
-            // Nur komplett uebernehmen
-            for (int i = 0; i < 5; i++) {
-                appState.customColors[i] = tempColors[i];
-            }
+        // Alle fuenf Farben als "#RRGGBB" laut Einstellungsschema. Ein Teil-Array
+        // liesse die uebrigen stehen; ein ungueltiger Wert verwirft alle.
+        if (!doc["colors"].is<JsonArray>() || doc["colors"].size() != 5) {
+            server.send(400, "text/plain; charset=utf-8", "Ungültiges Farbformat");
+            return;
+        }
+        String inputError;
+        int changedFields = applySettingsForm(SETTING_FORM_COLORS, doc.as<JsonVariantConst>(), inputError);
+        if (changedFields < 0) {
+            LOG_W("Farbeinstellungen abgelehnt: %s", inputError);
+            server.send(400, "text/plain; charset=utf-8", "Ungültiger Farbwert");
+            return;
+        }
 
+        if (changedFields > 0) {
             // Einstellungen speichern
             appState.settingsNeedSaving = true;
             appState.lastSettingsSaved = millis();
-
-            server.send(200, "text/plain", "OK");
-            debug(F("Farbeinstellungen gespeichert."));
-        } else {
-            server.send(400, "text/plain; charset=utf-8", "Ungültiges Farbformat");
         }
-    });
 
-    // API testen
-    server.on("/testapi", HTTP_POST, []() {
+        server.send(200, "text/plain", "OK");
+        LOG_I("Farbeinstellungen gespeichert.");
+    }},
+
+    // API testen — die Messung laeuft im Hintergrund (api_probe.cpp), die Antwort
+    // kommt sofort mit 202 + Job-ID. Ergebnis mit Zeitaufschluesselung unter
+    // GET /testapi/status?job=<id>
+    {"/testapi", HTTP_POST, ROUTE_ACTION, []() {
         String jsonStr = server.arg("plain");
         JsonDocument doc;
         DeserializationError error = deserializeJson(doc, jsonStr);
 
         if (error) {
-            debug(String(F("JSON Parsing Fehler: ")) + error.c_str());
+            LOG_E("JSON Parsing Fehler: %s", error.c_str());
             server.send(400, "application/json", "{\"success\":false,\"message\":\"JSON Parsing Fehler\"}");
             return;
         }
@@ -1373,122 +1524,47 @@ void setupWebServer() {
         String testApiUrl = doc["apiUrl"].as<String>();
         // v9.0: headlinesPerSource removed - not needed for new API endpoints
 
-        // API testen
-        HTTPClient http;
-        http.setReuse(false);
-        http.setUserAgent("MoodlightClient/1.0");
-
-        debug(String(F("Teste API URL: ")) + testApiUrl);
-
-        if (http.begin(wifiClientHTTP, testApiUrl)) {
-            http.setTimeout(10000);
-            int httpCode = http.GET();
-
-            if (httpCode == HTTP_CODE_OK) {
-                WiFiClient* stream = http.getStreamPtr();
-                JsonDocument testDoc;
-                DeserializationError testError = deserializeJson(testDoc, *stream);
-
-                if (!testError) {
-                    if (testDoc["sentiment"].is<float>()) {
-                        float sentimentValue = testDoc["sentiment"].as<float>();
-                        debug(String(F("API Test erfolgreich! Sentiment: ")) + String(sentimentValue, 2));
-
-                        JsonDocument resultDoc;
-                        resultDoc["success"] = true;
-                        resultDoc["sentiment"] = sentimentValue;
-
-                        String resultJson;
-                        serializeJson(resultDoc, resultJson);
-                        http.end();
-                        server.send(200, "application/json", resultJson);
-                        return;
-                    } else {
-                        debug(F("API Test: JSON enthält keinen gültigen 'sentiment' Wert"));
-                        http.end();
-                        server.send(200, "application/json", "{\"success\":false,\"message\":\"JSON enthält keinen gültigen 'sentiment' Wert\"}");
-                        return;
-                    }
-                } else {
-                    debug(String(F("API Test: JSON Parsing Fehler: ")) + testError.c_str());
-                    http.end();
-                    server.send(200, "application/json", "{\"success\":false,\"message\":\"JSON Parsing Fehler: " + String(testError.c_str()) + "\"}");
-                    return;
-                }
-            } else {
-                debug(String(F("API Test: HTTP Fehler: ")) + String(httpCode));
-                http.end();
-                server.send(200, "application/json", "{\"success\":false,\"message\":\"HTTP Fehler: " + String(httpCode) + "\"}");
-                return;
-            }
-            http.end();
-        } else {
-            debug(String(F("API Test: Verbindungsfehler zu: ")) + testApiUrl);
-            server.send(200, "application/json", "{\"success\":false,\"message\":\"Verbindungsfehler zur API\"}");
+        uint32_t job = startApiProbe(testApiUrl);
+        if (job == 0) {
+            server.send(503, "application/json", "{\"success\":false,\"message\":\"API-Test konnte nicht gestartet werden\"}");
             return;
         }
-    });
+        String json;
+        int code = apiProbeResponse(job, json);
+        server.send(code, "application/json", json);
+    }},
+
+    {"/testapi/status", HTTP_GET, ROUTE_JSON, []() {
+        String json;
+        int code = apiProbeResponse((uint32_t)server.arg("job").toInt(), json);
+        server.send(code, "application/json", json);
+    }},
 
     // Hardware Einstellungen speichern (nur Pin/LEDs, erfordert Neustart)
-    server.on("/savehardware", HTTP_POST, []() {
+    {"/savehardware", HTTP_POST, ROUTE_ACTION, []() {
         String jsonStr = server.arg("plain");
         JsonDocument doc;
         DeserializationError error = deserializeJson(doc, jsonStr);
 
         if (error) {
-            debug(String(F("JSON Parsing Fehler: ")) + error.c_str());
+            LOG_E("JSON Parsing Fehler: %s", error.c_str());
             server.send(400, "text/plain", "JSON Parsing Fehler");
             return;
         }
 
-        bool needsReboot = false;
-        String rejectedPins = "";
-
-        // Werte aus JSON extrahieren und prüfen, ob Änderung vorliegt
-        // Pins 6-11 sind intern mit dem Flash verbunden — deren Nutzung würde das Gerät bricken
-        if (doc["ledPin"].is<int>()) {
-            int newLedPin = doc["ledPin"].as<int>();
-            if (newLedPin >= 0 && newLedPin <= 39 && !(newLedPin >= 6 && newLedPin <= 11)) {
-                if (newLedPin != appState.ledPin) {
-                    appState.ledPin = newLedPin;
-                    needsReboot = true;  // Pin-Änderung erfordert Neustart
-                }
-            } else {
-                debug(String(F("Ungültiger LED-Pin ignoriert: ")) + newLedPin);
-                rejectedPins += "ledPin=" + String(newLedPin) + " ";
-            }
-        }
-        if (doc["dhtPin"].is<int>()) {
-            int newDhtPin = doc["dhtPin"].as<int>();
-            if (newDhtPin >= 0 && newDhtPin <= 39 && !(newDhtPin >= 6 && newDhtPin <= 11)) {
-                if (newDhtPin != appState.dhtPin) {
-                    appState.dhtPin = newDhtPin;
-                    needsReboot = true;  // Pin-Änderung erfordert Neustart
-                }
-            } else {
-                debug(String(F("Ungültiger DHT-Pin ignoriert: ")) + newDhtPin);
-                rejectedPins += "dhtPin=" + String(newDhtPin) + " ";
-            }
-        }
-
-        if (doc["numLeds"].is<int>()) {
-            int newNumLeds = constrain(doc["numLeds"].as<int>(), 1, MAX_LEDS);
-            if (newNumLeds != appState.numLeds) {
-                appState.numLeds = newNumLeds;
-                appState.statusLedIndex = appState.numLeds - 1;
-                needsReboot = true;  // LED-Anzahl-Änderung erfordert Neustart
-            }
-        }
-
-        // DHT Intervall wird hier NICHT mehr verarbeitet
-
-        if (rejectedPins.length() > 0 && !needsReboot) {
-            // Nur abgelehnte Pins, keine sonstige Aenderung — Fehler statt stillem Ignorieren melden
-            server.send(400, "text/plain; charset=utf-8", "Ungueltige Pin-Werte abgelehnt: " + rejectedPins);
+        // Pins (ohne die Flash-Pins 6-11) und LED-Anzahl laut Einstellungsschema.
+        // Ein ungueltiger Pin lehnt das ganze Formular ab, statt ihn still zu
+        // uebergehen.
+        String inputError;
+        int changedFields = applySettingsForm(SETTING_FORM_HARDWARE, doc.as<JsonVariantConst>(), inputError);
+        if (changedFields < 0) {
+            LOG_W("Hardware-Einstellungen abgelehnt: %s", inputError);
+            server.send(400, "text/plain; charset=utf-8", inputError);
             return;
         }
 
-        if (needsReboot) {
+        // Pin- und LED-Aenderungen greifen erst nach dem Neustart
+        if (changedFields > 0) {
             // Einstellungen speichern (nur wenn relevant)
             appState.settingsNeedSaving = true;
             appState.lastSettingsSaved = millis();  // Speichert die geänderten Pins/LEDs
@@ -1497,34 +1573,34 @@ void setupWebServer() {
             appState.rebootNeeded = true;
             appState.rebootTime = millis() + REBOOT_DELAY;
 
-            String response = "OK";
-            if (rejectedPins.length() > 0) {
-                response += " (Ungueltige Pins ignoriert: " + rejectedPins + ")";
-            }
-            server.send(200, "text/plain; charset=utf-8", response);
-            debug(F("Hardware Pin/LED-Einstellungen gespeichert, Reboot geplant"));
+            server.send(200, "text/plain", "OK");
+            LOG_I("Hardware Pin/LED-Einstellungen gespeichert, Reboot geplant");
         } else {
-            debug(F("Hardware Pin/LED-Einstellungen: Keine Änderungen erkannt."));
+            LOG_I("Hardware Pin/LED-Einstellungen: Keine Änderungen erkannt.");
             server.send(200, "text/plain; charset=utf-8", "Keine Änderungen");
         }
-    });
+    }},
 
     // Factory Reset - Alle Einstellungen zurücksetzen
-    server.on("/factoryreset", HTTP_POST, []() {
-        debug(F("Factory Reset angefordert"));
+    {"/factoryreset", HTTP_POST, ROUTE_ACTION, []() {
+        LOG_I("Factory Reset angefordert");
 
         // Preferences komplett löschen
         preferences.begin("moodlight", false);
         preferences.clear();
         preferences.end();
+        clearSettingsJournal();
 
-        // Persistierte JSON-Einstellungen löschen — sonst lädt loadSettings()
-        // beim nächsten Boot bevorzugt die alte Datei und der Reset greift nicht
-        if (LittleFS.exists("/data/settings.json")) {
-            LittleFS.remove("/data/settings.json");
+        // preferences.clear() nimmt die Einstellungsbloecke mit. Die alte JSON-Datei
+        // muss ebenfalls weg — sonst uebernimmt loadSettings() sie beim naechsten
+        // Boot als Altformat und der Reset greift nicht
+        const char *settingsFile = "/data/settings.json";
+        String settingsBackup = fileOps.backupPath(settingsFile);
+        if (LittleFS.exists(settingsFile)) {
+            LittleFS.remove(settingsFile);
         }
-        if (LittleFS.exists("/data/settings.json.bak")) {
-            LittleFS.remove("/data/settings.json.bak");
+        if (LittleFS.exists(settingsBackup)) {
+            LittleFS.remove(settingsBackup);
         }
 
         // Standardwerte wiederherstellen
@@ -1548,36 +1624,30 @@ void setupWebServer() {
         appState.rebootTime = millis() + REBOOT_DELAY;
 
         server.send(200, "text/plain", "OK");
-        debug(F("Factory Reset durchgeführt, Reboot geplant"));
-    });
+        LOG_I("Factory Reset durchgeführt, Reboot geplant");
+    }},
 
     // Log-Anzeige
-    server.on("/logs", HTTP_GET, []() {
-        String logs = "";
-        logs.reserve(LOG_BUFFER_SIZE * 200); // Pre-allokieren um Fragmentierung zu vermeiden
-        for (int i = 0; i < LOG_BUFFER_SIZE; i++) {
-            int idx = (appState.logIndex + i) % LOG_BUFFER_SIZE;
-            if (appState.logBuffer[idx][0] != '\0') {
-                logs += appState.logBuffer[idx];
-                logs += "\n";
-            }
-        }
+    {"/logs", HTTP_GET, ROUTE_JSON, []() {
+        // Der Ring haelt nur rohe Eintraege — formatiert wird erst hier
+        String logs;
+        formatLogs(logs);
         server.send(200, "text/plain; charset=utf-8", logs);
-    });
+    }},
 
     // /status entfernt — Duplikat von /api/status, kein Aufrufer (A-NIEDRIG)
 
     // Force-Refresh fuer Sentiment — nutzt den gleichen Flag-Mechanismus wie HA-Button
-    server.on("/refresh", HTTP_GET, []() {
-        debug(F("Force-Update via Web — setze Flag fuer naechsten Loop"));
+    {"/refresh", HTTP_GET, ROUTE_ACTION, []() {
+        LOG_I("Force-Update via Web — setze Flag fuer naechsten Loop");
         // Antwort sofort senden
         server.send(200, "text/plain", "Refresh initiated");
         // Flag setzen, loop() fuehrt den Abruf sicher aus (wie beim HA-Button)
         appState.mqttRefreshPending = true;
-    });
+    }},
 
     // toggle-light Endpunkt
-    server.on("/toggle-light", HTTP_GET, []() {
+    {"/toggle-light", HTTP_GET, ROUTE_ACTION, []() {
         appState.lightOn = !appState.lightOn;
 
         // Antwort senden
@@ -1595,11 +1665,11 @@ void setupWebServer() {
             haLight.setState(appState.lightOn);
         }
 
-        debug(String(F("Licht über Web umgeschaltet: ")) + (appState.lightOn ? "AN" : "AUS"));
-    });
+        LOG_I("Licht über Web umgeschaltet: %s", appState.lightOn ? "AN" : "AUS");
+    }},
 
     // toggle-mode Endpunkt
-    server.on("/toggle-mode", HTTP_GET, []() {
+    {"/toggle-mode", HTTP_GET, ROUTE_ACTION, []() {
         appState.autoMode = !appState.autoMode;
         // Home Assistant aktualisieren, wenn aktiviert
         if (appState.mqttEnabled && mqtt.isConnected()) {
@@ -1616,11 +1686,11 @@ void setupWebServer() {
         appState.lastSettingsSaved = millis();
 
         server.send(200, "text/plain", "OK");
-        debug(String(F("Modus über Web umgeschaltet: ")) + (appState.autoMode ? "Auto" : "Manual"));
-    });
+        LOG_I("Modus über Web umgeschaltet: %s", appState.autoMode ? "Auto" : "Manual");
+    }},
 
     // set-color Endpunkt
-    server.on("/set-color", HTTP_GET, []() {
+    {"/set-color", HTTP_GET, ROUTE_ACTION, []() {
         if (server.hasArg("hex")) {
             String hexColor = server.arg("hex");
 
@@ -1661,14 +1731,14 @@ void setupWebServer() {
             appState.lastSettingsSaved = millis();
 
             server.send(200, "text/plain", "OK");
-            debug(String(F("Farbe über Web gesetzt: #")) + hexColor);
+            LOG_I("Farbe über Web gesetzt: #%s", hexColor);
         } else {
             server.send(400, "text/plain", "Missing hex parameter");
         }
-    });
+    }},
 
     // set-brightness Endpunkt
-    server.on("/set-brightness", HTTP_GET, []() {
+    {"/set-brightness", HTTP_GET, ROUTE_ACTION, []() {
         if (server.hasArg("value")) {
             int brightness = server.arg("value").toInt();
             brightness = constrain(brightness, 10, 255);
@@ -1689,52 +1759,20 @@ void setupWebServer() {
             appState.lastSettingsSaved = millis();
 
             server.send(200, "text/plain", "OK");
-            debug(String(F("Helligkeit über Web gesetzt: ")) + brightness);
+            LOG_I("Helligkeit über Web gesetzt: %d", brightness);
         } else {
             server.send(400, "text/plain", "Missing value parameter");
         }
-    });
+    }},
 
     // v9.0: set-headlines endpoint removed - parameter not used anymore
 
-    server.on("/api/settings/all", HTTP_GET, []() {
+    {"/api/settings/all", HTTP_GET, ROUTE_JSON, []() {
         JsonDocument doc;
 
-        // Allgemeine Einstellungen
-        doc["moodInterval"] = appState.moodUpdateInterval / 1000;
-        doc["dhtInterval"] = appState.dhtUpdateInterval / 1000;
-        doc["autoMode"] = appState.autoMode;
-        doc["lightOn"] = appState.lightOn;
-        doc["manBright"] = appState.manualBrightness;
-
-        // Farbe als HEX
-        char hexColor[10];
-        snprintf(hexColor, sizeof(hexColor), "#%06X", appState.manualColor & 0xFFFFFF);
-        doc["manColor"] = hexColor;
-
-        // v9.0: headlinesPS removed
-
-        // WiFi-Einstellungen (Passwort maskiert)
-        doc["wifiSSID"] = appState.wifiSSID;
-        doc["wifiConfigured"] = appState.wifiConfigured;
-
-        // Erweiterte Einstellungen (Passwort maskiert)
-        doc["apiUrl"] = appState.apiUrl;
-        doc["mqttServer"] = appState.mqttServer;
-        doc["mqttUser"] = appState.mqttUser;
-        doc["dhtPin"] = appState.dhtPin;
-        doc["dhtEnabled"] = appState.dhtEnabled;
-        doc["ledPin"] = appState.ledPin;
-        doc["numLeds"] = appState.numLeds;
-        doc["mqttEnabled"] = appState.mqttEnabled;
-
-        // Farben
-        JsonArray colors = doc["colors"].to<JsonArray>();
-        for (int i = 0; i < 5; i++) {
-            char hexColorArr[10];
-            snprintf(hexColorArr, sizeof(hexColorArr), "#%06X", appState.customColors[i] & 0xFFFFFF);
-            colors.add(hexColorArr);
-        }
+        // Einstellungen aus dem Schema: Intervalle in Sekunden, Farben als
+        // "#RRGGBB" (customColors als Array "colors"), Passwoerter nie
+        settingsWebJson(doc);
 
         // Dateisystem-Informationen — LittleFS.begin() entfernt, FS ist bereits gemountet (A-NIEDRIG)
         {
@@ -1742,7 +1780,7 @@ void setupWebServer() {
             size_t usedBytes = LittleFS.usedBytes();
             doc["fsTotal"] = totalBytes;
             doc["fsUsed"] = usedBytes;
-            doc["hasSettings"] = LittleFS.exists("/data/settings.json");
+            doc["hasSettings"] = settingsStored();
             doc["hasStats"] = false; // v9.0: stats managed in backend
             doc["hasFeeds"] = false; // v9.0: feeds managed in backend
         }
@@ -1751,25 +1789,39 @@ void setupWebServer() {
         size_t len = serializeJson(doc, jsonBuffer, JSON_BUFFER_SIZE);
         server.send(200, "application/json", jsonBuffer);
         jsonPool.release(jsonBuffer);
-    });
+    }},
+
+    // Einstellungen als JSON-Datei herunterladen (Passwoerter maskiert)
+    {"/api/settings/export", HTTP_GET, ROUTE_JSON, []() {
+        JsonDocument doc;
+        exportSettingsJson(doc);
+        char* jsonBuffer = jsonPool.acquire();
+        serializeJson(doc, jsonBuffer, JSON_BUFFER_SIZE);
+        server.sendHeader("Content-Disposition", "attachment; filename=\"moodlight-settings.json\"");
+        server.send(200, "application/json", jsonBuffer);
+        jsonPool.release(jsonBuffer);
+    }},
 
     // Restart Endpunkt
-    server.on("/restart", HTTP_GET, []() {
+    {"/restart", HTTP_GET, ROUTE_ACTION, []() {
         server.send(200, "text/html", "<html><body><h1>Restarting...</h1><p>Device will restart in a few seconds.</p><script>setTimeout(function(){window.location.href='/';}, 10000);</script></body></html>");
         delay(1000);
         ESP.restart();
-    });
+    }},
 
     // Update-Handler für Firmware
-    server.on(
-        "/update", HTTP_POST, []() {
+    {
+        "/update", HTTP_POST, ROUTE_UPLOAD, []() {
             server.sendHeader("Connection", "close");
-            if (Update.hasError()) {
+            if (firmwareUploadRejected) {
+                server.send(409, "text/plain; charset=utf-8", "Es laeuft bereits ein Update");
+            } else if (Update.hasError()) {
                 server.send(500, "text/html", "<html><body><h1>Update Failed!</h1><a href='/'>Return to Homepage</a></body></html>");
                 // Kein Restart bei fehlgeschlagenem Update
             } else {
                 server.send(200, "text/html", "<html><body><h1>Update Successful!</h1><p>Device is restarting...</p><script>setTimeout(function(){window.location.href='/';}, 10000);</script></body></html>");
                 delay(1000);
+                updateTxnRestarting();
                 ESP.restart();
             }
         },
@@ -1777,55 +1829,96 @@ void setupWebServer() {
             HTTPUpload &upload = server.upload();
             static String extractedVersion = "";
             static bool magicByteChecked = false;
+            // Firmware-X.X-AuraOS.bin.gz wird beim Schreiben entpackt (ota_gzip.h)
+            static GzipFlashWriter inflater;
+            static bool gzipUpload = false;
 
             if (upload.status == UPLOAD_FILE_START) {
+                // Der Hintergrund-Task (Installation, Vorab-Laden, Peer) schreibt
+                // ueber dasselbe Update und dieselbe Transaktion — nichts davon
+                // anfassen, die restlichen Chunks verfallen
+                firmwareUploadRejected = appState.updateInProgress;
+                if (firmwareUploadRejected) {
+                    LOG_W("Firmware-Upload abgewiesen: es laeuft bereits ein Update");
+                    return;
+                }
+                appState.updateInProgress = true;
+
                 String filename = upload.filename;
-                debug("Update: " + filename);
+                LOG_I("Update: %s", filename);
                 magicByteChecked = false;
+                gzipUpload = filename.endsWith(".bin.gz");
 
-                // Check naming convention: Firmware-X.X-AuraOS.bin
-                if (filename.startsWith("Firmware-") && filename.endsWith(".bin")) {
+                // Check naming convention: Firmware-X.X-AuraOS.bin (oder .bin.gz)
+                if (filename.startsWith("Firmware-") && (filename.endsWith(".bin") || gzipUpload)) {
                     int dashPos = filename.indexOf('-', 9); // Position after "Firmware-X.X"
 
                     if (dashPos > 0) {
                         // Extract version from filename (e.g., "2.1" from "Firmware-2.1-AuraOS.bin")
                         extractedVersion = filename.substring(9, dashPos);
-                        debug(String(F("Firmware-Version aus Dateiname: ")) + extractedVersion);
+                        LOG_D("Firmware-Version aus Dateiname: %s", extractedVersion);
                     }
                 } else {
-                    debug(F("Warnung: Firmware folgt nicht der Namenskonvention (Firmware-X.X-AuraOS.bin)"));
+                    LOG_W("Firmware folgt nicht der Namenskonvention (Firmware-X.X-AuraOS.bin)");
+                }
+
+                // Ohne vorher bereitgestellte UI (?stage=1) ist es ein reines Firmware-Update
+                if (!updateTxnOpen()) {
+                    updateTxnBegin(extractedVersion.c_str());
                 }
 
                 setStatusLED(3); // Update-Modus für Status-LED
+                updatePartitionWritten();
 
-                if (!Update.begin(UPDATE_SIZE_UNKNOWN)) {
-                    debug(F("ERROR: Update Begin fehlgeschlagen"));
+                if (gzipUpload) {
+                    if (!inflater.begin(UPDATE_SIZE_UNKNOWN)) {
+                        LOG_E("gzip-Update nicht moeglich: %s", inflater.error());
+                        Update.abort();  // Damit die Antwort den Fehler meldet
+                    }
+                }
+                else if (!Update.begin(UPDATE_SIZE_UNKNOWN)) {
+                    LOG_E("Update Begin fehlgeschlagen");
                     Update.printError(Serial);
                 }
             }
+            else if (firmwareUploadRejected) {
+                return;
+            }
+            else if (upload.status == UPLOAD_FILE_WRITE && gzipUpload) {
+                // Magic-Byte, CRC und Laenge prueft der Entpacker; nach einem
+                // Fehler ist er inaktiv und die restlichen Chunks verfallen
+                if (inflater.active() && !inflater.write(upload.buf, upload.currentSize)) {
+                    LOG_E("gzip-Update abgebrochen: %s", inflater.error());
+                }
+            }
             else if (upload.status == UPLOAD_FILE_WRITE) {
                 // Bricking-Vorsorge: erster Chunk muss mit dem ESP32-Firmware-Magic-Byte
                 // 0xE9 beginnen — verhindert das Flashen offensichtlich falscher Dateien
                 if (!magicByteChecked) {
                     magicByteChecked = true;
                     if (upload.currentSize == 0 || upload.buf[0] != 0xE9) {
-                        debug(F("ERROR: Ungültige Firmware-Datei (Magic Byte 0xE9 fehlt) - Update abgebrochen"));
+                        LOG_E("Ungültige Firmware-Datei (Magic Byte 0xE9 fehlt) - Update abgebrochen");
                         Update.abort();
                         return;
                     }
                 }
                 if (Update.write(upload.buf, upload.currentSize) != upload.currentSize) {
-                    debug(F("ERROR: Update Write fehlgeschlagen"));
+                    LOG_E("Update Write fehlgeschlagen");
                     Update.printError(Serial);
                 }
             }
             else if (upload.status == UPLOAD_FILE_END) {
-                if (Update.end(true)) {
-                    debug("Update erfolgreich: " + String(upload.totalSize) + " Bytes");
+                bool finished = gzipUpload ? inflater.end() : Update.end(true);
+                if (finished) {
+                    LOG_I("Update erfolgreich: %lu Bytes", (unsigned long)upload.totalSize);
+                    if (gzipUpload) {
+                        LOG_I("Entpackt: %lu Bytes", (unsigned long)inflater.outputBytes());
+                    }
+                    updateTxnFlashed();
 
                     // Save the extracted version to a file for future reference
                     if (extractedVersion.length() > 0) {
-                        debug(String(F("Speichere Firmware-Version: ")) + extractedVersion);
+                        LOG_D("Speichere Firmware-Version: %s", extractedVersion);
                         File versionFile = LittleFS.open("/firmware-version.txt", "w");
                         if (versionFile) {
                             versionFile.print(extractedVersion);
@@ -1833,46 +1926,142 @@ void setupWebServer() {
                         }
                     }
                 }
+                else if (gzipUpload) {
+                    LOG_E("gzip-Update fehlgeschlagen: %s", inflater.error());
+                    updateTxnAbort();
+                }
                 else {
-                    debug(F("ERROR: Update End fehlgeschlagen"));
+                    LOG_E("Update End fehlgeschlagen");
                     Update.printError(Serial);
+                    updateTxnAbort();
                 }
+                appState.updateInProgress = false;
             }
             else if (upload.status == UPLOAD_FILE_ABORTED) {
-                debug(F("Firmware-Update abgebrochen"));
+                LOG_W("Firmware-Update abgebrochen");
+                inflater.abort();
                 Update.abort();
+                updateTxnAbort();
                 setStatusLED(0);
+                appState.updateInProgress = false;
             }
-        });
+        }
+    },
 
     // Update-Status fuer die WebUI: was liegt bereit, was ist gerade los
-    server.on("/api/update/status", HTTP_GET, []() {
+    {"/api/update/status", HTTP_GET, ROUTE_JSON, []() {
         JsonDocument doc;
         doc["current"] = MOODLIGHT_VERSION;
         doc["check_enabled"] = appState.updateCheckEnabled;
         doc["update_available"] = appState.updateAvailable;
+
+        // Vorab-Laden in der Nacht: eingeschaltet, Drossel, Stand
+        const PrefetchStatus &pre = updatePrefetchStatus();
+        JsonObject prefetchObj = doc["prefetch"].to<JsonObject>();
+        prefetchObj["enabled"] = appState.updatePrefetchEnabled;
+        prefetchObj["rate_kbps"] = appState.updatePrefetchRate;
+        prefetchObj["hours"] = String(UPDATE_PREFETCH_HOUR_START) + "-" + String(UPDATE_PREFETCH_HOUR_END);
+        prefetchObj["state"] = prefetchStateName(pre.state);
+        if (pre.state != PREFETCH_IDLE) {
+            prefetchObj["version"] = pre.version.c_str();
+        }
+        if (pre.finishedMs > 0) {
+            prefetchObj["bytes"] = pre.bytes;
+            prefetchObj["duration_ms"] = pre.durationMs;
+        }
+        if (pre.state == PREFETCH_FAILED) {
+            prefetchObj["last_error"] = pre.lastError.c_str();
+        }
         doc["in_progress"] = appState.updateInProgress;
         if (appState.updateAvailable) {
-            doc["latest"] = appState.updateVersion;
+            doc["latest"] = appState.updateVersion.c_str();
             // Die Release-Notes zeigt die Lampe nicht selbst an — sie verlinkt
             // auf GitHub. Spart RAM und die Notes bleiben vollstaendig lesbar.
-            doc["release_url"] = appState.updateReleaseUrl;
+            doc["release_url"] = appState.updateReleaseUrl.c_str();
             doc["size"] = appState.updateFirmwareSize;
+            if (appState.updateFirmwareGzSize > 0) {
+                doc["gz_size"] = appState.updateFirmwareGzSize;
+            }
+            if (appState.updateDeltaSize > 0) {
+                doc["delta_size"] = appState.updateDeltaSize;
+            }
+            if (appState.updateUiSize > 0) {
+                doc["ui_size"] = appState.updateUiSize;
+            }
         }
         if (appState.lastUpdateCheck > 0) {
             doc["last_check_ago_s"] = (millis() - appState.lastUpdateCheck) / 1000;
         }
         if (appState.updateLastError.length() > 0) {
-            doc["last_error"] = appState.updateLastError;
+            doc["last_error"] = appState.updateLastError.c_str();
+        }
+
+        // Firmware und UI als Transaktion: bereitgestellt, in Pruefung, bestaetigt
+        // oder zurueckgerollt — samt gemessener Ausfallzeit
+        const UpdateTxnReport &txn = updateTxnReport();
+        if (txn.state != TXN_NONE) {
+            JsonObject t = doc["transaction"].to<JsonObject>();
+            t["state"] = updateTxnStateName(txn.state);
+            t["version"] = txn.version.c_str();
+            t["with_ui"] = txn.withUi;
+            t["ui_activated"] = txn.uiActivated;
+            t["rollback_supported"] = txn.rollbackSupported;
+            if (txn.offlineMs > 0) {
+                t["offline_ms"] = txn.offlineMs;
+            }
+            if (txn.commitMs > 0) {
+                t["commit_ms"] = txn.commitMs;
+            }
+        }
+
+        // Fortschritt der laufenden bzw. letzten Installation
+        const UpdateProgress &p = updateProgress();
+        if (p.phase != UPDATE_PHASE_IDLE) {
+            JsonObject prog = doc["progress"].to<JsonObject>();
+            uint32_t rate = updateBytesPerSecond();
+            prog["phase"] = updatePhaseName(p.phase);
+            prog["written"] = p.written;
+            prog["total"] = p.total;
+            prog["flashed"] = p.flashed;
+            prog["compressed"] = p.compressed;
+            prog["resumes"] = p.resumes;
+            prog["retransmitted"] = p.retransmitted;
+            prog["delta"] = p.delta;
+            prog["prefetch"] = p.prefetch;
+            prog["from_prefetch"] = p.fromPrefetch;
+            if (p.peerIp != 0) {
+                prog["peer"] = IPAddress(p.peerIp).toString();
+            }
+            if (p.peerFallback) {
+                prog["peer_fallback"] = true;
+            }
+            if (p.deltaFallback) {
+                prog["delta_fallback"] = true;
+                prog["delta_discarded"] = p.deltaDiscarded;
+            }
+            prog["base_check_ms"] = p.baseCheckMs;
+            if (p.uiTotal > 0) {
+                prog["ui_written"] = p.uiWritten;
+                prog["ui_total"] = p.uiTotal;
+                prog["ui_skipped"] = p.uiFilesSkipped;
+            }
+            // Zum Vergleich mit der Downloadzeit: Hashen soll nicht bremsen
+            prog["hash_ms"] = p.hashUs / 1000;
+            prog["elapsed_ms"] = p.lastDataMs - p.startedMs;
+            prog["percent"] = p.total > 0 ? (uint32_t)((uint64_t)p.written * 100 / p.total) : 0;
+            prog["bytes_per_s"] = rate;
+            if (p.phase == UPDATE_PHASE_DOWNLOADING && rate > 0 && p.total > p.written) {
+                prog["eta_s"] = (p.total - p.written) / rate;
+            }
         }
         char* jsonBuffer = jsonPool.acquire();
         serializeJson(doc, jsonBuffer, JSON_BUFFER_SIZE);
         server.send(200, "application/json", jsonBuffer);
         jsonPool.release(jsonBuffer);
-    });
+    }},
 
     // Sofort nachsehen, ohne auf den Stundentakt zu warten
-    server.on("/api/update/check", HTTP_POST, []() {
+    {"/api/update/check", HTTP_POST, ROUTE_ACTION, []() {
         if (WiFi.status() != WL_CONNECTED) {
             server.send(503, "application/json",
                         "{\"status\":\"error\",\"message\":\"Keine WLAN-Verbindung\"}");
@@ -1885,8 +2074,8 @@ void setupWebServer() {
         doc["status"] = ok ? "success" : "error";
         doc["update_available"] = appState.updateAvailable;
         if (appState.updateAvailable) {
-            doc["latest"] = appState.updateVersion;
-            doc["release_url"] = appState.updateReleaseUrl;
+            doc["latest"] = appState.updateVersion.c_str();
+            doc["release_url"] = appState.updateReleaseUrl.c_str();
         }
         if (!ok) {
             doc["message"] = "Backend nicht erreichbar";
@@ -1895,31 +2084,26 @@ void setupWebServer() {
         serializeJson(doc, jsonBuffer, JSON_BUFFER_SIZE);
         server.send(ok ? 200 : 502, "application/json", jsonBuffer);
         jsonPool.release(jsonBuffer);
-    });
+    }},
 
-    // Installation anstossen — der Neustart passiert in der loop(), damit
-    // diese Antwort den Browser noch erreicht
-    server.on("/api/update/install", HTTP_POST, []() {
+    // Installation anstossen. Download und Flash laufen im Hintergrund, die
+    // WebUI verfolgt sie ueber /api/update/status; den Neustart macht die loop().
+    {"/api/update/install", HTTP_POST, ROUTE_ACTION, []() {
         if (!appState.updateAvailable) {
             server.send(400, "application/json",
                         "{\"status\":\"error\",\"message\":\"Kein Update vorgemerkt\"}");
             return;
         }
-        if (appState.updateInProgress) {
-            server.send(409, "application/json",
-                        "{\"status\":\"error\",\"message\":\"Update laeuft bereits\"}");
-            return;
-        }
 
-        String version = appState.updateVersion;
-        bool ok = downloadAndInstallUpdate();
+        // Laeuft schon etwas, entscheidet startUpdateInstall(): ein Vorab-Laden
+        // uebernimmt den Klick, alles andere ist ein Konflikt
+        bool ok = startUpdateInstall();
 
         JsonDocument doc;
-        doc["status"] = ok ? "success" : "error";
+        doc["status"] = ok ? "started" : "error";
         if (ok) {
-            doc["message"] = String(F("Version ")) + version +
-                             F(" installiert — das Geraet startet neu");
-            doc["restarting"] = true;
+            doc["message"] = String(F("Installation von Version ")) + appState.updateVersion +
+                             F(" laeuft im Hintergrund");
         } else {
             doc["message"] = appState.updateLastError.length() > 0
                                  ? appState.updateLastError
@@ -1927,12 +2111,50 @@ void setupWebServer() {
         }
         char* jsonBuffer = jsonPool.acquire();
         serializeJson(doc, jsonBuffer, JSON_BUFFER_SIZE);
-        server.send(ok ? 200 : 500, "application/json", jsonBuffer);
+        server.send(ok ? 202 : (appState.updateInProgress ? 409 : 500), "application/json", jsonBuffer);
         jsonPool.release(jsonBuffer);
-    });
+    }},
+
+    // Firmware fuer ein anderes Moodlight im LAN (update_checker.h). Geliefert
+    // wird nur eine Partition, deren Inhalt genau die angefragte SHA-256 hat —
+    // laufend oder vorab geladen. Hier geht nur der Kopf raus, den Rest
+    // schickt servePeerImage() aus der loop().
+    {"/api/update/peer-image", HTTP_GET, ROUTE_JSON, []() {
+        if (appState.updateInProgress) {
+            // Die freie Partition wird womoeglich gerade beschrieben
+            server.send(503, "application/json",
+                        "{\"status\":\"error\",\"message\":\"Update laeuft\"}");
+            return;
+        }
+        if (peerTransfer.part) {
+            // Eine Weitergabe zur Zeit — das fragende Geraet nimmt das naechste
+            // oder das Backend
+            server.send(503, "application/json",
+                        "{\"status\":\"error\",\"message\":\"Weitergabe laeuft bereits\"}");
+            return;
+        }
+        size_t size = server.arg("size").toInt();
+        const esp_partition_t *part = updatePeerImage(server.arg("sha").c_str(), size);
+        if (!part) {
+            server.send(404, "application/json",
+                        "{\"status\":\"error\",\"message\":\"Image nicht vorhanden\"}");
+            return;
+        }
+
+        LOG_I("Gebe Firmware an %s weiter (%u Bytes aus %s)", server.client().remoteIP().toString(), size,
+              part->label);
+        server.sendHeader("Connection", "close");
+        server.setContentLength(size);
+        server.send(200, "application/octet-stream", "");
+        peerTransfer.client = server.client();
+        peerTransfer.part = part;
+        peerTransfer.size = size;
+        peerTransfer.offset = 0;
+        peerTransfer.startedMs = millis();
+    }},
 
     // Automatische Suche an-/abschalten
-    server.on("/api/update/settings", HTTP_POST, []() {
+    {"/api/update/settings", HTTP_POST, ROUTE_ACTION, []() {
         if (!server.hasArg("plain")) {
             server.send(400, "application/json",
                         "{\"status\":\"error\",\"message\":\"Kein Body\"}");
@@ -1947,37 +2169,228 @@ void setupWebServer() {
         if (doc["check_enabled"].is<bool>()) {
             appState.updateCheckEnabled = doc["check_enabled"].as<bool>();
             appState.settingsNeedSaving = true;
-            debug(String(F("Update-Suche: ")) +
-                  (appState.updateCheckEnabled ? F("aktiviert") : F("deaktiviert")));
+            LOG_I("Update-Suche: %s", appState.updateCheckEnabled ? "aktiviert" : "deaktiviert");
+        }
+        if (doc["prefetch_enabled"].is<bool>()) {
+            appState.updatePrefetchEnabled = doc["prefetch_enabled"].as<bool>();
+            appState.settingsNeedSaving = true;
+            LOG_I("Vorab-Laden: %s", appState.updatePrefetchEnabled ? "aktiviert" : "deaktiviert");
+        }
+        long lo, hi;
+        if (doc["prefetch_rate_kbps"].is<int>() && settingLimits("prefetchRate", lo, hi)) {
+            appState.updatePrefetchRate = constrain(doc["prefetch_rate_kbps"].as<long>(), lo, hi);
+            appState.settingsNeedSaving = true;
         }
         JsonDocument resp;
         resp["status"] = "success";
         resp["check_enabled"] = appState.updateCheckEnabled;
+        resp["prefetch_enabled"] = appState.updatePrefetchEnabled;
+        resp["prefetch_rate_kbps"] = appState.updatePrefetchRate;
         char* jsonBuffer = jsonPool.acquire();
         serializeJson(resp, jsonBuffer, JSON_BUFFER_SIZE);
         server.send(200, "application/json", jsonBuffer);
         jsonPool.release(jsonBuffer);
-    });
+    }},
 
-    server.on("/api/firmware-version", HTTP_GET, []() {
+    {"/api/firmware-version", HTTP_GET, ROUTE_JSON, []() {
         JsonDocument doc;
         doc["version"] = getCurrentFirmwareVersion();
         char* jsonBuffer = jsonPool.acquire();
         size_t len = serializeJson(doc, jsonBuffer, JSON_BUFFER_SIZE);
         server.send(200, "application/json", jsonBuffer);
         jsonPool.release(jsonBuffer);
-    });
+    }},
+};
+
+static const size_t ROUTE_COUNT = sizeof(webRoutes) / sizeof(webRoutes[0]);
+
+// Ein Eintrag mehr als Routen: der letzte zaehlt onNotFound (uebrige Dateien, 404)
+static RouteStats routeStats[ROUTE_COUNT + 1];
+
+static void runRoute(size_t index, void (*handler)()) {
+    server.beginMetering();
+    unsigned long start = micros();
+    handler();
+    routeStats[index].record(micros() - start, server.meteredBytes(), server.meteredStatus());
+}
+
+static void runUpload(size_t index) {
+    unsigned long start = micros();
+    webRoutes[index].upload();
+    routeStats[index].uploadMicros += micros() - start;
+}
+
+static const char* methodName(HTTPMethod method) {
+    switch (method) {
+        case HTTP_GET: return "GET";
+        case HTTP_POST: return "POST";
+        default: return "ANY";
+    }
+}
+
+static const char* const ROUTE_KIND_NAMES[] = {"static", "json", "action", "upload"};
+
+// Chunked statt JsonBufferPool: ~50 Routen sprengen die 4 KB des Pools, und so
+// braucht die Antwort nur einen Zeilenpuffer auf dem Stack
+static void handleApiRoutes() {
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "application/json", "");
+    server.sendContent("{\"uptime\":" + String(millis() / 1000) + ",\"routes\":[");
+
+    char line[256];
+    for (size_t i = 0; i <= ROUTE_COUNT; i++) {
+        const RouteStats &st = routeStats[i];
+        const bool fallback = (i == ROUTE_COUNT);
+        snprintf(line, sizeof(line),
+                 "%s{\"path\":\"%s\",\"method\":\"%s\",\"kind\":\"%s\",\"count\":%lu,"
+                 "\"avgUs\":%lu,\"maxUs\":%lu,\"totalMs\":%lu,\"uploadMs\":%lu,\"bytes\":%lu,"
+                 "\"s2xx\":%lu,\"s3xx\":%lu,\"s4xx\":%lu,\"s5xx\":%lu,\"noResponse\":%lu}",
+                 i > 0 ? "," : "",
+                 fallback ? "*" : webRoutes[i].path,
+                 fallback ? "ANY" : methodName(webRoutes[i].method),
+                 fallback ? "static" : ROUTE_KIND_NAMES[webRoutes[i].kind],
+                 (unsigned long)st.count,
+                 (unsigned long)(st.count > 0 ? st.totalMicros / st.count : 0),
+                 (unsigned long)st.maxMicros,
+                 (unsigned long)(st.totalMicros / 1000),
+                 (unsigned long)(st.uploadMicros / 1000),
+                 (unsigned long)st.bytes,
+                 (unsigned long)st.status[0], (unsigned long)st.status[1],
+                 (unsigned long)st.status[2], (unsigned long)st.status[3],
+                 (unsigned long)st.noResponse);
+        server.sendContent(line);
+    }
+    server.sendContent("]}");
+    server.sendContent("");  // Ende der chunked-Antwort
+}
+
+// Print-Ziel fuer serializeJson(): sammelt in einem Stack-Puffer und schickt
+// ihn als Chunk einer chunked-Antwort, sobald er voll ist
+class ChunkedJsonWriter : public Print {
+public:
+    ChunkedJsonWriter() {
+        server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+        server.send(200, "application/json", "");
+    }
+    using Print::write;
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t *data, size_t len) override {
+        for (size_t i = 0; i < len; i++) {
+            if (_used == sizeof(_buf)) {
+                sendChunk();
+            }
+            _buf[_used++] = data[i];
+        }
+        return len;
+    }
+    void end() {
+        sendChunk();
+        server.sendContent("");  // Ende der chunked-Antwort
+    }
+
+private:
+    void sendChunk() {
+        if (_used > 0) {
+            server.sendContent(_buf, _used);
+            _used = 0;
+        }
+    }
+
+    char _buf[256];
+    size_t _used = 0;
+};
+
+// Reset-Grund, die letzten Log-Zeilen vor dem Reset (RTC-Ring, siehe debug.cpp)
+// und die Zusammenfassung des Core-Dumps aus der coredump-Partition.
+// Chunked statt JsonBufferPool: bis zu LOG_CRASH_LINES Zeilen plus Backtrace
+// passen nicht sicher in dessen 4 KB
+static void handleApiCrashLog() {
+    JsonDocument doc;
+    doc["resetReason"] = resetReasonName();
+    doc["bootsSinceLogReset"] = logRingBoots();
+
+    JsonArray lines = doc["previousBoot"].to<JsonArray>();
+    const String &log = crashLogLines();
+    int start = 0;
+    while (start < (int)log.length()) {
+        int end = log.indexOf('\n', start);
+        if (end < 0) {
+            end = log.length();
+        }
+        lines.add(log.substring(start, end));
+        start = end + 1;
+    }
+
+    JsonObject dump = doc["coreDump"].to<JsonObject>();
+#if CONFIG_ESP_COREDUMP_ENABLE_TO_FLASH
+    size_t dumpAddr = 0, dumpSize = 0;
+    bool present = esp_core_dump_image_check() == ESP_OK &&
+                   esp_core_dump_image_get(&dumpAddr, &dumpSize) == ESP_OK;
+    dump["present"] = present;
+    if (present) {
+        dump["size"] = (unsigned long)dumpSize;
+#if CONFIG_ESP_COREDUMP_DATA_FORMAT_ELF
+        esp_core_dump_summary_t *summary = (esp_core_dump_summary_t*)malloc(sizeof(esp_core_dump_summary_t));
+        if (summary && esp_core_dump_get_summary(summary) == ESP_OK) {
+            char hex[12];
+            dump["task"] = summary->exc_task;
+            snprintf(hex, sizeof(hex), "0x%08lx", (unsigned long)summary->exc_pc);
+            dump["pc"] = hex;
+            JsonArray bt = dump["backtrace"].to<JsonArray>();
+            for (uint32_t i = 0; i < summary->exc_bt_info.depth && i < 16; i++) {
+                snprintf(hex, sizeof(hex), "0x%08lx", (unsigned long)summary->exc_bt_info.bt[i]);
+                bt.add(hex);
+            }
+            dump["backtraceCorrupted"] = summary->exc_bt_info.corrupted;
+            dump["excCause"] = summary->ex_info.exc_cause;
+            snprintf(hex, sizeof(hex), "0x%08lx", (unsigned long)summary->ex_info.exc_vaddr);
+            dump["excVaddr"] = hex;
+            // Steht im Summary schon als Hex-Text (nullterminiert)
+            char sha[sizeof(summary->app_elf_sha256)];
+            strlcpy(sha, (const char *)summary->app_elf_sha256, sizeof(sha));
+            dump["elfSha256"] = sha;
+        }
+        free(summary);
+#endif
+    }
+#else
+    dump["present"] = false;
+    dump["message"] = "Core-Dump nicht aktiviert";
+#endif
+
+    ChunkedJsonWriter out;
+    serializeJson(doc, out);
+    out.end();
+}
+
+// ===== Web-Server Setup =====
+
+void setupWebServer() {
+    for (size_t i = 0; i < ROUTE_COUNT; i++) {
+        const WebRoute &route = webRoutes[i];
+        if (route.upload) {
+            server.on(route.path, route.method,
+                      [i]() { runRoute(i, webRoutes[i].handler); },
+                      [i]() { runUpload(i); });
+        } else {
+            server.on(route.path, route.method, [i]() { runRoute(i, webRoutes[i].handler); });
+        }
+    }
+
+    // WebServer behaelt nur Request-Header, nach denen vorher gefragt wurde —
+    // handleStaticFile() braucht Accept-Encoding fuer die Seiten-Bundles
+    static const char *collectedHeaders[] = {"Accept-Encoding"};
+    server.collectHeaders(collectedHeaders, 1);
 
     // Generischer Handler für alle anderen statischen Dateien
     server.onNotFound([]() {
-        String path = server.uri();
-        handleStaticFile(path);
+        runRoute(ROUTE_COUNT, []() { handleStaticFile(server.uri()); });
     });
 
     // server.begin() wird NICHT hier aufgerufen — das passiert in
     // connectWiFiAndStartServices() (STA) oder startAPModeWithServer() (AP)
     // nachdem WiFi korrekt initialisiert ist.
-    debug(F("Webserver-Routen registriert"));
+    LOG_D("Webserver-Routen registriert: %u", ROUTE_COUNT);
 }
 
 // A-NIEDRIG: initWatchdog() entfernt — toter Code, kein Aufrufer
@@ -1986,7 +2399,7 @@ void setupWebServer() {
 // === Regelmäßiger System-Gesundheitscheck ===
 void runSystemHealthCheck() {
     unsigned long currentMillis = millis();
-    debug(F("Führe regelmäßige Systemprüfung durch..."));
+    LOG_I("Führe regelmäßige Systemprüfung durch...");
 
     // Memory-Analyse durchführen
     memMonitor.update();
@@ -1998,7 +2411,7 @@ void runSystemHealthCheck() {
     sysHealth.update();
 
     if (sysHealth.isRestartRecommended()) {
-        debug(F("System empfiehlt Neustart - plane Neustart für 3:00 Uhr..."));
+        LOG_I("System empfiehlt Neustart - plane Neustart für 3:00 Uhr...");
 
         time_t now;
         time(&now);
@@ -2006,11 +2419,11 @@ void runSystemHealthCheck() {
         localtime_r(&now, &timeinfo);
 
         if (timeinfo.tm_hour >= NIGHT_REBOOT_HOUR_START && timeinfo.tm_hour < NIGHT_REBOOT_HOUR_END) {
-            debug(F("Nachtstunden, führe Neustart sofort durch..."));
+            LOG_I("Nachtstunden, führe Neustart sofort durch...");
             appState.rebootNeeded = true;
             appState.rebootTime = currentMillis + NIGHT_REBOOT_DELAY;
         } else {
-            debug(F("Neustart verschoben auf Nachtstunden..."));
+            LOG_I("Neustart verschoben auf Nachtstunden...");
             Preferences prefs;
             prefs.begin("syshealth", false);
             prefs.putBool("restartPending", true);
@@ -2021,7 +2434,7 @@ void runSystemHealthCheck() {
         Preferences prefs;
         prefs.begin("syshealth", false);
         if (prefs.getBool("restartPending", false)) {
-            debug(F("Neustart-Empfehlung aufgehoben, lösche restartPending-Flag"));
+            LOG_I("Neustart-Empfehlung aufgehoben, lösche restartPending-Flag");
             prefs.putBool("restartPending", false);
         }
         prefs.end();
@@ -2041,7 +2454,7 @@ void runSystemHealthCheck() {
             localtime_r(&now, &timeinfo);
 
             if (timeinfo.tm_hour >= SCHEDULED_REBOOT_HOUR_START && timeinfo.tm_hour < SCHEDULED_REBOOT_HOUR_END) {
-                debug(F("Geplanter Neustart wird ausgeführt..."));
+                LOG_I("Geplanter Neustart wird ausgeführt...");
                 appState.rebootNeeded = true;
                 appState.rebootTime = currentMillis + SCHEDULED_REBOOT_DELAY;
 
@@ -2059,7 +2472,7 @@ void runSystemHealthCheck() {
     float percentUsed = (total > 0) ? ((float)used * 100.0 / total) : 0;
 
     if (percentUsed > STORAGE_WARNING_PERCENT) {
-        debug(F("Hohe Dateisystembelegung erkannt"));
+        LOG_I("Hohe Dateisystembelegung erkannt");
     }
 
     appState.lastSystemHealthCheckTime = currentMillis;
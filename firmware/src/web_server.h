@@ -3,14 +3,41 @@
 #include "app_state.h"
 #include <WebServer.h>
 
+// WebServer, der mitzaehlt, was eine Antwort verschickt (Statuscode, Bytes).
+// Grundlage der Routen-Metriken unter /api/system/routes.
+class MeteredWebServer : public WebServer {
+public:
+    using WebServer::WebServer;
+
+    void beginMetering() {
+        _meterStatus = 0;
+        _meterBytes = 0;
+        _meterBodyKnown = false;
+    }
+    int meteredStatus() const { return _meterStatus; }
+    size_t meteredBytes() const { return _meterBytes; }
+
+protected:
+    size_t _currentClientWrite(const char *b, size_t l) override;
+    size_t _currentClientWrite_P(PGM_P b, size_t l) override;
+
+private:
+    void meter(const char *b, size_t l);
+
+    int _meterStatus = 0;
+    size_t _meterBytes = 0;
+    bool _meterBodyKnown = false;
+};
+
 // Hardware-Instanz — definiert in web_server.cpp
-extern WebServer server;
+extern MeteredWebServer server;
 
 // === Web-Server-Funktionen ===
 
 // Dateisystem
 void initFS();
 void getStorageInfo(uint64_t &totalBytes, uint64_t &usedBytes, uint64_t &freeBytes);
+bool deleteDir(const String& dirPath);  // rekursiv
 
 // Versions-Abfragen
 String getCurrentUiVersion();
@@ -18,6 +45,7 @@ String getCurrentFirmwareVersion();
 
 // Statische Dateien
 void handleStaticFile(String path);
+void invalidateFileCache();  // RAM-Cache verwerfen, z.B. nach UI-Update
 
 // API-Handler
 void handleApiStatus();
@@ -35,4 +63,8 @@ void setupWebServer();
 // Regelmäßiger System-Gesundheitscheck (aus loop())
 void runSystemHealthCheck();
 
+// Naechste Scheibe einer laufenden Firmware-Weitergabe (/api/update/peer-image),
+// einmal je loop()-Durchlauf nach server.handleClient()
+void servePeerImage();
+
 // JsonBufferPool bleibt intern in web_server.cpp
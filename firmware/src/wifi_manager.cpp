@@ -23,6 +23,9 @@ extern WatchdogManager watchdog;
 
 #include "debug.h"
 #include "web_server.h"
+#include "update_checker.h"
+
+#define LOG_TAG LOG_TAG_WIFI
 
 // Hardware-Instanz — definiert in diesem Modul
 DNSServer dnsServer;
@@ -73,11 +76,11 @@ public:
 // checkNtpTimeSync() im naechsten Loop-Durchlauf geprueft (statt hier 1s zu blockieren).
 void initTime() {
     if (WiFi.status() != WL_CONNECTED) {
-        debug(F("NTP: Kann Zeit nicht synchronisieren, kein WLAN"));
+        LOG_W("NTP: Kann Zeit nicht synchronisieren, kein WLAN");
         return;
     }
 
-    debug(F("NTP: Starte Zeitsynchronisation..."));
+    LOG_D("NTP: Starte Zeitsynchronisation...");
 
     // Simple time config with fewer parameters
     configTime(0, 0, NTP_SERVER, "time.nist.gov");
@@ -103,14 +106,14 @@ void checkNtpTimeSync() {
 
         char dateStr[64];
         strftime(dateStr, sizeof(dateStr), "%d.%m.%Y %H:%M:%S", &timeinfo);
-        debug(String(F("NTP: Zeit synchronisiert - ")) + dateStr);
+        LOG_I("NTP: Zeit synchronisiert - %s", dateStr);
     }
 }
 
 // === Sichere WiFi-Verbindung mit Timeout ===
 bool safeWiFiConnect(const String &ssid, const String &password, unsigned long timeout)
 {
-    debug(String(F("Safely connecting to WiFi: ")) + ssid);
+    LOG_I("Safely connecting to WiFi: %s", ssid);
 
     // Always disconnect first
     WiFi.disconnect(true);
@@ -128,7 +131,7 @@ bool safeWiFiConnect(const String &ssid, const String &password, unsigned long t
     {
         if (millis() - startTime > timeout)
         {
-            debug(F("WiFi connection timeout"));
+            LOG_W("WiFi connection timeout");
             return false;
         }
 
@@ -136,7 +139,7 @@ bool safeWiFiConnect(const String &ssid, const String &password, unsigned long t
         dotCounter++;
         if (dotCounter % 10 == 0)
         {
-            debug(".");
+            LOG_T(".");
             watchdog.feed(); // Watchdog füttern alle 500ms während Verbindungsaufbau
             yield();
         }
@@ -144,7 +147,7 @@ bool safeWiFiConnect(const String &ssid, const String &password, unsigned long t
 
     // Explicitly disable power save after connection
     esp_wifi_set_ps(WIFI_PS_NONE);
-    debug(String(F("WiFi connected! IP: ")) + WiFi.localIP().toString());
+    LOG_I("WiFi connected! IP: %s", WiFi.localIP().toString());
     return true;
 }
 
@@ -153,11 +156,11 @@ bool startWiFiStation()
 {
     if (!appState.wifiConfigured || appState.wifiSSID.isEmpty())
     {
-        debug(F("Keine WiFi-Konfiguration vorhanden."));
+        LOG_I("Keine WiFi-Konfiguration vorhanden.");
         return false;
     }
 
-    debug(String(F("Verbinde mit WiFi: ")) + appState.wifiSSID);
+    LOG_I("Verbinde mit WiFi: %s", appState.wifiSSID);
     WiFi.mode(WIFI_STA);
     WiFi.setAutoReconnect(true);
     WiFi.persistent(false);
@@ -175,23 +178,31 @@ bool startWiFiStation()
     }
     else
     {
-        debug(F("WiFi Verbindungs-Timeout! Fahre trotzdem fort."));
+        LOG_W("WiFi Verbindungs-Timeout! Fahre trotzdem fort.");
     }
 
     return connected;
 }
 
 // === WiFi-Netzwerke scannen fuer Setup-Seite ===
-String scanWiFiNetworks()
-{
-    debug(F("Scanne WiFi-Netzwerke..."));
+// Der Scan laeuft asynchron im WLAN-Treiber. Ein synchroner Scan haelt Webserver
+// und Loop mehrere Sekunden an — die LEDs stehen, alle anderen Clients warten.
+// Jetzt startet /wifiscan den Scan und antwortet sofort mit 202 und einer Job-ID;
+// die Setup-Seite fragt nach, bis das Ergebnis da ist. Fertige Ergebnisse werden
+// WIFI_SCAN_CACHE_MS lang wiederverwendet, wiederholtes Klicken scannt nicht neu.
 
-    int n = WiFi.scanNetworks();
-    debug(String(F("Scan abgeschlossen: ")) + n + F(" Netzwerke gefunden"));
+enum WiFiScanPhase { SCAN_IDLE, SCAN_RUNNING, SCAN_DONE, SCAN_FAILED };
 
-    JsonDocument doc; // Groesser fuer viele WiFi-Netzwerke
-    JsonArray networks = doc["networks"].to<JsonArray>();
+static WiFiScanPhase scanPhase = SCAN_IDLE;
+static uint32_t scanJob = 0;
+static unsigned long scanStartedAt = 0;
+static unsigned long scanFinishedAt = 0;
+static String scanNetworksJson;  // JSON-Array des letzten erfolgreichen Scans
 
+static void finishWiFiScan(int n)
+{
+    JsonDocument doc;
+    JsonArray networks = doc.to<JsonArray>();
     for (int i = 0; i < n; i++)
     {
         JsonObject network = networks.add<JsonObject>();
@@ -199,11 +210,86 @@ String scanWiFiNetworks()
         network["rssi"] = WiFi.RSSI(i);
         network["secure"] = (WiFi.encryptionType(i) != WIFI_AUTH_OPEN);
     }
-
-    String jsonResult;
-    serializeJson(doc, jsonResult);
+    scanNetworksJson = "";
+    serializeJson(doc, scanNetworksJson);
     WiFi.scanDelete(); // Scan-Ergebnisse freigeben, nachdem sie serialisiert wurden
-    return jsonResult;
+
+    scanPhase = SCAN_DONE;
+    scanFinishedAt = millis();
+    LOG_I("Scan abgeschlossen: %d Netzwerke gefunden (%lu ms)", n, scanFinishedAt - scanStartedAt);
+}
+
+void updateWiFiScan()
+{
+    if (scanPhase != SCAN_RUNNING)
+    {
+        return;
+    }
+
+    int16_t n = WiFi.scanComplete();
+    if (n >= 0)
+    {
+        finishWiFiScan(n);
+    }
+    else if (n == WIFI_SCAN_FAILED || millis() - scanStartedAt > WIFI_SCAN_TIMEOUT_MS)
+    {
+        LOG_E("WiFi-Scan fehlgeschlagen");
+        WiFi.scanDelete();
+        scanPhase = SCAN_FAILED;
+        scanFinishedAt = millis();
+    }
+}
+
+uint32_t startWiFiScan(bool force)
+{
+    updateWiFiScan();
+
+    if (scanPhase == SCAN_RUNNING)
+    {
+        return scanJob;
+    }
+    if (!force && scanPhase == SCAN_DONE && millis() - scanFinishedAt < WIFI_SCAN_CACHE_MS)
+    {
+        return scanJob; // Frisch genug — kein neuer Scan
+    }
+
+    LOG_D("Scanne WiFi-Netzwerke...");
+    scanJob++;
+    scanStartedAt = millis();
+    int16_t result = WiFi.scanNetworks(true);
+    scanPhase = (result == WIFI_SCAN_FAILED) ? SCAN_FAILED : SCAN_RUNNING;
+    if (scanPhase == SCAN_FAILED)
+    {
+        scanFinishedAt = scanStartedAt;
+        LOG_E("WiFi-Scan konnte nicht gestartet werden");
+    }
+    return scanJob;
+}
+
+int wifiScanResponse(uint32_t job, String &json)
+{
+    updateWiFiScan();
+
+    String head = "{\"job\":" + String(scanJob);
+    if (job != scanJob || scanPhase == SCAN_IDLE)
+    {
+        json = head + ",\"status\":\"unknown\"}";
+        return 404;
+    }
+    switch (scanPhase)
+    {
+    case SCAN_RUNNING:
+        json = head + ",\"status\":\"scanning\",\"elapsedMs\":" + String(millis() - scanStartedAt) + "}";
+        return 202;
+    case SCAN_FAILED:
+        json = head + ",\"status\":\"failed\"}";
+        return 500;
+    default:
+        json = head + ",\"status\":\"done\",\"ageMs\":" + String(millis() - scanFinishedAt) +
+               ",\"durationMs\":" + String(scanFinishedAt - scanStartedAt) +
+               ",\"networks\":" + scanNetworksJson + "}";
+        return 200;
+    }
 }
 
 // === DNS-Anfragen fuer Captive Portal verarbeiten ===
@@ -238,7 +324,7 @@ void checkAndReconnectWifi()
     {
         if (appState.wifiWasConnected)
         {
-            debug(F("WiFi Verbindung verloren! Starte Reconnect-Prozess..."));
+            LOG_W("WiFi Verbindung verloren! Starte Reconnect-Prozess...");
             appState.wifiWasConnected = false;
             appState.wifiReconnectActive = true;  // LED-02: Unterdrueckt pixels.show() waehrend Reconnect
             appState.wifiReconnectAttempts = 0;
@@ -261,7 +347,7 @@ void checkAndReconnectWifi()
             // Only try to connect if we have SSID
             if (appState.wifiConfigured && !appState.wifiSSID.isEmpty())
             {
-                debug(String(F("WiFi Reconnect Versuch #")) + appState.wifiReconnectAttempts + String(F(" mit Delay ")) + String(appState.wifiReconnectDelay / 1000) + "s");
+                LOG_I("WiFi Reconnect Versuch #%d mit Delay %lus", appState.wifiReconnectAttempts, appState.wifiReconnectDelay / 1000);
 
                 // Try reconnect
                 WiFi.disconnect(true);
@@ -284,7 +370,7 @@ void checkAndReconnectWifi()
 
                 if (WiFi.status() == WL_CONNECTED)
                 {
-                    debug(F("WiFi erfolgreich wieder verbunden!"));
+                    LOG_I("WiFi erfolgreich wieder verbunden!");
                     appState.wifiWasConnected = true;
                     appState.wifiReconnectActive = false;  // LED-02: Reconnect beendet, LEDs wieder freigeben
                     appState.disconnectStartMs = 0;         // LED-03: Grace-Timer zuruecksetzen
@@ -306,7 +392,7 @@ void checkAndReconnectWifi()
                 {
                     // Exponential backoff - with max limit
                     appState.wifiReconnectDelay = min(appState.wifiReconnectDelay * 2, (unsigned long)MAX_RECONNECT_DELAY);
-                    debug(String(F("WiFi Reconnect fehlgeschlagen. Naechster Versuch in ")) + String(appState.wifiReconnectDelay / 1000) + "s");
+                    LOG_W("WiFi Reconnect fehlgeschlagen. Naechster Versuch in %lus", appState.wifiReconnectDelay / 1000);
                 }
             }
         }
@@ -314,7 +400,7 @@ void checkAndReconnectWifi()
     else if (!appState.wifiWasConnected)
     {
         // WiFi is now connected but was disconnected before
-        debug(F("WiFi ist wieder verbunden."));
+        LOG_I("WiFi ist wieder verbunden.");
         appState.wifiWasConnected = true;
         appState.wifiReconnectActive = false;  // LED-02: Reconnect beendet, LEDs wieder freigeben
         appState.disconnectStartMs = 0;         // LED-03: Grace-Timer zuruecksetzen
@@ -348,7 +434,7 @@ void checkAndReconnectWifi()
     if (wifiOk && apiOk && (appState.statusLedMode == 1 || appState.statusLedMode == 2)) {
         setStatusLED(0);
         appState.disconnectStartMs = 0;
-        debug(F("Status-LED zurueckgesetzt: WLAN und API sind in Ordnung"));
+        LOG_I("Status-LED zurueckgesetzt: WLAN und API sind in Ordnung");
     }
 
     yield();
@@ -358,10 +444,10 @@ void checkAndReconnectWifi()
 // === AP-Modus mit Server-Start (fuer Setup-Phase) ===
 void startAPModeWithServer()
 {
-    debug(F("Starte Access Point Modus..."));
+    LOG_I("Starte Access Point Modus...");
 
     // Status-LED via Serial signalisieren, da pixels.show() vermieden wird
-    debug(F("AP Mode activated (visual LED indicator skipped during init)."));
+    LOG_D("AP Mode activated (visual LED indicator skipped during init).");
     // pixels.fill(pixels.Color(255, 255, 0));  // Gelb
     // pixels.show(); // <-- Vermeiden waehrend Setup-Phase
 
@@ -382,11 +468,11 @@ void startAPModeWithServer()
 
     // *** ESP-IDF Power Save im AP Modus deaktivieren ***
     esp_wifi_set_ps(WIFI_PS_NONE);
-    debug(F("ESP-IDF WiFi Power Save explicitly disabled (AP)."));
+    LOG_D("ESP-IDF WiFi Power Save explicitly disabled (AP).");
 
     // Jetzt erst den Webserver starten
     server.begin();
-    debug(F("Webserver im AP-Modus gestartet"));
+    LOG_I("Webserver im AP-Modus gestartet");
 
     // Setup komplettes Webserver-Routing (ist bereits global erfolgt)
     // setupWebServer(); // Nicht nochmal aufrufen!
@@ -395,8 +481,8 @@ void startAPModeWithServer()
     dnsServer.start(DNS_PORT, "*", IP);
     appState.isInConfigMode = true; // Dies markiert, dass wir im AP-Modus sind
 
-    debug("AP gestartet mit IP " + WiFi.softAPIP().toString());
-    debug(String(F("SSID: ")) + DEFAULT_AP_NAME);
+    LOG_I("AP gestartet mit IP %s", WiFi.softAPIP().toString());
+    LOG_I("SSID: %s", DEFAULT_AP_NAME);
 
     // Captive Portal Request Handler hinzufuegen
     server.addHandler(new CaptiveRequestHandler());
@@ -411,43 +497,45 @@ void startAPModeWithServer()
 // === WiFi verbinden + NTP + mDNS + Server starten ===
 bool connectWiFiAndStartServices() {
     if (!appState.wifiConfigured || appState.wifiSSID.isEmpty()) {
-        debug(F("Keine WiFi-Konfiguration gefunden. Starte Access Point..."));
+        LOG_I("Keine WiFi-Konfiguration gefunden. Starte Access Point...");
         startAPModeWithServer();
         return false;
     }
 
-    debug(String(F("Vorhandene WiFi-Konfiguration gefunden: ")) + appState.wifiSSID);
+    LOG_I("Vorhandene WiFi-Konfiguration gefunden: %s", appState.wifiSSID);
 
     bool wifiConnected = startWiFiStation();
 
     if (!wifiConnected) {
-        debug(F("WiFi-Verbindung fehlgeschlagen. Starte Access Point..."));
+        LOG_W("WiFi-Verbindung fehlgeschlagen. Starte Access Point...");
         startAPModeWithServer();
         return false;
     }
 
-    debug(F("WiFi verbunden. Deaktiviere explizit Power Save..."));
+    LOG_D("WiFi verbunden. Deaktiviere explizit Power Save...");
     esp_wifi_set_ps(WIFI_PS_NONE);
-    debug(F("ESP-IDF WiFi Power Save explicitly disabled (STA)."));
+    LOG_D("ESP-IDF WiFi Power Save explicitly disabled (STA).");
 
     // TCP-Stack stabilisieren: Nach schnellem Reboot können verwaiste TCP-Sessions
     // vom vorherigen Lauf im Router/Broker noch offen sein. Ohne Delay crasht der
     // lwIP-Stack (LoadProhibited in tcp_free_acked_segments) beim ersten HTTP/MQTT-Request.
-    debug(F("Warte auf TCP-Stack-Stabilisierung..."));
+    LOG_D("Warte auf TCP-Stack-Stabilisierung...");
     delay(3000);
     watchdog.feed();
 
     initTime();
 
-    debug(F("Starte Webserver..."));
+    LOG_D("Starte Webserver...");
     server.begin();
-    debug(F("Webserver gestartet"));
+    LOG_I("Webserver gestartet");
 
     if (MDNS.begin("moodlight")) {
         MDNS.addService("http", "tcp", 80);
-        debug(F("mDNS responder gestartet"));
+        MDNS.addService(UPDATE_PEER_SERVICE, "tcp", 80);
+        updatePeerAdvertise();
+        LOG_I("mDNS responder gestartet");
     } else {
-        debug(F("mDNS start fehlgeschlagen"));
+        LOG_E("mDNS start fehlgeschlagen");
     }
 
     return true;
@@ -19,8 +19,16 @@ bool safeWiFiConnect(const String &ssid, const String &password, unsigned long t
 // WiFi Station-Modus starten und verbinden
 bool startWiFiStation();
 
-// Verfuegbare WiFi-Netzwerke scannen (gibt JSON-String zurueck)
-String scanWiFiNetworks();
+// Asynchroner WiFi-Scan: startet einen Scan, sofern kein frisches Ergebnis
+// vorliegt (force = immer neu), und gibt die Job-ID zurueck
+uint32_t startWiFiScan(bool force);
+
+// Laufenden Scan pruefen und bei Abschluss Ergebnisse uebernehmen (aus loop())
+void updateWiFiScan();
+
+// Stand eines Scan-Jobs als JSON; Rueckgabe ist der HTTP-Status
+// (200 fertig, 202 laeuft noch, 404 unbekannter Job, 500 fehlgeschlagen)
+int wifiScanResponse(uint32_t job, String &json);
 
 // DNS-Anfragen fuer Captive Portal verarbeiten
 void processDNS();
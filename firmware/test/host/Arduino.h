@@ -0,0 +1,91 @@
+#pragma once
+
+// Arduino-Ersatz fuer die Host-Tests (pio test -e native): nur das, was die
+// dort eingebundenen Module aus src/ brauchen.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <algorithm>
+#include <chrono>
+
+#include "WString.h"
+
+using std::max;
+using std::min;
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// newlib (ESP32) und macOS haben strlcpy, glibc erst ab 2.38
+#if defined(__GLIBC__) && !__GLIBC_PREREQ(2, 38)
+inline size_t strlcpy(char *dst, const char *src, size_t size) {
+    size_t len = strlen(src);
+    if (size > 0) {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+#endif
+
+inline unsigned long micros() {
+    using namespace std::chrono;
+    static const steady_clock::time_point start = steady_clock::now();
+    return (unsigned long)duration_cast<microseconds>(steady_clock::now() - start).count();
+}
+
+inline unsigned long millis() {
+    return micros() / 1000;
+}
+
+inline void delay(unsigned long) {}
+inline void yield() {}
+
+inline char *dtostrf(double value, signed char width, unsigned char precision, char *out) {
+    sprintf(out, "%*.*f", width, precision, value);
+    return out;
+}
+
+// === ESP32 und FreeRTOS ===
+// Ein Thread, keine Tasks: Sperren sind leer, Tasks starten nicht.
+
+#define RTC_NOINIT_ATTR
+
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+
+typedef void *TaskHandle_t;
+typedef int BaseType_t;
+#define pdTRUE 1
+#define pdPASS 1
+#define portMAX_DELAY 0xFFFFFFFFu
+#define tskIDLE_PRIORITY 0
+
+inline BaseType_t xTaskCreate(void (*)(void *), const char *, uint32_t, void *, unsigned, TaskHandle_t *task) {
+    *task = nullptr;
+    return 0;
+}
+inline void xTaskNotifyGive(TaskHandle_t) {}
+inline uint32_t ulTaskNotifyTake(BaseType_t, uint32_t) { return 0; }
+
+struct HostEsp {
+    // Takte eines ESP32 mit 240 MHz, aus der Host-Uhr
+    uint32_t getCycleCount() {
+        using namespace std::chrono;
+        return (uint32_t)(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count() * 240 / 1000);
+    }
+    uint32_t getFreeHeap() { return 200000; }
+};
+inline HostEsp ESP;
+
+struct HostSerial {
+    void println(const char *line) { puts(line); }
+    void println(const __FlashStringHelper *line) { puts(reinterpret_cast<const char *>(line)); }
+};
+inline HostSerial Serial;
@@ -0,0 +1,147 @@
+#pragma once
+
+// String-Ersatz fuer die Host-Tests. Beim Heap verhaelt er sich wie der String
+// aus arduino-esp32: bis 14 Zeichen im Objekt (SSO), darueber ein Block per
+// realloc, der nur waechst. Zuweisen eines temporaeren Strings uebernimmt
+// dessen Block, ausser der eigene ist schon gross genug. Alle Heap-Zugriffe
+// laufen ueber hostHeap(), damit ein Test sie zaehlen oder auf ein eigenes
+// Heap-Modell umlenken kann.
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct HostHeap {
+    void *(*realloc)(void *ptr, size_t size);
+    void (*free)(void *ptr);
+};
+
+inline HostHeap &hostHeap() {
+    static HostHeap heap = {::realloc, ::free};
+    return heap;
+}
+
+class __FlashStringHelper;
+#define F(text) (reinterpret_cast<const __FlashStringHelper *>(text))
+
+class String {
+public:
+    String() { init(); }
+    String(const char *text) { init(); if (text) copy(text, strlen(text)); }
+    String(const __FlashStringHelper *text) : String(reinterpret_cast<const char *>(text)) {}
+    String(const String &other) { init(); copy(other.c_str(), other._len); }
+    String(String &&other) noexcept { init(); move(other); }
+    explicit String(char c) { init(); copy(&c, 1); }
+    explicit String(int value) : String((long)value) {}
+    explicit String(unsigned int value) : String((unsigned long)value) {}
+    explicit String(long value) { init(); char b[24]; copy(b, snprintf(b, sizeof(b), "%ld", value)); }
+    explicit String(unsigned long value) { init(); char b[24]; copy(b, snprintf(b, sizeof(b), "%lu", value)); }
+    explicit String(float value, unsigned decimals = 2) : String((double)value, decimals) {}
+    explicit String(double value, unsigned decimals = 2) {
+        init();
+        char b[40];
+        copy(b, snprintf(b, sizeof(b), "%.*f", (int)decimals, value));
+    }
+    ~String() { release(); }
+
+    String &operator=(const String &other) { if (this != &other) copy(other.c_str(), other._len); return *this; }
+    String &operator=(String &&other) noexcept { if (this != &other) move(other); return *this; }
+    String &operator=(const char *text) { return text ? copy(text, strlen(text)) : copy("", 0); }
+    String &operator=(const __FlashStringHelper *text) { return *this = reinterpret_cast<const char *>(text); }
+
+    const char *c_str() const { return _sso ? _small : _heap; }
+    size_t length() const { return _len; }
+    bool isEmpty() const { return _len == 0; }
+
+    bool reserve(size_t size) {
+        if (size < capacity()) return true;
+        if (_sso && size < SSO_SIZE) return true;
+        char *grown = (char *)hostHeap().realloc(_sso ? nullptr : _heap, size + 1);
+        if (!grown) return false;
+        if (_sso) {
+            memcpy(grown, _small, _len + 1);
+            _sso = false;
+        }
+        _heap = grown;
+        _capacity = size;
+        return true;
+    }
+
+    bool concat(const char *text, size_t len) {
+        if (!reserve(_len + len)) return false;
+        memmove(buffer() + _len, text, len);
+        _len += len;
+        buffer()[_len] = '\0';
+        return true;
+    }
+
+    String &operator+=(const String &other) { concat(other.c_str(), other._len); return *this; }
+    String &operator+=(const char *text) { if (text) concat(text, strlen(text)); return *this; }
+    String &operator+=(const __FlashStringHelper *text) { return *this += reinterpret_cast<const char *>(text); }
+    String &operator+=(char c) { concat(&c, 1); return *this; }
+    template <typename T>
+    String &operator+=(T value) { return *this += String(value); }
+
+    bool operator==(const char *text) const { return strcmp(c_str(), text ? text : "") == 0; }
+    bool operator==(const String &other) const { return _len == other._len && *this == other.c_str(); }
+    bool operator!=(const char *text) const { return !(*this == text); }
+    bool operator!=(const String &other) const { return !(*this == other); }
+
+private:
+    static constexpr size_t SSO_SIZE = 15;      // Wie arduino-esp32: 14 Zeichen + Nullterminator
+
+    void init() {
+        _sso = true;
+        _small[0] = '\0';
+        _len = 0;
+        _capacity = 0;
+    }
+
+    void release() {
+        if (!_sso) hostHeap().free(_heap);
+    }
+
+    size_t capacity() const { return _sso ? SSO_SIZE - 1 : _capacity; }
+    char *buffer() { return _sso ? _small : _heap; }
+
+    String &copy(const char *text, size_t len) {
+        if (!reserve(len)) return *this;
+        memmove(buffer(), text, len);
+        _len = len;
+        buffer()[_len] = '\0';
+        return *this;
+    }
+
+    void move(String &other) {
+        if (!_sso && _capacity >= other._len) {
+            copy(other.c_str(), other._len);
+            other.release();
+            other.init();
+            return;
+        }
+        release();
+        _sso = other._sso;
+        if (_sso) {
+            memcpy(_small, other._small, SSO_SIZE);
+        } else {
+            _heap = other._heap;
+        }
+        _len = other._len;
+        _capacity = other._capacity;
+        other.init();
+    }
+
+    union {
+        char _small[SSO_SIZE];
+        char *_heap;
+    };
+    bool _sso;
+    size_t _len;
+    size_t _capacity;
+};
+
+// Wie StringSumHelper: die Kette haengt an den temporaeren linken String an
+template <typename T>
+inline String operator+(String lhs, const T &rhs) { lhs += rhs; return lhs; }
+inline String operator+(const char *lhs, const String &rhs) { String sum(lhs); sum += rhs; return sum; }
@@ -0,0 +1,14 @@
+#pragma once
+
+// esp_app_get_description(): nur der ELF-SHA, den debug.cpp als Build-ID nutzt
+
+#include <stdint.h>
+
+typedef struct {
+    uint8_t app_elf_sha256[32];
+} esp_app_desc_t;
+
+inline const esp_app_desc_t *esp_app_get_description() {
+    static const esp_app_desc_t desc = {{0x42, 0x55, 0x49, 0x4C, 0x44}};
+    return &desc;
+}
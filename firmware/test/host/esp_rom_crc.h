@@ -0,0 +1,18 @@
+#pragma once
+
+// esp_rom_crc32_le() wie im ROM des ESP32: CRC-32 (IEEE, reflektiert), crc ist
+// der Stand des vorigen Aufrufs bzw. 0
+
+#include <stddef.h>
+#include <stdint.h>
+
+inline uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len) {
+    crc = ~crc;
+    while (len--) {
+        crc ^= *buf++;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
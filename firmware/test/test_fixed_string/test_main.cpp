@@ -0,0 +1,377 @@
+// Host-Test: FixedString (fixed_string.h)
+//
+// Verhalten wie String fuer den bestehenden Code, dazu ein Dauertest ueber
+// simulierte Tage: dieselben Zuweisungen wie im Betrieb (Sentiment-Abruf,
+// stuendliche Update-Pruefung, Fehlertexte, WebUI-Anfragen) einmal mit
+// String-, einmal mit FixedString-Feldern. Der Heap ist ein kleines
+// First-Fit-Modell — der ESP32 nutzt TLSF, das Muster (langlebige Bloecke
+// zwischen kurzlebigen) ist dasselbe. Gemessen werden freier Heap, groesster
+// freier Block und Heap-Zugriffe je Tag. Auf dem Geraet zeigt minMaxBlock in
+// /api/system/metrics den echten Verlauf.
+
+#include <unity.h>
+
+#include "fixed_string.h"
+
+// ===== Heap-Modell =====
+// Bloecke mit 8 Bytes Kopf, 8 Bytes ausgerichtet; Freigeben verschmilzt
+// benachbarte freie Bloecke, realloc waechst wenn moeglich an Ort und Stelle.
+
+static const size_t ARENA_BYTES = 40 * 1024;
+alignas(8) static uint8_t arena[ARENA_BYTES];
+
+struct ArenaBlock {
+    uint32_t size;      // Inklusive Kopf
+    uint32_t used;
+};
+
+static uint32_t arenaCalls = 0;
+
+static ArenaBlock *nextBlock(ArenaBlock *b) {
+    uint8_t *next = (uint8_t *)b + b->size;
+    return next < arena + ARENA_BYTES ? (ArenaBlock *)next : nullptr;
+}
+
+static void arenaReset() {
+    ArenaBlock *b = (ArenaBlock *)arena;
+    b->size = ARENA_BYTES;
+    b->used = 0;
+    arenaCalls = 0;
+}
+
+static size_t blockSize(size_t n) {
+    return sizeof(ArenaBlock) + ((n + 7) & ~(size_t)7);
+}
+
+static void split(ArenaBlock *b, size_t need) {
+    if (b->size - need >= 2 * sizeof(ArenaBlock)) {
+        ArenaBlock *rest = (ArenaBlock *)((uint8_t *)b + need);
+        rest->size = b->size - need;
+        rest->used = 0;
+        b->size = need;
+    }
+}
+
+static void coalesce() {
+    for (ArenaBlock *b = (ArenaBlock *)arena; b; b = nextBlock(b)) {
+        ArenaBlock *n;
+        while (!b->used && (n = nextBlock(b)) && !n->used) {
+            b->size += n->size;
+        }
+    }
+}
+
+static void *arenaAlloc(size_t n) {
+    size_t need = blockSize(n);
+    for (ArenaBlock *b = (ArenaBlock *)arena; b; b = nextBlock(b)) {
+        if (!b->used && b->size >= need) {
+            split(b, need);
+            b->used = 1;
+            return b + 1;
+        }
+    }
+    return nullptr;
+}
+
+static void arenaFree(void *p) {
+    if (!p) return;
+    arenaCalls++;
+    ((ArenaBlock *)p - 1)->used = 0;
+    coalesce();
+}
+
+static void *arenaRealloc(void *p, size_t n) {
+    arenaCalls++;
+    if (!p) return arenaAlloc(n);
+    ArenaBlock *b = (ArenaBlock *)p - 1;
+    size_t need = blockSize(n);
+    if (b->size >= need) return p;
+    ArenaBlock *next = nextBlock(b);
+    if (next && !next->used && b->size + next->size >= need) {
+        b->size += next->size;
+        split(b, need);
+        return p;
+    }
+    void *moved = arenaAlloc(n);
+    if (moved) {
+        memcpy(moved, p, b->size - sizeof(ArenaBlock));
+        b->used = 0;
+        coalesce();
+    }
+    return moved;
+}
+
+struct ArenaStats {
+    size_t free;
+    size_t largest;
+};
+
+static ArenaStats arenaStats() {
+    ArenaStats s = {0, 0};
+    for (ArenaBlock *b = (ArenaBlock *)arena; b; b = nextBlock(b)) {
+        if (b->used) continue;
+        s.free += b->size - sizeof(ArenaBlock);
+        s.largest = max(s.largest, (size_t)(b->size - sizeof(ArenaBlock)));
+    }
+    return s;
+}
+
+// Fuer die Tests mit dem echten Heap: nur zaehlen
+static uint32_t heapCalls = 0;
+static void *countingRealloc(void *p, size_t n) { heapCalls++; return realloc(p, n); }
+static void countingFree(void *p) { if (p) heapCalls++; free(p); }
+
+void setUp()
+{
+    hostHeap() = {countingRealloc, countingFree};
+    heapCalls = 0;
+}
+
+void tearDown() {}
+
+// ===== Verhalten =====
+
+static void test_assign_and_truncate()
+{
+    FixedString<8> s;
+    TEST_ASSERT_TRUE(s.isEmpty());
+    TEST_ASSERT_TRUE(s.assign("abc"));
+    TEST_ASSERT_EQUAL_STRING("abc", s.c_str());
+    TEST_ASSERT_EQUAL(3, s.length());
+    TEST_ASSERT_FALSE(s.truncated());
+
+    TEST_ASSERT_FALSE(s.assign("abcdefghij"));
+    TEST_ASSERT_EQUAL_STRING("abcdefg", s.c_str());
+    TEST_ASSERT_EQUAL(7, s.length());
+    TEST_ASSERT_TRUE(s.truncated());
+
+    s = (const char *)nullptr;
+    TEST_ASSERT_TRUE(s.isEmpty());
+    s = F("flash");
+    TEST_ASSERT_EQUAL_STRING("flash", s.c_str());
+}
+
+static void test_compares_like_string()
+{
+    FixedString<16> s = "neutral";
+    String other("neutral");
+    FixedString<32> wide = "neutral";
+    TEST_ASSERT_TRUE(s == "neutral");
+    TEST_ASSERT_TRUE(s == other);
+    TEST_ASSERT_TRUE(other == s);
+    TEST_ASSERT_TRUE(s == wide);
+    TEST_ASSERT_TRUE(s != "positiv");
+    TEST_ASSERT_TRUE(s != String("neutral "));
+    TEST_ASSERT_TRUE(s != (const char *)nullptr);
+
+    String joined = String("Kategorie: ") + s;
+    TEST_ASSERT_EQUAL_STRING("Kategorie: neutral", joined.c_str());
+}
+
+// Zuweisen aus const char*, F() und einem kurzen String kommt ohne Heap aus
+static void test_assignment_without_heap()
+{
+    FixedString<96> error;
+    String shortText("kurz");
+    heapCalls = 0;
+    for (int i = 0; i < 100; i++) {
+        error = "Verbindung zum Backend fehlgeschlagen";
+        error = F("WLAN kam waehrend des Downloads nicht zurueck");
+        error = shortText;
+        error.clear();
+    }
+    TEST_ASSERT_EQUAL(0, heapCalls);
+}
+
+// ===== Dauertest =====
+
+struct StringState {
+    String sentimentCategory;
+    String updateVersion;
+    String updateReleaseUrl;
+    String updateFirmwarePath;
+    String updateFirmwareGzPath;
+    String updateFirmwareSha256;
+    String updateDeltaPath;
+    String updateUiPath;
+    String updateLastError;
+};
+
+struct FixedState {
+    FixedString<24> sentimentCategory;
+    FixedString<16> updateVersion;
+    FixedString<128> updateReleaseUrl;
+    FixedString<96> updateFirmwarePath;
+    FixedString<96> updateFirmwareGzPath;
+    FixedString<65> updateFirmwareSha256;
+    FixedString<96> updateDeltaPath;
+    FixedString<96> updateUiPath;
+    FixedString<96> updateLastError;
+};
+
+static uint32_t rng = 1;
+static uint32_t nextRandom(uint32_t range)
+{
+    rng = rng * 1103515245 + 12345;
+    return (rng >> 8) % range;
+}
+
+// HTTP-Antwort wie getString(): waechst in Stuecken
+static String httpBody(size_t bytes)
+{
+    String body;
+    char chunk[65];
+    memset(chunk, 'x', 64);
+    chunk[64] = '\0';
+    while (body.length() < bytes) {
+        body += chunk;
+    }
+    return body;
+}
+
+static const char *const categories[] = {"sehr negativ", "negativ", "neutral", "positiv", "sehr positiv"};
+
+template <typename State>
+static void moodUpdate(State &state)
+{
+    String body = httpBody(600 + nextRandom(300));
+    void *doc = arenaRealloc(nullptr, 1024);        // JsonDocument
+    String categoryText = categories[nextRandom(5)];
+    if (categoryText != state.sentimentCategory) {
+        state.sentimentCategory = categoryText;
+    }
+    arenaFree(doc);
+}
+
+template <typename State>
+static void updateCheck(State &state, unsigned release)
+{
+    String body = httpBody(800 + nextRandom(400));
+    void *doc = arenaRealloc(nullptr, 2048);
+
+    if (nextRandom(10) == 0) {
+        static const char *const errors[] = {"Verbindung zum Backend fehlgeschlagen",
+                                             "WLAN kam waehrend des Downloads nicht zurueck"};
+        if (nextRandom(2)) {
+            state.updateLastError = String(F("Backend nicht erreichbar (")) + String(-(int)nextRandom(12)) + ")";
+        } else {
+            state.updateLastError = errors[nextRandom(2)];
+        }
+    } else if (release > 0) {
+        // Die Felder zeigen in die JsonDocument, wie in checkForUpdate()
+        char version[16], text[128];
+        snprintf(version, sizeof(version), "9.%u", 22 + release);
+        state.updateVersion = version;
+        snprintf(text, sizeof(text), "https://github.com/Revisor01/auraos-moodlight/releases/tag/v%s", version);
+        state.updateReleaseUrl = text;
+        snprintf(text, sizeof(text), "/api/firmware/files/moodlight-%s.bin", version);
+        state.updateFirmwarePath = text;
+        snprintf(text, sizeof(text), "/api/firmware/files/moodlight-%s.bin.gz", version);
+        state.updateFirmwareGzPath = text;
+        snprintf(text, sizeof(text), "%08x%056x", (unsigned)release * 2654435761u, release);
+        state.updateFirmwareSha256 = text;
+        snprintf(text, sizeof(text), "/api/firmware/files/delta-9.%u-%s.bin", 21 + release, version);
+        state.updateDeltaPath = text;
+        snprintf(text, sizeof(text), "/api/firmware/files/ui-%s.tar", version);
+        state.updateUiPath = text;
+        state.updateLastError = "";
+    }
+    arenaFree(doc);
+}
+
+static void webRequest()
+{
+    void *request = arenaRealloc(nullptr, 512 + nextRandom(2560));
+    String response = httpBody(200 + nextRandom(800));
+    arenaFree(request);
+}
+
+struct SoakDay {
+    ArenaStats heap;
+    uint32_t calls;
+};
+
+// Simuliert days Tage; Werte je Tag, gemessen wenn nichts Kurzlebiges lebt
+template <typename State>
+static void soak(State &state, SoakDay *result, unsigned days)
+{
+    arenaReset();
+    hostHeap() = {arenaRealloc, arenaFree};
+    rng = 1;
+
+    // Dauerhafte Puffer ab Boot (WLAN, MQTT, Webserver)
+    arenaRealloc(nullptr, 6 * 1024);
+    arenaRealloc(nullptr, 2 * 1024);
+
+    for (unsigned day = 0; day < days; day++) {
+        uint32_t callsBefore = arenaCalls;
+        unsigned release = day < 2 ? 0 : 1 + (day - 2) / 5;    // Alle 5 Tage eine neue Version
+        for (unsigned hour = 0; hour < 24; hour++) {
+            moodUpdate(state);
+            webRequest();
+            updateCheck(state, release);
+            for (uint32_t n = nextRandom(5); n > 0; n--) {
+                webRequest();
+            }
+            moodUpdate(state);
+        }
+        result[day].heap = arenaStats();
+        result[day].calls = arenaCalls - callsBefore;
+    }
+}
+
+static void report(const char *name, const SoakDay *days, unsigned count)
+{
+    const unsigned shown[] = {0, 6, count - 1};
+    size_t minLargest = ARENA_BYTES;
+    for (unsigned i = 0; i < count; i++) {
+        minLargest = min(minLargest, days[i].heap.largest);
+    }
+    for (unsigned i : shown) {
+        char message[160];
+        snprintf(message, sizeof(message),
+                 "%s Tag %2u: frei %5u B, groesster Block %5u B (%.1f %% fragmentiert), %u Heap-Zugriffe/Tag",
+                 name, i + 1, (unsigned)days[i].heap.free, (unsigned)days[i].heap.largest,
+                 100.0 - days[i].heap.largest * 100.0 / days[i].heap.free, (unsigned)days[i].calls);
+        TEST_MESSAGE(message);
+    }
+    char message[96];
+    snprintf(message, sizeof(message), "%s kleinster groesster Block: %u B", name, (unsigned)minLargest);
+    TEST_MESSAGE(message);
+}
+
+static const unsigned SOAK_DAYS = 30;
+
+static void test_soak_heap_over_days()
+{
+    static SoakDay withString[SOAK_DAYS], withFixed[SOAK_DAYS];
+    {
+        StringState state;
+        soak(state, withString, SOAK_DAYS);
+        report("String     ", withString, SOAK_DAYS);
+    }
+    {
+        FixedState state;
+        soak(state, withFixed, SOAK_DAYS);
+        report("FixedString", withFixed, SOAK_DAYS);
+    }
+    hostHeap() = {countingRealloc, countingFree};
+
+    for (unsigned i = 0; i < SOAK_DAYS; i++) {
+        // Mit FixedString bleibt nach jedem Tag ein einziger freier Block
+        TEST_ASSERT_EQUAL(withFixed[i].heap.free, withFixed[i].heap.largest);
+        TEST_ASSERT_TRUE(withFixed[i].heap.largest >= withString[i].heap.largest);
+        TEST_ASSERT_TRUE(withFixed[i].calls <= withString[i].calls);
+    }
+    TEST_ASSERT_EQUAL(withFixed[0].heap.free, withFixed[SOAK_DAYS - 1].heap.free);
+}
+
+int main(int, char **)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_assign_and_truncate);
+    RUN_TEST(test_compares_like_string);
+    RUN_TEST(test_assignment_without_heap);
+    RUN_TEST(test_soak_heap_over_days);
+    return UNITY_END();
+}
@@ -0,0 +1,191 @@
+// Host-Test: binaerer Log-Ring (debug.cpp)
+//
+// Formatieren beim Lesen, Verdraengen im Ring und die Laufzeit-Schwelle, dazu
+// die Messung je Log-Aufruf: Aufrufe pro Sekunde und Heap-Allokationen, fuer
+// die alte Schreibweise (String-Verkettung, debug(String)), LOG_I mit rohen
+// Argumenten, debug(F()) und einen per Laufzeit-Schwelle verworfenen LOG_D.
+// Zum Vergleich das fruehere debug(): snprintf jeder Zeile in einen
+// 192-Byte-Slot. Serial ist aus — gemessen wird, was der Aufrufer bezahlt.
+// Die Zahlen stammen vom Host; auf dem Geraet stehen Takte je Aufruf unter
+// log in /api/system/metrics.
+
+#include <unity.h>
+
+#include "debug.cpp"
+
+static uint32_t allocations = 0;
+static void *countingRealloc(void *p, size_t n) { allocations++; return realloc(p, n); }
+
+static void resetRing()
+{
+    rtcLog.head = rtcLog.tail = rtcLog.count = 0;
+    logStats = LogStats();
+}
+
+void setUp()
+{
+    hostHeap() = {countingRealloc, free};
+    setLogSerial(false);
+    setLogLevel(LOG_LEVEL_TRACE);
+    resetRing();
+}
+
+void tearDown() {}
+
+static void test_formats_on_read()
+{
+    LOG_I("Sentiment %.2f, LED %d, %s", 0.25f, 3, "positiv");
+    LOG_W("Status %x %u%%", 255u, 7u);
+    debug(F("Literal"));
+    debug(String("Kopie ") + String(12));
+
+    String out;
+    formatLogs(out);
+    TEST_ASSERT_EQUAL_STRING("[0s] I Sentiment 0.25, LED 3, positiv\n"
+                             "[0s] W Status ff 7%\n"
+                             "[0s] I Literal\n"
+                             "[0s] I Kopie 12\n", out.c_str());
+}
+
+// %s nimmt auch Zahlen: wie String(x), Gleitkomma mit zwei Stellen
+static void test_numbers_for_string_conversion()
+{
+    LOG_I("%s %s %s %s", 5, 7u, -3L, 1.5f);
+
+    String out;
+    formatLogs(out);
+    TEST_ASSERT_EQUAL_STRING("[0s] I 5 7 -3 1.50\n", out.c_str());
+}
+
+static void test_ring_drops_oldest()
+{
+    for (int i = 0; i < 1000; i++) {
+        LOG_I("Eintrag %d", i);
+    }
+    TEST_ASSERT_TRUE(logStats.overwritten > 0);
+    TEST_ASSERT_EQUAL(1000, logStats.records);
+    TEST_ASSERT_EQUAL(1000 - logStats.overwritten, rtcLog.count);
+
+    String out;
+    formatLogs(out);
+    const char *last = strstr(out.c_str(), "Eintrag 999\n");
+    TEST_ASSERT_NOT_NULL(last);
+    TEST_ASSERT_EQUAL('\0', last[strlen("Eintrag 999\n")]);
+    TEST_ASSERT_NULL(strstr(out.c_str(), "Eintrag 0\n"));
+}
+
+static void test_long_arguments_are_truncated()
+{
+    char text[LOG_MAX_STRING_ARG * 2];
+    memset(text, 'a', sizeof(text) - 1);
+    text[sizeof(text) - 1] = '\0';
+    LOG_I("%s", text);
+    TEST_ASSERT_EQUAL(1, logStats.truncatedArgs);
+
+    String out;
+    formatLogs(out);
+    TEST_ASSERT_EQUAL(strlen("[0s] I ") + LOG_MAX_STRING_ARG + 1, out.length());
+}
+
+static void test_runtime_level_filters()
+{
+    setLogLevel(LOG_LEVEL_WARN);
+    LOG_I("weg %d", 1);
+    LOG_D("weg %d", 2);
+    debug(F("weg"));
+    LOG_W("bleibt %d", 3);
+    TEST_ASSERT_EQUAL(1, logStats.records);
+    TEST_ASSERT_EQUAL(1, logStats.perLevel[LOG_LEVEL_WARN]);
+}
+
+// ===== Messung =====
+
+// Das fruehere debug(): jede Zeile sofort in einen Slot formatiert
+static char legacySlots[20][192];
+static uint8_t legacyIndex = 0;
+static void legacyDebug(const String &message)
+{
+    snprintf(legacySlots[legacyIndex], sizeof(legacySlots[0]), "[%lus] %s", millis() / 1000, message.c_str());
+    legacyIndex = (legacyIndex + 1) % 20;
+}
+
+static const int BENCH_CALLS = 200000;
+
+// slotBytes: feste Eintragsgroesse, sonst der Schnitt aus dem Ring
+template <typename Call>
+static void bench(const char *name, Call call, unsigned slotBytes = 0)
+{
+    resetRing();
+    allocations = 0;
+    unsigned long start = micros();
+    for (int i = 0; i < BENCH_CALLS; i++) {
+        call(i);
+    }
+    unsigned long us = micros() - start;
+
+    unsigned bytes = slotBytes ? slotBytes : logStats.records ? logStats.bytesLogged / logStats.records : 0;
+    char message[160];
+    snprintf(message, sizeof(message), "%-32s %7.1f ns/Aufruf (%.1f Mio./s), %.2f Allokationen/Aufruf, %u Bytes/Eintrag",
+             name, us * 1000.0 / BENCH_CALLS, (double)BENCH_CALLS / (us ? us : 1), (double)allocations / BENCH_CALLS,
+             bytes);
+    TEST_MESSAGE(message);
+}
+
+static void test_benchmark_log_calls()
+{
+    static const char *const categories[] = {"negativ", "neutral", "sehr positiv"};
+    float score = 0.42f;
+
+    bench("frueher: String + snprintf-Slot", [&](int i) {
+        legacyDebug(String(F("Sentiment: ")) + String(score, 2) + F(", LED ") + String(i % 5) +
+                    F(", Kategorie ") + categories[i % 3]);
+    }, sizeof(legacySlots[0]));
+    bench("debug(String-Verkettung)", [&](int i) {
+        debug(String(F("Sentiment: ")) + String(score, 2) + F(", LED ") + String(i % 5) +
+              F(", Kategorie ") + categories[i % 3]);
+    });
+    bench("LOG_I mit Argumenten", [&](int i) {
+        LOG_I("Sentiment: %.2f, LED %d, Kategorie %s", score, i % 5, categories[i % 3]);
+    });
+    TEST_ASSERT_EQUAL(0, allocations);
+    bench("debug(F())", [&](int) {
+        debug(F("WiFi verbunden"));
+    });
+    TEST_ASSERT_EQUAL(0, allocations);
+
+    setLogLevel(LOG_LEVEL_INFO);
+    bench("LOG_D, Laufzeit-Schwelle info", [&](int i) {
+        LOG_D("Sentiment: %.2f, LED %d, Kategorie %s", score, i % 5, categories[i % 3]);
+    });
+    TEST_ASSERT_EQUAL(0, logStats.records);
+    setLogLevel(LOG_LEVEL_TRACE);
+
+    // Formatieren beim Lesen: ein voller Ring
+    resetRing();
+    for (int i = 0; i < 1000; i++) {
+        LOG_I("Sentiment: %.2f, LED %d, Kategorie %s", score, i % 5, categories[i % 3]);
+    }
+    const int reads = 200;
+    unsigned long start = micros();
+    for (int i = 0; i < reads; i++) {
+        String out;
+        formatLogs(out);
+    }
+    unsigned long us = micros() - start;
+    char message[128];
+    snprintf(message, sizeof(message), "formatLogs(): %u Eintraege in %.1f us (%.2f us je Eintrag)",
+             (unsigned)rtcLog.count, (double)us / reads, (double)us / reads / rtcLog.count);
+    TEST_MESSAGE(message);
+}
+
+int main(int, char **)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_formats_on_read);
+    RUN_TEST(test_numbers_for_string_conversion);
+    RUN_TEST(test_ring_drops_oldest);
+    RUN_TEST(test_long_arguments_are_truncated);
+    RUN_TEST(test_runtime_level_filters);
+    RUN_TEST(test_benchmark_log_calls);
+    return UNITY_END();
+}
@@ -0,0 +1,208 @@
+// Host-Test: Binaerbloecke der Einstellungen (settings_blob.h)
+//
+// Rundweg und Pruefung jedes Abschnitts, dazu die Messung fuer einen Speicher-
+// und Ladevorgang: Zeit, an NVS uebergebene Bytes und Heap. Zum Vergleich das fruehere Format — JSON-Datei
+// (Temp-Datei plus Backup-Kopie) und je Einstellung ein Preferences-Key —,
+// nachgebildet aus dem Schema. Die Zahlen stehen im Testprotokoll; auf dem
+// Geraet liefert /api/system/metrics (settings) die echten Werte.
+
+#include <unity.h>
+#include <new>
+
+#include "settings_schema.cpp"
+#include "settings_blob.cpp"
+
+// Heap-Zugriffe zaehlen: Kodieren und Pruefen sollen ohne auskommen
+static size_t allocations = 0;
+
+void *operator new(size_t size)
+{
+    allocations++;
+    void *p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+static void fillSample(SettingsPayload &p)
+{
+    memset(&p, 0, sizeof(p));
+    for (const SettingSchema &s : settingsSchema) {
+        if (s.type == SETTING_TEXT) {
+            // Typische Laengen: SSID, Passwort, URL, Broker, Benutzer
+            char text[SETTINGS_URL_LEN];
+            size_t len = s.max < 40 ? s.max / 2 : 24;
+            memset(text, 'x', len);
+            text[len] = '\0';
+            writeSettingText(s, p, text);
+        } else {
+            writeSetting(s, p, s.def);
+        }
+    }
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_sections_round_trip()
+{
+    SettingsPayload original, copy;
+    fillSample(original);
+    memset(&copy, 0, sizeof(copy));
+
+    uint8_t buffer[SETTINGS_SECTION_BLOB_MAX];
+    for (uint8_t id = 0; id < SECTION_COUNT; id++) {
+        size_t len = encodeSettingsSection(id, original, buffer);
+        TEST_ASSERT_EQUAL(sizeof(SettingsBlobHeader) + settingsSections[id].size, len);
+        uint8_t version = 0;
+        TEST_ASSERT_EQUAL(SETTINGS_BLOB_OK, decodeSettingsSection(id, buffer, len, copy, version));
+        TEST_ASSERT_EQUAL(SETTINGS_SCHEMA_VERSION, version);
+    }
+    TEST_ASSERT_EQUAL_MEMORY(&original, &copy, sizeof(original));
+}
+
+static void test_damaged_blocks_are_rejected()
+{
+    SettingsPayload p, target;
+    fillSample(p);
+    fillSample(target);
+    uint8_t buffer[SETTINGS_SECTION_BLOB_MAX];
+    size_t len = encodeSettingsSection(SECTION_NET, p, buffer);
+    uint8_t version;
+
+    buffer[len - 1] ^= 0x01;
+    TEST_ASSERT_EQUAL(SETTINGS_BLOB_CRC, decodeSettingsSection(SECTION_NET, buffer, len, target, version));
+    buffer[len - 1] ^= 0x01;
+
+    TEST_ASSERT_EQUAL(SETTINGS_BLOB_FORMAT, decodeSettingsSection(SECTION_NET, buffer, len - 1, target, version));
+    TEST_ASSERT_EQUAL(SETTINGS_BLOB_FORMAT, decodeSettingsSection(SECTION_NET, buffer, 4, target, version));
+    buffer[0] ^= 0xFF;
+    TEST_ASSERT_EQUAL(SETTINGS_BLOB_FORMAT, decodeSettingsSection(SECTION_NET, buffer, len, target, version));
+}
+
+// Ein Block aus einem aelteren Schema ist ein Praefix des aktuellen Abschnitts
+// (hier ohne das letzte Feld prefetchRate): es behaelt den vorbelegten Stand
+static void test_older_schema_keeps_new_fields()
+{
+    SettingsPayload p, target;
+    fillSample(p);
+    p.device.prefetchRate = 99;
+    fillSample(target);
+
+    uint8_t buffer[SETTINGS_SECTION_BLOB_MAX];
+    const size_t oldSize = offsetof(DeviceSettings, prefetchRate);
+    SettingsBlobHeader header = {SETTINGS_BLOB_MAGIC, 0, 0, (uint16_t)oldSize, 0,
+                                 settingsCrc((const uint8_t *)&p.device, oldSize)};
+    memcpy(buffer, &header, sizeof(header));
+    memcpy(buffer + sizeof(header), &p.device, oldSize);
+
+    uint8_t version = 0xFF;
+    TEST_ASSERT_EQUAL(SETTINGS_BLOB_OK,
+                      decodeSettingsSection(SECTION_DEVICE, buffer, sizeof(header) + oldSize, target, version));
+    TEST_ASSERT_EQUAL(0, version);
+    TEST_ASSERT_EQUAL(UPDATE_PREFETCH_DEFAULT_RATE, target.device.prefetchRate);
+    TEST_ASSERT_EQUAL_MEMORY(&p.device, &target.device, oldSize);
+}
+
+static void test_encode_decode_without_heap()
+{
+    SettingsPayload p, copy;
+    fillSample(p);
+    uint8_t buffer[SETTINGS_SECTION_BLOB_MAX];
+    uint8_t version;
+
+    size_t before = allocations;
+    for (uint8_t id = 0; id < SECTION_COUNT; id++) {
+        size_t len = encodeSettingsSection(id, p, buffer);
+        decodeSettingsSection(id, buffer, len, copy, version);
+    }
+    TEST_ASSERT_EQUAL(0, allocations - before);
+}
+
+// Frueheres Format: die JSON-Datei (wie serializeJson, ohne Leerzeichen)
+static size_t legacyJsonBytes(const SettingsPayload &p)
+{
+    size_t bytes = 2;   // {}
+    for (const SettingSchema &s : settingsSchema) {
+        char value[SETTINGS_URL_LEN + 8];
+        if (s.type == SETTING_TEXT) {
+            snprintf(value, sizeof(value), "\"%s\"", (const char *)settingPtr(s, p));
+        } else if (s.type == SETTING_FLAG) {
+            snprintf(value, sizeof(value), "%s", readSetting(s, p) ? "true" : "false");
+        } else {
+            snprintf(value, sizeof(value), "%lld", (long long)readSetting(s, p));
+        }
+        bytes += strlen(s.key) + 3 + strlen(value) + 1;    // "key":value,
+    }
+    return bytes - 1;
+}
+
+// ... und je Einstellung ein Preferences-Key: Zahlen ein NVS-Eintrag, Texte
+// ein Kopf- plus ihre Dateneintraege
+static size_t legacyPreferencesBytes(const SettingsPayload &p)
+{
+    size_t bytes = 0;
+    for (const SettingSchema &s : settingsSchema) {
+        if (s.type == SETTING_TEXT) {
+            size_t len = strlen((const char *)settingPtr(s, p)) + 1;
+            bytes += NVS_ENTRY_BYTES * (1 + (len + NVS_ENTRY_BYTES - 1) / NVS_ENTRY_BYTES);
+        } else {
+            bytes += NVS_ENTRY_BYTES;
+        }
+    }
+    return bytes;
+}
+
+static void test_benchmark_save_and_load()
+{
+    const int rounds = 20000;
+    SettingsPayload p, copy;
+    fillSample(p);
+    uint8_t buffer[SETTINGS_SECTION_BLOB_MAX];
+    uint8_t version;
+    char message[160];
+
+    for (uint8_t id = 0; id < SECTION_COUNT; id++) {
+        size_t len = 0;
+        unsigned long start = micros();
+        for (int i = 0; i < rounds; i++) {
+            len = encodeSettingsSection(id, p, buffer);
+        }
+        unsigned long encodeUs = micros() - start;
+
+        start = micros();
+        for (int i = 0; i < rounds; i++) {
+            decodeSettingsSection(id, buffer, len, copy, version);
+        }
+        unsigned long decodeUs = micros() - start;
+
+        snprintf(message, sizeof(message),
+                 "%s: %u Bytes, %u Bytes NVS belegt, kodieren %.3f us, pruefen %.3f us",
+                 settingsSections[id].key, (unsigned)len, (unsigned)nvsBlobFootprint(len),
+                 (double)encodeUs / rounds, (double)decodeUs / rounds);
+        TEST_MESSAGE(message);
+    }
+
+    size_t json = legacyJsonBytes(p);
+    size_t prefs = legacyPreferencesBytes(p);
+    size_t run = nvsBlobFootprint(sizeof(SettingsBlobHeader) + sizeof(RuntimeSettings));
+    snprintf(message, sizeof(message),
+             "Frueher je Speichern: JSON %u Bytes x2 (Temp + Backup) + %u Bytes Preferences; "
+             "jetzt Helligkeit: %u Bytes (cfg.run) bzw. %u Bytes (Journal)",
+             (unsigned)json, (unsigned)prefs, (unsigned)run, (unsigned)NVS_ENTRY_BYTES);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(run < prefs);
+}
+
+int main(int, char **)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_sections_round_trip);
+    RUN_TEST(test_damaged_blocks_are_rejected);
+    RUN_TEST(test_older_schema_keeps_new_fields);
+    RUN_TEST(test_encode_decode_without_heap);
+    RUN_TEST(test_benchmark_save_and_load);
+    return UNITY_END();
+}
@@ -0,0 +1,375 @@
+// Host-Test: Einstellungsschema (settings_schema.h) und WebUI (settings_web.h)
+//
+// Prueft, dass jede Zeile verlustfrei durch die WebUI-Darstellung und zurueck
+// kommt, dass /api/settings/all (settingsWebJson()) dasselbe liefert wie der
+// fruehere handgeschriebene Handler (als Referenz hier nachgebaut) und dass die
+// Formulare ihre Eingaben wie vorher pruefen. Dazu ein Zeitvergleich Schema
+// gegen Handarbeit; die Zahlen stehen im Testprotokoll.
+
+#include <unity.h>
+
+#include "settings_schema.cpp"
+#include "settings_web.cpp"
+
+// Ein Feld der Antwort, als Text: Zahlen dezimal, bool als true/false,
+// Texte in Anfuehrungszeichen. Farben-Array als colors[0] ... colors[4].
+struct WebField {
+    char name[24];
+    char value[SETTINGS_URL_LEN + 2];
+};
+
+struct WebFields {
+    WebField fields[SETTINGS_SCHEMA_COUNT];
+    size_t count = 0;
+
+    void add(const char *name, const char *value) {
+        WebField &f = fields[count++];
+        snprintf(f.name, sizeof(f.name), "%s", name);
+        snprintf(f.value, sizeof(f.value), "%s", value);
+    }
+    void addNumber(const char *name, long long value) {
+        char text[24];
+        snprintf(text, sizeof(text), "%lld", value);
+        add(name, text);
+    }
+    void addBool(const char *name, bool value) {
+        add(name, value ? "true" : "false");
+    }
+    void addText(const char *name, const char *value) {
+        char text[SETTINGS_URL_LEN + 2];
+        snprintf(text, sizeof(text), "\"%s\"", value);
+        add(name, text);
+    }
+    const WebField *find(const char *name) const {
+        for (size_t i = 0; i < count; i++) {
+            if (strcmp(fields[i].name, name) == 0) return &fields[i];
+        }
+        return nullptr;
+    }
+};
+
+static void addWebField(WebFields &out, const char *name, JsonVariantConst value) {
+    if (value.is<bool>()) {
+        out.addBool(name, value.as<bool>());
+    } else if (value.is<long long>()) {
+        out.addNumber(name, value.as<long long>());
+    } else if (value.is<const char*>()) {
+        out.addText(name, value.as<const char*>());
+    } else {
+        TEST_FAIL_MESSAGE(name);
+    }
+}
+
+// Antwort als WebFields, damit Reihenfolge und Zahlentyp keine Rolle spielen
+static void webFields(const JsonDocument &doc, WebFields &out) {
+    for (JsonPairConst field : doc.as<JsonObjectConst>()) {
+        if (!field.value().is<JsonArrayConst>()) {
+            addWebField(out, field.key().c_str(), field.value());
+            continue;
+        }
+        unsigned index = 0;
+        for (JsonVariantConst item : field.value().as<JsonArrayConst>()) {
+            char name[24];
+            snprintf(name, sizeof(name), "%s[%u]", field.key().c_str(), index++);
+            addWebField(out, name, item);
+        }
+    }
+}
+
+// Der fruehere Handler von /api/settings/all, Feld fuer Feld von Hand
+static void handWrittenWebJson(const SettingsPayload &p, JsonDocument &doc) {
+    char hex[10];
+    doc["moodInterval"] = (long)(p.device.moodInterval / 1000);
+    doc["dhtInterval"] = (long)(p.device.dhtInterval / 1000);
+    doc["autoMode"] = (bool)(p.run.flags & SETTING_AUTO_MODE);
+    doc["lightOn"] = (bool)(p.run.flags & SETTING_LIGHT_ON);
+    doc["manBright"] = (long)p.run.manualBrightness;
+    snprintf(hex, sizeof(hex), "#%06X", (unsigned)(p.run.manualColor & 0xFFFFFF));
+    doc["manColor"] = (const char*)hex;
+    doc["wifiSSID"] = (const char*)p.net.wifiSSID;
+    doc["wifiConfigured"] = (bool)(p.net.flags & SETTING_WIFI_CONFIGURED);
+    doc["apiUrl"] = (const char*)p.net.apiUrl;
+    doc["mqttServer"] = (const char*)p.net.mqttServer;
+    doc["mqttUser"] = (const char*)p.net.mqttUser;
+    doc["dhtPin"] = (long)p.device.dhtPin;
+    doc["dhtEnabled"] = (bool)(p.device.flags & SETTING_DHT_ENABLED);
+    doc["ledPin"] = (long)p.device.ledPin;
+    doc["numLeds"] = (long)p.device.numLeds;
+    doc["mqttEnabled"] = (bool)(p.net.flags & SETTING_MQTT_ENABLED);
+    for (int i = 0; i < 5; i++) {
+        snprintf(hex, sizeof(hex), "#%06X", (unsigned)(p.device.customColors[i] & 0xFFFFFF));
+        doc["colors"].add((const char*)hex);
+    }
+}
+
+// Gueltige Werte abseits der Standardwerte, damit ein vergessenes Feld auffaellt
+static void fillSample(SettingsPayload &p, uint32_t seed) {
+    memset(&p, 0, sizeof(p));
+    for (const SettingSchema &s : settingsSchema) {
+        seed = seed * 1103515245 + 12345;
+        if (s.type == SETTING_TEXT) {
+            // Leer hiesse bei SETTING_KEEP_EMPTY "unveraendert" — kein Rundweg
+            size_t lo = (s.web & SETTING_KEEP_EMPTY) && s.min == 0 ? 1 : s.min;
+            size_t len = lo + seed % (s.max - lo + 1);
+            char text[SETTINGS_URL_LEN];
+            for (size_t i = 0; i < len; i++) {
+                text[i] = 'a' + (seed >> 8) % 26;
+                seed = seed * 1103515245 + 12345;
+            }
+            text[len] = '\0';
+            writeSettingText(s, p, text);
+            continue;
+        }
+        int64_t value = s.min + (int64_t)(seed >> 4) % ((int64_t)s.max - s.min + 1);
+        if (s.web & SETTING_SECONDS) {
+            value -= value % 1000;
+            value = constrain(value, (int64_t)s.min, (int64_t)s.max);
+        }
+        if (s.type == SETTING_PIN && !settingInRange(s, value)) {
+            value = 4;
+        }
+        writeSetting(s, p, value);
+    }
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_every_row_round_trips_through_web()
+{
+    for (uint32_t seed = 1; seed <= 200; seed++) {
+        SettingsPayload original, copy;
+        fillSample(original, seed);
+        fillSample(copy, seed + 1000);
+
+        for (const SettingSchema &s : settingsSchema) {
+            SettingWebValue value;
+            settingWebValue(s, original, value);
+            SettingInput result = value.kind == SettingWebValue::TEXT
+                ? settingFromWeb(s, copy, value.text)
+                : settingFromWeb(s, copy, value.number);
+            TEST_ASSERT_TRUE_MESSAGE(result != SETTING_INPUT_INVALID, s.key);
+            TEST_ASSERT_FALSE_MESSAGE(settingDiffers(s, original, copy), s.key);
+        }
+        TEST_ASSERT_EQUAL_MEMORY(&original, &copy, sizeof(original));
+    }
+}
+
+static void test_every_row_round_trips_through_numbers()
+{
+    SettingsPayload original, copy;
+    fillSample(original, 7);
+    memset(&copy, 0xFF, sizeof(copy));
+    for (const SettingSchema &s : settingsSchema) {
+        if (s.type == SETTING_TEXT) {
+            writeSettingText(s, copy, (const char *)settingPtr(s, original));
+        } else {
+            writeSetting(s, copy, readSetting(s, original));
+        }
+    }
+    // Nur die Flag-Bytes haben Bits ausserhalb des Schemas
+    for (const SettingSchema &s : settingsSchema) {
+        TEST_ASSERT_FALSE_MESSAGE(settingDiffers(s, original, copy), s.key);
+    }
+}
+
+static void test_settings_all_matches_hand_written_handler()
+{
+    for (uint32_t seed = 1; seed <= 50; seed++) {
+        SettingsPayload p;
+        fillSample(p, seed);
+        JsonDocument generatedDoc, referenceDoc;
+        settingsWebJson(p, generatedDoc);
+        handWrittenWebJson(p, referenceDoc);
+        WebFields generated, reference;
+        webFields(generatedDoc, generated);
+        webFields(referenceDoc, reference);
+
+        for (size_t i = 0; i < reference.count; i++) {
+            const WebField *field = generated.find(reference.fields[i].name);
+            TEST_ASSERT_NOT_NULL_MESSAGE(field, reference.fields[i].name);
+            TEST_ASSERT_EQUAL_STRING_MESSAGE(reference.fields[i].value, field->value, reference.fields[i].name);
+        }
+        // Neu dazugekommen sind nur die Update-Einstellungen; Passwoerter nie
+        TEST_ASSERT_EQUAL(reference.count + 3, generated.count);
+        TEST_ASSERT_NOT_NULL(generated.find("updateCheck"));
+        TEST_ASSERT_NOT_NULL(generated.find("updatePrefetch"));
+        TEST_ASSERT_NOT_NULL(generated.find("prefetchRate"));
+        TEST_ASSERT_NULL(generated.find("wifiPass"));
+        TEST_ASSERT_NULL(generated.find("mqttPass"));
+    }
+}
+
+static const SettingSchema &row(const char *key)
+{
+    const SettingSchema *s = findSetting(key);
+    TEST_ASSERT_NOT_NULL(s);
+    return *s;
+}
+
+static void test_wifi_form_limits()
+{
+    SettingsPayload p;
+    fillSample(p, 3);
+    char error[64];
+
+    TEST_ASSERT_EQUAL(SETTING_INPUT_INVALID, settingFromWeb(row("wifiSSID"), p, ""));
+    settingInputError(row("wifiSSID"), error, sizeof(error));
+    TEST_ASSERT_EQUAL_STRING("ssid muss 1-32 Zeichen lang sein", error);
+    TEST_ASSERT_EQUAL(SETTING_INPUT_INVALID,
+                      settingFromWeb(row("wifiSSID"), p, "123456789012345678901234567890123"));
+    TEST_ASSERT_EQUAL(SETTING_INPUT_CHANGED,
+                      settingFromWeb(row("wifiSSID"), p, "12345678901234567890123456789012"));
+
+    // Offenes WLAN: leeres Passwort wird uebernommen, die Maske nicht
+    TEST_ASSERT_EQUAL(SETTING_INPUT_CHANGED, settingFromWeb(row("wifiPass"), p, "secret"));
+    TEST_ASSERT_EQUAL(SETTING_INPUT_KEPT, settingFromWeb(row("wifiPass"), p, "****"));
+    TEST_ASSERT_EQUAL_STRING("secret", p.net.wifiPassword);
+    TEST_ASSERT_EQUAL(SETTING_INPUT_CHANGED, settingFromWeb(row("wifiPass"), p, ""));
+    TEST_ASSERT_EQUAL_STRING("", p.net.wifiPassword);
+
+    char tooLong[65];
+    memset(tooLong, 'x', 64);
+    tooLong[64] = '\0';
+    TEST_ASSERT_EQUAL(SETTING_INPUT_INVALID, settingFromWeb(row("wifiPass"), p, tooLong));
+    settingInputError(row("wifiPass"), error, sizeof(error));
+    TEST_ASSERT_EQUAL_STRING("pass darf maximal 63 Zeichen lang sein", error);
+}
+
+static void test_mqtt_form_keeps_password()
+{
+    SettingsPayload p;
+    memset(&p, 0, sizeof(p));
+    TEST_ASSERT_EQUAL(SETTING_INPUT_CHANGED, settingFromWeb(row("mqttPass"), p, "geheim"));
+    TEST_ASSERT_EQUAL(SETTING_INPUT_KEPT, settingFromWeb(row("mqttPass"), p, ""));
+    TEST_ASSERT_EQUAL(SETTING_INPUT_KEPT, settingFromWeb(row("mqttPass"), p, "****"));
+    TEST_ASSERT_EQUAL_STRING("geheim", p.net.mqttPassword);
+
+    TEST_ASSERT_EQUAL(SETTING_INPUT_CHANGED, settingFromWeb(row("mqttEnabled"), p, (int64_t)1));
+    TEST_ASSERT_EQUAL(SETTING_INPUT_KEPT, settingFromWeb(row("mqttEnabled"), p, (int64_t)1));
+    TEST_ASSERT_TRUE(p.net.flags & SETTING_MQTT_ENABLED);
+    TEST_ASSERT_EQUAL(SETTING_INPUT_KEPT, settingFromWeb(row("mqttServer"), p, ""));
+
+    // Formularfelder und ihre Namen kommen aus dem Schema
+    const char *expected[] = {"enabled", "server", "user", "pass"};
+    size_t n = 0;
+    for (const SettingSchema &s : settingsSchema) {
+        if (s.form != SETTING_FORM_MQTT) continue;
+        TEST_ASSERT_TRUE(n < 4);
+        TEST_ASSERT_EQUAL_STRING(expected[n++], s.webKey);
+    }
+    TEST_ASSERT_EQUAL(4, n);
+}
+
+static void test_numbers_are_clamped()
+{
+    SettingsPayload p;
+    fillSample(p, 9);
+    // Sekunden werden vor der Multiplikation begrenzt
+    settingFromWeb(row("moodInterval"), p, (int64_t)5000000000LL);
+    TEST_ASSERT_EQUAL_UINT32(7200000, p.device.moodInterval);
+    settingFromWeb(row("dhtInterval"), p, (int64_t)1);
+    TEST_ASSERT_EQUAL_UINT32(10000, p.device.dhtInterval);
+    // Flash-Pins lehnt das Formular ab; aus dem Flash werden sie zum Standard
+    int8_t ledPin = p.device.ledPin;
+    TEST_ASSERT_EQUAL(SETTING_INPUT_INVALID, settingFromWeb(row("ledPin"), p, (int64_t)7));
+    TEST_ASSERT_EQUAL(ledPin, p.device.ledPin);
+    TEST_ASSERT_EQUAL(SETTING_INPUT_INVALID, settingFromWeb(row("dhtPin"), p, (int64_t)40));
+    writeSetting(row("ledPin"), p, 7);
+    TEST_ASSERT_EQUAL(DEFAULT_LED_PIN, p.device.ledPin);
+    // Farben als "#RRGGBB"
+    TEST_ASSERT_EQUAL(SETTING_INPUT_INVALID, settingFromWeb(row("color1"), p, "#12345G"));
+    settingFromWeb(row("color1"), p, "#12ab56");
+    TEST_ASSERT_EQUAL_UINT32(0x12AB56, p.device.customColors[1]);
+}
+
+// /saveapi, /savecolors und /savehardware laufen ueber dasselbe Schema
+static void test_api_colors_hardware_forms()
+{
+    SettingsPayload p;
+    fillSample(p, 5);
+    JsonDocument in;
+    String error;
+
+    // Sekunden (auch als Kommazahl) und dhtEnabled als bool
+    deserializeJson(in, "{\"apiUrl\":\"http://example.org/api\",\"moodInterval\":60,"
+                        "\"dhtEnabled\":false,\"dhtInterval\":30.7}");
+    TEST_ASSERT_TRUE(settingsFromForm(SETTING_FORM_API, in.as<JsonVariantConst>(), p, error) > 0);
+    TEST_ASSERT_EQUAL_STRING("http://example.org/api", p.net.apiUrl);
+    TEST_ASSERT_EQUAL_UINT32(60000, p.device.moodInterval);
+    TEST_ASSERT_EQUAL_UINT32(30000, p.device.dhtInterval);
+    TEST_ASSERT_FALSE(p.device.flags & SETTING_DHT_ENABLED);
+    TEST_ASSERT_EQUAL(0, settingsFromForm(SETTING_FORM_API, in.as<JsonVariantConst>(), p, error));
+
+    // Zu lange URL wird abgelehnt, nicht gekuerzt
+    char body[SETTINGS_URL_LEN + 32];
+    int n = snprintf(body, sizeof(body), "{\"apiUrl\":\"http://");
+    while (n < SETTINGS_URL_LEN + 12) body[n++] = 'x';
+    snprintf(body + n, sizeof(body) - n, "\"}");
+    deserializeJson(in, body);
+    TEST_ASSERT_EQUAL(-1, settingsFromForm(SETTING_FORM_API, in.as<JsonVariantConst>(), p, error));
+    TEST_ASSERT_EQUAL_STRING("apiUrl darf maximal 160 Zeichen lang sein", error.c_str());
+
+    // Farben der Reihe nach aus dem Array, mit oder ohne '#'
+    deserializeJson(in, "{\"colors\":[\"#010203\",\"#a0b0c0\",\"#FFFFFF\",\"000000\",\"#123456\"]}");
+    TEST_ASSERT_TRUE(settingsFromForm(SETTING_FORM_COLORS, in.as<JsonVariantConst>(), p, error) >= 0);
+    const uint32_t colors[5] = {0x010203, 0xA0B0C0, 0xFFFFFF, 0x000000, 0x123456};
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(colors, p.device.customColors, 5);
+    deserializeJson(in, "{\"colors\":[\"#010203\",\"#zzzzzz\",\"#FFFFFF\",\"000000\",\"#123456\"]}");
+    TEST_ASSERT_EQUAL(-1, settingsFromForm(SETTING_FORM_COLORS, in.as<JsonVariantConst>(), p, error));
+    TEST_ASSERT_EQUAL_STRING("colors: ungueltiger Wert", error.c_str());
+
+    // Ein Flash-Pin lehnt das ganze Formular ab; LED-Anzahl wird begrenzt
+    deserializeJson(in, "{\"ledPin\":7,\"dhtPin\":4,\"numLeds\":500}");
+    TEST_ASSERT_EQUAL(-1, settingsFromForm(SETTING_FORM_HARDWARE, in.as<JsonVariantConst>(), p, error));
+    TEST_ASSERT_EQUAL_STRING("ledPin: ungueltiger Wert", error.c_str());
+    deserializeJson(in, "{\"ledPin\":25,\"dhtPin\":4,\"numLeds\":500}");
+    TEST_ASSERT_TRUE(settingsFromForm(SETTING_FORM_HARDWARE, in.as<JsonVariantConst>(), p, error) > 0);
+    TEST_ASSERT_EQUAL(25, p.device.ledPin);
+    TEST_ASSERT_EQUAL(4, p.device.dhtPin);
+    TEST_ASSERT_EQUAL(MAX_LEDS, p.device.numLeds);
+}
+
+// Zeitvergleich: /api/settings/all aus dem Schema gegen den handgeschriebenen
+// Handler. Beide schreiben in ein JsonDocument, gemessen wird also nur die
+// Feldauswahl und Umrechnung.
+static void test_benchmark_generated_vs_hand_written()
+{
+    const int rounds = 20000;
+    SettingsPayload p;
+    fillSample(p, 11);
+    JsonDocument out;
+
+    unsigned long start = micros();
+    for (int i = 0; i < rounds; i++) {
+        out.clear();
+        settingsWebJson(p, out);
+    }
+    unsigned long generatedUs = micros() - start;
+
+    start = micros();
+    for (int i = 0; i < rounds; i++) {
+        out.clear();
+        handWrittenWebJson(p, out);
+    }
+    unsigned long handUs = micros() - start;
+
+    char message[128];
+    snprintf(message, sizeof(message), "settings/all: Schema %.2f us, von Hand %.2f us je Antwort (%d Runden)",
+             (double)generatedUs / rounds, (double)handUs / rounds, rounds);
+    TEST_MESSAGE(message);
+}
+
+int main(int, char **)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_every_row_round_trips_through_web);
+    RUN_TEST(test_every_row_round_trips_through_numbers);
+    RUN_TEST(test_settings_all_matches_hand_written_handler);
+    RUN_TEST(test_wifi_form_limits);
+    RUN_TEST(test_mqtt_form_keeps_password);
+    RUN_TEST(test_numbers_are_clamped);
+    RUN_TEST(test_api_colors_hardware_forms);
+    RUN_TEST(test_benchmark_generated_vs_hand_written);
+    return UNITY_END();
+}
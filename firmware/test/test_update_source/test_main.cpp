@@ -0,0 +1,236 @@
+// Host-Test: Reihenfolge und Rueckfall der Update-Quellen (update_source.h)
+//
+// Das Stub-Backend spielt Download und Flash nach: je Quelle ist festgelegt,
+// ob sie liefert, scheitert oder uebersprungen wird. Geprueft wird, welche
+// Quellen in welcher Reihenfolge versucht werden.
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "update_source.cpp"
+
+static const uint32_t SELF_IP = 0x0A00A8C0;   // 192.168.0.10
+
+struct StubBackend {
+    UpdateAttempt peer[UPDATE_PEER_SCAN_MAX];
+    UpdateAttempt delta = UPDATE_ATTEMPT_FAILED;
+    UpdateAttempt gzip = UPDATE_ATTEMPT_FAILED;
+    UpdateAttempt raw = UPDATE_ATTEMPT_FAILED;
+
+    char log[128] = {};     // Versuchte Quellen, z.B. "P0 P2 D G R"
+};
+
+static UpdateAttempt stubAttempt(const UpdateSource &source, void *ctx)
+{
+    StubBackend &backend = *static_cast<StubBackend *>(ctx);
+    char entry[8];
+    UpdateAttempt result = UPDATE_ATTEMPT_FAILED;
+    switch (source.kind) {
+        case UPDATE_SOURCE_PEER:
+            snprintf(entry, sizeof(entry), "P%u ", source.peer);
+            result = backend.peer[source.peer];
+            break;
+        case UPDATE_SOURCE_DELTA:
+            snprintf(entry, sizeof(entry), "D ");
+            result = backend.delta;
+            break;
+        case UPDATE_SOURCE_GZIP:
+            snprintf(entry, sizeof(entry), "G ");
+            result = backend.gzip;
+            break;
+        case UPDATE_SOURCE_RAW:
+            snprintf(entry, sizeof(entry), "R ");
+            result = backend.raw;
+            break;
+    }
+    strncat(backend.log, entry, sizeof(backend.log) - strlen(backend.log) - 1);
+    return result;
+}
+
+static UpdatePeer makePeer(uint32_t ip, const char *fw, const char *pre = "")
+{
+    UpdatePeer peer;
+    peer.ip = ip;
+    peer.port = 80;
+    strncpy(peer.fw, fw, sizeof(peer.fw) - 1);
+    strncpy(peer.pre, pre, sizeof(peer.pre) - 1);
+    return peer;
+}
+
+static UpdateOffer fullOffer()
+{
+    UpdateOffer offer;
+    offer.version = "9.5";
+    offer.firmwareSize = 1200000;
+    offer.selfIp = SELF_IP;
+    offer.delta = true;
+    offer.gzip = true;
+    return offer;
+}
+
+// Plant, laesst das Stub-Backend laufen und liefert die versuchten Quellen
+static const char *run(const UpdateOffer &offer, const UpdatePeer *peers, uint8_t peerCount,
+                       StubBackend &backend, int &used)
+{
+    UpdateSource plan[UPDATE_SOURCES_MAX];
+    uint8_t count = planUpdateSources(offer, peers, peerCount, plan, UPDATE_SOURCES_MAX);
+    used = runUpdateSources(plan, count, stubAttempt, &backend);
+    size_t len = strlen(backend.log);
+    if (len > 0) {
+        backend.log[len - 1] = '\0';
+    }
+    return backend.log;
+}
+
+static void initPeers(StubBackend &backend, UpdateAttempt result)
+{
+    for (auto &peer : backend.peer) {
+        peer = result;
+    }
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_order_peer_delta_gzip_raw()
+{
+    UpdatePeer peers[] = {makePeer(0x0B00A8C0, "9.5")};
+    StubBackend backend;
+    initPeers(backend, UPDATE_ATTEMPT_FAILED);
+    backend.gzip = UPDATE_ATTEMPT_SKIPPED;
+    int used;
+    TEST_ASSERT_EQUAL_STRING("P0 D G R", run(fullOffer(), peers, 1, backend, used));
+    TEST_ASSERT_EQUAL_INT(-1, used);
+}
+
+static void test_peer_success_stops()
+{
+    UpdatePeer peers[] = {makePeer(0x0B00A8C0, "9.5"), makePeer(0x0C00A8C0, "9.5")};
+    StubBackend backend;
+    initPeers(backend, UPDATE_ATTEMPT_OK);
+    int used;
+    TEST_ASSERT_EQUAL_STRING("P0", run(fullOffer(), peers, 2, backend, used));
+    TEST_ASSERT_EQUAL_INT(0, used);
+}
+
+static void test_peer_filter_self_and_version()
+{
+    UpdatePeer peers[] = {
+        makePeer(SELF_IP, "9.5"),               // das eigene Geraet
+        makePeer(0x0B00A8C0, "9.4"),            // alte Version
+        makePeer(0x0C00A8C0, "9.4", "9.5"),     // vorab geladen
+        makePeer(0x0D00A8C0, "9.5"),
+    };
+    StubBackend backend;
+    initPeers(backend, UPDATE_ATTEMPT_FAILED);
+    backend.delta = UPDATE_ATTEMPT_OK;
+    int used;
+    TEST_ASSERT_EQUAL_STRING("P2 P3 D", run(fullOffer(), peers, 4, backend, used));
+    TEST_ASSERT_EQUAL_INT(2, used);
+}
+
+static void test_peer_tries_capped()
+{
+    UpdatePeer peers[UPDATE_PEER_MAX_TRIES + 2];
+    for (uint8_t i = 0; i < UPDATE_PEER_MAX_TRIES + 2; i++) {
+        peers[i] = makePeer(0x0B00A8C0 + i, "9.5");
+    }
+    StubBackend backend;
+    initPeers(backend, UPDATE_ATTEMPT_FAILED);
+    backend.delta = UPDATE_ATTEMPT_SKIPPED;
+    backend.gzip = UPDATE_ATTEMPT_OK;
+
+    UpdateSource plan[UPDATE_SOURCES_MAX];
+    uint8_t count = planUpdateSources(fullOffer(), peers, UPDATE_PEER_MAX_TRIES + 2, plan,
+                                      UPDATE_SOURCES_MAX);
+    TEST_ASSERT_EQUAL_UINT8(UPDATE_PEER_MAX_TRIES + 3, count);
+    uint8_t peerSources = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        peerSources += plan[i].kind == UPDATE_SOURCE_PEER;
+    }
+    TEST_ASSERT_EQUAL_UINT8(UPDATE_PEER_MAX_TRIES, peerSources);
+}
+
+static void test_no_peers_without_size()
+{
+    UpdatePeer peers[] = {makePeer(0x0B00A8C0, "9.5")};
+    UpdateOffer offer = fullOffer();
+    offer.firmwareSize = 0;
+    StubBackend backend;
+    initPeers(backend, UPDATE_ATTEMPT_OK);
+    backend.raw = UPDATE_ATTEMPT_OK;
+    int used;
+    // Ohne Groesse weder Peer noch Patch noch Entpacken — nur das rohe Binary
+    TEST_ASSERT_EQUAL_STRING("R", run(offer, peers, 1, backend, used));
+    TEST_ASSERT_EQUAL_INT(0, used);
+}
+
+static void test_delta_failure_falls_back_to_gzip()
+{
+    StubBackend backend;
+    backend.delta = UPDATE_ATTEMPT_FAILED;
+    backend.gzip = UPDATE_ATTEMPT_OK;
+    int used;
+    TEST_ASSERT_EQUAL_STRING("D G", run(fullOffer(), nullptr, 0, backend, used));
+    TEST_ASSERT_EQUAL_INT(1, used);
+}
+
+static void test_gzip_failure_stops()
+{
+    StubBackend backend;
+    backend.delta = UPDATE_ATTEMPT_SKIPPED;
+    backend.gzip = UPDATE_ATTEMPT_FAILED;
+    backend.raw = UPDATE_ATTEMPT_OK;
+    int used;
+    TEST_ASSERT_EQUAL_STRING("D G", run(fullOffer(), nullptr, 0, backend, used));
+    TEST_ASSERT_EQUAL_INT(-1, used);
+}
+
+static void test_gzip_skipped_uses_raw()
+{
+    StubBackend backend;
+    backend.delta = UPDATE_ATTEMPT_SKIPPED;
+    backend.gzip = UPDATE_ATTEMPT_SKIPPED;
+    backend.raw = UPDATE_ATTEMPT_OK;
+    int used;
+    TEST_ASSERT_EQUAL_STRING("D G R", run(fullOffer(), nullptr, 0, backend, used));
+    TEST_ASSERT_EQUAL_INT(2, used);
+}
+
+static void test_backend_without_delta_and_gzip()
+{
+    UpdateOffer offer = fullOffer();
+    offer.delta = false;
+    offer.gzip = false;
+    StubBackend backend;
+    backend.raw = UPDATE_ATTEMPT_OK;
+    int used;
+    TEST_ASSERT_EQUAL_STRING("R", run(offer, nullptr, 0, backend, used));
+    TEST_ASSERT_EQUAL_INT(0, used);
+}
+
+static void test_plan_respects_max()
+{
+    UpdatePeer peers[] = {makePeer(0x0B00A8C0, "9.5"), makePeer(0x0C00A8C0, "9.5")};
+    UpdateSource plan[2];
+    uint8_t count = planUpdateSources(fullOffer(), peers, 2, plan, 2);
+    TEST_ASSERT_EQUAL_UINT8(2, count);
+    TEST_ASSERT_EQUAL(UPDATE_SOURCE_PEER, plan[1].kind);
+}
+
+int main(int, char **)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_order_peer_delta_gzip_raw);
+    RUN_TEST(test_peer_success_stops);
+    RUN_TEST(test_peer_filter_self_and_version);
+    RUN_TEST(test_peer_tries_capped);
+    RUN_TEST(test_no_peers_without_size);
+    RUN_TEST(test_delta_failure_falls_back_to_gzip);
+    RUN_TEST(test_gzip_failure_stops);
+    RUN_TEST(test_gzip_skipped_uses_raw);
+    RUN_TEST(test_backend_without_delta_and_gzip);
+    RUN_TEST(test_plan_respects_max);
+    return UNITY_END();
+}
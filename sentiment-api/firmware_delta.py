@@ -0,0 +1,198 @@
+# -*- coding: utf-8 -*-
+"""
+Delta-Patches zwischen zwei Firmware-Images
+
+Zwei aufeinanderfolgende Releases unterscheiden sich meist nur in wenigen
+Funktionen — der größte Teil des ~1,3 MB großen Images bleibt gleich oder
+verschiebt sich nur. Statt des ganzen Binarys lädt die Lampe dann einen Patch,
+der beschreibt, wie aus dem laufenden Image das neue entsteht. Angewendet wird
+er auf dem Gerät Block für Block (firmware/src/ota_delta.cpp): alte Bytes kommen
+aus der laufenden App-Partition, das Ergebnis geht in die andere.
+
+Format (little endian), als Ganzes gzip-komprimiert:
+
+    Kopf:   b'AOD1' | u32 base_size | 32 Byte SHA-256 der Basis | u32 target_size
+    COPY    0x01 | u32 quelle | u32 laenge                 alte Bytes unverändert
+    ADD     0x02 | u32 quelle | u32 laenge | laenge Bytes  alt + Differenz (mod 256)
+    INSERT  0x03 | u32 laenge | laenge Bytes               neue Bytes wörtlich
+
+Die Befehle folgen bis target_size erreicht ist. ADD ist der Trick aus bsdiff:
+verschobener Code unterscheidet sich vom alten oft nur in einzelnen Adressen,
+die Differenz besteht dann fast nur aus Nullen und gzip macht sie winzig.
+
+Aufruf von Hand (z.B. zum Ausprobieren vor einem Release):
+    python3 firmware_delta.py alt.bin neu.bin patch.bin.gz
+"""
+
+import gzip
+import hashlib
+import struct
+import sys
+
+DELTA_MAGIC = b'AOD1'
+HEADER = struct.Struct('<4sI32sI')
+
+OP_COPY = 0x01
+OP_ADD = 0x02
+OP_INSERT = 0x03
+
+# Gesucht wird nach übereinstimmenden Blöcken von BLOCK Bytes. Indiziert wird
+# nur jede STRIDE-te Position des alten Images — das hält den Index klein
+# (~160k Einträge für 1,3 MB) und findet trotzdem jede Übereinstimmung ab
+# BLOCK + STRIDE Bytes.
+BLOCK = 16
+STRIDE = 8
+
+# Ein ADD-Bereich wächst, solange Übereinstimmungen überwiegen. Kommt so viele
+# Bytes lang keine Verbesserung, ist der Bereich zu Ende.
+LOOKAHEAD = 256
+
+
+def _match_length(old: bytes, new: bytes, o: int, p: int) -> int:
+    """
+    Länge des ADD-Bereichs ab old[o] / new[p].
+
+    Wie bei bsdiff zählt Übereinstimmungen minus Abweichungen; genommen wird
+    die Länge mit der besten Bilanz. Einzelne geänderte Bytes (Adressen,
+    Konstanten) unterbrechen den Bereich also nicht.
+    """
+    limit = min(len(old) - o, len(new) - p)
+
+    # Schneller Vorlauf über den exakt gleichen Anfang
+    i = 0
+    while i + 64 <= limit and old[o + i:o + i + 64] == new[p + i:p + i + 64]:
+        i += 64
+
+    score = best_score = best = i
+    while i < limit:
+        if old[o + i] == new[p + i]:
+            score += 1
+        else:
+            score -= 1
+        i += 1
+        if score > best_score:
+            best_score = score
+            best = i
+        elif i - best > LOOKAHEAD:
+            break
+    return best
+
+
+def make_delta(old: bytes, new: bytes) -> bytes:
+    """Patch von old nach new, unkomprimiert."""
+    index = {}
+    for i in range(0, len(old) - BLOCK + 1, STRIDE):
+        index.setdefault(old[i:i + BLOCK], i)
+
+    out = bytearray(HEADER.pack(DELTA_MAGIC, len(old),
+                                hashlib.sha256(old).digest(), len(new)))
+
+    def insert(start, end):
+        if end > start:
+            out.extend(struct.pack('<BI', OP_INSERT, end - start))
+            out.extend(new[start:end])
+
+    literal_start = 0
+    p = 0
+    while p <= len(new) - BLOCK:
+        o = index.get(new[p:p + BLOCK])
+        if o is None:
+            p += 1
+            continue
+
+        # Der Index kennt nur jede STRIDE-te Position — den Anfang der
+        # Übereinstimmung rückwärts suchen
+        while p > literal_start and o > 0 and old[o - 1] == new[p - 1]:
+            p -= 1
+            o -= 1
+
+        length = _match_length(old, new, o, p)
+        insert(literal_start, p)
+
+        old_part = old[o:o + length]
+        new_part = new[p:p + length]
+        if old_part == new_part:
+            out.extend(struct.pack('<BII', OP_COPY, o, length))
+        else:
+            out.extend(struct.pack('<BII', OP_ADD, o, length))
+            out.extend(bytes((n - b) & 0xFF for n, b in zip(new_part, old_part)))
+
+        p += length
+        literal_start = p
+
+    insert(literal_start, len(new))
+    return bytes(out)
+
+
+def apply_delta(old: bytes, delta: bytes) -> bytes:
+    """
+    Wendet einen unkomprimierten Patch an — Referenz für die Firmware.
+
+    Raises:
+        ValueError bei falschem Kopf, falscher Basis oder kaputtem Patch.
+    """
+    if len(delta) < HEADER.size:
+        raise ValueError("Patch kuerzer als der Kopf")
+    magic, base_size, base_sha, target_size = HEADER.unpack_from(delta, 0)
+    if magic != DELTA_MAGIC:
+        raise ValueError("Kein AuraOS-Delta")
+    if base_size != len(old) or hashlib.sha256(old).digest() != base_sha:
+        raise ValueError("Patch passt nicht zur Basis")
+
+    out = bytearray()
+    pos = HEADER.size
+    while len(out) < target_size:
+        if pos >= len(delta):
+            raise ValueError("Patch endet vorzeitig")
+        op = delta[pos]
+        if op in (OP_COPY, OP_ADD):
+            src, length = struct.unpack_from('<II', delta, pos + 1)
+            pos += 9
+            if src + length > len(old):
+                raise ValueError("Quelle ausserhalb der Basis")
+            if op == OP_COPY:
+                out.extend(old[src:src + length])
+            else:
+                diff = delta[pos:pos + length]
+                if len(diff) != length:
+                    raise ValueError("Patch endet vorzeitig")
+                out.extend((b + d) & 0xFF for b, d in zip(old[src:src + length], diff))
+                pos += length
+        elif op == OP_INSERT:
+            (length,) = struct.unpack_from('<I', delta, pos + 1)
+            pos += 5
+            data = delta[pos:pos + length]
+            if len(data) != length:
+                raise ValueError("Patch endet vorzeitig")
+            out.extend(data)
+            pos += length
+        else:
+            raise ValueError(f"Unbekannter Befehl 0x{op:02x}")
+
+    if len(out) != target_size or pos != len(delta):
+        raise ValueError("Patch und Zielgroesse passen nicht zusammen")
+    return bytes(out)
+
+
+def compress_delta(delta: bytes) -> bytes:
+    """gzip wie bei der .bin.gz: Stufe 9, mtime 0, reproduzierbar."""
+    return gzip.compress(delta, compresslevel=9, mtime=0)
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 4:
+        print("Aufruf: firmware_delta.py alt.bin neu.bin patch.bin.gz")
+        sys.exit(2)
+    with open(sys.argv[1], 'rb') as fh:
+        old_image = fh.read()
+    with open(sys.argv[2], 'rb') as fh:
+        new_image = fh.read()
+    patch = make_delta(old_image, new_image)
+    if apply_delta(old_image, patch) != new_image:
+        print("FEHLER: Patch reproduziert das neue Image nicht")
+        sys.exit(1)
+    packed = compress_delta(patch)
+    with open(sys.argv[3], 'wb') as fh:
+        fh.write(packed)
+    full = len(gzip.compress(new_image, compresslevel=9, mtime=0))
+    print(f"Delta: {len(packed)} Bytes (Image {len(new_image)}, gzip {full})")
@@ -22,6 +22,7 @@ Integration in app.py:
     register_firmware_endpoints(app)
 """
 
+import gzip
 import hashlib
 import json
 import logging
@@ -29,6 +30,7 @@ import os
 import re
 import secrets
 import shutil
+import tarfile
 import tempfile
 from datetime import datetime, timezone
 from pathlib import Path
@@ -37,6 +39,7 @@ import requests as http_requests
 from flask import Response, jsonify, request, send_file
 
 from database import get_database
+from firmware_delta import apply_delta, compress_delta, make_delta
 
 logger = logging.getLogger(__name__)
 
@@ -55,6 +58,20 @@ SYNC_TOKEN = os.getenv('FIRMWARE_SYNC_TOKEN', '').strip()
 # davon deutet auf ein falsches Asset hin und würde nur Plattenplatz fressen.
 MAX_ASSET_BYTES = 8 * 1024 * 1024
 
+# Kompressionsstufe der .bin.gz-Variante. Gepackt wird einmal beim Spiegeln,
+# entpackt auf dem Gerät — dort kostet Stufe 9 nichts extra, weil das
+# Deflate-Fenster unabhängig von der Stufe immer 32 KB groß ist.
+GZIP_LEVEL = 9
+
+# Delta-Patches (firmware_delta.py) werden gegen so viele der zuletzt
+# gespiegelten Vorversionen gebaut. Ältere Geräte laden das volle Image.
+DELTA_BASES = 3
+
+# Ein Patch wird nur ausgeliefert, wenn er höchstens diesen Anteil der
+# .bin.gz ausmacht. Knapp darunter lohnt der Aufwand auf dem Gerät nicht
+# (Basis prüfen, alte Partition lesen) und ein Fehlschlag kostet doppelt.
+DELTA_MAX_SHARE = 0.6
+
 # Settings-Keys in der Datenbank
 KEY_RELEASED = 'firmware_released_version'   # Was die Geräte bekommen dürfen
 KEY_LATEST_MIRRORED = 'firmware_latest_mirrored'  # Was zuletzt gespiegelt wurde
@@ -96,11 +113,18 @@ def _mirror_paths(version: str):
     return {
         'dir': base,
         'firmware': base / f'Firmware-{version}-AuraOS.bin',
+        'firmware_gz': base / f'Firmware-{version}-AuraOS.bin.gz',
         'ui': base / f'UI-{version}-AuraOS.tgz',
+        'ui_manifest': base / f'UI-{version}-manifest.json',
         'meta': base / 'release.json',
     }
 
 
+def _delta_path(version: str, base_version: str) -> Path:
+    """Patch von base_version nach version, liegt beim Ziel-Release."""
+    return MIRROR_DIR / version / f'Delta-{base_version}-to-{version}-AuraOS.bin.gz'
+
+
 def _read_meta(version: str):
     """Metadaten eines gespiegelten Release lesen, None wenn nicht vorhanden."""
     meta_path = _mirror_paths(version)['meta']
@@ -178,6 +202,179 @@ def _verify_firmware_magic(path: Path) -> bool:
         return False
 
 
+def _file_sha256(path: Path) -> str:
+    """SHA-256 einer Datei als Hex, blockweise gelesen."""
+    digest = hashlib.sha256()
+    with open(path, 'rb') as fh:
+        for chunk in iter(lambda: fh.read(64 * 1024), b''):
+            digest.update(chunk)
+    return digest.hexdigest()
+
+
+def _read_ui_manifest(path: Path) -> tuple:
+    """
+    Liest manifest.json aus dem UI-Archiv und prüft es gegen die Einträge.
+
+    Die Lampe schreibt anhand des Manifests nur geänderte Dateien und bricht
+    ab, sobald eine Datei nicht dazu passt. Ein fehlerhaftes Manifest soll
+    deshalb schon hier auffallen und nicht erst auf jedem Gerät. Es muss der
+    erste Eintrag sein — die Lampe entpackt im Durchgang und sieht es sonst
+    zu spät.
+
+    Returns:
+        (manifest, None) wenn vorhanden und stimmig, (None, None) bei Archiven
+        ohne Manifest (vor build-ui-manifest.py), (None, Fehlermeldung) sonst.
+    """
+    try:
+        with tarfile.open(path, 'r:gz') as tar:
+            members = [m for m in tar.getmembers() if m.isfile()]
+            if not members or members[0].name.removeprefix('./') != 'manifest.json':
+                has_manifest = any(m.name.removeprefix('./') == 'manifest.json' for m in members)
+                return None, ("manifest.json ist nicht der erste Eintrag"
+                              if has_manifest else None)
+
+            manifest = json.loads(tar.extractfile(members[0]).read())
+            expected = manifest.get('files') or {}
+
+            seen = {}
+            for member in members[1:]:
+                data = tar.extractfile(member).read()
+                seen[member.name.removeprefix('./')] = {
+                    'size': len(data),
+                    'sha256': hashlib.sha256(data).hexdigest(),
+                }
+    except (OSError, tarfile.TarError, ValueError, AttributeError) as exc:
+        return None, f"UI-Archiv nicht lesbar: {exc}"
+
+    if set(seen) != set(expected):
+        return None, "Manifest und Archiv nennen verschiedene Dateien"
+    for name, entry in seen.items():
+        if (expected[name].get('size') != entry['size']
+                or expected[name].get('sha256') != entry['sha256']):
+            return None, f"{name} passt nicht zum Manifest"
+    return manifest, None
+
+
+def _write_gzip(source: Path, target: Path) -> tuple:
+    """
+    Legt neben dem Binary eine gzip-Variante für den OTA-Download ab.
+
+    Die Lampe entpackt sie beim Flashen blockweise (ota_gzip.cpp) — über die
+    Luft gehen so rund 40 % weniger Bytes. mtime=0 und kein Dateiname im
+    Header: dasselbe Binary ergibt immer dieselbe .gz und damit dieselbe
+    Prüfsumme.
+
+    Returns:
+        (sha256, groesse) der .gz bei Erfolg, (None, Fehlermeldung) sonst.
+    """
+    tmp_fd, tmp_name = tempfile.mkstemp(dir=str(target.parent), suffix='.part')
+    os.close(tmp_fd)
+    tmp_path = Path(tmp_name)
+
+    try:
+        with open(source, 'rb') as src, open(tmp_path, 'wb') as raw:
+            with gzip.GzipFile(filename='', mode='wb', fileobj=raw,
+                               compresslevel=GZIP_LEVEL, mtime=0) as gz:
+                shutil.copyfileobj(src, gz, 64 * 1024)
+
+        sha = _file_sha256(tmp_path)
+        size = tmp_path.stat().st_size
+
+        tmp_path.replace(target)
+        return sha, size
+
+    except OSError as exc:
+        return None, f"gzip-Variante nicht schreibbar: {exc}"
+    finally:
+        if tmp_path.exists():
+            try:
+                tmp_path.unlink()
+            except OSError:
+                pass
+
+
+def _delta_bases(version: str) -> list:
+    """Die bis zu DELTA_BASES nächstälteren gespiegelten Versionen mit Binary."""
+    target = _parse_version(version)
+    bases = []
+    if target is None or not MIRROR_DIR.is_dir():
+        return bases
+    for entry in MIRROR_DIR.iterdir():
+        parsed = _parse_version(entry.name)
+        if (entry.is_dir() and parsed is not None and parsed < target
+                and _mirror_paths(entry.name)['firmware'].is_file()):
+            bases.append(entry.name)
+    bases.sort(key=_parse_version, reverse=True)
+    return bases[:DELTA_BASES]
+
+
+def _write_deltas(version: str, full_size: int) -> dict:
+    """
+    Baut Delta-Patches von den Vorversionen auf version.
+
+    Jeder Patch wird vor dem Ablegen einmal angewendet und mit dem neuen
+    Binary verglichen — ein fehlerhafter Patch käme sonst erst auf dem Gerät
+    ans Licht, wo er zwar abgefangen wird, aber einen Download verschwendet.
+
+    Args:
+        full_size: Größe des vollen Downloads (.bin.gz, sonst .bin) als
+                   Vergleichsmaßstab.
+
+    Returns:
+        {basisversion: {name, size, sha256, base_size, base_sha256}} — leer,
+        wenn sich kein Patch lohnt.
+    """
+    paths = _mirror_paths(version)
+    try:
+        with open(paths['firmware'], 'rb') as fh:
+            new_image = fh.read()
+    except OSError as exc:
+        logger.warning(f"Deltas fuer {version} nicht gebaut: {exc}")
+        return {}
+
+    deltas = {}
+    for base in _delta_bases(version):
+        target = _delta_path(version, base)
+        try:
+            with open(_mirror_paths(base)['firmware'], 'rb') as fh:
+                old_image = fh.read()
+
+            patch = make_delta(old_image, new_image)
+            if apply_delta(old_image, patch) != new_image:
+                logger.error(f"Delta {base} -> {version} reproduziert das Binary nicht — verworfen")
+                continue
+
+            packed = compress_delta(patch)
+            if len(packed) > full_size * DELTA_MAX_SHARE:
+                logger.info(f"Delta {base} -> {version}: {len(packed)} Bytes lohnt nicht "
+                            f"(voll {full_size})")
+                target.unlink(missing_ok=True)
+                continue
+
+            tmp_fd, tmp_name = tempfile.mkstemp(dir=str(target.parent), suffix='.part')
+            try:
+                with os.fdopen(tmp_fd, 'wb') as fh:
+                    fh.write(packed)
+                Path(tmp_name).replace(target)
+            finally:
+                Path(tmp_name).unlink(missing_ok=True)
+
+        except (OSError, ValueError) as exc:
+            logger.warning(f"Delta {base} -> {version} nicht gebaut: {exc}")
+            continue
+
+        deltas[base] = {
+            'name': target.name,
+            'size': len(packed),
+            'sha256': hashlib.sha256(packed).hexdigest(),
+            'base_size': len(old_image),
+            'base_sha256': hashlib.sha256(old_image).hexdigest(),
+        }
+        logger.info(f"Delta {base} -> {version}: {len(packed)} Bytes (voll {full_size})")
+
+    return deltas
+
+
 def register_firmware_endpoints(app):
     """Registriert die Firmware-Endpoints an der Flask-App."""
 
@@ -285,6 +482,16 @@ def register_firmware_endpoints(app):
                 "message": "Datei ist keine ESP32-Firmware (Magic-Byte fehlt)"
             }), 400
 
+        # Komprimierte Variante für den Download. Optional: ohne sie lädt die
+        # Lampe einfach das rohe Binary
+        gz_sha, gz_size = _write_gzip(paths['firmware'], paths['firmware_gz'])
+        if gz_sha is None:
+            logger.warning(f"Firmware {version}: {gz_size}")
+            gz_sha, gz_size = None, 0
+
+        # Patches von den Vorversionen — ebenfalls optional
+        deltas = _write_deltas(version, gz_size or fw_size)
+
         # UI-Archiv ist optional — ein reines Firmware-Release ist zulässig
         ui_sha, ui_size = None, 0
         if ui_name in assets:
@@ -295,6 +502,23 @@ def register_firmware_endpoints(app):
                 logger.warning(f"UI-Archiv {version} nicht gespiegelt: {ui_size}")
                 ui_sha, ui_size = None, 0
 
+        # Manifest für inkrementelle UI-Updates. Passt es nicht zum Archiv,
+        # würde jede Lampe die Installation abbrechen — dann lieber ohne UI
+        ui_files = 0
+        if ui_sha:
+            manifest, problem = _read_ui_manifest(paths['ui'])
+            if problem:
+                logger.warning(f"UI-Archiv {version} verworfen: {problem}")
+                paths['ui'].unlink(missing_ok=True)
+                ui_sha, ui_size = None, 0
+            elif manifest:
+                try:
+                    with open(paths['ui_manifest'], 'w', encoding='utf-8') as fh:
+                        json.dump(manifest, fh, separators=(',', ':'), sort_keys=True)
+                    ui_files = len(manifest.get('files') or {})
+                except OSError as exc:
+                    logger.warning(f"UI-Manifest {version} nicht schreibbar: {exc}")
+
         meta = {
             'version': version,
             'tag': tag,
@@ -302,7 +526,11 @@ def register_firmware_endpoints(app):
             'published_at': release.get('published_at', ''),
             'mirrored_at': datetime.now(timezone.utc).isoformat(),
             'firmware': {'name': fw_name, 'size': fw_size, 'sha256': fw_sha},
-            'ui': ({'name': ui_name, 'size': ui_size, 'sha256': ui_sha}
+            'firmware_gz': ({'name': paths['firmware_gz'].name, 'size': gz_size,
+                             'sha256': gz_sha} if gz_sha else None),
+            'deltas': deltas,
+            'ui': ({'name': ui_name, 'size': ui_size, 'sha256': ui_sha,
+                    'manifest_files': ui_files}
                    if ui_sha else None),
         }
 
@@ -316,7 +544,8 @@ def register_firmware_endpoints(app):
         db = get_database()
         db.set_setting(KEY_LATEST_MIRRORED, version)
 
-        logger.info(f"Firmware {version} gespiegelt ({fw_size} Bytes) — noch nicht freigegeben")
+        logger.info(f"Firmware {version} gespiegelt ({fw_size} Bytes, gzip {gz_size} Bytes, "
+                    f"{len(deltas)} Deltas) — noch nicht freigegeben")
         return jsonify({
             "status": "success",
             "version": version,
@@ -370,17 +599,37 @@ def register_firmware_endpoints(app):
             fw = meta.get('firmware') or {}
             payload["firmware_url"] = f"/api/firmware/download/{released}/firmware"
             payload["firmware_size"] = fw.get('size', 0)
+            # Pflicht für die Lampe: ohne passende Prüfsumme flasht sie nicht
             payload["firmware_sha256"] = fw.get('sha256', '')
+            # Ältere Firmware kennt nur firmware_url und ignoriert das hier
+            fw_gz = meta.get('firmware_gz')
+            if fw_gz and _mirror_paths(released)['firmware_gz'].is_file():
+                payload["firmware_gz_url"] = f"/api/firmware/download/{released}/firmware_gz"
+                payload["firmware_gz_size"] = fw_gz.get('size', 0)
+            # Patch nur, wenn einer genau von der laufenden Version existiert.
+            # Ob das Gerät wirklich dieses Binary trägt, prüft es selbst anhand
+            # von delta_base_sha256 — sonst lädt es das volle Image
+            delta = (meta.get('deltas') or {}).get(current)
+            if delta and _delta_path(released, current).is_file():
+                payload["delta_url"] = f"/api/firmware/download/{released}/delta/{current}"
+                payload["delta_size"] = delta.get('size', 0)
+                payload["delta_base_size"] = delta.get('base_size', 0)
+                payload["delta_base_sha256"] = delta.get('base_sha256', '')
             if meta.get('ui'):
                 payload["ui_url"] = f"/api/firmware/download/{released}/ui"
                 payload["ui_size"] = (meta.get('ui') or {}).get('size', 0)
+                # Dateiliste mit Prüfsummen: daran sieht die Lampe vor dem
+                # Download, ob sich an ihrer UI überhaupt etwas ändert
+                if _mirror_paths(released)['ui_manifest'].is_file():
+                    payload["ui_manifest_url"] = (
+                        f"/api/firmware/download/{released}/ui_manifest")
 
         return jsonify(payload), 200
 
     @app.route('/api/firmware/download/<version>/<kind>', methods=['GET'])
     def firmware_download(version, kind):
         """
-        Liefert Binary oder UI-Archiv per HTTP aus — das lädt die Lampe.
+        Liefert Binary, gzip-Binary, UI-Archiv oder UI-Manifest per HTTP aus — das lädt die Lampe.
 
         Nur die freigegebene Version ist abrufbar. Sonst könnte ein Gerät eine
         zurückgezogene Version nachladen, weil es die alte URL noch kennt.
@@ -388,7 +637,7 @@ def register_firmware_endpoints(app):
         if not VERSION_RE.match(version or ''):
             return jsonify({"status": "error", "message": "Ungueltige Version"}), 400
 
-        if kind not in ('firmware', 'ui'):
+        if kind not in ('firmware', 'firmware_gz', 'ui', 'ui_manifest'):
             return jsonify({"status": "error", "message": "Unbekannter Typ"}), 400
 
         db = get_database()
@@ -400,11 +649,40 @@ def register_firmware_endpoints(app):
             }), 403
 
         paths = _mirror_paths(version)
-        target = paths['firmware'] if kind == 'firmware' else paths['ui']
+        target = paths[kind]
 
         if not target.is_file():
             return jsonify({"status": "error", "message": "Datei nicht im Spiegel"}), 404
 
+        if kind == 'ui_manifest':
+            return send_file(str(target), mimetype='application/json', conditional=True)
+
+        return send_file(
+            str(target),
+            mimetype='application/octet-stream',
+            as_attachment=True,
+            download_name=target.name,
+            conditional=True,
+        )
+
+    @app.route('/api/firmware/download/<version>/delta/<base>', methods=['GET'])
+    def firmware_download_delta(version, base):
+        """Delta-Patch von base auf die freigegebene Version."""
+        if not VERSION_RE.match(version or '') or not VERSION_RE.match(base or ''):
+            return jsonify({"status": "error", "message": "Ungueltige Version"}), 400
+
+        db = get_database()
+        released = (db.get_setting(KEY_RELEASED) or '').strip()
+        if version != released:
+            return jsonify({
+                "status": "error",
+                "message": "Diese Version ist nicht freigegeben"
+            }), 403
+
+        target = _delta_path(version, base)
+        if not target.is_file():
+            return jsonify({"status": "error", "message": "Kein Delta fuer diese Version"}), 404
+
         return send_file(
             str(target),
             mimetype='application/octet-stream',
@@ -434,7 +712,11 @@ def register_firmware_endpoints(app):
                     "mirrored_at": meta.get('mirrored_at', ''),
                     "release_url": meta.get('release_url', ''),
                     "firmware_size": (meta.get('firmware') or {}).get('size', 0),
+                    "firmware_gz_size": (meta.get('firmware_gz') or {}).get('size', 0),
+                    "deltas": sorted((meta.get('deltas') or {}).keys(),
+                                     key=lambda v: _parse_version(v) or (0, 0)),
                     "has_ui": bool(meta.get('ui')),
+                    "ui_manifest_files": (meta.get('ui') or {}).get('manifest_files', 0),
                 })
 
         versions.sort(key=lambda v: _parse_version(v['version']) or (0, 0), reverse=True)
@@ -495,6 +777,19 @@ def register_firmware_endpoints(app):
                 "message": "Gespiegelte Datei ist keine gueltige ESP32-Firmware"
             }), 400
 
+        # Die Lampe prüft das Geflashte gegen firmware_sha256 und verwirft es bei
+        # Abweichung. Eine Datei, die nicht mehr zur Prüfsumme passt, würde also
+        # auf jedem Gerät heruntergeladen und dann verworfen — besser gar nicht
+        # erst freigeben
+        meta = _read_meta(version) or {}
+        expected = (meta.get('firmware') or {}).get('sha256', '')
+        if not expected or _file_sha256(paths['firmware']) != expected:
+            logger.error(f"Freigabe {version} abgelehnt: SHA-256 passt nicht zu release.json")
+            return jsonify({
+                "status": "error",
+                "message": "Gespiegelte Datei passt nicht zur Pruefsumme"
+            }), 400
+
         db.set_setting(KEY_RELEASED, version)
         logger.info(f"Firmware {version} fuer alle Geraete freigegeben")
 
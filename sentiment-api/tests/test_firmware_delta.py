@@ -0,0 +1,172 @@
+# -*- coding: utf-8 -*-
+"""
+Unit-Tests für die Delta-Patches (firmware_delta.py) und ihre Ablage im
+Firmware-Spiegel.
+
+apply_delta() ist die Referenz für den Patcher auf der Lampe
+(firmware/src/ota_delta.cpp): was hier rund läuft, muss dort Byte für Byte
+dasselbe Image ergeben.
+"""
+
+import sys
+import os
+import gzip
+import hashlib
+import json
+import random
+import struct
+import tempfile
+import unittest
+from pathlib import Path
+from unittest import mock
+from unittest.mock import MagicMock
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..'))
+sys.path.insert(0, os.path.dirname(__file__))
+
+# Fremdpakete mocken, die in der lokalen Testumgebung nicht installiert sind
+sys.modules.setdefault('psycopg2', MagicMock())
+sys.modules.setdefault('psycopg2.extras', MagicMock())
+sys.modules.setdefault('psycopg2.pool', MagicMock())
+sys.modules.setdefault('redis', MagicMock())
+sys.modules.setdefault('requests', MagicMock())
+sys.modules.setdefault('flask', MagicMock())
+
+import firmware_delta  # noqa: E402
+import firmware_mirror  # noqa: E402
+from test_firmware_gzip import _fake_firmware  # noqa: E402
+
+
+def _next_release(old: bytes, seed=7) -> bytes:
+    """
+    Stellvertreter für das nächste Release: eine neue Funktion mitten im
+    Image (alles dahinter verschiebt sich) und verstreut geänderte Adressen.
+    """
+    rng = random.Random(seed)
+    new = bytearray(old)
+    new[400000:400000] = rng.randbytes(3000)
+    for _ in range(2000):
+        pos = rng.randrange(len(new))
+        new[pos] = (new[pos] + 4) & 0xFF
+    new[0] = 0xE9
+    return bytes(new)
+
+
+class TestDeltaFormat(unittest.TestCase):
+    """Tests für make_delta() / apply_delta()"""
+
+    @classmethod
+    def setUpClass(cls):
+        cls.old = _fake_firmware()
+        cls.new = _next_release(cls.old)
+        cls.patch = firmware_delta.make_delta(cls.old, cls.new)
+
+    def test_roundtrip(self):
+        """Patch auf das alte Image ergibt genau das neue"""
+        self.assertEqual(firmware_delta.apply_delta(self.old, self.patch), self.new)
+
+    def test_much_smaller_than_gzip(self):
+        """Der Grund für das Ganze: deutlich weniger Bytes als die .bin.gz"""
+        packed = firmware_delta.compress_delta(self.patch)
+        full = len(gzip.compress(self.new, compresslevel=9))
+        self.assertLess(len(packed), full // 10)
+
+    def test_header(self):
+        """Kopf trägt Größe und SHA-256 der Basis sowie die Zielgröße"""
+        magic, base_size, base_sha, target_size = struct.unpack_from('<4sI32sI', self.patch)
+        self.assertEqual(magic, b'AOD1')
+        self.assertEqual(base_size, len(self.old))
+        self.assertEqual(base_sha, hashlib.sha256(self.old).digest())
+        self.assertEqual(target_size, len(self.new))
+
+    def test_identical_images_single_copy(self):
+        """Unverändertes Image: ein einziger COPY über alles"""
+        patch = firmware_delta.make_delta(self.old, self.old)
+        self.assertEqual(len(patch), firmware_delta.HEADER.size + 9)
+        self.assertEqual(patch[firmware_delta.HEADER.size], firmware_delta.OP_COPY)
+
+    def test_unrelated_images(self):
+        """Ohne Gemeinsamkeiten bleibt der Patch korrekt, nur eben groß"""
+        other = _fake_firmware(size=200 * 1024, seed=99)
+        patch = firmware_delta.make_delta(self.old[:200 * 1024], other)
+        self.assertEqual(firmware_delta.apply_delta(self.old[:200 * 1024], patch), other)
+
+    def test_wrong_base_rejected(self):
+        """Ein Patch auf die falsche Basis wird nicht angewendet"""
+        wrong = bytearray(self.old)
+        wrong[1000] ^= 0xFF
+        with self.assertRaises(ValueError):
+            firmware_delta.apply_delta(bytes(wrong), self.patch)
+
+    def test_truncated_rejected(self):
+        """Abgeschnittener Patch fällt auf, statt ein halbes Image zu liefern"""
+        with self.assertRaises(ValueError):
+            firmware_delta.apply_delta(self.old, self.patch[:-100])
+
+    def test_unknown_op_rejected(self):
+        """Unbekannter Befehl bricht ab"""
+        broken = bytearray(self.patch)
+        broken[firmware_delta.HEADER.size] = 0x7F
+        with self.assertRaises(ValueError):
+            firmware_delta.apply_delta(self.old, bytes(broken))
+
+
+class TestMirrorDeltas(unittest.TestCase):
+    """Tests für _delta_bases() und _write_deltas()"""
+
+    def setUp(self):
+        self._tmp = tempfile.TemporaryDirectory()
+        self.mirror = Path(self._tmp.name)
+        self._patch = mock.patch.object(firmware_mirror, 'MIRROR_DIR', self.mirror)
+        self._patch.start()
+
+    def tearDown(self):
+        self._patch.stop()
+        self._tmp.cleanup()
+
+    def _mirror(self, version, image):
+        path = firmware_mirror._mirror_paths(version)['firmware']
+        path.parent.mkdir(parents=True, exist_ok=True)
+        path.write_bytes(image)
+
+    def test_bases_numeric_order(self):
+        """9.10 ist neuer als 9.9 — Basen nach Version, nicht nach Text"""
+        for version in ('9.8', '9.9', '9.10', '9.11', '9.12'):
+            self._mirror(version, b'\xe9')
+        self.assertEqual(firmware_mirror._delta_bases('9.12'), ['9.11', '9.10', '9.9'])
+        self.assertEqual(firmware_mirror._delta_bases('9.8'), [])
+
+    def test_write_deltas(self):
+        """Patch wird abgelegt und beschreibt Basis und Datei vollständig"""
+        old = _fake_firmware()
+        new = _next_release(old)
+        self._mirror('9.15', old)
+        self._mirror('9.16', new)
+
+        full = len(gzip.compress(new, compresslevel=9))
+        deltas = firmware_mirror._write_deltas('9.16', full)
+
+        self.assertEqual(list(deltas), ['9.15'])
+        info = deltas['9.15']
+        path = firmware_mirror._delta_path('9.16', '9.15')
+        packed = path.read_bytes()
+        self.assertEqual(info['name'], 'Delta-9.15-to-9.16-AuraOS.bin.gz')
+        self.assertEqual(info['size'], len(packed))
+        self.assertEqual(info['sha256'], hashlib.sha256(packed).hexdigest())
+        self.assertEqual(info['base_size'], len(old))
+        self.assertEqual(info['base_sha256'], hashlib.sha256(old).hexdigest())
+        self.assertEqual(firmware_delta.apply_delta(old, gzip.decompress(packed)), new)
+        self.assertEqual(list(path.parent.glob('*.part')), [])
+        json.dumps(deltas)  # landet so in release.json
+
+    def test_skips_delta_that_does_not_pay_off(self):
+        """Kein Patch, wenn er kaum kleiner wäre als der volle Download"""
+        self._mirror('9.15', _fake_firmware(size=200 * 1024, seed=1))
+        self._mirror('9.16', _fake_firmware(size=200 * 1024, seed=2))
+
+        self.assertEqual(firmware_mirror._write_deltas('9.16', 100 * 1024), {})
+        self.assertFalse(firmware_mirror._delta_path('9.16', '9.15').exists())
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,144 @@
+# -*- coding: utf-8 -*-
+"""
+Unit-Tests für die gzip-Variante im Firmware-Spiegel (firmware_mirror.py).
+
+Die Lampe entpackt die .bin.gz beim Flashen mit dem tinfl aus dem ESP32-ROM.
+Die Tests prüfen deshalb, was dieser Entpacker voraussetzt: gültiger
+gzip-Header, unveränderter Inhalt, CRC32/Länge im Trailer — und dass die
+Datei über einen lokalen HTTP-Server als Stellvertreter für das Backend
+tatsächlich mit weniger Bytes ankommt als das rohe Binary.
+"""
+
+import sys
+import os
+import gzip
+import hashlib
+import random
+import struct
+import tempfile
+import threading
+import unittest
+import urllib.request
+import zlib
+from functools import partial
+from http.server import SimpleHTTPRequestHandler, ThreadingHTTPServer
+from pathlib import Path
+from unittest.mock import MagicMock
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..'))
+
+# Fremdpakete mocken, die in der lokalen Testumgebung nicht installiert sind
+sys.modules.setdefault('psycopg2', MagicMock())
+sys.modules.setdefault('psycopg2.extras', MagicMock())
+sys.modules.setdefault('psycopg2.pool', MagicMock())
+sys.modules.setdefault('redis', MagicMock())
+sys.modules.setdefault('requests', MagicMock())
+sys.modules.setdefault('flask', MagicMock())
+
+import firmware_mirror  # noqa: E402
+
+
+def _fake_firmware(size=1300 * 1024, seed=42):
+    """
+    Stellvertreter für ein AuraOS-Binary: Magic-Byte 0xE9, danach ein Mix aus
+    wiederkehrenden Befehlsmustern, Zeichenketten und zufälligen Daten —
+    grob die Mischung, die ein echtes ESP32-Image ausmacht.
+    """
+    rng = random.Random(seed)
+    opcodes = [rng.randbytes(3) for _ in range(600)]
+    strings = [f"Sentiment-Update {i}: HTTP-Fehler %d\0".encode() for i in range(80)]
+    out = bytearray(b'\xe9\x06\x02\x20')
+    while len(out) < size:
+        pick = rng.random()
+        if pick < 0.70:
+            out += rng.choice(opcodes)
+        elif pick < 0.75:
+            out += rng.choice(strings)
+        else:
+            out += rng.randbytes(4)
+    return bytes(out[:size])
+
+
+class _QuietHandler(SimpleHTTPRequestHandler):
+    def log_message(self, *args):
+        pass
+
+
+class TestFirmwareGzip(unittest.TestCase):
+    """Tests für _write_gzip() und die Auslieferung der .bin.gz"""
+
+    def setUp(self):
+        self._tmp = tempfile.TemporaryDirectory()
+        self.dir = Path(self._tmp.name)
+        self.raw = _fake_firmware()
+        self.source = self.dir / 'Firmware-9.99-AuraOS.bin'
+        self.source.write_bytes(self.raw)
+        self.target = self.dir / 'Firmware-9.99-AuraOS.bin.gz'
+
+    def tearDown(self):
+        self._tmp.cleanup()
+
+    def test_roundtrip_and_checksum(self):
+        sha, size = firmware_mirror._write_gzip(self.source, self.target)
+        data = self.target.read_bytes()
+
+        self.assertEqual(size, len(data))
+        self.assertEqual(sha, hashlib.sha256(data).hexdigest())
+        self.assertEqual(gzip.decompress(data), self.raw)
+
+    def test_header_and_trailer_match_device_expectations(self):
+        firmware_mirror._write_gzip(self.source, self.target)
+        data = self.target.read_bytes()
+
+        # ID1 ID2, CM=8 (Deflate), keine Flags, mtime 0
+        self.assertEqual(data[:4], b'\x1f\x8b\x08\x00')
+        self.assertEqual(data[4:8], b'\x00\x00\x00\x00')
+
+        crc, isize = struct.unpack('<II', data[-8:])
+        self.assertEqual(crc, zlib.crc32(self.raw))
+        self.assertEqual(isize, len(self.raw) & 0xFFFFFFFF)
+
+    def test_output_is_reproducible(self):
+        first_sha, _ = firmware_mirror._write_gzip(self.source, self.target)
+        second_sha, _ = firmware_mirror._write_gzip(self.source, self.target)
+        self.assertEqual(first_sha, second_sha)
+
+    def test_no_partial_file_left_behind(self):
+        firmware_mirror._write_gzip(self.source, self.target)
+        leftovers = [p.name for p in self.dir.iterdir() if p.suffix == '.part']
+        self.assertEqual(leftovers, [])
+
+    def test_missing_source_reports_error(self):
+        sha, message = firmware_mirror._write_gzip(self.dir / 'fehlt.bin', self.target)
+        self.assertIsNone(sha)
+        self.assertIn('gzip', message)
+        self.assertFalse(self.target.exists())
+
+    def test_file_sha256_matches_hashlib(self):
+        self.assertEqual(firmware_mirror._file_sha256(self.source),
+                         hashlib.sha256(self.raw).hexdigest())
+
+    def test_fewer_bytes_over_the_wire(self):
+        """Lokaler HTTP-Server als Backend-Ersatz: gezählt wird, was ankommt."""
+        firmware_mirror._write_gzip(self.source, self.target)
+
+        handler = partial(_QuietHandler, directory=str(self.dir))
+        server = ThreadingHTTPServer(('127.0.0.1', 0), handler)
+        thread = threading.Thread(target=server.serve_forever, daemon=True)
+        thread.start()
+        try:
+            base = f'http://127.0.0.1:{server.server_address[1]}/'
+            with urllib.request.urlopen(base + self.source.name) as resp:
+                raw_wire = resp.read()
+            with urllib.request.urlopen(base + self.target.name) as resp:
+                gz_wire = resp.read()
+        finally:
+            server.shutdown()
+            server.server_close()
+
+        self.assertEqual(gzip.decompress(gz_wire), raw_wire)
+        self.assertLess(len(gz_wire), len(raw_wire) * 0.8)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,144 @@
+# -*- coding: utf-8 -*-
+"""
+Unit-Tests für die Prüfung des UI-Manifests im Firmware-Spiegel.
+
+Das Manifest (firmware/build-ui-manifest.py) steht als erster Eintrag im
+UI-Archiv und nennt je Datei Größe und SHA-256. Die Lampe überspringt damit
+unveränderte Dateien und bricht ab, wenn eine Datei nicht passt — der Spiegel
+soll ein solches Archiv gar nicht erst ausliefern.
+"""
+
+import sys
+import os
+import gzip
+import hashlib
+import io
+import json
+import tarfile
+import tempfile
+import unittest
+from pathlib import Path
+from unittest.mock import MagicMock
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..'))
+
+# Fremdpakete mocken, die in der lokalen Testumgebung nicht installiert sind
+sys.modules.setdefault('psycopg2', MagicMock())
+sys.modules.setdefault('psycopg2.extras', MagicMock())
+sys.modules.setdefault('psycopg2.pool', MagicMock())
+sys.modules.setdefault('redis', MagicMock())
+sys.modules.setdefault('requests', MagicMock())
+sys.modules.setdefault('flask', MagicMock())
+
+import firmware_mirror  # noqa: E402
+
+
+FILES = {
+    'index.html': b'<html>index</html>',
+    'setup.html': b'<html>setup</html>',
+    'js/mood.js': b'console.log("mood");\n' * 40,
+    'css/style.css': b'body { color: #fff; }\n',
+}
+
+
+def _manifest(files):
+    return {
+        'version': '9.17',
+        'files': {name: {'size': len(data), 'sha256': hashlib.sha256(data).hexdigest()}
+                  for name, data in files.items()},
+    }
+
+
+def _write_tgz(path, entries):
+    """entries: Liste (name, bytes) in Archivreihenfolge."""
+    with open(path, 'wb') as fh, \
+            gzip.GzipFile(fileobj=fh, mode='wb', mtime=0) as gz, \
+            tarfile.open(fileobj=gz, mode='w', format=tarfile.USTAR_FORMAT) as tar:
+        for name, data in entries:
+            info = tarfile.TarInfo(name)
+            info.size = len(data)
+            tar.addfile(info, io.BytesIO(data))
+
+
+def _manifest_entry(manifest):
+    return ('manifest.json', json.dumps(manifest).encode())
+
+
+class TestReadUiManifest(unittest.TestCase):
+
+    def setUp(self):
+        self.tmp = tempfile.TemporaryDirectory()
+        self.path = Path(self.tmp.name) / 'UI-9.17-AuraOS.tgz'
+
+    def tearDown(self):
+        self.tmp.cleanup()
+
+    def test_valid_manifest(self):
+        manifest = _manifest(FILES)
+        _write_tgz(self.path, [_manifest_entry(manifest)] + list(FILES.items()))
+
+        result, problem = firmware_mirror._read_ui_manifest(self.path)
+
+        self.assertIsNone(problem)
+        self.assertEqual(result, manifest)
+
+    def test_dot_slash_names_accepted(self):
+        # tar -C data . erzeugt ./index.html usw.
+        manifest = _manifest(FILES)
+        entries = [('./manifest.json', _manifest_entry(manifest)[1])]
+        entries += [('./' + name, data) for name, data in FILES.items()]
+        _write_tgz(self.path, entries)
+
+        result, problem = firmware_mirror._read_ui_manifest(self.path)
+
+        self.assertIsNone(problem)
+        self.assertEqual(result, manifest)
+
+    def test_archive_without_manifest_is_no_error(self):
+        # Ältere Releases: die Lampe schreibt dann einfach alle Dateien
+        _write_tgz(self.path, list(FILES.items()))
+
+        self.assertEqual(firmware_mirror._read_ui_manifest(self.path), (None, None))
+
+    def test_manifest_must_come_first(self):
+        items = list(FILES.items())
+        _write_tgz(self.path, items[:1] + [_manifest_entry(_manifest(FILES))] + items[1:])
+
+        result, problem = firmware_mirror._read_ui_manifest(self.path)
+
+        self.assertIsNone(result)
+        self.assertIn('erste Eintrag', problem)
+
+    def test_hash_mismatch_rejected(self):
+        manifest = _manifest(FILES)
+        changed = dict(FILES)
+        changed['js/mood.js'] = b'console.log("anders");\n'
+        # Größe gleich lassen, damit wirklich der Hash greift
+        changed['js/mood.js'] = changed['js/mood.js'].ljust(len(FILES['js/mood.js']), b' ')
+        _write_tgz(self.path, [_manifest_entry(manifest)] + list(changed.items()))
+
+        result, problem = firmware_mirror._read_ui_manifest(self.path)
+
+        self.assertIsNone(result)
+        self.assertIn('js/mood.js', problem)
+
+    def test_file_missing_from_manifest_rejected(self):
+        manifest = _manifest({k: v for k, v in FILES.items() if k != 'css/style.css'})
+        _write_tgz(self.path, [_manifest_entry(manifest)] + list(FILES.items()))
+
+        result, problem = firmware_mirror._read_ui_manifest(self.path)
+
+        self.assertIsNone(result)
+        self.assertIn('verschiedene Dateien', problem)
+
+    def test_broken_archive_reported(self):
+        self.path.write_bytes(b'kein gzip')
+
+        result, problem = firmware_mirror._read_ui_manifest(self.path)
+
+        self.assertIsNone(result)
+        self.assertIn('nicht lesbar', problem)
+
+
+if __name__ == '__main__':
+    unittest.main()